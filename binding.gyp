@@ -4,17 +4,42 @@
       "target_name": "bes",
       "sources": [
         "src/connector/native/main.cc",
-        "src/connector/native/string.cc",
-        "src/connector/native/mouse.cc",
-        "src/connector/native/keyboard.cc",
         "src/connector/native/rect.cc",
         "src/connector/native/screen.cc",
         "src/connector/native/point.cc",
         "src/connector/native/color.cc",
-        "src/connector/native/window.cc",
-        "src/connector/native/eventsource.cc",
-        "src/connector/native/bitwig.cc",
-        "src/connector/native/ui.cc"
+        "src/connector/native/ui.cc",
+        "src/connector/native/detect.cc",
+        "src/connector/native/layoutprofile.cc",
+        "src/connector/native/sequence.cc",
+        "src/connector/native/constraint.cc",
+        "src/connector/native/pointerconstraint.cc",
+        "src/connector/native/windowregistry.cc",
+        "src/connector/native/pluginwindows.cc",
+        "src/connector/native/windowgeometry.cc",
+        "src/connector/native/activeapp.cc",
+        "src/connector/native/processtable.cc",
+        "src/connector/native/workerpool.cc",
+        "src/connector/native/nativeevents.cc",
+        "src/connector/native/resources.cc",
+        "src/connector/native/framer.cc",
+        "src/connector/native/packetframer.cc",
+        "src/connector/native/metrics.cc",
+        "src/connector/native/stats.cc",
+        "src/connector/native/windowlist.cc",
+        "src/connector/native/detectgraph.cc",
+        "src/connector/native/clips.cc",
+        "src/connector/native/ruler.cc",
+        "src/connector/native/headercontrols.cc",
+        "src/connector/native/glyphmatch.cc",
+        "src/connector/native/footerpanels.cc",
+        "src/connector/native/pixelrows.cc",
+        "src/connector/native/devicechain.cc",
+        "src/connector/native/mixerstrips.cc",
+        "src/connector/native/meteractivity.cc",
+        "src/connector/native/activity.cc",
+        "src/connector/native/lzblock.cc",
+        "src/connector/native/framerecording.cc"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")"
@@ -39,6 +64,15 @@
       },
       'conditions': [
       ['OS == "mac"', {
+        'sources': [
+          "src/connector/native/string.cc",
+          "src/connector/native/mouse.cc",
+          "src/connector/native/keyboard.cc",
+          "src/connector/native/window.cc",
+          "src/connector/native/eventsource.cc",
+          "src/connector/native/bitwig.cc",
+          "src/connector/native/capture.cc"
+        ],
         'cflags+': ['-fvisibility=hidden'],
         'xcode_settings': {
           'GCC_SYMBOLS_PRIVATE_EXTERN': 'YES', # -fvisibility=hidden
@@ -55,8 +89,134 @@
             '-framework ApplicationServices'
           ]
         }
+      }],
+      ['OS == "linux"', {
+        'sources': [
+          "src/connector/native/linux/x11.cc",
+          "src/connector/native/linux/eventsource.cc",
+          "src/connector/native/linux/keymap.cc",
+          "src/connector/native/linux/mouse.cc",
+          "src/connector/native/linux/keyboard.cc",
+          "src/connector/native/linux/window.cc",
+          "src/connector/native/linux/bitwig.cc",
+          "src/connector/native/linux/capture.cc"
+        ],
+        'cflags_cc': ['-std=c++17'],
+        'link_settings': {
+          'libraries': [
+            '-lX11',
+            '-lXext',
+            '-lXtst',
+            '-lXfixes'
+          ]
+        }
       }]
     ]
     }
+  ],
+  'conditions': [
+    ['OS == "linux"', {
+      'targets': [
+        {
+          # Fake Bitwig window for running the addon under Xvfb, see scripts/xvfbStandin.js
+          "target_name": "bes_standin",
+          "type": "executable",
+          "sources": [
+            "src/connector/native/standin/main.cc",
+            "src/connector/native/standin/layout.cc"
+          ],
+          'cflags_cc': ['-std=c++17'],
+          'link_settings': {
+            'libraries': [
+              '-lX11'
+            ]
+          }
+        },
+        {
+          # Native benchmarks without Node or a display, see bench/main.cc
+          "target_name": "bes_bench",
+          "type": "executable",
+          "sources": [
+            "src/connector/native/bench/main.cc",
+            "src/connector/native/detect.cc",
+            "src/connector/native/layoutprofile.cc",
+            "src/connector/native/detectgraph.cc",
+            "src/connector/native/clips.cc",
+            "src/connector/native/ruler.cc",
+            "src/connector/native/headercontrols.cc",
+            "src/connector/native/glyphmatch.cc",
+            "src/connector/native/footerpanels.cc",
+            "src/connector/native/pixelrows.cc",
+            "src/connector/native/devicechain.cc",
+            "src/connector/native/mixerstrips.cc",
+            "src/connector/native/lzblock.cc",
+            "src/connector/native/framerecording.cc",
+            "src/connector/native/workerpool.cc",
+            "src/connector/native/metrics.cc",
+            "src/connector/native/framer.cc",
+            "src/connector/native/standin/layout.cc",
+            "src/connector/native/linux/keymap.cc",
+            "src/connector/native/linux/eventsource.cc"
+          ],
+          'cflags_cc': ['-std=c++17'],
+          'link_settings': {
+            'libraries': [
+              '-lX11',
+              '-lXtst'
+            ]
+          }
+        },
+        {
+          # Unit tests for the modules with no N-API or display code, see test/test.h
+          "target_name": "bes_tests",
+          "type": "executable",
+          "sources": [
+            "src/connector/native/test/main.cc",
+            "src/connector/native/test/pointerconstraint.cc",
+            "src/connector/native/test/windowregistry.cc",
+            "src/connector/native/test/framer.cc",
+            "src/connector/native/test/framerecording.cc",
+            "src/connector/native/test/processtable.cc",
+            "src/connector/native/test/windowgeometry.cc",
+            "src/connector/native/test/detect.cc",
+            "src/connector/native/test/clips.cc",
+            "src/connector/native/test/ruler.cc",
+            "src/connector/native/test/headercontrols.cc",
+            "src/connector/native/test/devicechain.cc",
+            "src/connector/native/test/mixerstrips.cc",
+            "src/connector/native/test/layoutprofile.cc",
+            "src/connector/native/test/meteractivity.cc",
+            "src/connector/native/test/footerpanels.cc",
+            "src/connector/native/pointerconstraint.cc",
+            "src/connector/native/windowregistry.cc",
+            "src/connector/native/windowgeometry.cc",
+            "src/connector/native/processtable.cc",
+            "src/connector/native/framer.cc",
+            "src/connector/native/framerecording.cc",
+            "src/connector/native/lzblock.cc",
+            "src/connector/native/metrics.cc",
+            "src/connector/native/standin/layout.cc",
+            # FrameImage, and what detect.cc brings with it
+            "src/connector/native/detect.cc",
+            "src/connector/native/clips.cc",
+            "src/connector/native/ruler.cc",
+            "src/connector/native/devicechain.cc",
+            "src/connector/native/mixerstrips.cc",
+            "src/connector/native/meteractivity.cc",
+            "src/connector/native/layoutprofile.cc",
+            "src/connector/native/footerpanels.cc",
+            "src/connector/native/headercontrols.cc",
+            "src/connector/native/glyphmatch.cc",
+            "src/connector/native/pixelrows.cc"
+          ],
+          'cflags_cc': ['-std=c++17'],
+          'link_settings': {
+            'libraries': [
+              '-lpthread'
+            ]
+          }
+        }
+      ]
+    }]
   ]
 }
\ No newline at end of file
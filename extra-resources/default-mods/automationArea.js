@@ -299,40 +299,56 @@ Mod.registerAction({
     }
 })
 
-async function showTrackVolumeAutomation(currentTrack) {
+/**
+ * The selected track, or the one under the mouse, from a single capture. Tracks scrolled so only
+ * their automation lanes show are left out, they have no header to click on
+ */
+function findTrack({ selected }) {
     const tracks = UI.MainWindow.getArrangerTracks()
     if (tracks === null || tracks.length === 0) {
-        return log('No tracks found, spoopy...')
+        log('No tracks found, spoopy...')
+        return null
     }
+    if (selected) {
+        return tracks.find(t => t.selected) || null
+    }
+    // visibleRect, a partly scrolled header's rect starts above the arranger
+    const { y } = Mouse.getPosition()
+    return tracks.find(t => y >= t.visibleRect.y && y < t.visibleRect.y + t.visibleRect.h) || null
+}
 
-    const mousePos = Mouse.getPosition()
-    const getTargetTrack = () => {
-        if (currentTrack) {
-            return tracks.find(t => t.selected)
-        } else {
-            return tracks.find(t => mousePos.y >= t.rect.y && mousePos.y < t.rect.y + t.rect.h)
-        }
+/**
+ * The level meter runs along the bottom of a large header and down the right hand edge of a
+ * small one. null if that part of the header is scrolled out of view
+ */
+function levelMeterPoint(track) {
+    const header = track.headerRect()
+    if (!header) {
+        return null
+    }
+    const point = track.isLargeTrackHeight ? {
+        x: header.x + header.w / 2,
+        y: header.y + header.h - UI.scale(12)
+    } : {
+        x: header.x + header.w - UI.scale(25),
+        y: header.y + header.h / 2
     }
-    const targetT = getTargetTrack()
+    return point.y >= header.y ? point : null
+}
+
+async function showTrackVolumeAutomation(currentTrack) {
+    const targetT = findTrack({ selected: currentTrack })
     if (!targetT) {
         return showMessage(`Couldn't find track`)
     }
-    log(targetT)
+    const clickAt = levelMeterPoint(targetT)
+    if (!clickAt) {
+        return showMessage(`Track level meter isn't visible`)
+    }
 
     if (!targetT.selected) {
         await targetT.selectWithMouse()
     }
-
-    const clickAt = targetT.isLargeTrackHeight ? {
-        // Level meter is halfway across near the bottom
-        x: targetT.rect.x + (targetT.rect.w / 2), 
-        y: targetT.rect.y + UI.scale(33),
-    } : {
-        // Level meter is on the right hand edge from top to bottom
-        x: (targetT.rect.x + targetT.rect.w) - UI.scale(25),
-        y: targetT.rect.y + UI.scale(15),
-    }
-
     log('Clicking at: ', clickAt)
     await Mouse.click(0, {
         ...clickAt,
@@ -387,33 +403,13 @@ Mod.registerAction({
         keys: ["Alt", "S"]
     },
     action: async () => {
-        const tracks = UI.MainWindow.getArrangerTracks()
-        if (tracks === null || tracks.length === 0) {
-            return log('No tracks found, spoopy...')
-        }
-    
-        const mousePos = Mouse.getPosition()
-        const getTargetTrack = () => {
-            return tracks.find(t => mousePos.y >= t.rect.y && mousePos.y < t.rect.y + t.rect.h)
-        }
-        const targetT = getTargetTrack()
+        const targetT = findTrack({ selected: false })
         if (!targetT) {
             return showMessage(`Couldn't find track`)
         }
-        log(targetT)
-        
-        const clickAt = targetT.isLargeTrackHeight ? {
-            x: targetT.rect.x + targetT.rect.w - UI.scale(54), 
-            y: targetT.rect.y + UI.scale(10),
-        } : {
-            x: targetT.rect.x + targetT.rect.w - UI.scale(90), 
-            y: targetT.rect.y + UI.scale(7),
+        if (!await targetT.clickControl('solo')) {
+            showMessage(`Solo button isn't visible`)
         }
-        await Mouse.click(0, {
-            ...clickAt,
-            avoidPluginWindows: true,
-            returnAfter: true
-        })
     }
 })
 
@@ -427,33 +423,13 @@ Mod.registerAction({
         keys: ["Shift", "M"]
     },
     action: async () => {
-        const tracks = UI.MainWindow.getArrangerTracks()
-        if (tracks === null || tracks.length === 0) {
-            return log('No tracks found, spoopy...')
-        }
-    
-        const mousePos = Mouse.getPosition()
-        const getTargetTrack = () => {
-            return tracks.find(t => mousePos.y >= t.rect.y && mousePos.y < t.rect.y + t.rect.h)
-        }
-        const targetT = getTargetTrack()
+        const targetT = findTrack({ selected: false })
         if (!targetT) {
             return showMessage(`Couldn't find track`)
         }
-        log(targetT)
-        
-        const clickAt = targetT.isLargeTrackHeight ? {
-            x: targetT.rect.x + targetT.rect.w - UI.scale(30), 
-            y: targetT.rect.y + UI.scale(10),
-        } : {
-            x: targetT.rect.x + targetT.rect.w - UI.scale(60), 
-            y: targetT.rect.y + UI.scale(7),
+        if (!await targetT.clickControl('mute')) {
+            showMessage(`Mute button isn't visible`)
         }
-        await Mouse.click(0, {
-            ...clickAt,
-            avoidPluginWindows: true,
-            returnAfter: true
-        })
     }
 })
 
@@ -467,32 +443,15 @@ Mod.registerAction({
         keys: ["Shift", "A"]
     },
     action: async () => {
-        const tracks = UI.MainWindow.getArrangerTracks()
-        if (tracks === null || tracks.length === 0) {
-            return log('No tracks found, spoopy...')
-        }
-    
-        const mousePos = Mouse.getPosition()
-        const getTargetTrack = () => {
-            return tracks.find(t => mousePos.y >= t.rect.y && mousePos.y < t.rect.y + t.rect.h)
-        }
-        const targetT = getTargetTrack()
+        const targetT = findTrack({ selected: false })
         if (!targetT) {
             return showMessage(`Couldn't find track`)
         }
-        
-        const clickAt = targetT.isLargeTrackHeight ? {
-            x: targetT.rect.x + targetT.rect.w - UI.scale(26), 
-            y: targetT.rect.y + UI.scale(36),
-        } : {
-            x: targetT.rect.x + targetT.rect.w - UI.scale(44), 
-            y: targetT.rect.y + UI.scale(7),
+        // Bitwig's own action instead of the header's automation icon, which isn't always shown
+        if (!targetT.selected) {
+            await targetT.selectWithMouse()
         }
-        await Mouse.click(0, {
-            ...clickAt,
-            avoidPluginWindows: true,
-            returnAfter: true
-        })
+        Bitwig.runAction(`toggle_automation_shown_for_selected_tracks`)
     }
 })
 
@@ -506,27 +465,15 @@ Mod.registerAction({
         keys: ["Shift", "V"]
     },
     action: async () => {
-        const tracks = UI.MainWindow.getArrangerTracks()
-        if (tracks === null || tracks.length === 0) {
-            return log('No tracks found, spoopy...')
-        }
-
-        const selected = tracks.find(t => t.selected)
+        const selected = findTrack({ selected: true })
         if (!selected) {
             return showMessage(`Couldn't find selected track`)
         }
-
-        const clickAt = selected.isLargeTrackHeight ? {
-            // Level meter is halfway across near the bottom
-            x: selected.rect.x + (selected.rect.w / 2), 
-            y: selected.rect.y + UI.scaleXY({ x: 0, y: 33 }).y,
-        } : {
-            // Level meter is on the right hand edge from top to bottom
-            x: (selected.rect.x + selected.rect.w) - UI.scaleXY({ x: 25, y: 0 }).x,
-            y: selected.rect.y + UI.scaleXY({ x: 0, y: 15 }).y,
+        const point = levelMeterPoint(selected)
+        if (!point) {
+            return showMessage(`Track level meter isn't visible`)
         }
-
-        Mouse.setPosition(clickAt.x, clickAt.y)
+        Mouse.setPosition(point.x, point.y)
     }
 })
 
@@ -540,11 +487,7 @@ Mod.registerAction({
         keys: ["G"]
     },
     action: async () => {
-        const tracks = UI.MainWindow.getArrangerTracks()
-        if (tracks === null || tracks.length === 0) {
-            return log('No tracks found, spoopy...')
-        }
-        const selected = tracks.find(t => t.selected)
+        const selected = findTrack({ selected: true })
         if (!selected) {
             return showMessage(`Couldn't find selected track`)
         }
@@ -562,12 +505,7 @@ Mod.registerAction({
         keys: ["Shift", "G"]
     },
     action: async () => {
-        const tracks = UI.MainWindow.getArrangerTracks()
-        if (tracks === null || tracks.length === 0) {
-            return log('No tracks found, spoopy...')
-        }
-        const mousePos = Mouse.getPosition()
-        const inside = tracks.find(t => mousePos.y >= t.rect.y && mousePos.y < t.rect.y + t.rect.h)
+        const inside = findTrack({ selected: false })
         if (!inside) {
             return showMessage(`Couldn't find hovered track`)
         }
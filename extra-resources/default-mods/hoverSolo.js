@@ -24,7 +24,11 @@ async function toggleSolo(index, opts = {}) {
     if (!targetT) {
         return showMessage(`Couldn't find track`)
     }    
-    const clickAt = targetT.isLargeTrackHeight ? {
+    const control = targetT.controls[isMute ? 'mute' : 'solo']
+    const clickAt = control ? {
+        x: control.rect.x + Math.floor(control.rect.w / 2),
+        y: control.rect.y + Math.floor(control.rect.h / 2),
+    } : targetT.isLargeTrackHeight ? {
         x: targetT.rect.x + targetT.rect.w - UI.scale(isMute ? 30 : 54), 
         y: targetT.rect.y + UI.scale(10),
     } : {
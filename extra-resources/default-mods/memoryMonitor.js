@@ -5,21 +5,23 @@
  * @category global
  */
 
-const util = require('util');
-const exec = util.promisify(require('child_process').exec)
+const GB = 1000 * 1000 * 1000
 
-Mod.setInterval(async () => {
-    const { stdout, stderr } = await exec(`top -l 1 | grep 'Bitwig'`)
-    const lines = stdout.split('\n').map(line => line.trim().split(/\s+/)).filter(l => l.length > 0)
-    for (const line of lines) {
-        const process = line[1]
-        if (process) {
-            const ram = parseInt(line[7], 10)
-            const GB = `${ram / 1000}GB`
-            log(`${process} using ${GB}`)
-            if (!isNaN(ram) && ram > 16000) {
-                Bitwig.showMessage(`Warning: Currently using ${GB} RAM`)
-            }
+// Sampled natively from the kernel, no need to run top
+Bitwig.setResourceSampling({ interval: 5000, thresholds: { rss: 16 * GB } })
+
+Bitwig.on('resourceThreshold', ({ app, kind, value }) => {
+    if (kind === 'rss') {
+        Bitwig.showMessage(`Warning: ${app} currently using ${(value / GB).toFixed(1)}GB RAM`)
+    }
+})
+
+Mod.setInterval(() => {
+    const history = Bitwig.getResourceHistory()
+    for (const app in history) {
+        const latest = history[app][history[app].length - 1]
+        if (latest) {
+            log(`${app} using ${(latest.rss / GB).toFixed(2)}GB, ${latest.cpu.toFixed(0)}% CPU, ${latest.threads} threads`)
         }
     }
-}, 1000 * 60)
\ No newline at end of file
+}, 1000 * 60)
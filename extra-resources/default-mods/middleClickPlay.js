@@ -101,9 +101,10 @@ function playWithEvent(event) {
     } else {
         const pluginPositions = Bitwig.getPluginWindowsPosition()
         Mod.runAction(`move-plugin-windows-offscreen`, { forceState: 'bottomright' })
-        setTimeout(() => {
+        setTimeout(async () => {
             doTheClick()
-            Bitwig.setPluginWindowsPosition(pluginPositions)
+            // Positions only, the frames also carry w/h and sizes aren't ours to put back
+            await Bitwig.setPluginWindowsPosition(_.mapObject(pluginPositions, ({x, y}) => ({x, y})))
         }, 100)
     }
 }
@@ -5,6 +5,10 @@
  * @category devices
  */
 
+// Frames from getPluginWindowsPosition carry w/h too, which would resize windows back to
+// whatever size they were when the positions were saved
+const onlyPositions = windows => _.mapObject(windows, ({x, y}) => ({x, y}))
+
 const repositionLabels = () => {
     Popup.closeAll()
     const positions = Object.values(Bitwig.getPluginWindowsPosition())
@@ -82,7 +86,7 @@ Mod.registerAction({
             }
         })
 
-        Bitwig.setPluginWindowsPosition(_.indexBy(offscreenPositions, 'id'))
+        await Bitwig.setPluginWindowsPosition(_.indexBy(offscreenPositions, 'id'))
         Popup.closeAll()
     }
 })
@@ -100,7 +104,7 @@ Mod.registerAction({
         if (!positions) {
             return Bitwig.showMessage('No position data saved')
         } 
-        Bitwig.setPluginWindowsPosition(positions)
+        await Bitwig.setPluginWindowsPosition(onlyPositions(positions))
         Db.setCurrentTrackData({
             positions,
             state: 'onscreen'
@@ -117,7 +121,7 @@ Mod.registerAction({
     defaultSetting: {
         keys: ["F2"]
     },
-    action: () => {        
+    action: async () => {
         const pluginWindows = Object.values(Bitwig.getPluginWindowsPosition()).sort((a, b) => a.id < b.id ? -1 : 1)
         if (pluginWindows.length === 0) {
             return
@@ -173,7 +177,7 @@ Mod.registerAction({
             }
         }
 
-        Bitwig.setPluginWindowsPosition(finalPositions)
+        await Bitwig.setPluginWindowsPosition(finalPositions)
         Db.setCurrentTrackData({
             positions: finalPositions,
             state: 'onscreen'
@@ -200,18 +204,19 @@ Mouse.on('mousedown', event => {
     }
 })
 
-Mouse.on('mouseup', event => {
-    if (draggingWindowId) {
-        let pos = initialPositions[draggingWindowId]
-        initialPositions[draggingWindowId] = {
-            ...pos,
-            x: pos.x + event.x - downEvent.x,
-            y: pos.y + event.y - downEvent.y
+Mouse.on('mouseup', async event => {
+    // Only the dragged window moves, the others are where they were (and keep their size)
+    const moved = draggingWindowId ? {
+        [draggingWindowId]: {
+            x: initialPositions[draggingWindowId].x + event.x - downEvent.x,
+            y: initialPositions[draggingWindowId].y + event.y - downEvent.y
         }
-        Bitwig.setPluginWindowsPosition(initialPositions)
-        repositionLabels()
-    }
+    } : null
     downEvent = null
     draggingWindowId = null
     initialPositions = {}
-})
\ No newline at end of file
+    if (moved) {
+        await Bitwig.setPluginWindowsPosition(moved)
+        repositionLabels()
+    }
+})
@@ -1,13 +1,28 @@
 /**
  * @name Remember Device View Scroll
  * @id device-view-scroll
- * @description Return to previous scroll position when switching between tracks. Scroll position is currently tracked by listening for middle click drags on the device view portion of the screen.
+ * @description Return to previous scroll position when switching between tracks. Scroll position is read from the device panel's scrollbar after middle click drags on it.
  * @category devices
  */
 
 let currTrackScroll = 0
 let middleMouseDown = false
-let lastX = 0
+
+const deviceChainRect = () => {
+    const chain = UI.MainWindow.getDeviceChain()
+    return chain ? chain.rect : null
+}
+
+const contains = (rect, { x, y }) => rect && x >= rect.x && x < rect.x + rect.w && y >= rect.y && y < rect.y + rect.h
+
+const readScroll = () => {
+    // Pixels scrolled, from where the scrollbar thumb sits
+    const chain = UI.MainWindow.getDeviceChain()
+    if (!chain || chain.scroll.end <= chain.scroll.start) {
+        return null
+    }
+    return Math.round(chain.scroll.start * chain.rect.w / (chain.scroll.end - chain.scroll.start))
+}
 
 const doScroll = (dX) => {
     Mouse.returnAfter(() => {
@@ -23,26 +38,21 @@ const doScroll = (dX) => {
 }
 
 Mouse.on('mousedown', whenActiveListener(event => {
-    if (event.y >= 1159 && event.x > 170) {
-        if (event.button === 1) {
-            middleMouseDown = true
-            lastX = event.x
-        }
+    if (event.button === 1 && contains(deviceChainRect(), event)) {
+        middleMouseDown = true
     }
 }))
 
 Mouse.on('mouseup', whenActiveListener(event => {
+    if (middleMouseDown) {
+        const scroll = readScroll()
+        if (scroll !== null) {
+            currTrackScroll = scroll
+        }
+    }
     middleMouseDown = false
 }))
 
-// Mouse.on('mousemove', whenActiveListener(event => {
-//     if (middleMouseDown) {
-//         const dX = event.x - lastX
-//         currTrackScroll = Math.max(0, currTrackScroll - dX)
-//         lastX = event.x
-//     }
-// }))
-
 Bitwig.on('selectedTrackChanged', async ( curr, prev ) => {
     if (prev) {
         Db.setTrackData(prev, {scroll: currTrackScroll})
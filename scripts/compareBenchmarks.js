@@ -0,0 +1,64 @@
+#!/usr/bin/env node
+/**
+ * Compares two runs of the native benchmarks, e.g. between releases
+ *
+ *   ./build/Release/bes_bench > before.jsonl
+ *   (checkout, rebuild)
+ *   ./build/Release/bes_bench > after.jsonl
+ *   node ./scripts/compareBenchmarks.js before.jsonl after.jsonl
+ *
+ * Prints the change in ns/op and allocations for every benchmark in both runs, and exits
+ * non-zero if anything got slower by more than THRESHOLD (default 10%) or started allocating
+ * where it didn't before.
+ */
+
+const fs = require('fs')
+
+const THRESHOLD = parseFloat(process.env.THRESHOLD || '0.1')
+
+function load(path) {
+    const results = {}
+    for (const line of fs.readFileSync(path, 'utf8').split('\n')) {
+        if (line.trim().startsWith('{')) {
+            const result = JSON.parse(line)
+            results[result.name] = result
+        }
+    }
+    return results
+}
+
+function main() {
+    const [beforePath, afterPath] = process.argv.slice(2)
+    if (!beforePath || !afterPath) {
+        console.error('Usage: compareBenchmarks.js <before.jsonl> <after.jsonl>')
+        process.exit(2)
+    }
+    const before = load(beforePath)
+    const after = load(afterPath)
+
+    let regressions = 0
+    for (const name in after) {
+        const a = after[name]
+        const b = before[name]
+        if (!b) {
+            console.log(`${name}: new, ${a.nsPerOp.toFixed(1)}ns/op`)
+            continue
+        }
+        const change = (a.nsPerOp - b.nsPerOp) / b.nsPerOp
+        const startedAllocating = b.allocationsPerOp === 0 && a.allocationsPerOp > 0
+        const regressed = change > THRESHOLD || startedAllocating
+        regressions += regressed ? 1 : 0
+        console.log(`${regressed ? 'REGRESSED ' : ''}${name}: ${b.nsPerOp.toFixed(1)} -> ${a.nsPerOp.toFixed(1)}ns/op (${change >= 0 ? '+' : ''}${(change * 100).toFixed(1)}%), ${b.allocationsPerOp.toFixed(1)} -> ${a.allocationsPerOp.toFixed(1)} allocs/op`)
+    }
+    for (const name in before) {
+        if (!after[name]) {
+            console.log(`${name}: missing from ${afterPath}`)
+        }
+    }
+    if (regressions) {
+        console.log(`${regressions} regression(s) over ${(THRESHOLD * 100).toFixed(0)}%`)
+        process.exitCode = 1
+    }
+}
+
+main()
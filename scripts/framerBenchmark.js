@@ -0,0 +1,121 @@
+#!/usr/bin/env node
+/**
+ * Throughput of the controller script packet framing, old string based JS vs the native
+ * PacketFramer, e.g.
+ *
+ *   npm run rebuildc && node ./scripts/framerBenchmark.js
+ *
+ * A local TCP server stands in for the controller script, writing length prefixed packets
+ * the way it does (a mix of small status packets and large track lists). Both framers read
+ * the same stream over the socket, and the type/id of each packet is checked against what
+ * was sent.
+ */
+
+const net = require('net')
+
+const PACKETS = parseInt(process.env.PACKETS || '20000', 10)
+const TRACKS = parseInt(process.env.TRACKS || '200', 10)
+
+function makePackets() {
+    const tracks = []
+    for (let i = 0; i < TRACKS; i++) {
+        tracks.push({ name: `Track ${i} – ünïcode`, color: '#ff8800', selected: i === 3, volume: 0.5, type: 'Instrument' })
+    }
+    const packets = []
+    for (let i = 0; i < PACKETS; i++) {
+        packets.push(i % 20 === 0
+            ? JSON.stringify({ type: 'tracks', id: `internal${i}`, data: tracks })
+            : JSON.stringify({ type: 'transport/position', data: { position: i / 4, nested: { type: 'ignored' } } }))
+    }
+    return packets
+}
+
+function startStandin(packets) {
+    // Lengths are JS string lengths, bodies UTF-8, same as the controller script
+    const stream = Buffer.from(packets.map(str => str.length + str).join(''), 'utf8')
+    const server = net.createServer(socket => {
+        socket.end(stream)
+    })
+    return new Promise(res => server.listen(0, '127.0.0.1', () => res({ server, bytes: stream.length })))
+}
+
+/**
+ * What WebsocketToSocket.ts did before the native framer
+ */
+function makeJSFramer(onPacket) {
+    let waiting = 0
+    let partialMsg = ''
+    return data => {
+        let leftToParse = data.toString()
+        while (leftToParse.length > 0) {
+            if (waiting === 0) {
+                waiting = parseInt(leftToParse, 10)
+                partialMsg = ''
+                leftToParse = leftToParse.substr(String(waiting).length)
+            }
+            let thisTime = leftToParse.substr(0, waiting)
+            leftToParse = leftToParse.substr(waiting)
+            partialMsg += thisTime
+            waiting -= thisTime.length
+            if (waiting === 0) {
+                // Decoding each chunk on its own splits characters that straddle chunks,
+                // which shows up here as a packet that won't parse
+                let packet = {}
+                try {
+                    packet = JSON.parse(partialMsg)
+                } catch (e) {}
+                onPacket(packet.type, packet.id)
+                partialMsg = ''
+            }
+        }
+    }
+}
+
+function makeNativeFramer(onPacket) {
+    const { Bitwig } = require('bindings')('bes')
+    const framer = new Bitwig.PacketFramer()
+    return data => {
+        for (const frame of framer.push(data)) {
+            onPacket(frame.type, frame.id)
+        }
+    }
+}
+
+function run(label, port, bytes, packets, makeFramer) {
+    return new Promise(res => {
+        let received = 0
+        let mismatched = 0
+        const push = makeFramer((type, id) => {
+            const expected = packets[received++]
+            if (!expected.startsWith(`{"type":"${type}"`) || (id && !expected.includes(`"id":"${id}"`))) {
+                mismatched++
+            }
+        })
+        const start = process.hrtime.bigint()
+        const socket = net.connect(port, '127.0.0.1')
+        socket.on('data', push)
+        socket.on('end', () => {
+            const ms = Number(process.hrtime.bigint() - start) / 1e6
+            const mbPerS = bytes / 1e6 / (ms / 1000)
+            console.log(`${label}: ${received} packets in ${ms.toFixed(1)}ms, ${mbPerS.toFixed(1)}MB/s${mismatched || received !== packets.length ? ` (${mismatched} mismatched, expected ${packets.length})` : ''}`)
+            if (label === 'native' && (mismatched || received !== packets.length)) {
+                process.exitCode = 1
+            }
+            res()
+        })
+    })
+}
+
+async function main() {
+    const packets = makePackets()
+    const { server, bytes } = await startStandin(packets)
+    const { port } = server.address()
+    console.log(`${PACKETS} packets, ${(bytes / 1e6).toFixed(1)}MB`)
+    for (let i = 0; i < 3; i++) {
+        await run('js', port, bytes, packets, makeJSFramer)
+        await run('native', port, bytes, packets, makeNativeFramer)
+    }
+    server.close()
+}
+
+main()
@@ -0,0 +1,174 @@
+#!/usr/bin/env node
+/**
+ * Runs the native addon against the stand-in Bitwig window on a headless X server:
+ * 
+ *   npm run test:standin
+ * 
+ * Needs Xvfb on the PATH. Exercises layout detection, input synthesis/listening and plugin
+ * window handling, then prints timings for the detection calls. Exits non-zero if any check
+ * fails, anything throws or it doesn't finish within STANDIN_TIMEOUT ms.
+ */
+
+const { spawn } = require('child_process')
+const path = require('path')
+const readline = require('readline')
+
+const DISPLAY = process.env.STANDIN_DISPLAY || ':99'
+const ITERATIONS = parseInt(process.env.ITERATIONS || '200', 10)
+const TIMEOUT = parseInt(process.env.STANDIN_TIMEOUT || '60000', 10)
+const standinPath = path.join(__dirname, '../build/Release/bes_standin')
+
+const wait = ms => new Promise(res => setTimeout(res, ms))
+
+function startStandin(args) {
+    const proc = spawn(standinPath, args, { stdio: ['pipe', 'pipe', 'inherit'], env: { ...process.env, DISPLAY } })
+    const lines = readline.createInterface({ input: proc.stdout })
+    const waiting = []
+    lines.on('line', () => waiting.length && waiting.shift()())
+    proc.command = (command) => new Promise(res => {
+        waiting.push(res)
+        proc.stdin.write(command + '\n')
+    })
+    return proc
+}
+
+function time(label, fn) {
+    const start = process.hrtime.bigint()
+    for (let i = 0; i < ITERATIONS; i++) {
+        fn()
+    }
+    const perOp = Number(process.hrtime.bigint() - start) / ITERATIONS / 1000
+    console.log(`${label}: ${perOp.toFixed(1)}us/op`)
+}
+
+let checks = 0
+let failures = 0
+
+function check(label, condition) {
+    console.log(`${condition ? 'ok' : 'FAILED'} - ${label}`)
+    checks++
+    if (!condition) {
+        failures++
+    }
+}
+
+function fail(message) {
+    console.log(`FAILED - ${message}`)
+    process.exit(1)
+}
+
+async function main() {
+    setTimeout(() => fail(`timed out after ${TIMEOUT}ms`), TIMEOUT).unref()
+    const xvfb = spawn('Xvfb', [DISPLAY, '-screen', '0', '1920x1200x24', '-nolisten', 'tcp'], { stdio: 'inherit' })
+    xvfb.on('error', error => fail(`couldn't start Xvfb: ${error.message}`))
+    await wait(500)
+    process.env.DISPLAY = DISPLAY
+
+    const standin = startStandin(['--width', '1600', '--height', '1000', '--tracks', '10', '--plugins', '2'])
+    standin.on('error', error => fail(`couldn't start ${standinPath}: ${error.message}`))
+    let quitting = false
+    standin.on('exit', code => !quitting && fail(`bes_standin exited early (${code})`))
+    await wait(500)
+
+    const { UI, Mouse, Keyboard, Bitwig, Stats } = require('bindings')('bes')
+    const mainWindow = new UI.BitwigWindow({})
+    UI.updateUILayoutInfo({ scale: 1, isLargeTrackHeight: true })
+
+    try {
+        await standin.command('select 2')
+        UI.invalidateLayout()
+        let layout = mainWindow.getLayoutState()
+        check('inspector detected', !!layout.inspector)
+        check('no editor panel', !layout.editor)
+        const tracks = mainWindow._getArrangerTracks()
+        check('10 tracks detected', tracks && tracks.length === 10)
+        check('third track selected', tracks && tracks[2].selected)
+
+        await standin.command('panel device')
+        UI.invalidateLayout()
+        layout = mainWindow.getLayoutState()
+        check('device panel detected', layout.editor && layout.editor.type === 'device')
+
+        const plugins = Bitwig.getPluginWindowsPosition()
+        check('plugin windows found', Object.keys(plugins).length === 2)
+
+        // Stand-in plugin windows cascade, so the top left corner of the first only overlaps itself
+        const target = Object.values(plugins).sort((a, b) => a.x - b.x)[0]
+        const clearStart = process.hrtime.bigint()
+        const moved = await Bitwig.clearPluginWindowsFrom({ x: target.x + 1, y: target.y + 1 })
+        const clearMs = Number(process.hrtime.bigint() - clearStart) / 1e6
+        // No waiting for ConfigureNotify, confirmed moves go straight into the cache
+        const afterClear = Bitwig.getPluginWindowsPosition()
+        check('only the overlapping plugin window moved', moved.length === 1 && afterClear[moved[0].id].x !== target.x)
+        const restored = await Bitwig.restorePluginWindows(moved)
+        check('restore reports the window applied', restored[moved[0].windowId] === 'applied')
+        await wait(50)
+        check('plugin window restored', Bitwig.getPluginWindowsPosition()[moved[0].id].x === target.x)
+        const unchanged = await Bitwig.setPluginWindowsPosition(Bitwig.getPluginWindowsPosition())
+        check('unchanged windows are skipped', Object.values(unchanged).every(status => status === 'unchanged'))
+        console.log(`clearPluginWindowsFrom: ${clearMs.toFixed(2)}ms`)
+        check('getPluginWindowAt finds the window', Bitwig.getPluginWindowAt(target.x + 1, target.y + 1).id === target.id)
+        time('getPluginWindowAt', () => Bitwig.getPluginWindowAt(target.x + 1, target.y + 1))
+
+        const activeChanges = []
+        const activeListener = Bitwig.on('activeAppChanged', change => activeChanges.push(change))
+        check('main window active', Bitwig.isActiveApplication('Bitwig Studio'))
+        await standin.command('activate plugin 1')
+        await wait(20)
+        check('plugin window active', Bitwig.isPluginWindowActive() && !Bitwig.isActiveApplication('Bitwig Studio'))
+        await standin.command('activate main')
+        await wait(20)
+        check('activeAppChanged events received', activeChanges.length === 2 && activeChanges[1].app === 'Bitwig Studio')
+        Bitwig.off(activeListener)
+        time('isActiveApplication', () => Bitwig.isActiveApplication('Bitwig Studio'))
+
+        const received = []
+        Keyboard.on('mousedown', event => received.push(event))
+        Mouse.click(0, { x: 400, y: 300 })
+        Mouse.click(0, { x: 410, y: 310, modwigListeners: true })
+        await wait(200)
+        check('own events skipped, modwigListeners events received', received.length === 1 && received[0].x === 410)
+
+        const steps = []
+        for (let i = 0; i < 20; i++) {
+            steps.push({ type: 'move', x: 300 + i * 5, y: 300, after: 5 })
+        }
+        const blockedStart = process.hrtime.bigint()
+        const sequenceDone = Mouse.sequence(steps)
+        const blockedUs = Number(process.hrtime.bigint() - blockedStart) / 1000
+        const timings = await sequenceDone
+        const gaps = timings.slice(1).map((t, i) => t - timings[i])
+        const jitter = Math.max(...gaps.map(gap => Math.abs(gap - 5)))
+        check('sequence posts every step', timings.length === steps.length)
+        console.log(`sequence: ${blockedUs.toFixed(1)}us on the JS thread, max gap jitter ${(jitter * 1000).toFixed(0)}us`)
+
+        Stats.reset()
+        Stats.startTrace()
+        time('getLayoutState', () => {
+            UI.invalidateLayout()
+            mainWindow.getLayoutState()
+        })
+        time('getArrangerTracks', () => mainWindow._getArrangerTracks())
+        time('pixelColorAt', () => mainWindow.pixelColorAt({ x: 10, y: 10 }))
+        const tracePath = path.join(require('os').tmpdir(), 'bes-standin-trace.json')
+        const trace = Stats.stopTrace(tracePath)
+        check('trace written', trace.written && trace.events > 0)
+        console.log(`trace: ${trace.events} events in ${tracePath}`)
+        const { histograms, counters } = Stats.snapshot()
+        for (const name of ['capture.time', 'detect.layout.time', 'detect.tracks.time', 'napi.tracks.time']) {
+            const h = histograms[name]
+            console.log(`${name}: ${h.count} samples, mean ${(h.mean / 1000).toFixed(1)}us, p99 < ${(h.p99 / 1000).toFixed(1)}us`)
+        }
+        check('no capture failures', !counters['capture.failures'])
+    } catch (error) {
+        check(`no exceptions (${error.stack})`, false)
+    } finally {
+        quitting = true
+        await standin.command('quit')
+        xvfb.kill()
+        console.log(`${checks} checks, ${failures} failed`)
+        process.exit(failures === 0 && checks > 0 ? 0 : 1)
+    }
+}
+
+main().catch(error => fail(error.stack))
@@ -0,0 +1,61 @@
+#include "activeapp.h"
+#include "nativeevents.h"
+#include <algorithm>
+
+ActiveAppTracker::ActiveAppTracker() : active(std::make_shared<const std::string>("")) {}
+
+std::string ActiveAppTracker::getActive() {
+    return *std::atomic_load(&active);
+}
+
+void ActiveAppTracker::activated(const std::string& app) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    auto previous = std::atomic_load(&active);
+    if (*previous == app) {
+        return;
+    }
+    std::atomic_store(&active, std::make_shared<const std::string>(app));
+    for (auto& pair : listeners) {
+        pair.second(app, *previous);
+    }
+}
+
+void ActiveAppTracker::deactivated(const std::string& app) {
+    if (getActive() == app) {
+        activated("");
+    }
+}
+
+int ActiveAppTracker::addListener(Listener listener) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    int id = nextListenerId++;
+    listeners.push_back({id, listener});
+    return id;
+}
+
+void ActiveAppTracker::removeListener(int id) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [=](const std::pair<int, Listener>& pair) {
+        return pair.first == id;
+    }), listeners.end());
+}
+
+ActiveAppTracker& getActiveAppTracker() {
+    static ActiveAppTracker tracker;
+    return tracker;
+}
+
+void addActiveAppFunctions(Napi::Env env, Napi::Object obj) {
+    registerNativeEventType("activeAppChanged", watchActiveApps);
+    getActiveAppTracker().addListener([](const std::string& app, const std::string& previous) {
+        if (!hasNativeEventListeners("activeAppChanged")) {
+            return;
+        }
+        emitNativeEvent("activeAppChanged", [=](Napi::Env env) -> Napi::Value {
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set(Napi::String::New(env, "app"), Napi::String::New(env, app));
+            obj.Set(Napi::String::New(env, "previous"), Napi::String::New(env, previous));
+            return obj;
+        });
+    });
+}
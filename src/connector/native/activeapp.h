@@ -0,0 +1,43 @@
+#pragma once
+#include <napi.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Frontmost application as last reported by the platform watcher in bitwig.cc (activation
+ * notifications on macOS, _NET_ACTIVE_WINDOW on X11). Reads are a pointer load.
+ */
+class ActiveAppTracker {
+public:
+    typedef std::function<void(const std::string& app, const std::string& previous)> Listener;
+private:
+    // "" when something we don't watch is active
+    std::shared_ptr<const std::string> active;
+    std::mutex writeMutex;
+    std::vector<std::pair<int, Listener>> listeners;
+    int nextListenerId = 0;
+public:
+    ActiveAppTracker();
+    std::string getActive();
+    void activated(const std::string& app);
+    // Only clears if app was the active one, as notifications can arrive out of order
+    void deactivated(const std::string& app);
+    int addListener(Listener listener);
+    void removeListener(int id);
+};
+
+ActiveAppTracker& getActiveAppTracker();
+
+/**
+ * Defined per platform in bitwig.cc, starts watching the Bitwig processes if they're running
+ */
+void watchActiveApps();
+
+/**
+ * Raises 'activeAppChanged' ({app, previous}) through Bitwig.on, see nativeevents.h
+ */
+void addActiveAppFunctions(Napi::Env env, Napi::Object obj);
@@ -0,0 +1,159 @@
+#include "activity.h"
+#include "capture.h"
+#include "meteractivity.h"
+#include "metrics.h"
+#include "mixerstrips.h"
+#include "nativeevents.h"
+#include "windowlist.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+std::mutex activityMutex;
+std::condition_variable activityCondition;
+bool activityThreadStarted = false;
+bool activityEnabled = false;
+// Bumped each time sampling starts or stops, so a tick in flight doesn't record into new state
+uint64_t activityGeneration = 0;
+NativeWindowId activityWindowId = 0;
+MWRect activityFrameSize{0, 0, 0, 0};
+std::vector<int32_t> activityMeters;
+MWRect activityBounds{0, 0, 0, 0};
+ActivityOptions activityOptions;
+MeterActivity meterActivity;
+
+void emitActivity(NativeWindowId windowId, const std::vector<ActivityChange>& changes) {
+    static auto& eventCount = metricCounter("activity.events");
+    eventCount.add();
+    double time = std::chrono::duration<double, std::milli>(std::chrono::system_clock::now().time_since_epoch()).count();
+    emitNativeEvent("activity", [=](Napi::Env env) -> Napi::Value {
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set(Napi::String::New(env, "windowId"), Napi::Number::New(env, (double)windowId));
+        obj.Set(Napi::String::New(env, "time"), Napi::Number::New(env, time));
+        auto arr = Napi::Array::New(env, changes.size());
+        for (size_t i = 0; i < changes.size(); i++) {
+            Napi::Object change = Napi::Object::New(env);
+            change.Set(Napi::String::New(env, "strip"), Napi::Number::New(env, changes[i].strip));
+            change.Set(Napi::String::New(env, "active"), Napi::Boolean::New(env, changes[i].active));
+            change.Set(Napi::String::New(env, "level"), Napi::Number::New(env, changes[i].level));
+            arr.Set(i, change);
+        }
+        obj.Set(Napi::String::New(env, "changes"), arr);
+        return obj;
+    });
+}
+
+void ensureActivityThread() {
+    if (activityThreadStarted) {
+        return;
+    }
+    activityThreadStarted = true;
+    std::thread([]() {
+        static auto& captureTime = metricHistogram("activity.capture.time");
+        static auto& captureBytes = metricHistogram("activity.capture.bytes");
+        static auto& skippedTicks = metricCounter("activity.ticks.skipped");
+        static auto& metersGone = metricCounter("activity.ticks.metersGone");
+        std::vector<int32_t> meters;
+        std::vector<float> levels;
+        auto nextTick = std::chrono::steady_clock::now();
+        while (true) {
+            std::unique_lock<std::mutex> lock(activityMutex);
+            activityCondition.wait(lock, [] { return activityEnabled; });
+            auto generation = activityGeneration;
+            auto windowId = activityWindowId;
+            auto frameSize = activityFrameSize;
+            auto bounds = activityBounds;
+            auto interval = std::chrono::microseconds(1000000 / activityOptions.rate);
+            meters = activityMeters;
+            lock.unlock();
+
+            // Capturing happens outside the lock, so getActivityHistory never waits on the window server
+            bool sampled = false;
+            auto window = getWindowList()->find(windowId);
+            if (window != nullptr && window->frame.w == frameSize.w && window->frame.h == frameSize.h) {
+                std::unique_ptr<ImageDeets> image;
+                {
+                    MetricTimer timer(captureTime);
+                    image.reset(captureWindowRegion(WindowInfo{windowId, window->frame}, bounds));
+                }
+                if (image != nullptr) {
+                    captureBytes.record(image->bytesPerRow * image->height);
+                    // Same size but the mixer closed or covered, whatever is there now isn't levels
+                    sampled = sampleMeters(image.get(), XYPoint{bounds.x, bounds.y}, meters, levels);
+                    if (!sampled) {
+                        metersGone.add();
+                    }
+                }
+            }
+            if (!sampled) {
+                skippedTicks.add();
+            }
+
+            std::vector<ActivityChange> changes;
+            lock.lock();
+            if (sampled && generation == activityGeneration) {
+                meterActivity.record(levels, changes);
+            }
+            if (changes.size() > 0) {
+                lock.unlock();
+                emitActivity(windowId, changes);
+                lock.lock();
+            }
+            // Fall behind rather than catch up with a burst of ticks
+            nextTick = std::max(nextTick + interval, std::chrono::steady_clock::now());
+            // Woken early when sampling is set again
+            activityCondition.wait_until(lock, nextTick, [generation] { return generation != activityGeneration; });
+        }
+    }).detach();
+}
+
+void startActivitySampling(NativeWindowId windowId, MWRect frameSize, const std::vector<int32_t>& meters, ActivityOptions options) {
+    {
+        std::lock_guard<std::mutex> lock(activityMutex);
+        // More often than the screen refreshes would only read the same frame again
+        options.rate = std::max(1, std::min(120, options.rate));
+        options.capacity = std::max((size_t)1, options.capacity);
+        activityOptions = options;
+        activityWindowId = windowId;
+        activityFrameSize = frameSize;
+        activityMeters = meters;
+        activityBounds = meterBounds(meters);
+        meterActivity.reset(meters.size() / 4, options.threshold, options.capacity);
+        activityEnabled = activityBounds.w > 0;
+        activityGeneration++;
+        ensureActivityThread();
+    }
+    activityCondition.notify_one();
+}
+
+void stopActivitySampling() {
+    {
+        std::lock_guard<std::mutex> lock(activityMutex);
+        activityEnabled = false;
+        activityGeneration++;
+    }
+    activityCondition.notify_one();
+}
+
+ActivityHistory getActivityHistory() {
+    std::lock_guard<std::mutex> lock(activityMutex);
+    ActivityHistory history;
+    if (!activityEnabled) {
+        return history;
+    }
+    history.windowId = activityWindowId;
+    history.rate = activityOptions.rate;
+    for (size_t i = 0; i < meterActivity.stripCount(); i++) {
+        history.levels.push_back(meterActivity.history(i));
+        history.active.push_back(meterActivity.isActive(i));
+    }
+    return history;
+}
+
+void registerActivityEvents() {
+    registerNativeEventType("activity");
+}
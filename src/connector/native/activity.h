@@ -0,0 +1,39 @@
+#pragma once
+#include "detect.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Samples one window's mixer meters on a background thread. Each tick captures only the meters'
+ * bounds and reads one column per meter (see readMeterLevels), keeping the last capacity levels
+ * of each strip. A strip whose level over the last few ticks goes over threshold, or back under
+ * half of it, raises 'activity' through Bitwig.on. Every crossing from one tick goes in a single
+ * event:
+ *
+ *   { windowId, time, changes: [{ strip, active, level }] }
+ *
+ * Geometry is fixed when sampling starts, ticks are skipped while the window is a different size
+ * or the meters aren't showing (the mixer closed or covered), see sampleMeters.
+ * Exposed as UI.MainWindow.setActivitySampling and getActivityHistory in ui.cc
+ */
+struct ActivityOptions {
+    int rate = 30; // Per second
+    float threshold = 0.05;
+    size_t capacity = 64;
+};
+
+struct ActivityHistory {
+    NativeWindowId windowId = 0;
+    int rate = 0;
+    // Per strip, oldest first
+    std::vector<std::vector<float>> levels;
+    std::vector<bool> active;
+};
+
+/**
+ * frameSize is the window's size when meters were found
+ */
+void startActivitySampling(NativeWindowId windowId, MWRect frameSize, const std::vector<int32_t>& meters, ActivityOptions options);
+void stopActivitySampling();
+ActivityHistory getActivityHistory();
+void registerActivityEvents();
@@ -0,0 +1,833 @@
+#include "../detect.h"
+#include "../clips.h"
+#include "../headercontrols.h"
+#include "../devicechain.h"
+#include "../footerpanels.h"
+#include "../mixerstrips.h"
+#include "../detectgraph.h"
+#include "../ruler.h"
+#include "../framer.h"
+#include "../framerecording.h"
+#include "../standin/layout.h"
+#include "../linux/keymap.h"
+#include "../linux/eventsource.h"
+#include <X11/keysym.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Native benchmarks for the detection and input pipelines, no Node or display needed:
+ *
+ *   npm run buildc && ./build/Release/bes_bench > before.jsonl
+ *   node ./scripts/compareBenchmarks.js before.jsonl after.jsonl
+ *
+ * Frames come from bench/fixtures.txt, painted the same way the Xvfb stand-in paints its
+ * window, and what's detected in each is checked against what was painted. Any mismatch is
+ * printed to stderr and the exit status is 1. Input events are a fixed synthetic stream.
+ * Prints one JSON object per line:
+ *
+ *   {"name", "iterations", "nsPerOp", "bytesAllocatedPerOp", "allocationsPerOp", "throughput", "throughputUnit"}
+ *
+ * Options: --fixtures <path>, --profiles <layout profiles path>, --filter <substring>,
+ * --min-time <ms per benchmark>, --replay <recording> [--replay-scale <UI scale>] to bench
+ * a session recorded with BitwigWindow.startRecording instead of the fixtures
+ */
+
+// Every allocation in the process goes through here, benchmarks read the difference
+std::atomic<size_t> allocatedBytes(0);
+std::atomic<size_t> allocationCount(0);
+
+// Every form of new and delete is replaced so the pairs match (GCC warns about a malloc'd
+// pointer reaching a delete it can't see was replaced too)
+void* countedAllocation(size_t size) {
+    allocatedBytes += size;
+    allocationCount++;
+    void* ptr = malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+void* countedAllocation(size_t size, std::align_val_t alignment) {
+    allocatedBytes += size;
+    allocationCount++;
+    // aligned_alloc wants the size to be a multiple of the alignment
+    size_t align = (size_t)alignment;
+    void* ptr = aligned_alloc(align, (std::max(size, (size_t)1) + align - 1) / align * align);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new(size_t size) {
+    return countedAllocation(size);
+}
+void* operator new[](size_t size) {
+    return countedAllocation(size);
+}
+void* operator new(size_t size, std::align_val_t alignment) {
+    return countedAllocation(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return countedAllocation(size, alignment);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAllocation(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return countedAllocation(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    free(ptr);
+}
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept {
+    free(ptr);
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+
+// Results are folded into this so the work can't be optimised away
+volatile size_t sink = 0;
+
+struct BenchOptions {
+    std::string fixturesPath = "src/connector/native/bench/fixtures.txt";
+    std::string profilesPath = "extra-resources/layout-profiles.txt";
+    std::string filter = "";
+    double minTimeMs = 200;
+    std::string replayPath = "";
+    float replayScale = 1;
+};
+BenchOptions options;
+
+/**
+ * Runs op in growing batches until a batch takes minTimeMs, then reports that batch.
+ * unitsPerOp is how much work one op does in throughputUnit (pixels, bytes, events...)
+ */
+void bench(const std::string& name, double unitsPerOp, const std::string& throughputUnit, std::function<void()> op) {
+    if (options.filter != "" && name.find(options.filter) == std::string::npos) {
+        return;
+    }
+    // Warm up, first calls initialise lazily built tables
+    op();
+
+    size_t iterations = 1;
+    while (true) {
+        size_t bytesBefore = allocatedBytes, countBefore = allocationCount;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++) {
+            op();
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (ns >= options.minTimeMs * 1e6 || iterations >= ((size_t)1 << 40)) {
+            double nsPerOp = ns / iterations;
+            std::cout << "{\"name\":\"" << name << "\""
+                << ",\"iterations\":" << iterations
+                << ",\"nsPerOp\":" << nsPerOp
+                << ",\"bytesAllocatedPerOp\":" << (double)(allocatedBytes - bytesBefore) / iterations
+                << ",\"allocationsPerOp\":" << (double)(allocationCount - countBefore) / iterations
+                << ",\"throughput\":" << unitsPerOp / (nsPerOp / 1e9)
+                << ",\"throughputUnit\":\"" << throughputUnit << "/s\"}" << std::endl;
+            return;
+        }
+        // Aim a little past the target so we usually finish on the next batch
+        double perOp = std::max(ns / iterations, 1.0);
+        iterations = std::max(iterations * 2, (size_t)(options.minTimeMs * 1e6 * 1.2 / perOp));
+    }
+}
+
+/**
+ * Frame fixtures
+ */
+struct FrameFixture {
+    std::string name;
+    StandinLayout layout;
+    std::vector<uint8_t> pixels;
+    size_t bytesPerRow;
+};
+
+std::vector<int> parseIndices(const std::string& list) {
+    std::vector<int> indices;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        indices.push_back(atoi(item.c_str()));
+    }
+    return indices;
+}
+
+bool parseFixture(const std::string& line, FrameFixture& fixture) {
+    std::stringstream stream(line);
+    if (!(stream >> fixture.name) || fixture.name[0] == '#') {
+        return false;
+    }
+    auto& layout = fixture.layout;
+    int trackCount = 8, trackHeight = 45, selected = -1, lanes = 1, clips = 0;
+    std::vector<int> automation, muted, soloed, armed, groups, folded, collapsedDevices;
+    int selectedDevice = -1, selectedStrip = -1;
+    std::string setting;
+    while (stream >> setting) {
+        auto eq = setting.find('=');
+        auto key = setting.substr(0, eq);
+        auto value = eq == std::string::npos ? "" : setting.substr(eq + 1);
+        if (key == "width") layout.width = atoi(value.c_str());
+        else if (key == "height") layout.height = atoi(value.c_str());
+        else if (key == "scale") layout.scale = atof(value.c_str());
+        else if (key == "tracks") trackCount = atoi(value.c_str());
+        else if (key == "trackHeight") trackHeight = atoi(value.c_str());
+        else if (key == "select") selected = atoi(value.c_str());
+        else if (key == "automation") automation = parseIndices(value);
+        else if (key == "lanes") lanes = atoi(value.c_str());
+        else if (key == "scroll") layout.scroll = atoi(value.c_str());
+        else if (key == "clips") clips = atoi(value.c_str());
+        else if (key == "muted") muted = parseIndices(value);
+        else if (key == "soloed") soloed = parseIndices(value);
+        else if (key == "armed") armed = parseIndices(value);
+        else if (key == "groups") groups = parseIndices(value);
+        else if (key == "folded") folded = parseIndices(value);
+        else if (key == "devices") layout.devices = makeStandinDevices(atoi(value.c_str()));
+        else if (key == "collapsed") collapsedDevices = parseIndices(value);
+        else if (key == "selectDevice") selectedDevice = atoi(value.c_str());
+        else if (key == "deviceScroll") layout.deviceScroll = atoi(value.c_str());
+        else if (key == "strips") layout.strips = makeStandinStrips(atoi(value.c_str()));
+        else if (key == "stripWidth") layout.stripWidth = atoi(value.c_str());
+        else if (key == "selectStrip") selectedStrip = atoi(value.c_str());
+        else if (key == "barWidth") layout.barWidth = atoi(value.c_str());
+        else if (key == "timelineScroll") layout.timelineScroll = atoi(value.c_str());
+        else if (key == "playhead") layout.playhead = atoi(value.c_str());
+        else if (key == "selection") {
+            auto bounds = parseIndices(value);
+            layout.selectionStart = bounds.size() == 2 ? bounds[0] : -1;
+            layout.selectionEnd = bounds.size() == 2 ? bounds[1] : -1;
+        }
+        else if (key == "panel") layout.panel = value;
+        else if (key == "panelHeight") layout.panelHeight = atoi(value.c_str());
+        else if (key == "inspector") layout.inspectorOpen = value == "on";
+        else if (key == "modal") layout.modalOpen = value == "on";
+        else std::cerr << "Unknown fixture setting " << key << " in " << fixture.name << std::endl;
+    }
+    layout.tracks.resize(trackCount);
+    for (int i = 0; i < trackCount; i++) {
+        layout.tracks[i].height = trackHeight;
+        layout.tracks[i].selected = i == selected;
+        layout.tracks[i].clips = makeStandinClips(clips, i);
+    }
+    auto setEach = [&](const std::vector<int>& indices, std::function<void(StandinTrack&)> set) {
+        for (auto i : indices) {
+            if (i >= 0 && i < trackCount) {
+                set(layout.tracks[i]);
+            }
+        }
+    };
+    setEach(muted, [](StandinTrack& track) { track.muted = true; });
+    setEach(soloed, [](StandinTrack& track) { track.soloed = true; });
+    setEach(armed, [](StandinTrack& track) { track.armed = true; });
+    setEach(groups, [](StandinTrack& track) { track.group = true; });
+    setEach(folded, [](StandinTrack& track) { track.group = true; track.unfolded = false; });
+    for (auto i : collapsedDevices) {
+        if (i >= 0 && i < (int)layout.devices.size()) {
+            layout.devices[i].collapsed = true;
+        }
+    }
+    if (selectedDevice >= 0 && selectedDevice < (int)layout.devices.size()) {
+        layout.devices[selectedDevice].selected = true;
+    }
+    if (selectedStrip >= 0 && selectedStrip < (int)layout.strips.size()) {
+        layout.strips[selectedStrip].selected = true;
+    }
+    for (auto i : automation) {
+        if (i >= 0 && i < trackCount) {
+            layout.tracks[i].automationOpen = true;
+            layout.tracks[i].automationLanes = lanes;
+            // Same as the stand-in, automation lanes need the room
+            layout.tracks[i].height = std::max(trackHeight, 45 + 60 * lanes);
+        }
+    }
+
+    fixture.bytesPerRow = layout.width * 4;
+    fixture.pixels.assign(fixture.bytesPerRow * layout.height, 0);
+    drawStandinLayout(layout, fixture.pixels.data(), fixture.bytesPerRow);
+    return true;
+}
+
+std::vector<FrameFixture> loadFixtures(const std::string& path) {
+    std::vector<FrameFixture> fixtures;
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Couldn't open fixtures at " << path << ", pass --fixtures" << std::endl;
+        return fixtures;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        FrameFixture fixture;
+        if (parseFixture(line, fixture)) {
+            fixtures.push_back(std::move(fixture));
+        }
+    }
+    return fixtures;
+}
+
+/**
+ * Ground truth: whatever was painted into a fixture has to be what detection finds, timing a
+ * detector that has stopped finding things measures nothing. Returns what didn't match
+ */
+std::vector<std::string> checkFixture(const FrameFixture& fixture, const LayoutProfile& profile) {
+    std::vector<std::string> mismatches;
+    auto expect = [&](bool matched, const std::string& what) {
+        if (!matched) {
+            mismatches.push_back(what);
+        }
+    };
+    auto& layout = fixture.layout;
+    auto painted = standinGeometry(layout);
+    auto frame = MWRect{0, 0, layout.width, layout.height};
+    FrameImage image(fixture.pixels.data(), fixture.bytesPerRow, WindowInfo{0, frame});
+
+    auto detected = detectLayout(&image, profile, frame);
+    expect(detected.modalOpen == layout.modalOpen, "modalOpen");
+    if (layout.modalOpen) {
+        return mismatches;
+    }
+    expect((bool)detected.inspector == layout.inspectorOpen, "inspector");
+    expect(detected.editor ? detected.editor->type == layout.panel : layout.panel == "", "editor panel type");
+    expect(detected.arranger && detected.arranger->rect.x == painted.arranger.x, "arranger");
+    if (!detected.arranger) {
+        return mismatches;
+    }
+
+    // Every track with some part below the ruler, in order
+    std::vector<ArrangerTrack> tracks;
+    detectArrangerTracks(&image, profile, frame, detected, tracks);
+    std::vector<size_t> visible;
+    for (size_t i = 0; i < painted.tracks.size(); i++) {
+        if (painted.tracks[i].y + painted.tracks[i].h > painted.tracksTop) {
+            visible.push_back(i);
+        }
+    }
+    expect(tracks.size() == visible.size(), "track count " + std::to_string(tracks.size()) + " not " + std::to_string(visible.size()));
+    for (size_t i = 0; i < tracks.size() && i < visible.size(); i++) {
+        auto& found = tracks[i];
+        auto& track = layout.tracks[visible[i]];
+        auto& rect = painted.tracks[visible[i]];
+        auto name = "track " + std::to_string(visible[i]) + " ";
+        // Cut off by the ruler or the bottom, and with no header to go by, only what shows
+        auto top = found.header == HEADER_HIDDEN ? painted.tracksTop : rect.y;
+        auto bottom = std::min(rect.y + rect.h, painted.tracksBottom);
+        expect(found.rect.y == top && found.rect.y + found.rect.h == bottom, name + "rect");
+        expect(found.selected == track.selected, name + "selected");
+        expect(found.automationOpen == track.automationOpen, name + "automationOpen");
+        expect(!track.automationOpen || found.automationLanes.size() == (size_t)std::max(1, track.automationLanes), name + "automation lanes");
+        if (found.header == HEADER_VISIBLE) {
+            expect(found.mute && found.mute->on == track.muted, name + "mute");
+            expect(found.solo && found.solo->on == track.soloed, name + "solo");
+            expect(track.group ? !found.arm : found.arm && found.arm->on == track.armed, name + "arm");
+            expect(track.group ? found.fold && found.fold->on == track.unfolded : !found.fold, name + "fold");
+        }
+    }
+
+    if (layout.panel == "device") {
+        MWRect rect;
+        DeviceChain chain;
+        expect(getDeviceChainRect(profile, detected, rect), "device chain rect");
+        detectDeviceChain(&image, profile, rect, chain);
+        size_t devices = 0;
+        for (auto& device : painted.devices) {
+            devices += device.x + device.w > rect.x && device.x < rect.x + rect.w;
+        }
+        expect(chain.deviceCount() == devices, "device count " + std::to_string(chain.deviceCount()) + " not " + std::to_string(devices));
+    }
+    if (layout.panel == "mixer") {
+        MWRect rect;
+        MixerStrips mixer;
+        expect(getMixerRect(profile, detected, rect), "mixer rect");
+        detectMixerStrips(&image, profile, rect, mixer);
+        expect(mixer.stripCount() == painted.strips.size(), "strip count " + std::to_string(mixer.stripCount()) + " not " + std::to_string(painted.strips.size()));
+    }
+    return mismatches;
+}
+
+// False if anything detected in a fixture wasn't what was painted, see checkFixture
+bool benchFrames(std::vector<FrameFixture>& fixtures) {
+    bool matched = true;
+    for (auto& fixture : fixtures) {
+        auto& layout = fixture.layout;
+        auto frame = MWRect{0, 0, layout.width, layout.height};
+        FrameImage image(fixture.pixels.data(), fixture.bytesPerRow, WindowInfo{0, frame});
+        isLargeTrackHeight = true;
+        auto& profile = *findLayoutProfile(layout.scale, uiLayout);
+
+        // Raw pixel reads over a grid, the floor everything else builds on
+        const int stride = 4;
+        double gridPixels = (double)((layout.width + stride - 1) / stride) * ((layout.height + stride - 1) / stride);
+        bench("colorAt/" + fixture.name, gridPixels, "px", [&]() {
+            size_t total = 0;
+            for (int y = 0; y < layout.height; y += stride) {
+                for (int x = 0; x < layout.width; x += stride) {
+                    total += image.colorAt(XYPoint{x, y}).r;
+                }
+            }
+            sink = sink + total;
+        });
+
+        // Full height column scans, like the searches for panel borders and track ends
+        bench("seekUntilColor/" + fixture.name, layout.height, "px", [&]() {
+            auto found = image.seekUntilColor(
+                XYPoint{layout.width / 2, 0},
+                [](MWColor color) { return color.r == 255; },
+                AXIS_Y,
+                DIRECTION_DOWN,
+                1
+            );
+            sink = sink + (found ? found->y : 0);
+        });
+
+        bench("detectLayout/" + fixture.name, 1, "frames", [&]() {
+            auto detected = detectLayout(&image, profile, frame);
+            sink = sink + (detected.arranger ? detected.arranger->rect.h : 0);
+        });
+        FooterPanels panels;
+        bench("footerPanels/" + fixture.name, 1, "frames", [&]() {
+            detectFooterPanels(&image, profile, frame, panels);
+            sink = sink + panels.open;
+        });
+
+        if (!layout.modalOpen) {
+            auto detected = detectLayout(&image, profile, frame);
+            std::vector<ArrangerTrack> tracks;
+            bench("detectArrangerTracks/" + fixture.name, 1, "frames", [&]() {
+                tracks.clear();
+                detectArrangerTracks(&image, profile, frame, detected, tracks);
+                sink = sink + tracks.size();
+            });
+        }
+
+        // Glyph matching on its own, the rest of detectArrangerTracks is column walks
+        if (!layout.modalOpen) {
+            auto detected = detectLayout(&image, profile, frame);
+            std::vector<ArrangerTrack> tracks;
+            detectArrangerTracks(&image, profile, frame, detected, tracks);
+            bench("findHeaderControls/" + fixture.name, tracks.size(), "tracks", [&]() {
+                for (auto& track : tracks) {
+                    track.mute = track.solo = track.arm = track.fold = {};
+                    auto background = image.colorAt(XYPoint{track.rect.x + track.rect.w - 1, track.visibleRect.y + profile.scale(5)});
+                    findHeaderControls(&image, profile, background, track);
+                    sink = sink + (bool)track.mute;
+                }
+            });
+        }
+
+        if (!layout.modalOpen) {
+            auto detected = detectLayout(&image, profile, frame);
+            std::vector<ArrangerTrack> tracks;
+            detectArrangerTracks(&image, profile, frame, detected, tracks);
+            ArrangerClips clips;
+            bench("segmentArrangerClips/" + fixture.name, tracks.size(), "tracks", [&]() {
+                segmentArrangerClips(&image, profile, detected, tracks, clips);
+                sink = sink + clips.rects.size();
+            });
+        }
+
+        // A full ruler read every time, then a playing playhead (only its tiles change)
+        if (!layout.modalOpen) {
+            auto detected = detectLayout(&image, profile, frame);
+            auto timelineStartX = detected.arranger->rect.x + detectTrackWidth(&image, profile, frame, (bool)detected.inspector) + profile.scale(2);
+            RulerTracker tracker;
+            bench("ruler/full/" + fixture.name, 1, "frames", [&]() {
+                tracker.reset();
+                sink = sink + tracker.update(&image, profile, detected, timelineStartX).ticks.size();
+            });
+
+            auto moved = layout;
+            moved.playhead = layout.playhead == -1 ? 0 : layout.playhead + 37;
+            std::vector<uint8_t> movedPixels(fixture.pixels.size());
+            drawStandinLayout(moved, movedPixels.data(), fixture.bytesPerRow);
+            FrameImage movedImage(movedPixels.data(), fixture.bytesPerRow, WindowInfo{0, frame});
+            bool flip = false;
+            bench("ruler/playhead/" + fixture.name, 1, "frames", [&]() {
+                flip = !flip;
+                sink = sink + tracker.update(flip ? &movedImage : &image, profile, detected, timelineStartX).playheadX;
+            });
+        }
+
+        // The device panel read from scratch, then again with nothing changed
+        MWRect chainRect;
+        auto detectedLayout = detectLayout(&image, profile, frame);
+        if (getDeviceChainRect(profile, detectedLayout, chainRect)) {
+            DeviceChain chain;
+            bench("deviceChain/detect/" + fixture.name, 1, "frames", [&]() {
+                detectDeviceChain(&image, profile, chainRect, chain);
+                sink = sink + chain.deviceCount();
+            });
+            DeviceChainCache cache;
+            cache.update(&image, profile, detectedLayout);
+            bench("deviceChain/cached/" + fixture.name, 1, "frames", [&]() {
+                sink = sink + cache.update(&image, profile, detectedLayout)->deviceCount();
+            });
+        }
+
+        MWRect mixerRect;
+        if (getMixerRect(profile, detectedLayout, mixerRect)) {
+            MixerStrips mixer;
+            detectMixerStrips(&image, profile, mixerRect, mixer);
+            bench("mixerStrips/" + fixture.name, std::max<size_t>(1, mixer.stripCount()), "strips", [&]() {
+                detectMixerStrips(&image, profile, mixerRect, mixer);
+                sink = sink + mixer.stripCount();
+            });
+            // What the activity sampler does each tick once it has the region
+            std::vector<float> levels;
+            bench("meterLevels/" + fixture.name, std::max<size_t>(1, mixer.stripCount()), "strips", [&]() {
+                readMeterLevels(&image, XYPoint{0, 0}, mixer.meters, levels);
+                sink = sink + levels.size();
+            });
+        }
+
+        // Layout and tracks together
+        bench("detectUISnapshot/" + fixture.name, 1, "frames", [&]() {
+            auto snapshot = detectUISnapshot(&image, profile, frame);
+            sink = sink + snapshot.tracks.size();
+        });
+        bench("detectUISnapshot/clips/" + fixture.name, 1, "frames", [&]() {
+            auto snapshot = detectUISnapshot(&image, profile, frame, true);
+            sink = sink + snapshot.clips.rects.size();
+        });
+
+        for (auto& mismatch : checkFixture(fixture, profile)) {
+            std::cerr << fixture.name << ": detected " << mismatch << " doesn't match the fixture" << std::endl;
+            matched = false;
+        }
+    }
+    return matched;
+}
+
+std::string benchTempPath(const std::string& name) {
+    auto dir = getenv("TMPDIR");
+    return std::string(dir != nullptr ? dir : "/tmp") + "/" + name;
+}
+
+/**
+ * Recording the fixtures as a playing session would be: every frame after the first is the
+ * playhead moving, a delta of a few tiles. Then replaying it from the start
+ */
+void benchRecording(std::vector<FrameFixture>& fixtures) {
+    auto path = benchTempPath("bes_bench-recording.bes");
+    const int frameCount = 8;
+    for (auto& fixture : fixtures) {
+        auto& layout = fixture.layout;
+        auto frame = MWRect{0, 0, layout.width, layout.height};
+        FrameImage image(fixture.pixels.data(), fixture.bytesPerRow, WindowInfo{0, frame});
+        auto moved = layout;
+        moved.playhead = layout.playhead == -1 ? 0 : layout.playhead + 37;
+        std::vector<uint8_t> movedPixels(fixture.pixels.size());
+        drawStandinLayout(moved, movedPixels.data(), fixture.bytesPerRow);
+        FrameImage movedImage(movedPixels.data(), fixture.bytesPerRow, WindowInfo{0, frame});
+
+        try {
+            {
+                FrameRecorder recorder(path);
+                double time = 0;
+                bench("recording/encode/" + fixture.name, frameCount, "frames", [&]() {
+                    for (int i = 0; i < frameCount; i++) {
+                        recorder.addFrame(i % 2 ? &movedImage : &image, time += 16);
+                    }
+                    sink = sink + recorder.bytesWritten();
+                });
+            }
+            {
+                FrameRecorder recorder(path);
+                for (int i = 0; i < frameCount; i++) {
+                    recorder.addFrame(i % 2 ? &movedImage : &image, i * 16);
+                }
+            }
+            FrameReplay replay(path);
+            bench("recording/replay/" + fixture.name, frameCount, "frames", [&]() {
+                for (size_t i = 0; i < replay.frameCount(); i++) {
+                    sink = sink + replay.seek(i)->width;
+                }
+            });
+        } catch (const std::runtime_error& error) {
+            std::cerr << error.what() << ", skipping recording benchmarks" << std::endl;
+            break;
+        }
+    }
+    std::remove(path.c_str());
+}
+
+/**
+ * --replay: decoding the recording frame by frame, then detecting each frame as getUISnapshot
+ * does. The second includes the first's decoding
+ */
+bool benchReplay(const std::string& path) {
+    std::unique_ptr<FrameReplay> replay;
+    try {
+        replay.reset(new FrameReplay(path));
+    } catch (const std::runtime_error& error) {
+        std::cerr << error.what() << std::endl;
+        return false;
+    }
+    if (replay->frameCount() == 0) {
+        std::cerr << path << " has no frames" << std::endl;
+        return false;
+    }
+    isLargeTrackHeight = true;
+    auto& profile = *findLayoutProfile(options.replayScale, uiLayout);
+    auto frames = replay->frameCount();
+    bench("replay/decode", frames, "frames", [&]() {
+        for (size_t i = 0; i < frames; i++) {
+            auto image = replay->seek(i);
+            sink = sink + (image != nullptr ? image->width : 0);
+        }
+    });
+    bench("replay/detectUISnapshot", frames, "frames", [&]() {
+        for (size_t i = 0; i < frames; i++) {
+            auto image = replay->seek(i);
+            if (image != nullptr) {
+                auto snapshot = detectUISnapshot(image, profile, image->frame.frame);
+                sink = sink + snapshot.tracks.size();
+            }
+        }
+    });
+    return true;
+}
+
+/**
+ * Key names and a synthetic stream of recorded X events
+ */
+void benchKeymap() {
+    std::vector<std::string> keys = {
+        "Enter", "Tab", "Space", "Backspace", "Escape", "Meta", "Shift", "Control", "Alt",
+        "ArrowLeft", "ArrowRight", "ArrowUp", "ArrowDown", "Home", "End", "PageUp", "PageDown",
+        "Delete", "NumpadEnter", "Numpad5", "=", "-", "[", "]", ";", ",", ".", "/"
+    };
+    for (char c = 'a'; c <= 'z'; c++) keys.push_back(std::string(1, c));
+    for (char c = '0'; c <= '9'; c++) keys.push_back(std::string(1, c));
+    for (int i = 1; i <= 12; i++) keys.push_back("F" + std::to_string(i));
+    std::vector<KeySym> syms;
+    for (auto& key : keys) {
+        syms.push_back(keySymForKey(key));
+    }
+
+    bench("keymap/keySymForKey", keys.size(), "lookups", [&]() {
+        size_t total = 0;
+        for (auto& key : keys) {
+            total += keySymForKey(key);
+        }
+        sink = sink + total;
+    });
+    bench("keymap/keyForKeySym", syms.size(), "lookups", [&]() {
+        size_t total = 0;
+        for (auto sym : syms) {
+            total += keyForKeySym(sym).size();
+        }
+        sink = sink + total;
+    });
+}
+
+struct RecordedEvent {
+    int type;
+    unsigned int detail, state;
+    int x, y;
+    KeySym sym;
+};
+
+std::vector<RecordedEvent> makeEventStream(size_t count) {
+    // Fixed seed so every run sees the same mix: mostly motion, some clicks, keys and scrolls
+    uint32_t seed = 12345;
+    auto next = [&]() {
+        seed = seed * 1664525 + 1013904223;
+        return seed >> 8;
+    };
+    std::vector<RecordedEvent> events;
+    int x = 500, y = 500;
+    for (size_t i = 0; i < count; i++) {
+        auto kind = next() % 100;
+        unsigned int state = next() % 10 == 0 ? ShiftMask : 0;
+        if (kind < 60) {
+            x = (x + (int)(next() % 21) - 10 + 1920) % 1920;
+            y = (y + (int)(next() % 21) - 10 + 1200) % 1200;
+            events.push_back(RecordedEvent{MotionNotify, 0, state, x, y, NoSymbol});
+        } else if (kind < 75) {
+            unsigned int button = 1 + next() % 3;
+            events.push_back(RecordedEvent{ButtonPress, button, state, x, y, NoSymbol});
+            events.push_back(RecordedEvent{ButtonRelease, button, state | Button1Mask, x, y, NoSymbol});
+        } else if (kind < 95) {
+            KeySym sym = XK_a + next() % 26;
+            unsigned int keyCode = 24 + (unsigned int)(sym - XK_a);
+            events.push_back(RecordedEvent{KeyPress, keyCode, state, x, y, sym});
+            events.push_back(RecordedEvent{KeyRelease, keyCode, state, x, y, sym});
+        } else {
+            events.push_back(RecordedEvent{ButtonPress, 4 + next() % 2, state, x, y, NoSymbol});
+        }
+    }
+    return events;
+}
+
+void benchEvents() {
+    auto events = makeEventStream(10000);
+
+    bench("events/translate", events.size(), "events", [&]() {
+        JSEvent event;
+        size_t total = 0;
+        for (auto& recorded : events) {
+            if (translateRecordedEvent(recorded.type, recorded.detail, recorded.state, recorded.x, recorded.y, recorded.sym, event)) {
+                total += event.type.size();
+            }
+        }
+        sink = sink + total;
+    });
+
+    // The record thread's whole path short of N-API: own event check, translation and fan out
+    // to listeners by type, as dispatchEvent does for native listeners
+    std::vector<std::pair<std::string, std::function<void(JSEvent*)>>> listeners;
+    size_t delivered = 0;
+    for (auto type : {"mousemove", "mousedown", "mouseup", "keydown", "keyup", "scroll", "mousemove", "keydown"}) {
+        listeners.push_back({type, [&](JSEvent* event) { delivered += event->x; }});
+    }
+    bench("events/dispatch", events.size(), "events", [&]() {
+        for (size_t i = 0; i < events.size(); i++) {
+            auto& recorded = events[i];
+            if (i % 50 == 0) {
+                // Some of our own synthesised events come through too
+                expectSyntheticEvent(recorded.type, recorded.detail);
+            }
+            if (isOwnSyntheticEvent(recorded.type, recorded.detail)) {
+                continue;
+            }
+            JSEvent event;
+            if (!translateRecordedEvent(recorded.type, recorded.detail, recorded.state, recorded.x, recorded.y, recorded.sym, event)) {
+                continue;
+            }
+            for (auto& listener : listeners) {
+                if (listener.first == event.type) {
+                    JSEvent copy = event;
+                    listener.second(&copy);
+                }
+            }
+        }
+        sink = sink + delivered;
+    });
+}
+
+/**
+ * Controller script packets, same mix as scripts/framerBenchmark.js
+ */
+void benchFramer() {
+    std::string stream;
+    std::string tracks = "[";
+    for (int i = 0; i < 200; i++) {
+        tracks += std::string(i > 0 ? "," : "") + "{\"name\":\"Track " + std::to_string(i) + " ünïcode\",\"color\":\"#ff8800\",\"volume\":0.5}";
+    }
+    tracks += "]";
+    for (int i = 0; i < 2000; i++) {
+        auto packet = i % 20 == 0
+            ? "{\"type\":\"tracks\",\"id\":\"internal" + std::to_string(i) + "\",\"data\":" + tracks + "}"
+            : "{\"type\":\"transport/position\",\"data\":{\"position\":" + std::to_string(i / 4) + "}}";
+        // Lengths count UTF-16 units, the 2 byte characters above are one unit each
+        size_t units = 0;
+        for (unsigned char c : packet) {
+            units += (c & 0xC0) != 0x80;
+        }
+        stream += std::to_string(units) + packet;
+    }
+    auto data = (const uint8_t*)stream.data();
+
+    for (size_t chunkSize : {(size_t)1500, (size_t)65536}) {
+        PacketFramer framer;
+        std::vector<PacketFrame> frames;
+        bench("framer/push/" + std::to_string(chunkSize), stream.size(), "B", [&]() {
+            size_t count = 0;
+            for (size_t offset = 0; offset < stream.size(); offset += chunkSize) {
+                frames.clear();
+                framer.push(data + offset, std::min(chunkSize, stream.size() - offset), frames);
+                count += frames.size();
+            }
+            sink = sink + count;
+        });
+    }
+
+    PacketFramer framer;
+    std::vector<PacketFrame> frames;
+    framer.push(data, stream.size(), frames);
+    std::string type, id;
+    bench("framer/scanPacketHeader", frames.size(), "packets", [&]() {
+        size_t total = 0;
+        for (auto& frame : frames) {
+            scanPacketHeader(data + frame.offset, frame.length, type, id);
+            total += type.size() + id.size();
+        }
+        sink = sink + total;
+    });
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+        if (arg == "--fixtures") options.fixturesPath = next();
+        else if (arg == "--profiles") options.profilesPath = next();
+        else if (arg == "--filter") options.filter = next();
+        else if (arg == "--min-time") options.minTimeMs = atof(next().c_str());
+        else if (arg == "--replay") options.replayPath = next();
+        else if (arg == "--replay-scale") options.replayScale = atof(next().c_str());
+    }
+
+    try {
+        loadLayoutProfiles(options.profilesPath);
+    } catch (const std::runtime_error& error) {
+        std::cerr << error.what() << ", using the built in layout constants" << std::endl;
+    }
+    if (options.replayPath != "") {
+        return benchReplay(options.replayPath) ? 0 : 1;
+    }
+    auto fixtures = loadFixtures(options.fixturesPath);
+    if (fixtures.size() == 0) {
+        return 1;
+    }
+    bool matched = benchFrames(fixtures);
+    benchRecording(fixtures);
+    benchKeymap();
+    benchEvents();
+    benchFramer();
+    return matched ? 0 : 1;
+}
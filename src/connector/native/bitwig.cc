@@ -1,71 +1,139 @@
 #include "bitwig.h"
 #include "string.h"
-#include "keyboard.h"
+#include "pluginwindows.h"
+#include "activeapp.h"
+#include "nativeevents.h"
+#include "windowregistry.h"
+#include "processtable.h"
+#include "packetframer.h"
+#include "resources.h"
+#include "windowlist.h"
 #include <CoreGraphics/CoreGraphics.h>
 #include <ApplicationServices/ApplicationServices.h>
 #include <iostream>
 #include <string>
 #include <cstddef>
-#include <atomic>
+#include <future>
 #include <map>
+#include <mutex>
+#include <thread>
 #include <vector>
+#include <sys/event.h>
+#include <libproc.h>
+#include <mach/mach_time.h>
+#include <unistd.h>
 using namespace std::string_literals;
 
 struct AppData {
     AXUIElementRef ref;
     pid_t pid;
 };
+// Reached from the JS thread, the resource sampler and the AX observers
+std::mutex appDataMutex;
 std::map<std::string,AppData> appDataByProcessName = {};
+// Replaced when an app restarts but never released, another thread may still be using one
+std::vector<AXUIElementRef> retiredAppRefs;
+
+
+/**
+ * Finds processes by their windows' owner name, then leaves it to kqueue to tell us when
+ * they exit. Bitwig Studio starts the audio engine and plugin host itself, so forks of a
+ * watched process are our cue to look again for anything that wasn't running
+ */
+class KqueueProcessSource : public ProcessSource {
+    int kq = -1;
+    ProcessTable* table = nullptr;
+    std::once_flag started;
+
+    void run() {
+        while (true) {
+            struct kevent event;
+            if (kevent(kq, NULL, 0, &event, 1, NULL) <= 0) {
+                continue;
+            }
+            if (event.fflags & NOTE_EXIT) {
+                // One-shot on exit, the kernel drops the knote itself
+                table->exited((pid_t)event.ident);
+            } else if (event.fflags & (NOTE_FORK | NOTE_EXEC)) {
+                table->launched();
+            }
+        }
+    }
 
-std::string activeApp;
-std::atomic<bool> activeAppDirty(true);
+public:
+    pid_t lookup(const std::string& name) override {
+        auto windows = getWindowList();
+        auto window = windows->findOwned(name);
+        return window != nullptr ? window->pid : -1;
+    }
 
-bool pidIsAlive(pid_t pid)  {
-    return 0 == kill(pid, 0);
+    bool watch(pid_t pid, ProcessTable* table) override {
+        std::call_once(started, [this, table]() {
+            this->table = table;
+            kq = kqueue();
+            if (kq != -1) {
+                std::thread([this]() {
+                    run();
+                }).detach();
+            }
+        });
+        if (kq == -1) {
+            return false;
+        }
+        struct kevent event;
+        EV_SET(&event, pid, EVFILT_PROC, EV_ADD | EV_ENABLE, NOTE_EXIT | NOTE_FORK | NOTE_EXEC, 0, NULL);
+        // Fails with ESRCH if it's already gone, then the table's own check catches it
+        return kevent(kq, &event, 1, NULL, 0, NULL) == 0;
+    }
+};
+
+ProcessTable& getProcessTable() {
+    static KqueueProcessSource source;
+    static ProcessTable table(&source);
+    return table;
 }
 
-pid_t GetPID(std::string name) {
-    // Go through all on screen windows, find BW
-    CFArrayRef array = CGWindowListCopyWindowInfo(kCGWindowListOptionOnScreenOnly | kCGWindowListExcludeDesktopElements, kCGNullWindowID);
-    CFIndex count = CFArrayGetCount(array);
-    for (CFIndex i = 0; i < count; i++) {
-        CFDictionaryRef dict = (CFDictionaryRef)CFArrayGetValueAtIndex(array, i);
-        auto str = CFStringToString((CFStringRef)CFDictionaryGetValue(dict, kCGWindowOwnerName));
-        if (str == name) {
-            CFNumberRef ownerPidRef = (CFNumberRef) CFDictionaryGetValue(dict, kCGWindowOwnerPID);
-            pid_t ownerPid;
-            CFNumberGetValue(ownerPidRef, kCFNumberSInt32Type, &ownerPid);
-            CFRelease(array);
-            return ownerPid;
-        }
+bool readProcessResources(pid_t pid, ProcessResources& out) {
+    struct proc_taskinfo info;
+    if (proc_pidinfo(pid, PROC_PIDTASKINFO, 0, &info, sizeof(info)) != sizeof(info)) {
+        return false;
     }
-    CFRelease(array);
-    return -1;
+    // Task times are in mach absolute time units, which are only nanoseconds on Intel
+    static mach_timebase_info_data_t timebase = []() {
+        mach_timebase_info_data_t timebase;
+        mach_timebase_info(&timebase);
+        return timebase;
+    }();
+    double ticks = (double)(info.pti_total_user + info.pti_total_system);
+    out.rss = info.pti_resident_size;
+    out.cpuTime = ticks * timebase.numer / timebase.denom / 1e9;
+    out.threads = info.pti_threadnum;
+    return true;
 }
 
 AXUIElementRef findAXUIElementByName(std::string name) {
-    if (!appDataByProcessName.count(name)) {
-        auto pid = GetPID(name);
-        if (pid == -1) {
-            return NULL;
-        }
-        auto ref = AXUIElementCreateApplication(pid);
-        if (ref != NULL) {
-            appDataByProcessName[name] = AppData({
-                ref,
-                pid
-            });
-        }
-        return ref;
-    } else {
+    auto pid = getProcessTable().find(name);
+    std::lock_guard<std::mutex> lock(appDataMutex);
+    if (appDataByProcessName.count(name)) {
         auto data = appDataByProcessName[name];
-        if (!pidIsAlive(data.pid)) {
-            appDataByProcessName.erase(name);
-            // Try again
-            return findAXUIElementByName(name);
+        if (data.pid == pid) {
+            return data.ref;
         }
-        return data.ref;
+        // Exited, or restarted under a new pid
+        retiredAppRefs.push_back(data.ref);
+        appDataByProcessName.erase(name);
+    }
+    if (pid == -1) {
+        return NULL;
     }
+    auto ref = AXUIElementCreateApplication(pid);
+    if (ref != NULL) {
+        appDataByProcessName[name] = AppData({
+            ref,
+            pid
+        });
+    }
+    return ref;
 }
 
 AXUIElementRef GetBitwigAXUIElement() {
@@ -96,117 +164,269 @@ AXUIElementRef GetPluginAXUIElement() {
     return separateProcess != NULL ? separateProcess : findAXUIElementByName("Bitwig Studio Engine");
 }
 
-Napi::Value GetPluginWindowsPosition(const Napi::CallbackInfo &info) {
-    Napi::Env env = info.Env();
-    auto elementRef = GetPluginAXUIElement();
-    Napi::Object outObj = Napi::Object::New(env);
-    if (elementRef != NULL) {
-        CFArrayRef windowArray = nil;
-        AXUIElementCopyAttributeValue(elementRef, kAXWindowsAttribute, (CFTypeRef*)&windowArray);
-        if (windowArray != nil) { 
-            CFIndex nItems = CFArrayGetCount(windowArray);
-            for (int i = 0; i < nItems; i++) {
-                AXUIElementRef itemRef = (AXUIElementRef) CFArrayGetValueAtIndex(windowArray, i);
-                CFTypeRef position;
-                CFTypeRef size;
-                CGPoint positionPoint;
-                CGSize sizePoint;
-                CFStringRef titleRef;
-                CFBooleanRef isFocused;
-                AXUIElementCopyAttributeValue(itemRef, kAXPositionAttribute, (CFTypeRef *)&position);
-                AXValueGetValue((AXValueRef)position, (AXValueType)kAXValueCGPointType, &positionPoint);
-                AXUIElementCopyAttributeValue(itemRef, kAXSizeAttribute, (CFTypeRef *)&size);
-                AXValueGetValue((AXValueRef)size, (AXValueType)kAXValueCGSizeType, &sizePoint);
-                AXUIElementCopyAttributeValue(itemRef, kAXTitleAttribute, (CFTypeRef *) &titleRef);
-                AXUIElementCopyAttributeValue(itemRef, kAXFocusedAttribute, (CFTypeRef*) &isFocused);
-                auto windowTitle = CFStringToString((CFStringRef)titleRef);
-                if (outObj.Has(windowTitle)) {
-                    windowTitle = windowTitle + " (duplicate)";
+/**
+ * One thread for all our AXObservers (plugin windows, app activation)
+ */
+CFRunLoopRef getObserverRunLoop() {
+    static CFRunLoopRef runLoop = NULL;
+    static std::once_flag flag;
+    std::call_once(flag, []() {
+        std::promise<CFRunLoopRef> started;
+        auto future = started.get_future();
+        std::thread([](std::promise<CFRunLoopRef> started) {
+            started.set_value(CFRunLoopGetCurrent());
+            while (true) {
+                // Returns straight away when there are no sources (nothing running to observe)
+                if (CFRunLoopRunInMode(kCFRunLoopDefaultMode, 1, false) == kCFRunLoopRunFinished) {
+                    usleep(100000);
                 }
-                
-                auto obj = Napi::Object::New(env);
-                obj.Set(Napi::String::New(env, "x"), Napi::Number::New(env, positionPoint.x));
-                obj.Set(Napi::String::New(env, "y"), Napi::Number::New(env, positionPoint.y));
-                obj.Set(Napi::String::New(env, "w"), Napi::Number::New(env, sizePoint.width));
-                obj.Set(Napi::String::New(env, "h"), Napi::Number::New(env, sizePoint.height));
-                obj.Set(Napi::String::New(env, "id"), Napi::String::New(env, windowTitle));
-                obj.Set(Napi::String::New(env, "focused"), Napi::Boolean::New(env, isFocused == kCFBooleanTrue));
-                outObj.Set(Napi::String::New(env, windowTitle), obj);
             }
-            CFRelease(windowArray);
-            return outObj;
-        }
+        }, std::move(started)).detach();
+        runLoop = future.get();
+    });
+    return runLoop;
+}
+
+/**
+ * Position, size, title and focus in one round trip to the plugin host
+ */
+bool readPluginWindow(AXUIElementRef window, PluginWindow& out) {
+    CFStringRef attributes[] = { kAXPositionAttribute, kAXSizeAttribute, kAXTitleAttribute, kAXFocusedAttribute };
+    CFArrayRef attributeArray = CFArrayCreate(NULL, (const void **)attributes, 4, &kCFTypeArrayCallBacks);
+    CFArrayRef values = NULL;
+    auto err = AXUIElementCopyMultipleAttributeValues(window, attributeArray, 0, &values);
+    CFRelease(attributeArray);
+    if (err != kAXErrorSuccess || values == NULL) {
+        return false;
+    }
+    CGPoint position;
+    CGSize size;
+    // Failed attributes come back as kAXValueAXErrorType values, which AXValueGetValue rejects
+    bool ok = AXValueGetValue((AXValueRef)CFArrayGetValueAtIndex(values, 0), (AXValueType)kAXValueCGPointType, &position)
+        && AXValueGetValue((AXValueRef)CFArrayGetValueAtIndex(values, 1), (AXValueType)kAXValueCGSizeType, &size);
+    if (ok) {
+        out.key = CFHash(window);
+        out.x = position.x;
+        out.y = position.y;
+        out.w = size.width;
+        out.h = size.height;
+        CFTypeRef titleRef = CFArrayGetValueAtIndex(values, 2);
+        out.title = CFGetTypeID(titleRef) == CFStringGetTypeID() ? CFStringToString((CFStringRef)titleRef) : "";
+        out.focused = CFArrayGetValueAtIndex(values, 3) == kCFBooleanTrue;
     }
-    return outObj;
+    CFRelease(values);
+    return ok;
 }
 
-Napi::Value GetPluginWindowsCount(const Napi::CallbackInfo &info) {
-    Napi::Env env = info.Env();
-    auto inObject = info[0].As<Napi::Object>();
-    auto elementRef = GetPluginAXUIElement();
-    if (elementRef != NULL) {
-        CFArrayRef windowArray = nil;
-        AXUIElementCopyAttributeValue(elementRef, kAXWindowsAttribute, (CFTypeRef*)&windowArray);
-        if (windowArray != nil) { 
-            CFIndex nItems = CFArrayGetCount(windowArray);
-            CFRelease(windowArray);
-            return Napi::Number::New(env, nItems);
+bool setPluginWindowPosition(AXUIElementRef window, CGPoint point) {
+    auto position = AXValueCreate((AXValueType)kAXValueCGPointType, (const void *)&point);
+    auto err = AXUIElementSetAttributeValue(window, kAXPositionAttribute, position);
+    CFRelease(position);
+    return err == kAXErrorSuccess;
+}
+
+bool setPluginWindowSize(AXUIElementRef window, CGSize size) {
+    auto value = AXValueCreate((AXValueType)kAXValueCGSizeType, (const void *)&size);
+    auto err = AXUIElementSetAttributeValue(window, kAXSizeAttribute, value);
+    CFRelease(value);
+    return err == kAXErrorSuccess;
+}
+
+void pluginWindowObserverCallback(AXObserverRef observer, AXUIElementRef element, CFStringRef notification, void *refcon);
+
+/**
+ * Watches the plugin host with an AXObserver on its own run loop thread. Window elements
+ * are kept (retained) by key so moves and re-reads don't need to walk kAXWindowsAttribute
+ */
+class AXPluginWindowSource : public PluginWindowSource {
+    std::mutex mutex;
+    PluginWindowRegistry* registry = nullptr;
+    pid_t observedPid = -1;
+    AXObserverRef observer = NULL;
+    std::map<uint64_t, AXUIElementRef> elements;
+
+    // Returns retained, or NULL
+    AXUIElementRef elementForKey(uint64_t key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = elements.find(key);
+        if (it == elements.end()) {
+            return NULL;
         }
+        CFRetain(it->second);
+        return it->second;
     }
-    return Napi::Number::New(env, 0);
-}
 
-Napi::Value SetPluginWindowsPosition(const Napi::CallbackInfo &info) {
-    Napi::Env env = info.Env();
-    auto inObject = info[0].As<Napi::Object>();
-    auto elementRef = GetPluginAXUIElement();
+    void observeWindow(AXUIElementRef window) {
+        if (observer == NULL) {
+            return;
+        }
+        AXObserverAddNotification(observer, window, kAXWindowMovedNotification, this);
+        AXObserverAddNotification(observer, window, kAXWindowResizedNotification, this);
+        AXObserverAddNotification(observer, window, kAXTitleChangedNotification, this);
+        AXObserverAddNotification(observer, window, kAXUIElementDestroyedNotification, this);
+    }
 
-    if (elementRef != NULL) {
-        CFArrayRef windowArray = nil;
-        AXUIElementCopyAttributeValue(elementRef, kAXWindowsAttribute, (CFTypeRef*)&windowArray);
-        if (windowArray != nil) { 
-            CFIndex nItems = CFArrayGetCount(windowArray);
-            for (int i = 0; i < nItems; i++) {
-                AXUIElementRef itemRef = (AXUIElementRef) CFArrayGetValueAtIndex(windowArray, i);
-                CFStringRef titleRef;
-                AXUIElementCopyAttributeValue(itemRef, kAXTitleAttribute, (CFTypeRef *) &titleRef);
-                auto windowTitle = CFStringToString((CFStringRef)titleRef);
-
-                auto posForWindow = inObject.Get(windowTitle).As<Napi::Object>();
-                CGPoint newPoint;
-                newPoint.x = posForWindow.Get("x").As<Napi::Number>();
-                newPoint.y = posForWindow.Get("y").As<Napi::Number>();
-                auto position = (CFTypeRef)(AXValueCreate((AXValueType)kAXValueCGPointType, (const void *)&newPoint));
-                AXUIElementSetAttributeValue(itemRef, kAXPositionAttribute, position);
-            }
-            CFRelease(windowArray);
+    void stopObserving() {
+        if (observer != NULL) {
+            CFRunLoopRemoveSource(getObserverRunLoop(), AXObserverGetRunLoopSource(observer), kCFRunLoopDefaultMode);
+            CFRelease(observer);
+            observer = NULL;
+        }
+        for (auto& pair : elements) {
+            CFRelease(pair.second);
         }
+        elements.clear();
+        observedPid = -1;
     }
-}
 
-Napi::Value FocusPluginWindow(const Napi::CallbackInfo &info) {
-    Napi::Env env = info.Env();
-    std::string id = info[0].As<Napi::String>();
-    auto elementRef = GetPluginAXUIElement();
-    if (elementRef != NULL) {
-        CFArrayRef windowArray = nil;
-        AXUIElementCopyAttributeValue(elementRef, kAXWindowsAttribute, (CFTypeRef*)&windowArray);
-        if (windowArray != nil) { 
-            CFIndex nItems = CFArrayGetCount(windowArray);
-            for (int i = 0; i < nItems; i++) {
-                AXUIElementRef itemRef = (AXUIElementRef) CFArrayGetValueAtIndex(windowArray, i);
-                CFStringRef titleRef;
-                AXUIElementCopyAttributeValue(itemRef, kAXTitleAttribute, (CFTypeRef *) &titleRef);
-                auto windowTitle = CFStringToString((CFStringRef)titleRef);
-                if (id == windowTitle) {
-                    AXUIElementSetAttributeValue(elementRef, kAXFrontmostAttribute, kCFBooleanTrue);
-                    AXUIElementSetAttributeValue(itemRef, kAXMainAttribute, kCFBooleanTrue);
-                    break;
+public:
+    bool watch(PluginWindowRegistry* registry) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->registry = registry;
+        if (observer != NULL && getProcessTable().isAlive(observedPid)) {
+            return true;
+        }
+        stopObserving();
+        auto appRef = GetPluginAXUIElement();
+        pid_t pid;
+        if (appRef == NULL || AXUIElementGetPid(appRef, &pid) != kAXErrorSuccess) {
+            return false;
+        }
+        if (AXObserverCreate(pid, pluginWindowObserverCallback, &observer) != kAXErrorSuccess) {
+            observer = NULL;
+            return false;
+        }
+        AXObserverAddNotification(observer, appRef, kAXWindowCreatedNotification, this);
+        AXObserverAddNotification(observer, appRef, kAXFocusedWindowChangedNotification, this);
+        CFRunLoopAddSource(getObserverRunLoop(), AXObserverGetRunLoopSource(observer), kCFRunLoopDefaultMode);
+        CFRunLoopWakeUp(getObserverRunLoop());
+        observedPid = pid;
+        // Anything from before we were watching needs reading again
+        registry->invalidate();
+        return true;
+    }
+
+    PluginWindowList fetchAll() override {
+        PluginWindowList out;
+        std::map<uint64_t, AXUIElementRef> found;
+        auto appRef = GetPluginAXUIElement();
+        if (appRef != NULL) {
+            CFArrayRef windowArray = nil;
+            AXUIElementCopyAttributeValue(appRef, kAXWindowsAttribute, (CFTypeRef*)&windowArray);
+            if (windowArray != nil) { 
+                CFIndex nItems = CFArrayGetCount(windowArray);
+                for (int i = 0; i < nItems; i++) {
+                    AXUIElementRef itemRef = (AXUIElementRef) CFArrayGetValueAtIndex(windowArray, i);
+                    PluginWindow window;
+                    if (readPluginWindow(itemRef, window)) {
+                        out.push_back(window);
+                        CFRetain(itemRef);
+                        found[window.key] = itemRef;
+                    }
                 }
+                CFRelease(windowArray);
             }
-            CFRelease(windowArray);
         }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& pair : found) {
+            if (!elements.count(pair.first)) {
+                observeWindow(pair.second);
+            }
+        }
+        for (auto& pair : elements) {
+            CFRelease(pair.second);
+        }
+        elements = found;
+        return out;
     }
+
+    bool fetch(uint64_t key, PluginWindow& window) override {
+        auto element = elementForKey(key);
+        if (element == NULL) {
+            return false;
+        }
+        bool ok = readPluginWindow(element, window);
+        CFRelease(element);
+        return ok;
+    }
+
+    bool move(uint64_t key, double x, double y) override {
+        auto element = elementForKey(key);
+        if (element == NULL) {
+            return false;
+        }
+        bool ok = setPluginWindowPosition(element, CGPointMake((CGFloat)x, (CGFloat)y));
+        CFRelease(element);
+        return ok;
+    }
+
+    bool resize(uint64_t key, double w, double h) override {
+        auto element = elementForKey(key);
+        if (element == NULL) {
+            return false;
+        }
+        bool ok = setPluginWindowSize(element, CGSizeMake((CGFloat)w, (CGFloat)h));
+        CFRelease(element);
+        return ok;
+    }
+
+    void focus(uint64_t key) override {
+        auto appRef = GetPluginAXUIElement();
+        auto element = elementForKey(key);
+        if (appRef != NULL && element != NULL) {
+            AXUIElementSetAttributeValue(appRef, kAXFrontmostAttribute, kCFBooleanTrue);
+            AXUIElementSetAttributeValue(element, kAXMainAttribute, kCFBooleanTrue);
+        }
+        if (element != NULL) {
+            CFRelease(element);
+        }
+    }
+
+    void awayPosition(double& x, double& y) override {
+        auto screen = CGDisplayBounds(CGMainDisplayID());
+        x = screen.size.width - 1;
+        y = screen.size.height - 1;
+    }
+
+    void notify(AXUIElementRef element, CFStringRef notification) {
+        uint64_t key = CFHash(element);
+        PluginWindowRegistry* registry;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            registry = this->registry;
+            if (CFEqual(notification, kAXWindowCreatedNotification) && !elements.count(key)) {
+                CFRetain(element);
+                elements[key] = element;
+                observeWindow(element);
+            } else if (CFEqual(notification, kAXUIElementDestroyedNotification) && elements.count(key)) {
+                CFRelease(elements[key]);
+                elements.erase(key);
+            }
+        }
+        // Outside our lock, the registry calls back into fetch()
+        if (registry == nullptr) {
+            return;
+        }
+        if (CFEqual(notification, kAXUIElementDestroyedNotification)) {
+            registry->windowDestroyed(key);
+        } else if (CFEqual(notification, kAXFocusedWindowChangedNotification)) {
+            // element is the newly focused window, which may not be a plugin window at all
+            registry->focusChanged(key);
+        } else {
+            registry->windowChanged(key);
+        }
+    }
+};
+
+void pluginWindowObserverCallback(AXObserverRef observer, AXUIElementRef element, CFStringRef notification, void *refcon) {
+    ((AXPluginWindowSource*)refcon)->notify(element, notification);
+}
+
+PluginWindowRegistry& getPluginWindowRegistry() {
+    static AXPluginWindowSource source;
+    static PluginWindowRegistry registry(&source);
+    return registry;
 }
 
 void closeWindowsForAXUIElement(AXUIElementRef elementRef) {
@@ -220,8 +440,11 @@ void closeWindowsForAXUIElement(AXUIElementRef elementRef) {
                 AXUIElementRef buttonRef = nil;
 
                 AXUIElementCopyAttributeValue(itemRef, kAXCloseButtonAttribute, (CFTypeRef*)&buttonRef);
-                AXUIElementPerformAction(buttonRef, kAXPressAction);
-                CFRelease(buttonRef);
+                // Windows without a close button (e.g. mid-teardown) give us nothing back
+                if (buttonRef != nil) {
+                    AXUIElementPerformAction(buttonRef, kAXPressAction);
+                    CFRelease(buttonRef);
+                }
             }
 
             CFRelease(windowArray);
@@ -233,21 +456,84 @@ bool isAXUIElementActiveApp(AXUIElementRef element) {
     if (!element) {
         return false;
     }
-    CFBooleanRef isFrontmost;
-    AXUIElementCopyAttributeValue(element, kAXFrontmostAttribute, (CFTypeRef*) &isFrontmost);
-    return isFrontmost == kCFBooleanTrue;
+    CFBooleanRef isFrontmost = NULL;
+    auto err = AXUIElementCopyAttributeValue(element, kAXFrontmostAttribute, (CFTypeRef*) &isFrontmost);
+    bool active = err == kAXErrorSuccess && isFrontmost == kCFBooleanTrue;
+    if (isFrontmost != NULL) {
+        CFRelease(isFrontmost);
+    }
+    return active;
+}
+
+void activeAppObserverCallback(AXObserverRef observer, AXUIElementRef element, CFStringRef notification, void *refcon) {
+    auto app = (const std::string*)refcon;
+    if (CFEqual(notification, kAXApplicationActivatedNotification)) {
+        getActiveAppTracker().activated(*app);
+    } else {
+        getActiveAppTracker().deactivated(*app);
+    }
 }
 
-bool isAppActive(std::string app) {
-    if (!activeAppDirty) {
-        return activeApp == app;
+struct WatchedApp {
+    pid_t pid = -1;
+    AXObserverRef observer = NULL;
+};
+std::map<std::string, WatchedApp> watchedApps;
+
+/**
+ * Starts listening for app (de)activation if it's running and we aren't already. Returns
+ * false if that isn't possible right now
+ */
+bool watchAppActivation(const std::string& app) {
+    auto& watched = watchedApps[app];
+    if (watched.observer != NULL && getProcessTable().isAlive(watched.pid)) {
+        return true;
     }
-    auto axUIEl = findAXUIElementByName(app);
-    auto active = isAXUIElementActiveApp(axUIEl);
-    if (active) {
-        activeApp = app;
+    if (watched.observer != NULL) {
+        CFRunLoopRemoveSource(getObserverRunLoop(), AXObserverGetRunLoopSource(watched.observer), kCFRunLoopDefaultMode);
+        CFRelease(watched.observer);
+        watched.observer = NULL;
+        getActiveAppTracker().deactivated(app);
     }
-    return active;
+    auto element = findAXUIElementByName(app);
+    pid_t pid;
+    if (element == NULL || AXUIElementGetPid(element, &pid) != kAXErrorSuccess) {
+        return false;
+    }
+    AXObserverRef observer;
+    if (AXObserverCreate(pid, activeAppObserverCallback, &observer) != kAXErrorSuccess) {
+        return false;
+    }
+    // Map keys stay put for the life of the map, so the name is safe to hand over as refcon
+    auto refcon = (void*)&watchedApps.find(app)->first;
+    AXObserverAddNotification(observer, element, kAXApplicationActivatedNotification, refcon);
+    AXObserverAddNotification(observer, element, kAXApplicationDeactivatedNotification, refcon);
+    CFRunLoopAddSource(getObserverRunLoop(), AXObserverGetRunLoopSource(observer), kCFRunLoopDefaultMode);
+    CFRunLoopWakeUp(getObserverRunLoop());
+    watched.pid = pid;
+    watched.observer = observer;
+
+    // Catch up with whatever happened before we were listening
+    if (isAXUIElementActiveApp(element)) {
+        getActiveAppTracker().activated(app);
+    } else {
+        getActiveAppTracker().deactivated(app);
+    }
+    return true;
+}
+
+void watchActiveApps() {
+    for (auto app : {"Bitwig Studio", "Bitwig Plug-in Host 64", "Bitwig Studio Engine"}) {
+        watchAppActivation(app);
+    }
+}
+
+bool isAppActive(std::string app) {
+    if (watchAppActivation(app)) {
+        return getActiveAppTracker().getActive() == app;
+    }
+    // Not running, or couldn't be observed. Ask directly
+    return isAXUIElementActiveApp(findAXUIElementByName(app));
 }
 
 bool isBitwigActive() {
@@ -302,44 +588,26 @@ Napi::Value CloseFloatingWindows(const Napi::CallbackInfo &info) {
 
 Napi::Value GetAudioEnginePid(const Napi::CallbackInfo &info) {
     Napi::Env env = info.Env();
-    auto pluginAXUIElement = GetPluginAXUIElement();
-    if (appDataByProcessName.count("Bitwig Plug-in Host 64") == 1) {
-        return Napi::Number::New(env, appDataByProcessName["Bitwig Plug-in Host 64"].pid);
-    } else if (appDataByProcessName.count("Bitwig Studio Engine") == 1) {
-        return Napi::Number::New(env, appDataByProcessName["Bitwig Studio Engine"].pid);
+    auto pid = getProcessTable().find("Bitwig Plug-in Host 64");
+    if (pid == -1) {
+        pid = getProcessTable().find("Bitwig Studio Engine");
     }
-    return Napi::Number::New(env, -1);
+    return Napi::Number::New(env, pid);
 }
 
 Napi::Value GetPid(const Napi::CallbackInfo &info) {
     Napi::Env env = info.Env();
-    auto pluginAXUIElement = GetBitwigAXUIElement();
-    if (appDataByProcessName.count("Bitwig Studio") == 1) {
-        return Napi::Number::New(env, appDataByProcessName["Bitwig Studio"].pid);
-    }
-    return Napi::Number::New(env, -1);
+    return Napi::Number::New(env, getProcessTable().find("Bitwig Studio"));
 }
 
 Napi::Value InitBitwig(Napi::Env env, Napi::Object exports)
 {
     Napi::Object obj = Napi::Object::New(env);
 
-    addEventListener(EventListenerSpec{
-        "mouseup",
-        [](JSEvent* event) -> void {
-            activeAppDirty = true;
-        },
-        nullptr,
-        nullptr
-    });
-
-    addEventListener(EventListenerSpec{
-        "keyup",
-        [](JSEvent* event) -> void {
-            activeAppDirty = true;
-        },
-        nullptr,
-        nullptr
+    getProcessTable().addExitListener([](const std::string& name, pid_t pid) -> void {
+        // Don't wait for the next lookup to notice, e.g. the engine restarting
+        getActiveAppTracker().deactivated(name);
+        getPluginWindowRegistry().invalidate();
     });
 
     obj.Set("isActiveApplication", Napi::Function::New(env, IsActiveApplication));
@@ -347,10 +615,11 @@ Napi::Value InitBitwig(Napi::Env env, Napi::Object exports)
     obj.Set("makeMainWindowActive", Napi::Function::New(env, MakeMainWindowActive));
     obj.Set("closeFloatingWindows", Napi::Function::New(env, CloseFloatingWindows));
     obj.Set("isAccessibilityEnabled", Napi::Function::New(env, AccessibilityEnabled));
-    obj.Set("getPluginWindowsPosition", Napi::Function::New(env, GetPluginWindowsPosition));
-    obj.Set("setPluginWindowsPosition", Napi::Function::New(env, SetPluginWindowsPosition));
-    obj.Set("focusPluginWindow", Napi::Function::New(env, FocusPluginWindow));
-    obj.Set("getPluginWindowsCount", Napi::Function::New(env, GetPluginWindowsCount));
+    addPluginWindowFunctions(env, obj);
+    addNativeEventFunctions(env, obj);
+    addActiveAppFunctions(env, obj);
+    addResourceFunctions(env, obj);
+    BESPacketFramer::Init(env, obj);
     obj.Set("getAudioEnginePid", Napi::Function::New(env, GetAudioEnginePid));
     obj.Set("getPid", Napi::Function::New(env, GetPid));
     exports.Set("Bitwig", obj);
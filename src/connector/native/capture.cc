@@ -0,0 +1,75 @@
+#include "capture.h"
+#include "windowlist.h"
+#include <CoreGraphics/CoreGraphics.h>
+#include <ApplicationServices/ApplicationServices.h>
+
+/**
+ * ImageDeets
+ */
+ImageDeets::ImageDeets(CGImageRef latestImage, WindowInfo frame) {
+    this->frame = frame;
+    this->imageRef = latestImage;
+    CGDataProviderRef provider = CGImageGetDataProvider(latestImage);
+    imageData = CGDataProviderCopyData(provider);
+    data = CFDataGetBytePtr(imageData);
+
+    bytesPerRow = CGImageGetBytesPerRow(latestImage);
+    bytesPerPixel = CGImageGetBitsPerPixel(latestImage) / 8;
+
+    info = CGImageGetBitmapInfo(latestImage);
+    width = frame.frame.w;
+    height = frame.frame.h;
+    maxInclOffset = getPixelOffset(XYPoint{width - 1, height - 1});
+};
+
+ImageDeets::~ImageDeets() {
+    CFRelease(imageRef);
+    CFRelease(imageData);
+};
+
+WindowInfo findBitwigMainWindow() {
+    // Bitwig opens a separate window for its tooltips, ignore windows that small
+    // TODO Revisit better way of only getting the main window
+    auto windows = getWindowList();
+    auto window = windows->findOwned("Bitwig Studio", 100);
+    if (window != nullptr) {
+        return WindowInfo{
+            window->id,
+            window->frame
+        };
+    }
+    return WindowInfo{
+        1,
+        MWRect{0, 0, 0, 0}
+    };
+};
+
+ImageDeets* captureWindow(WindowInfo info) {
+    auto image = CGWindowListCreateImage(
+        CGRectNull, 
+        kCGWindowListOptionIncludingWindow, 
+        info.windowId, 
+        kCGWindowImageBoundsIgnoreFraming | kCGWindowImageNominalResolution
+    );
+    if (image == NULL) {
+        return nullptr;
+    }
+    return new ImageDeets(image, info);
+}
+
+ImageDeets* captureWindowRegion(WindowInfo info, MWRect region) {
+    if (region.w <= 0 || region.h <= 0 || region.x < 0 || region.y < 0 || region.x + region.w > info.frame.w || region.y + region.h > info.frame.h) {
+        return nullptr;
+    }
+    auto bounds = CGRectMake(info.frame.x + region.x, info.frame.y + region.y, region.w, region.h);
+    auto image = CGWindowListCreateImage(
+        bounds,
+        kCGWindowListOptionIncludingWindow,
+        info.windowId,
+        kCGWindowImageBoundsIgnoreFraming | kCGWindowImageNominalResolution
+    );
+    if (image == NULL) {
+        return nullptr;
+    }
+    return new ImageDeets(image, WindowInfo{info.windowId, MWRect{info.frame.x + region.x, info.frame.y + region.y, region.w, region.h}});
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "ui.h"
+
+/**
+ * Platform specific window lookup and capture. The macOS implementation is in capture.cc,
+ * the X11 one in linux/capture.cc. Both return nullptr from captureWindow if the window
+ * could not be read.
+ */
+WindowInfo findBitwigMainWindow();
+ImageDeets* captureWindow(WindowInfo info);
+/**
+ * Just region (window coordinates) of the window, for sampling a few pixels often without
+ * copying the whole window each time. The image's frame is the region's, in screen coordinates
+ */
+ImageDeets* captureWindowRegion(WindowInfo info, MWRect region);
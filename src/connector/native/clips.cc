@@ -0,0 +1,157 @@
+#include "clips.h"
+#include "metrics.h"
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Timeline background and grid lines are greys below this, clip colours are well above
+const int CLIP_MIN_SPREAD = 24;
+const int CLIP_MIN_BRIGHTNESS = 80;
+// Below the divider at the top of the track, in the clip's name strip
+const int CLIP_SAMPLE_OFFSET = 5;
+const int CLIP_MIN_WIDTH = 4;
+
+bool isClipPixel(const uint8_t* bgra) {
+    int hi = std::max(bgra[0], std::max(bgra[1], bgra[2]));
+    int lo = std::min(bgra[0], std::min(bgra[1], bgra[2]));
+    return hi - lo > CLIP_MIN_SPREAD || hi > CLIP_MIN_BRIGHTNESS;
+}
+
+/**
+ * Bit i set if pixel i of the 16 at bgra is a clip pixel
+ */
+inline uint32_t classifyClipPixels16(const uint8_t* bgra) {
+#if defined(__SSE2__)
+    const __m128i lowByte = _mm_set1_epi32(0xFF);
+    __m128i pixels[4];
+    for (int i = 0; i < 4; i++) {
+        pixels[i] = _mm_loadu_si128((const __m128i*)(bgra + i * 16));
+    }
+    // One byte per pixel for each of blue, green and red, like vld4q_u8 gives NEON for free
+    auto channel = [&](int shift) {
+        __m128i bytes[4];
+        for (int i = 0; i < 4; i++) {
+            bytes[i] = _mm_and_si128(_mm_srli_epi32(pixels[i], shift), lowByte);
+        }
+        return _mm_packus_epi16(_mm_packs_epi32(bytes[0], bytes[1]), _mm_packs_epi32(bytes[2], bytes[3]));
+    };
+    __m128i b = channel(0), g = channel(8), r = channel(16);
+    __m128i hi = _mm_max_epu8(b, _mm_max_epu8(g, r));
+    __m128i lo = _mm_min_epu8(b, _mm_min_epu8(g, r));
+    // No unsigned byte compare, a saturating subtract is only non zero when over the limit
+    __m128i over = _mm_or_si128(
+        _mm_subs_epu8(_mm_sub_epi8(hi, lo), _mm_set1_epi8(CLIP_MIN_SPREAD)),
+        _mm_subs_epu8(hi, _mm_set1_epi8(CLIP_MIN_BRIGHTNESS))
+    );
+    return ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(over, _mm_setzero_si128())) & 0xFFFF;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    static const uint8_t bitValues[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16x4_t pixels = vld4q_u8(bgra);
+    uint8x16_t hi = vmaxq_u8(pixels.val[0], vmaxq_u8(pixels.val[1], pixels.val[2]));
+    uint8x16_t lo = vminq_u8(pixels.val[0], vminq_u8(pixels.val[1], pixels.val[2]));
+    uint8x16_t clip = vorrq_u8(
+        vcgtq_u8(vsubq_u8(hi, lo), vdupq_n_u8(CLIP_MIN_SPREAD)),
+        vcgtq_u8(hi, vdupq_n_u8(CLIP_MIN_BRIGHTNESS))
+    );
+    // No movemask, weight each lane by its bit and add up each half instead
+    uint8x16_t bits = vandq_u8(clip, vld1q_u8(bitValues));
+    return (uint32_t)vaddv_u8(vget_low_u8(bits)) | ((uint32_t)vaddv_u8(vget_high_u8(bits)) << 8);
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < 16; i++) {
+        mask |= (uint32_t)isClipPixel(bgra + i * 4) << i;
+    }
+    return mask;
+#endif
+}
+
+void findClipSpans(const uint8_t* row, int pixels, int minWidth, std::vector<int32_t>& spans) {
+    int runStart = -1;
+    auto endRun = [&](int end) {
+        if (end - runStart >= minWidth) {
+            spans.push_back(runStart);
+            spans.push_back(end - runStart);
+        }
+        runStart = -1;
+    };
+
+    int x = 0;
+    for (; x + 16 <= pixels; x += 16) {
+        uint32_t mask = classifyClipPixels16(row + x * 4);
+        // Most blocks are all timeline or all clip, nothing to do unless that changes
+        if (mask == (runStart == -1 ? 0u : 0xFFFFu)) {
+            continue;
+        }
+        int i = 0;
+        while (i < 16) {
+            uint32_t rest = (runStart == -1 ? mask : ~mask & 0xFFFF) >> i;
+            if (rest == 0) {
+                break;
+            }
+            i += __builtin_ctz(rest);
+            if (runStart == -1) {
+                runStart = x + i;
+            } else {
+                endRun(x + i);
+            }
+        }
+    }
+    for (; x < pixels; x++) {
+        bool clip = isClipPixel(row + x * 4);
+        if (clip && runStart == -1) {
+            runStart = x;
+        } else if (!clip && runStart != -1) {
+            endRun(x);
+        }
+    }
+    if (runStart != -1) {
+        endRun(pixels);
+    }
+}
+
+void segmentArrangerClips(FrameImage* screenshot, const LayoutProfile& profile, const BitwigLayout& layout, const std::vector<ArrangerTrack>& tracks, ArrangerClips& clips) {
+    static auto& segmentTime = metricHistogram("detect.clips.segment.time");
+    static auto& clipsFound = metricCounter("detect.clips.found");
+    MetricTimer timer(segmentTime);
+    // Kept between calls so a frame's spans don't allocate
+    thread_local std::vector<int32_t> spans;
+
+    clips.clear();
+    clips.offsets.reserve(tracks.size() + 1);
+    clips.offsets.push_back(0);
+    if (!layout.arranger) {
+        clips.offsets.resize(tracks.size() + 1, 0);
+        return;
+    }
+    auto& arranger = layout.arranger->rect;
+    auto timelineEndX = std::min(arranger.x + arranger.w, screenshot->width);
+    for (auto& track : tracks) {
+        // Track rects end where the timeline starts, the 2px divider between is never a clip
+        auto timelineStartX = track.rect.x + track.rect.w;
+        auto rowTop = std::max(track.rect.y + 1, track.visibleRect.y);
+        auto rowBottom = std::min(
+            track.automationLanes.empty() ? track.rect.y + track.rect.h : track.automationLanes.front().y,
+            std::min(track.visibleRect.y + track.visibleRect.h, screenshot->height)
+        );
+        // The name strip may be scrolled away on a partial first track, the body is still coloured
+        auto sampleY = std::max(track.rect.y + profile.scale(CLIP_SAMPLE_OFFSET), rowTop);
+        if (track.header != HEADER_HIDDEN && sampleY < rowBottom && timelineStartX < timelineEndX) {
+            spans.clear();
+            auto row = screenshot->data + (size_t)sampleY * screenshot->bytesPerRow + (size_t)timelineStartX * 4;
+            findClipSpans(row, timelineEndX - timelineStartX, profile.scale(CLIP_MIN_WIDTH), spans);
+            for (size_t i = 0; i < spans.size(); i += 2) {
+                clips.rects.insert(clips.rects.end(), {
+                    timelineStartX + spans[i],
+                    rowTop,
+                    spans[i + 1],
+                    rowBottom - rowTop
+                });
+            }
+        }
+        clips.offsets.push_back((int32_t)(clips.rects.size() / 4));
+    }
+    clipsFound.add(clips.rects.size() / 4);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "detect.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Clips along each track's timeline row, found by run-length segmenting one row of pixels per
+ * track. Clips are coloured (or bright, when uncoloured and selected) against the dark grey
+ * timeline and its grid lines, so each row is classified 16 pixels at a time and only blocks
+ * where something changes are looked at pixel by pixel.
+ *
+ * Results are packed so they cross to JS as two Int32Arrays instead of an object per clip:
+ * track i's clips are rects[offsets[i] * 4 .. offsets[i + 1] * 4), each as x, y, w, h in the
+ * same pixels as the track rects.
+ */
+struct ArrangerClips {
+    std::vector<int32_t> offsets;
+    std::vector<int32_t> rects;
+    size_t trackCount() const {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+    size_t clipCount(size_t track) const {
+        return offsets[track + 1] - offsets[track];
+    }
+    void clear() {
+        offsets.clear();
+        rects.clear();
+    }
+};
+
+/**
+ * One BGRA pixel, what findClipSpans decides 16 at a time with SSE2 or NEON where it can
+ */
+bool isClipPixel(const uint8_t* bgra);
+
+/**
+ * Appends start, length pairs for each run of clip pixels in a row of BGRA pixels at least
+ * minWidth long (narrower runs are the playhead, cursor and such)
+ */
+void findClipSpans(const uint8_t* row, int pixels, int minWidth, std::vector<int32_t>& spans);
+
+/**
+ * Tracks as found by segmentArrangerTracks. Tracks scrolled so only their automation lanes show
+ * get no clips
+ */
+void segmentArrangerClips(FrameImage* screenshot, const LayoutProfile& profile, const BitwigLayout& layout, const std::vector<ArrangerTrack>& tracks, ArrangerClips& clips);
@@ -0,0 +1,74 @@
+#include "constraint.h"
+#include "input.h"
+
+PointerConstrainer pointerConstrainer;
+
+/**
+ * setPointerConstraint({ lockX, lockY, clamp: {x, y, w, h}, scale }). Locks hold the axis
+ * where the pointer is now. Replaces any previous constraint
+ */
+Napi::Value setPointerConstraint(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    PointerConstraint constraint;
+    if (info[0].IsObject()) {
+        Napi::Object obj = info[0].As<Napi::Object>();
+        constraint.lockX = obj.Has("lockX") && obj.Get("lockX").ToBoolean().Value();
+        constraint.lockY = obj.Has("lockY") && obj.Get("lockY").ToBoolean().Value();
+        if (obj.Has("clamp") && obj.Get("clamp").IsObject()) {
+            Napi::Object clamp = obj.Get("clamp").As<Napi::Object>();
+            constraint.clamp = true;
+            constraint.clampX = clamp.Get("x").As<Napi::Number>().DoubleValue();
+            constraint.clampY = clamp.Get("y").As<Napi::Number>().DoubleValue();
+            constraint.clampW = clamp.Get("w").As<Napi::Number>().DoubleValue();
+            constraint.clampH = clamp.Get("h").As<Napi::Number>().DoubleValue();
+        }
+        if (obj.Has("scale")) {
+            constraint.scale = obj.Get("scale").As<Napi::Number>().DoubleValue();
+        }
+    }
+    int x, y;
+    getMousePosition(x, y);
+    ensurePointerConstraintTap();
+    pointerConstrainer.set(constraint, x, y);
+    return Napi::Boolean::New(env, pointerConstrainer.isActive());
+}
+
+Napi::Value clearPointerConstraint(const Napi::CallbackInfo &info) {
+    pointerConstrainer.clear();
+    return info.Env().Undefined();
+}
+
+/**
+ * lockX(enabled = true) / lockY(enabled = true), shorthands for the above. Passing false
+ * clears the whole constraint
+ */
+Napi::Value lockAxis(const Napi::CallbackInfo &info, bool xAxis) {
+    Napi::Env env = info.Env();
+    if (info[0].IsBoolean() && !info[0].As<Napi::Boolean>().Value()) {
+        pointerConstrainer.clear();
+        return Napi::Boolean::New(env, false);
+    }
+    PointerConstraint constraint;
+    constraint.lockX = xAxis;
+    constraint.lockY = !xAxis;
+    int x, y;
+    getMousePosition(x, y);
+    ensurePointerConstraintTap();
+    pointerConstrainer.set(constraint, x, y);
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value lockX(const Napi::CallbackInfo &info) {
+    return lockAxis(info, true);
+}
+
+Napi::Value lockY(const Napi::CallbackInfo &info) {
+    return lockAxis(info, false);
+}
+
+void addPointerConstraintFunctions(Napi::Env env, Napi::Object keyboard) {
+    keyboard.Set(Napi::String::New(env, "setPointerConstraint"), Napi::Function::New(env, setPointerConstraint));
+    keyboard.Set(Napi::String::New(env, "clearPointerConstraint"), Napi::Function::New(env, clearPointerConstraint));
+    keyboard.Set(Napi::String::New(env, "lockX"), Napi::Function::New(env, lockX));
+    keyboard.Set(Napi::String::New(env, "lockY"), Napi::Function::New(env, lockY));
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <napi.h>
+#include "pointerconstraint.h"
+
+/**
+ * Keyboard.setPointerConstraint, clearPointerConstraint, lockX and lockY. The functions are
+ * the same on every platform, each backend applies pointerConstrainer to mouse moves as its
+ * tap (or XRecord) sees them and starts that with ensurePointerConstraintTap()
+ */
+extern PointerConstrainer pointerConstrainer;
+void ensurePointerConstraintTap();
+
+void addPointerConstraintFunctions(Napi::Env env, Napi::Object keyboard);
@@ -0,0 +1,475 @@
+#include "detect.h"
+#include "footerpanels.h"
+#include "headercontrols.h"
+#include "metrics.h"
+#include <cmath>
+#include <algorithm>
+
+float uiScale = 1;
+int scale(int point) {
+    return (int)round((float)point * uiScale);
+}
+std::string uiLayout = "Single Display (Large)";
+bool isLargeTrackHeight = true;
+
+int DIRECTION_UP = -1;
+int DIRECTION_DOWN = 1;
+int DIRECTION_LEFT = -1;
+int DIRECTION_RIGHT = 1;
+int AXIS_X = 0;
+int AXIS_Y = 1;
+
+// These are colors for midtones 28, black level 36
+// BenQ screen
+// MWColor trackSelectedColorActive = MWColor{141, 141, 141};
+// MWColor trackSelectedColorInactive = MWColor{97, 97, 97};
+// MWColor trackColor = MWColor{97, 97, 97};
+// MWColor panelBorder = MWColor{104, 104, 104};
+// MWColor trackAutomationBg = MWColor{34, 34, 34};
+// MWColor trackDivider = MWColor{6, 6, 6};
+// MWColor panelBorderInactive = MWColor{68, 68, 68};
+// MWColor panelOpenIcon = MWColor{240, 109, 39};
+// MWColor modalBgColor = MWColor{35, 35, 35};
+MWColor automationLaneDivider = MWColor{24, 24, 24};
+
+MWColor trackSelectedColorActive = MWColor{141, 141, 141};
+MWColor trackSelectedColorInactive = MWColor{97, 97, 97};
+MWColor trackColor = MWColor{68, 68, 68};
+MWColor panelBorder = MWColor{104, 104, 104};
+MWColor trackAutomationBg = MWColor{34, 34, 34};
+MWColor trackDivider = MWColor{6, 6, 6};
+MWColor panelBorderInactive = MWColor{68, 68, 68};
+MWColor panelOpenIcon = MWColor{236, 113, 37};
+MWColor modalBgColor = MWColor{35, 35, 35};
+
+/**
+ * MWRect
+ */
+XYPoint MWRect::fromBottomLeft(int x1, int y1) {
+    return XYPoint{x + x1, y + h - y1};
+}
+XYPoint MWRect::fromTopLeft(int x1, int y1) {
+    return XYPoint{x + x1, y + y1};
+}
+XYPoint MWRect::fromTopRight(int x1, int y1) {
+    return XYPoint{x + w - x1, y + y1};
+}
+XYPoint MWRect::fromBottomRight(int x1, int y1) {
+    return XYPoint{x + w - x1, y + h - y1};
+}
+
+/**
+ * MWColor
+ */
+bool MWColor::isWithinRange(MWColor other, int amount) {
+    return abs(other.r - r) < amount && abs(other.g - g) < amount && abs(other.b - b) < amount;
+};
+
+bool operator==(const MWRect& lhs, const MWRect& rhs)
+{
+    return lhs.x == rhs.x && lhs.y == rhs.y && lhs.w == rhs.w && lhs.h == rhs.h;
+};
+bool operator==(const XYPoint& lhs, const XYPoint& rhs)
+{
+    return lhs.x == rhs.x && lhs.y == rhs.y;
+};
+bool operator==(const UIPoint& lhs, const UIPoint& rhs)
+{
+    return lhs.point == rhs.point && lhs.window == rhs.window;
+};
+bool operator==(const MWColor& lhs, const MWColor& rhs)
+{
+    return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b;
+};
+
+/**
+ * FrameImage
+ */
+FrameImage::FrameImage(const uint8_t* data, size_t bytesPerRow, WindowInfo frame) {
+    this->data = data;
+    this->bytesPerRow = bytesPerRow;
+    this->frame = frame;
+    bytesPerPixel = 4;
+    width = frame.frame.w;
+    height = frame.frame.h;
+    maxInclOffset = getPixelOffset(XYPoint{width - 1, height - 1});
+}
+
+size_t FrameImage::getPixelOffset(XYPoint point) {
+    return (size_t)lround(point.y*bytesPerRow) + (size_t)lround(point.x*bytesPerPixel);
+};
+
+bool FrameImage::isWithinBounds(XYPoint point) {
+    return point.x >= 0 && point.y >= 0 && getPixelOffset(point) <= maxInclOffset;
+};
+
+MWColor FrameImage::colorAt(XYPoint point) {
+    size_t offset = getPixelOffset(point);
+    if (offset >= maxInclOffset) {
+        static auto& outOfRange = metricCounter("detect.offsetOutOfRange");
+        outOfRange.add();
+        return MWColor{0, 0, 0};
+    }
+    // int alpha = data[offset + 3],
+    int red = data[offset + 2],
+        green = data[offset + 1],
+        blue = data[offset + 0];
+    return MWColor{red, green, blue};
+};
+
+std::experimental::optional<XYPoint> FrameImage::seekUntilColor(
+    XYPoint startPoint,
+    std::function<bool(MWColor)> tester, 
+    int changeAxis,
+    int direction, 
+    int step
+) {
+    auto isYChanging = changeAxis == AXIS_Y;
+    auto endChange = isYChanging ? height - 1 : width - 1;
+    auto decreasing = direction == DIRECTION_UP || direction == DIRECTION_LEFT;
+    if (decreasing) {
+        endChange = 0;
+    }
+    int start = isYChanging ? startPoint.y : startPoint.x;
+    
+    for (int i = start; decreasing ? i >= endChange : i <= endChange; i += (direction * step)) {
+        auto point = isYChanging ? XYPoint{startPoint.x, i} : XYPoint{i, startPoint.y};
+        auto colorAtPoint = colorAt(point);
+        auto pointMatches = tester(colorAtPoint);
+        if (pointMatches) {
+            if (abs(step) > 1 && i != start) {
+                // Backtrack to find earliest match that we may have missed
+                for (int b = i - direction; b != i - (direction * step); b -= direction) {
+                    auto point = isYChanging ? XYPoint{startPoint.x, b} : XYPoint{b, startPoint.y};
+                    auto colorAtPoint = colorAt(point);
+                    auto pointMatches = tester(colorAtPoint);
+                    if (pointMatches) {
+                        return point;
+                    }
+                }
+            }
+            return point;
+        }
+    }
+
+    return {};
+};
+
+/**
+ * Layout detection
+ */
+int getMainPanelStartY(const LayoutProfile& profile, MWRect frame) {
+    auto headerHeight = profile.get(BITWIG_HEADER_HEIGHT);
+    if (frame.w <= profile.get(TOOLBAR_DOCK_WIDTH)) {
+        // TODO check exact height of switch, but toolbar will dock down below when there's not enough room for it
+        // Could be dynamic 😬  may need to do some pixel hunting
+        auto toolbarHeight = profile.get(BITWIG_HEADER_TOOLBAR_HEIGHT);
+        return headerHeight + toolbarHeight;
+    }
+    return headerHeight;
+}
+
+bool detectModalOpen(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame) {
+    return screenshot->colorAt(frame.fromBottomLeft(profile.get(MODAL_PROBE_X, true), profile.get(MODAL_PROBE_Y, true))).r == modalBgColor.r;
+}
+
+bool detectInspectorOpen(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame) {
+    return screenshot->colorAt(frame.fromBottomLeft(profile.get(INSPECTOR_ICON_X, true), profile.get(INSPECTOR_ICON_Y, true))).r == panelOpenIcon.r;
+}
+
+// Whether the footer icon at the given profile offsets is lit
+bool isPanelIconLit(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, LayoutConstant x, LayoutConstant y, MWColor color = panelOpenIcon) {
+    return screenshot->colorAt(frame.fromBottomLeft(profile.get(x, true), profile.get(y, true))).isWithinRange(color);
+}
+
+std::string detectPanelType(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame) {
+    static auto& probeFallbacks = metricCounter("detect.footer.probeFallbacks");
+    FooterPanels panels;
+    if (detectFooterPanels(screenshot, profile, frame, panels)) {
+        return footerPanelName(panels.open);
+    }
+    // Glyphs drawn some other way, one pixel per icon where the layout profile says
+    probeFallbacks.add();
+    if (isPanelIconLit(screenshot, profile, frame, DEVICE_ICON_X, DEVICE_ICON_Y)) {
+        return "device";
+    } else if (isPanelIconLit(screenshot, profile, frame, MIXER_ICON_X, MIXER_ICON_Y)) {
+        return "mixer";
+    } else if (isPanelIconLit(screenshot, profile, frame, AUTOMATION_ICON_X, AUTOMATION_ICON_Y, MWColor{153, 78, 32})) {
+        return "automation"; // FIX ME
+    } else if (isPanelIconLit(screenshot, profile, frame, DETAIL_ICON_X, DETAIL_ICON_Y)) {
+        return "detail";
+    }
+    return "";
+}
+
+void detectPanelSplit(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, bool inspectorOpen, const std::string& panelOpen, BitwigLayout& layout) {
+    static auto& panelSplitTime = metricHistogram("detect.layout.panelSplit.time");
+    auto arrangerStartY = getMainPanelStartY(profile, frame);
+    if (inspectorOpen) {
+        layout.inspector = Inspector{
+            .rect = MWRect{
+                0,
+                profile.scale(arrangerStartY),
+                profile.get(INSPECTOR_WIDTH, true),
+                frame.h - profile.scale(arrangerStartY + profile.get(BITWIG_FOOTER_HEIGHT))
+            }
+        };
+    }
+
+    auto arrangerStartX = inspectorOpen ? profile.get(INSPECTOR_WIDTH) : 4;
+    auto arrangerViewHeightPX = frame.h - profile.scale(arrangerStartY + profile.get(BITWIG_FOOTER_HEIGHT));
+    if (panelOpen != "") {
+        MetricTimer splitTimer(panelSplitTime);
+        // Find the horizontal split where the extra panel stops
+        auto minimumExtraPanel = 108; // Minimum possible height of any extra panel 
+        auto horizontalSplit = screenshot->seekUntilColor(
+            XYPoint{
+                profile.scale(arrangerStartX + 1), 
+                frame.h - profile.scale(profile.get(BITWIG_FOOTER_HEIGHT) + (int)((float)minimumExtraPanel * .8)) 
+            },
+            [](MWColor color) {
+                return color.r == panelBorder.r || color.r == panelBorderInactive.r;
+            },
+            AXIS_Y,
+            DIRECTION_UP,
+            // The border is a single row, stepping by 2 misses it whenever it's an odd number of
+            // rows up (e.g. at 125%)
+            1
+        ).value_or(XYPoint{-1, -1});
+
+        // Go up and right a bit so we can ensure we hit the flat edge of the border and not the rounded corners
+        auto arrangerYBottomBorder = screenshot->seekUntilColor(
+            XYPoint{horizontalSplit.x + profile.scale(20), horizontalSplit.y - profile.scale(3)},
+            [](MWColor color) {
+                return color.r == panelBorder.r || color.r == panelBorderInactive.r;
+            },
+            AXIS_Y,
+            DIRECTION_UP,
+            1
+        ).value_or(XYPoint{-1, -1});
+        arrangerViewHeightPX = arrangerYBottomBorder.y - profile.scale(arrangerStartY);      
+
+        layout.editor = EditorPanel{
+            .type = panelOpen,
+            .rect = MWRect{
+                profile.scale(arrangerStartX),
+                arrangerYBottomBorder.y,
+                frame.w - profile.scale(arrangerStartX),
+                frame.h - profile.get(BITWIG_FOOTER_HEIGHT, true) - arrangerYBottomBorder.y
+            }
+        };
+    }
+
+    layout.arranger = Arranger{
+        MWRect{
+            profile.scale(arrangerStartX),
+            profile.scale(arrangerStartY),
+            frame.w - profile.scale(arrangerStartX) - profile.scale(28),// 28 === scrollbar
+            arrangerViewHeightPX
+        }
+    };
+}
+
+BitwigLayout detectLayout(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame) {
+    static auto& layoutTime = metricHistogram("detect.layout.time");
+    MetricTimer timer(layoutTime);
+    auto layout = BitwigLayout();
+    if (detectModalOpen(screenshot, profile, frame)) {
+        layout.modalOpen = true;
+        return layout;
+    }
+    auto inspectorOpen = detectInspectorOpen(screenshot, profile, frame);
+    detectPanelSplit(screenshot, profile, frame, inspectorOpen, detectPanelType(screenshot, profile, frame), layout);
+    return layout;
+}
+
+int detectTrackWidth(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, bool inspectorOpen) {
+    static auto& widthTime = metricHistogram("detect.tracks.width.time");
+    static auto& widthNotFound = metricCounter("detect.tracks.widthNotFound");
+    MetricTimer widthTimer(widthTime);
+    auto arrangerStartX = inspectorOpen ? profile.get(INSPECTOR_WIDTH) : 4;
+    auto arrangerStartY = getMainPanelStartY(profile, frame);
+    auto arrangerTrackStartY = 42;
+    auto minimumPossibleTrackWidth = 210;
+    // Includes border at top, but not bottom, since first track starts with top border
+
+    // If we go too high here, the point will be affected by shadow from the top of arranger
+    // view which alters the colours, 6 becomes 5 etc...
+    auto startSearchPoint = XYPoint{
+        profile.scale(arrangerStartX + minimumPossibleTrackWidth),
+        profile.scale(arrangerStartY + arrangerTrackStartY + 15)
+    };
+
+    // Search right from minimum possible track width just a few Y pixels into first track. Of course, assumes arranger is open
+    auto endOfTrackWidthPoint = screenshot->seekUntilColor(
+        startSearchPoint,
+        [](MWColor color) {
+            return color.r == trackDivider.r;
+        },
+        AXIS_X,
+        DIRECTION_RIGHT,
+        2 // skip stays the same regardless of scale, we shouldn't lose that much speed and is safer
+    ).value_or(XYPoint{-1, -1});
+
+    // We gotta do 2 searches cause we could land on the horizontal line, which'll stunt our search
+    // Only run this is the first one comes back with the same x coord. Barely uses any extra processing
+    if (endOfTrackWidthPoint.x == startSearchPoint.x) {
+        auto endOfTrackWidthPoint2 = screenshot->seekUntilColor(
+            XYPoint{
+                startSearchPoint.x,
+                startSearchPoint.y + profile.scale(5)
+            },
+            [](MWColor color) {
+                return color.r == trackDivider.r;
+            },
+            AXIS_X,
+            DIRECTION_RIGHT,
+            2 // skip stays the same regardless of scale, we shouldn't lose that much speed and is safer
+        ).value_or(XYPoint{-1, -1});
+        if (endOfTrackWidthPoint2.x > endOfTrackWidthPoint.x) {
+            endOfTrackWidthPoint = endOfTrackWidthPoint2;
+        }
+    }
+
+    if (endOfTrackWidthPoint.x == -1) {
+        widthNotFound.add();
+        return -1;
+    }
+    return endOfTrackWidthPoint.x - profile.scale(arrangerStartX);
+}
+
+int findRowInColumn(FrameImage* screenshot, int x, int fromY, int toY, bool (*test)(MWColor)) {
+    for (int y = fromY; y < toY; y++) {
+        if (test(screenshot->colorAt(XYPoint{x, y}))) {
+            return y;
+        }
+    }
+    return toY;
+}
+
+void segmentArrangerTracks(FrameImage* screenshot, const LayoutProfile& profile, const BitwigLayout& layout, int trackWidthPX, std::vector<ArrangerTrack>& tracks) {
+    static auto& segmentTime = metricHistogram("detect.tracks.segment.time");
+    MetricTimer segmentTimer(segmentTime);
+    auto arrangerStartX = layout.inspector ? profile.get(INSPECTOR_WIDTH) : 4;
+    auto& arranger = (*layout.arranger).rect;
+    auto minimumTrackHeight = isLargeTrackHeight 
+        ? profile.get(MINIMUM_DOUBLE_TRACK_HEIGHT) 
+        : profile.get(MINIMUM_TRACK_HEIGHT);
+    // Each part scaled on its own, the way they're laid out, and the same place the ruler ends.
+    // Scaling the sum can land a pixel short at fractional scales, on the ruler's last row
+    auto tracksStartYPX = arranger.y + profile.get(ARRANGER_HEADER_HEIGHT, true);
+    auto minimumTrackHeightPX = profile.scale(minimumTrackHeight);
+    auto xSearchPX = profile.scale(arrangerStartX) + (trackWidthPX - profile.scale(1));
+    int trackI = 0;
+    auto tracksEndYPX = arranger.y + arranger.h - profile.get(ARRANGER_FOOTER_HEIGHT, true);
+
+    // Traverse down the arranger looking for pixels that are selection colour. Each track's
+    // header and automation lanes are walked in the same pass
+    for (int y = tracksStartYPX; y < tracksEndYPX;) {
+        auto trackBGColor = screenshot->colorAt(XYPoint{xSearchPX, y + profile.scale(5)});
+        if (trackBGColor.r == trackDivider.r && trackI != 0) {
+            // Empty space, reached last track
+            // Can't possibly be first track because no possible scroll position would allow for this (I don't think?)
+            break;
+        }
+        ArrangerTrack track{};
+        track.isLargeTrackHeight = isLargeTrackHeight;
+        track.selected = trackBGColor.r == trackSelectedColorActive.r || trackBGColor.r == trackSelectedColorInactive.r;
+
+        // If we've hit automation straight away, the whole track "header" is offscreen and only
+        // its lanes are showing
+        bool headerHidden = trackBGColor.r <= trackAutomationBg.r;
+        auto top = y;
+        auto headerEnd = y;
+        track.header = HEADER_HIDDEN;
+        if (!headerHidden) {
+            headerEnd = findRowInColumn(screenshot, xSearchPX, y + 1, tracksEndYPX, [](MWColor color) {
+                return color.r <= trackAutomationBg.r;
+            });
+            track.header = HEADER_VISIBLE;
+            if (trackI == 0 && headerEnd - y < minimumTrackHeightPX) {
+                // Scrolled so only the bottom of the header shows, put rect where the whole would be
+                track.header = HEADER_PARTIAL;
+                top = headerEnd - minimumTrackHeightPX;
+            }
+        }
+
+        auto trackEndXPX = profile.scale(arrangerStartX) + trackWidthPX;
+        auto automationTarget = XYPoint{
+            trackEndXPX - profile.scale(isLargeTrackHeight ? 21 : 36),
+            top + profile.scale(isLargeTrackHeight ? 33 : 14)
+        };
+        track.automationOpen = !headerHidden && automationTarget.y > y && screenshot->colorAt(automationTarget).isWithinRange(MWColor{253, 115, 42});
+        // Going by what's under the header rather than the icon, which can be scrolled out of view
+        bool hasLanes = headerHidden || (headerEnd < tracksEndYPX && screenshot->colorAt(XYPoint{xSearchPX, headerEnd}).r != trackDivider.r);
+
+        auto end = XYPoint{xSearchPX, y + minimumTrackHeightPX};
+        if (hasLanes) {
+            // Lanes are automation background split by lane dividers, walked row by row down to
+            // the track's own divider
+            end.y = tracksEndYPX;
+            for (int laneY = headerEnd; laneY < tracksEndYPX;) {
+                laneY = findRowInColumn(screenshot, xSearchPX, laneY, tracksEndYPX, [](MWColor color) {
+                    return color.r != automationLaneDivider.r;
+                });
+                if (laneY < tracksEndYPX && screenshot->colorAt(XYPoint{xSearchPX, laneY}).r == trackDivider.r) {
+                    end.y = laneY;
+                    break;
+                }
+                auto laneEnd = findRowInColumn(screenshot, xSearchPX, laneY, tracksEndYPX, [](MWColor color) {
+                    return color.r == automationLaneDivider.r || color.r == trackDivider.r;
+                });
+                if (laneEnd > laneY) {
+                    track.automationLanes.push_back(MWRect{
+                        profile.scale(arrangerStartX),
+                        laneY,
+                        trackWidthPX,
+                        laneEnd - laneY
+                    });
+                }
+                laneY = laneEnd;
+            }
+            track.automationOpen = true;
+        } else if (screenshot->colorAt(end).r != trackDivider.r) {
+            // Track height has been increased. Its header was already walked a row at a time down
+            // to the divider, which a seek stepping by 2 jumps over when every track is the same
+            // even height. For the first track that's also all that shows if it's cut off
+            end.y = headerEnd;
+        }
+        end.y = std::min(tracksEndYPX, end.y);
+
+        track.visibleRect = MWRect{
+            profile.scale(arrangerStartX),
+            y,
+            trackWidthPX,
+            end.y - y
+        };
+        track.rect = MWRect{
+            profile.scale(arrangerStartX),
+            top,
+            trackWidthPX,
+            (end.y - top)
+        };
+        findHeaderControls(screenshot, profile, trackBGColor, track);
+        tracks.push_back(std::move(track));
+        trackI++;
+        y = end.y;
+    };
+}
+
+bool detectArrangerTracks(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, const BitwigLayout& layout, std::vector<ArrangerTrack>& tracks) {
+    static auto& tracksTime = metricHistogram("detect.tracks.time");
+    MetricTimer timer(tracksTime);
+    if (layout.modalOpen || !layout.arranger) {
+        // Settings or a popup open
+        static auto& hidden = metricCounter("detect.tracks.arrangerHidden");
+        hidden.add();
+        return false;
+    }
+    auto trackWidthPX = detectTrackWidth(screenshot, profile, frame, !!layout.inspector);
+    if (trackWidthPX == -1) {
+        return false;
+    }
+    segmentArrangerTracks(screenshot, profile, layout, trackWidthPX, tracks);
+    return true;
+}
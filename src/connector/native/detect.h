@@ -0,0 +1,172 @@
+#pragma once
+#include "layoutprofile.h"
+#include <experimental/optional>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#ifdef __APPLE__
+#include <CoreGraphics/CoreGraphics.h>
+typedef CGWindowID NativeWindowId;
+#else
+typedef unsigned long NativeWindowId;
+#endif
+
+/**
+ * Geometry, pixel access and layout detection over a captured frame. Nothing in here needs
+ * N-API or a window system so it can be linked into bes_bench, the toJSObject/fromJSObject
+ * halves are only declared here and live in ui.cc.
+ */
+namespace Napi {
+    class Env;
+    class Object;
+}
+
+struct XYPoint {
+    int x, y;
+    Napi::Object toJSObject(Napi::Env env);
+    static XYPoint fromJSObject(Napi::Object obj, Napi::Env env);
+};
+struct UIPoint {
+    int window;
+    XYPoint point;
+};
+struct MWRect {
+    int x, y, w, h;
+    Napi::Object toJSObject(Napi::Env env);
+    static MWRect fromJSObject(Napi::Object obj, Napi::Env env);
+    XYPoint fromBottomLeft(int x, int y);
+    XYPoint fromTopLeft(int x, int y);
+    XYPoint fromTopRight(int x, int y);
+    XYPoint fromBottomRight(int x, int y);
+};
+struct WindowInfo {
+    NativeWindowId windowId;
+    MWRect frame;
+};
+struct MWColor {
+    int r, g, b;
+    Napi::Object toJSObject(Napi::Env env);
+    static MWColor fromJSObject(Napi::Object obj, Napi::Env env);
+    bool isWithinRange(MWColor b, int amount = 5);
+};
+bool operator==(const XYPoint& lhs, const XYPoint& rhs);
+bool operator==(const MWRect& lhs, const MWRect& rhs);
+bool operator==(const MWColor& lhs, const MWColor& rhs);
+
+struct EditorPanel {
+    std::string type;
+    MWRect rect;
+    Napi::Object toJSObject(Napi::Env env);
+};
+struct Inspector {
+    MWRect rect;
+    Napi::Object toJSObject(Napi::Env env);
+};
+struct Arranger {
+    MWRect rect;
+    Napi::Object toJSObject(Napi::Env env);
+};
+struct BitwigLayout {
+    std::experimental::optional<EditorPanel> editor;
+    std::experimental::optional<Inspector> inspector;
+    std::experimental::optional<Arranger> arranger;
+    bool modalOpen;
+    Napi::Object toJSObject(Napi::Env env);
+};
+enum TrackHeaderState {
+    HEADER_VISIBLE,
+    // First track, scrolled so only the bottom of its header shows. rect extends above visibleRect
+    HEADER_PARTIAL,
+    // Scrolled so only automation lanes show, rect is just what's visible
+    HEADER_HIDDEN
+};
+/**
+ * A button or the fold arrow in a track header. on is engaged for buttons, unfolded for the arrow
+ */
+struct HeaderControl {
+    MWRect rect;
+    bool on;
+    Napi::Object toJSObject(Napi::Env env);
+};
+struct ArrangerTrack {
+    MWRect rect, visibleRect;
+    bool selected, automationOpen, isLargeTrackHeight;
+    TrackHeaderState header;
+    // Visible part of each open automation lane, top to bottom
+    std::vector<MWRect> automationLanes;
+    // Whichever of these are fully visible, fold is only there on group tracks
+    std::experimental::optional<HeaderControl> mute, solo, arm, fold;
+    Napi::Object toJSObject(Napi::Env env);
+    static ArrangerTrack fromJSObject(Napi::Object obj, Napi::Env env);
+};
+
+/**
+ * A BGRA frame that someone else owns. ImageDeets (ui.h) adds the platform capture handles,
+ * bes_bench points one at a painted fixture
+ */
+struct FrameImage {
+    const uint8_t* data;
+    size_t bytesPerRow;
+    size_t bytesPerPixel;
+    WindowInfo frame;
+    size_t maxInclOffset;
+    int width, height;
+    FrameImage() = default;
+    FrameImage(const uint8_t* data, size_t bytesPerRow, WindowInfo frame);
+    size_t getPixelOffset(XYPoint point);
+    bool isWithinBounds(XYPoint point);
+    MWColor colorAt(XYPoint point);
+
+    std::experimental::optional<XYPoint> seekUntilColor(
+        XYPoint startPoint,
+        std::function<bool(MWColor)> tester,
+        int changeAxis,
+        int direction,
+        int step = 1
+    );
+};
+
+extern int DIRECTION_UP, DIRECTION_DOWN, DIRECTION_LEFT, DIRECTION_RIGHT;
+extern int AXIS_X, AXIS_Y;
+
+extern MWColor trackSelectedColorActive, trackSelectedColorInactive, trackColor, panelBorder,
+    trackAutomationBg, trackDivider, panelBorderInactive, panelOpenIcon, modalBgColor, automationLaneDivider;
+
+/**
+ * Set from JS with UI.updateUILayoutInfo, which then calls selectLayoutProfile
+ */
+extern float uiScale;
+extern bool isLargeTrackHeight;
+// Bitwig's display profile, the default for windows that don't have their own
+extern std::string uiLayout;
+int scale(int point);
+
+/**
+ * Where the arranger, inspector and editor panel are in the frame. frame is the window's
+ * rect, the image covers it from 0, 0
+ */
+int getMainPanelStartY(const LayoutProfile& profile, MWRect frame);
+BitwigLayout detectLayout(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame);
+
+/**
+ * Track headers down the arranger, false if the arranger isn't visible or the track column
+ * couldn't be found
+ */
+bool detectArrangerTracks(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, const BitwigLayout& layout, std::vector<ArrangerTrack>& tracks);
+
+/**
+ * The stages the two above are made of, run separately by the detection graph (detectgraph.h).
+ * detectPanelType matches the footer's panel glyphs (footerpanels.h), falling back to the layout
+ * profile's icon offsets. detectPanelSplit fills in the inspector, editor and arranger rects,
+ * detectTrackWidth returns -1 if it can't find the end of the track headers
+ */
+bool detectModalOpen(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame);
+bool detectInspectorOpen(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame);
+std::string detectPanelType(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame);
+void detectPanelSplit(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, bool inspectorOpen, const std::string& panelOpen, BitwigLayout& layout);
+int detectTrackWidth(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, bool inspectorOpen);
+// First y in [fromY, toY) down column x whose colour passes test, toY if none do
+int findRowInColumn(FrameImage* screenshot, int x, int fromY, int toY, bool (*test)(MWColor));
+void segmentArrangerTracks(FrameImage* screenshot, const LayoutProfile& profile, const BitwigLayout& layout, int trackWidthPX, std::vector<ArrangerTrack>& tracks);
@@ -0,0 +1,101 @@
+#include "detectgraph.h"
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+DetectionGraph::DetectionGraph() {
+    // Enough for the graphs we build, so adding stages doesn't reallocate
+    stages.reserve(8);
+}
+
+DetectionGraph::StageId DetectionGraph::add(MetricHistogram& time, std::vector<StageId> dependencies, std::function<void()> run) {
+    auto id = stages.size();
+    for (auto dependency : dependencies) {
+        if (dependency >= id) {
+            throw std::logic_error("Detection stages can only depend on earlier ones");
+        }
+    }
+    stages.push_back(Stage{&time, std::move(run)});
+    return id;
+}
+
+void DetectionGraph::run() {
+    for (auto& stage : stages) {
+        MetricTimer timer(*stage.time);
+        stage.run();
+    }
+}
+
+UISnapshot detectUISnapshot(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, bool withClips) {
+    static auto& snapshotTime = metricHistogram("detect.snapshot.time");
+    static auto& modalTime = metricHistogram("detect.graph.modal");
+    static auto& inspectorTime = metricHistogram("detect.graph.inspector");
+    static auto& panelTypeTime = metricHistogram("detect.graph.panelType");
+    static auto& panelSplitTime = metricHistogram("detect.graph.panelSplit");
+    static auto& trackWidthTime = metricHistogram("detect.graph.trackWidth");
+    static auto& tracksTime = metricHistogram("detect.graph.tracks");
+    static auto& clipsTime = metricHistogram("detect.graph.clips");
+    MetricTimer timer(snapshotTime);
+
+    // Stages capture just a pointer to this so they fit in std::function without allocating
+    struct {
+        FrameImage* screenshot;
+        const LayoutProfile* profile;
+        MWRect frame;
+        UISnapshot snapshot;
+        bool inspectorOpen = false;
+        std::string panelOpen;
+        int trackWidthPX = -1;
+    } work;
+    work.screenshot = screenshot;
+    work.profile = &profile;
+    work.frame = frame;
+    auto w = &work;
+
+    DetectionGraph graph;
+    auto modal = graph.add(modalTime, {}, [w]() {
+        w->snapshot.layout.modalOpen = detectModalOpen(w->screenshot, *w->profile, w->frame);
+    });
+    // Nothing else means anything with a modal up, so everything waits to find out first
+    auto inspector = graph.add(inspectorTime, {modal}, [w]() {
+        w->inspectorOpen = !w->snapshot.layout.modalOpen && detectInspectorOpen(w->screenshot, *w->profile, w->frame);
+    });
+    auto panelType = graph.add(panelTypeTime, {modal}, [w]() {
+        if (!w->snapshot.layout.modalOpen) {
+            w->panelOpen = detectPanelType(w->screenshot, *w->profile, w->frame);
+        }
+    });
+    auto panelSplit = graph.add(panelSplitTime, {inspector, panelType}, [w]() {
+        if (!w->snapshot.layout.modalOpen) {
+            detectPanelSplit(w->screenshot, *w->profile, w->frame, w->inspectorOpen, w->panelOpen, w->snapshot.layout);
+        }
+    });
+    auto trackWidth = graph.add(trackWidthTime, {inspector}, [w]() {
+        if (!w->snapshot.layout.modalOpen) {
+            w->trackWidthPX = detectTrackWidth(w->screenshot, *w->profile, w->frame, w->inspectorOpen);
+        }
+    });
+    auto tracks = graph.add(tracksTime, {panelSplit, trackWidth}, [w]() {
+        if (!w->snapshot.layout.modalOpen && w->trackWidthPX != -1) {
+            segmentArrangerTracks(w->screenshot, *w->profile, w->snapshot.layout, w->trackWidthPX, w->snapshot.tracks);
+            w->snapshot.tracksFound = true;
+        }
+    });
+    if (withClips) {
+        graph.add(clipsTime, {tracks}, [w]() {
+            if (w->snapshot.tracksFound) {
+                segmentArrangerClips(w->screenshot, *w->profile, w->snapshot.layout, w->snapshot.tracks, w->snapshot.clips);
+                w->snapshot.clipsFound = true;
+            }
+        });
+    }
+    graph.run();
+    return std::move(work.snapshot);
+}
+
+WorkerPool& getDetectionPool() {
+    // Detection is CPU bound, no point in more threads than cores. Never destroyed, its
+    // threads are still waiting on it at exit
+    static WorkerPool* pool = new WorkerPool(std::max(1u, std::thread::hardware_concurrency()));
+    return *pool;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "clips.h"
+#include "detect.h"
+#include "metrics.h"
+#include "workerpool.h"
+#include <functional>
+#include <vector>
+
+/**
+ * A small dependency graph of detection stages over one frame, each timed on its own. Stages
+ * run in the order they were added, which dependencies must respect. Running independent
+ * stages at once on a pool measured slower than this for a single frame (the stages are a few
+ * µs each, less than a hand off), so parallelism is across windows instead, see getLayoutStates
+ */
+class DetectionGraph {
+public:
+    typedef size_t StageId;
+private:
+    struct Stage {
+        MetricHistogram* time;
+        std::function<void()> run;
+    };
+    std::vector<Stage> stages;
+public:
+    DetectionGraph();
+    StageId add(MetricHistogram& time, std::vector<StageId> dependencies, std::function<void()> run);
+    void run();
+};
+
+/**
+ * Everything detected from one capture, see detectUISnapshot
+ */
+struct UISnapshot {
+    BitwigLayout layout;
+    bool tracksFound = false;
+    std::vector<ArrangerTrack> tracks;
+    // Only looked for when asked
+    bool clipsFound = false;
+    ArrangerClips clips;
+    Napi::Object toJSObject(Napi::Env env);
+};
+
+/**
+ * Layout and arranger tracks from a single frame: modal check, then inspector and panel type,
+ * then the panel split and track width side by side, then track segmentation and, with
+ * withClips, clip segmentation. Everything is measured with profile, the window's own
+ */
+UISnapshot detectUISnapshot(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, bool withClips = false);
+
+/**
+ * Lives for the life of the process, one thread per core
+ */
+WorkerPool& getDetectionPool();
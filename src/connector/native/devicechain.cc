@@ -0,0 +1,131 @@
+#include "devicechain.h"
+#include "metrics.h"
+#include "pixelrows.h"
+
+// Panel background and device bodies are darker than this, headers lighter
+const int DEVICE_HEADER_BRIGHTNESS = 70;
+const int DEVICE_SELECTED_BRIGHTNESS = 100;
+const int DEVICE_SCROLL_THUMB_BRIGHTNESS = 80;
+// Unscaled, from the top of the chain rect: the header band and a row through device bodies,
+// which only a collapsed device's strip is lit all the way across
+const int DEVICE_HEADER_TOP = 4;
+const int DEVICE_HEADER_HEIGHT = 22;
+const int DEVICE_HEADER_ROW = 15;
+const int DEVICE_BODY_ROW = 40;
+// Unscaled, from the bottom of the chain rect
+const int DEVICE_SCROLLBAR_ROW = 6;
+const int DEVICE_STRIP_BOTTOM = 12;
+const int DEVICE_MIN_WIDTH = 10;
+
+const uint8_t* devicePixel(FrameImage* screenshot, int x, int y) {
+    return screenshot->data + (size_t)y * screenshot->bytesPerRow + (size_t)x * screenshot->bytesPerPixel;
+}
+
+int deviceHeaderY(const LayoutProfile& profile, const MWRect& rect) {
+    return rect.y + profile.scale(DEVICE_HEADER_ROW);
+}
+
+int deviceBodyY(const LayoutProfile& profile, const MWRect& rect) {
+    return rect.y + profile.scale(DEVICE_BODY_ROW);
+}
+
+int deviceScrollbarY(const LayoutProfile& profile, const MWRect& rect) {
+    return rect.y + rect.h - profile.scale(DEVICE_SCROLLBAR_ROW);
+}
+
+bool getDeviceChainRect(const LayoutProfile& profile, const BitwigLayout& layout, MWRect& rect) {
+    if (!layout.editor || layout.editor->type != "device" || layout.modalOpen) {
+        return false;
+    }
+    // The editor rect starts on the arranger's bottom border, the panel's own is below the gap.
+    // The gap scales, the 1px border doesn't
+    auto& editor = layout.editor->rect;
+    auto top = profile.scale(5) + 1;
+    rect = MWRect{
+        editor.x + profile.scale(4),
+        editor.y + top,
+        editor.w - profile.scale(8),
+        editor.h - top
+    };
+    return rect.w > 0 && rect.h > profile.scale(DEVICE_BODY_ROW + DEVICE_STRIP_BOTTOM);
+}
+
+void detectDeviceChain(FrameImage* screenshot, const LayoutProfile& profile, MWRect rect, DeviceChain& chain) {
+    static auto& detectTime = metricHistogram("detect.devices.time");
+    static auto& devicesFound = metricCounter("detect.devices.found");
+    MetricTimer timer(detectTime);
+    thread_local std::vector<int32_t> spans;
+    chain.clear();
+    chain.rect = rect;
+    if (rect.x < 0 || rect.y < 0 || rect.x + rect.w > screenshot->width || rect.y + rect.h > screenshot->height) {
+        return;
+    }
+
+    spans.clear();
+    findLitSpans(devicePixel(screenshot, rect.x, deviceHeaderY(profile, rect)), rect.w, DEVICE_HEADER_BRIGHTNESS, profile.scale(DEVICE_MIN_WIDTH), spans);
+    auto body = devicePixel(screenshot, rect.x, deviceBodyY(profile, rect));
+    for (size_t i = 0; i < spans.size(); i += 2) {
+        auto start = spans[i], width = spans[i + 1];
+        int bodyLit = 0;
+        for (int x = start; x < start + width; x++) {
+            bodyLit += isLitPixel(body + x * 4, DEVICE_HEADER_BRIGHTNESS);
+        }
+        uint8_t flags = 0;
+        // Devices draw knobs and such in their bodies, a collapsed strip is lit right across
+        if (bodyLit * 10 >= width * 9) {
+            flags |= DEVICE_COLLAPSED;
+        }
+        if (isLitPixel(devicePixel(screenshot, rect.x + start + width / 2, deviceHeaderY(profile, rect)), DEVICE_SELECTED_BRIGHTNESS)) {
+            flags |= DEVICE_SELECTED;
+        }
+        if (start == 0 || start + width == rect.w) {
+            flags |= DEVICE_CLIPPED;
+        }
+        auto top = rect.y + profile.scale(DEVICE_HEADER_TOP);
+        auto height = flags & DEVICE_COLLAPSED
+            ? rect.y + rect.h - profile.scale(DEVICE_STRIP_BOTTOM) - top
+            : profile.scale(DEVICE_HEADER_HEIGHT);
+        chain.slots.insert(chain.slots.end(), {rect.x + start, top, width, height});
+        chain.flags.push_back(flags);
+    }
+    devicesFound.add(chain.flags.size());
+
+    // No thumb, no scrollbar: everything fits
+    spans.clear();
+    findLitSpans(devicePixel(screenshot, rect.x, deviceScrollbarY(profile, rect)), rect.w, DEVICE_SCROLL_THUMB_BRIGHTNESS, profile.scale(DEVICE_MIN_WIDTH), spans);
+    if (spans.size() == 2) {
+        chain.scrollStart = (double)spans[0] / rect.w;
+        chain.scrollEnd = (double)(spans[0] + spans[1]) / rect.w;
+    }
+}
+
+/**
+ * DeviceChainCache
+ */
+uint64_t DeviceChainCache::hashRows(FrameImage* screenshot, const LayoutProfile& profile, const MWRect& rect) {
+    uint64_t rowsHash = hashPixelRow(devicePixel(screenshot, rect.x, deviceHeaderY(profile, rect)), rect.w);
+    rowsHash = hashPixelRow(devicePixel(screenshot, rect.x, deviceBodyY(profile, rect)), rect.w, rowsHash);
+    return hashPixelRow(devicePixel(screenshot, rect.x, deviceScrollbarY(profile, rect)), rect.w, rowsHash);
+}
+
+DeviceChain* DeviceChainCache::update(FrameImage* screenshot, const LayoutProfile& profile, const BitwigLayout& layout) {
+    static auto& cacheHits = metricCounter("devices.cache.hits");
+    static auto& cacheMisses = metricCounter("devices.cache.misses");
+    lastUpdateCached = false;
+    MWRect rect;
+    if (!getDeviceChainRect(profile, layout, rect) || rect.x + rect.w > screenshot->width || rect.y + rect.h > screenshot->height) {
+        return nullptr;
+    }
+    auto rowsHash = hashRows(screenshot, profile, rect);
+    if (valid && rowsHash == hash && rect == chain.rect && hashProfile == &profile) {
+        cacheHits.add();
+        lastUpdateCached = true;
+        return &chain;
+    }
+    cacheMisses.add();
+    detectDeviceChain(screenshot, profile, rect, chain);
+    hash = rowsHash;
+    hashProfile = &profile;
+    valid = true;
+    return &chain;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "detect.h"
+#include <cstdint>
+#include <vector>
+
+enum DeviceSlotFlags {
+    DEVICE_COLLAPSED = 1,
+    DEVICE_SELECTED = 2,
+    // Cut off by the edge of the panel, scrolled partly out of view
+    DEVICE_CLIPPED = 4
+};
+
+/**
+ * The devices in the device panel, left to right. Each device's header is a lighter band along
+ * its top (the whole strip when it's collapsed), so one row through the band split into runs
+ * gives every device. Packed like ArrangerClips: slots has x, y, w, h of each header and flags
+ * the matching DeviceSlotFlags.
+ *
+ * scrollStart and scrollEnd are the visible part of the chain as fractions of its whole width,
+ * from the scrollbar thumb. 0 and 1 when it all fits.
+ */
+struct DeviceChain {
+    // Where devices are drawn, inside the panel's border
+    MWRect rect{0, 0, 0, 0};
+    std::vector<int32_t> slots;
+    std::vector<uint8_t> flags;
+    double scrollStart = 0, scrollEnd = 1;
+    size_t deviceCount() const {
+        return flags.size();
+    }
+    void clear() {
+        slots.clear();
+        flags.clear();
+        scrollStart = 0;
+        scrollEnd = 1;
+    }
+    Napi::Object toJSObject(Napi::Env env);
+};
+
+/**
+ * False unless the device panel is open
+ */
+bool getDeviceChainRect(const LayoutProfile& profile, const BitwigLayout& layout, MWRect& rect);
+void detectDeviceChain(FrameImage* screenshot, const LayoutProfile& profile, MWRect rect, DeviceChain& chain);
+
+/**
+ * Keeps a window's last device chain along with a hash of the rows detectDeviceChain reads, which
+ * are all it depends on. Nothing is detected again until one of them changes
+ */
+class DeviceChainCache {
+    DeviceChain chain;
+    uint64_t hash = 0;
+    // What it was detected with, a new profile (say a scale change) moves every row
+    const LayoutProfile* hashProfile = nullptr;
+    bool valid = false;
+    uint64_t hashRows(FrameImage* screenshot, const LayoutProfile& profile, const MWRect& rect);
+public:
+    // Whether the last update could use what was already there
+    bool lastUpdateCached = false;
+
+    // nullptr if the device panel isn't open
+    DeviceChain* update(FrameImage* screenshot, const LayoutProfile& profile, const BitwigLayout& layout);
+    void reset() {
+        valid = false;
+    }
+};
@@ -0,0 +1,139 @@
+#include "footerpanels.h"
+#include "metrics.h"
+#include <algorithm>
+
+// 1x masks, '#' lit. Drawn by hand after Bitwig 5's footer icons rather than traced from a
+// capture, so compare them with one when a version redraws the icons. The stand-in paints these
+// same masks, so its frames can't show they're right
+const char* const DEVICE_PANEL_GLYPH[] = {
+    "...#####...",
+    "..#.....#..",
+    ".#.......#.",
+    "#.........#",
+    "#....#....#",
+    "#....#....#",
+    "#.........#",
+    ".#.......#.",
+    "..#.....#..",
+    "...#####...",
+};
+const char* const MIXER_PANEL_GLYPH[] = {
+    ".#...#...#.",
+    ".#...#...#.",
+    "###..#...#.",
+    ".#...#..###",
+    ".#...#...#.",
+    ".#..###..#.",
+    ".#...#...#.",
+    ".#...#...#.",
+    ".#...#...#.",
+    "###########",
+};
+const char* const AUTOMATION_PANEL_GLYPH[] = {
+    "..........#",
+    ".........#.",
+    "........#..",
+    ".......#...",
+    "......#....",
+    ".....#.....",
+    "....#......",
+    "...#.......",
+    "..#........",
+    "###########",
+};
+const char* const DETAIL_PANEL_GLYPH[] = {
+    "###########",
+    "#.........#",
+    "#.###.....#",
+    "#.........#",
+    "#.........#",
+    "#....####.#",
+    "#.........#",
+    "#.##......#",
+    "#.........#",
+    "###########",
+};
+
+// Lit is this much brighter than the footer, and never darker than the minimum
+const int FOOTER_GLYPH_MIN_CONTRAST = 30;
+const int FOOTER_GLYPH_MIN_BRIGHTNESS = 100;
+// An open panel's glyph is orange, a closed one grey
+const int FOOTER_OPEN_RED_OVER_BLUE = 60;
+
+const char* footerPanelName(int panel) {
+    static const char* names[FOOTER_PANEL_COUNT] = {"device", "mixer", "automation", "detail"};
+    return panel >= 0 && panel < FOOTER_PANEL_COUNT ? names[panel] : "";
+}
+
+int FooterPanels::iconsFound() const {
+    int found = 0;
+    for (auto& icon : icons) {
+        found += icon.w > 0;
+    }
+    return found;
+}
+
+const FooterGlyphs& getFooterGlyphs(float scale) {
+    thread_local float cachedScale = 0;
+    thread_local FooterGlyphs glyphs;
+    if (scale != cachedScale) {
+        glyphs.icons[PANEL_DEVICE] = makeGlyph(DEVICE_PANEL_GLYPH, scale);
+        glyphs.icons[PANEL_MIXER] = makeGlyph(MIXER_PANEL_GLYPH, scale);
+        glyphs.icons[PANEL_AUTOMATION] = makeGlyph(AUTOMATION_PANEL_GLYPH, scale);
+        glyphs.icons[PANEL_DETAIL] = makeGlyph(DETAIL_PANEL_GLYPH, scale);
+        cachedScale = scale;
+    }
+    return glyphs;
+}
+
+bool detectFooterPanels(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, FooterPanels& panels) {
+    static auto& detectTime = metricHistogram("detect.footer.time");
+    static auto& iconsFound = metricCounter("detect.footer.icons.found");
+    MetricTimer timer(detectTime);
+    thread_local LitBits bits;
+    thread_local std::vector<MWRect> blobs;
+    panels = FooterPanels();
+
+    // Anywhere in the left of the footer, the toggles move about between versions
+    auto top = frame.fromBottomLeft(0, profile.get(BITWIG_FOOTER_HEIGHT, true));
+    auto area = MWRect{
+        std::max(0, top.x),
+        std::max(0, top.y),
+        std::min(screenshot->width, top.x + std::min(frame.w, profile.get(FOOTER_PANEL_SEARCH_WIDTH, true))) - std::max(0, top.x),
+        std::min(screenshot->height, frame.y + frame.h) - std::max(0, top.y)
+    };
+    if (area.w <= 0 || area.h <= 0) {
+        return false;
+    }
+
+    auto background = screenshot->colorAt(XYPoint{area.x + 1, area.y + area.h - 2});
+    auto threshold = std::min(254, std::max(FOOTER_GLYPH_MIN_BRIGHTNESS, std::max(background.r, std::max(background.g, background.b)) + FOOTER_GLYPH_MIN_CONTRAST));
+    auto& glyphs = getFooterGlyphs(profile.uiScale);
+    int widest = 0;
+    for (auto& mask : glyphs.icons) {
+        widest = std::max(widest, mask.w);
+    }
+    bits.fill(screenshot, area, threshold);
+    findLitBlobs(bits, widest + 2, blobs);
+
+    for (int i = 0; i < FOOTER_PANEL_COUNT; i++) {
+        auto& mask = glyphs.icons[i];
+        auto match = matchGlyph(bits, blobs, mask, false);
+        if (match.x == -1) {
+            continue;
+        }
+        panels.icons[i] = MWRect{area.x + match.x, area.y + match.y, mask.w, mask.h};
+        // The colour of the glyph's most lit row, at its first lit pixel
+        auto row = mask.order[0];
+        auto color = screenshot->colorAt(XYPoint{
+            area.x + match.x + __builtin_ctzll(mask.rows[row]),
+            area.y + match.y + row
+        });
+        if (panels.open == -1 && color.r - color.b > FOOTER_OPEN_RED_OVER_BLUE) {
+            panels.open = i;
+        }
+    }
+    auto found = panels.iconsFound();
+    iconsFound.add(found);
+    return found > 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "detect.h"
+#include "glyphmatch.h"
+
+/**
+ * The editor panel toggles in Bitwig's footer. Each is a small glyph, grey until its panel is
+ * open and then orange. Rather than reading one pixel at an offset measured for each scale, the
+ * glyphs are matched anywhere in the left of the footer (see glyphmatch.h), which finds them at
+ * any scale and wherever a version puts them.
+ */
+enum FooterPanel {
+    PANEL_DEVICE,
+    PANEL_MIXER,
+    PANEL_AUTOMATION,
+    PANEL_DETAIL,
+    FOOTER_PANEL_COUNT
+};
+
+struct FooterPanels {
+    // Each panel's glyph, w of 0 where it wasn't found
+    MWRect icons[FOOTER_PANEL_COUNT];
+    // A FooterPanel, -1 if none is open
+    int open = -1;
+    int iconsFound() const;
+    Napi::Object toJSObject(Napi::Env env);
+};
+
+/**
+ * "device", "mixer", "automation" and "detail", as EditorPanel::type
+ */
+const char* footerPanelName(int panel);
+
+/**
+ * The masks are drawn at 1x and resampled for other scales, cached per thread by scale
+ */
+struct FooterGlyphs {
+    GlyphMask icons[FOOTER_PANEL_COUNT];
+};
+const FooterGlyphs& getFooterGlyphs(float scale);
+
+/**
+ * False if none of the glyphs were found, e.g. a Bitwig version that draws them differently.
+ * frame is the window's rect as for detectLayout
+ */
+bool detectFooterPanels(FrameImage* screenshot, const LayoutProfile& profile, MWRect frame, FooterPanels& panels);
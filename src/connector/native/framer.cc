@@ -0,0 +1,191 @@
+#include "framer.h"
+#include <algorithm>
+#include <cstring>
+
+// Far beyond anything the controller sends (a whole project is a few MB). A longer prefix means
+// we're reading something that isn't a length, don't buffer until it overflows
+const size_t FRAMER_MAX_PACKET_UNITS = 1 << 28;
+
+void PacketFramer::push(const uint8_t* data, size_t length, std::vector<PacketFrame>& frames) {
+    size_t i = 0;
+    while (i < length) {
+        if (state == State::Length) {
+            uint8_t b = data[i];
+            if (b >= '0' && b <= '9') {
+                unitsLeft = unitsLeft * 10 + (b - '0');
+                if (unitsLeft > FRAMER_MAX_PACKET_UNITS) {
+                    unitsLeft = 0;
+                    state = State::Skip;
+                }
+                i++;
+            } else if (unitsLeft == 0) {
+                // Not a packet we understand (or an empty one), skip until the next length
+                i++;
+            } else {
+                // The first non digit starts the body
+                state = State::Body;
+            }
+            continue;
+        }
+        if (state == State::Skip) {
+            // The rest of the digits, then the usual skipping until the next length
+            if (data[i] >= '0' && data[i] <= '9') {
+                i++;
+            } else {
+                state = State::Length;
+            }
+            continue;
+        }
+
+        size_t start = i;
+        while (i < length && (unitsLeft > 0 || continuationLeft > 0)) {
+            if (continuationLeft == 0) {
+                // Packets are nearly all ASCII, take 8 bytes at a time while we can
+                while (unitsLeft >= 8 && i + 8 <= length) {
+                    uint64_t word;
+                    memcpy(&word, data + i, 8);
+                    if (word & 0x8080808080808080ULL) {
+                        break;
+                    }
+                    i += 8;
+                    unitsLeft -= 8;
+                }
+                if (i >= length || unitsLeft == 0) {
+                    break;
+                }
+            }
+            uint8_t b = data[i++];
+            if (b < 0x80) {
+                unitsLeft--;
+            } else if ((b & 0xC0) == 0x80) {
+                continuationLeft = std::max(0, continuationLeft - 1);
+            } else if (b >= 0xF0) {
+                // Outside the BMP, a surrogate pair in UTF-16
+                unitsLeft -= std::min<size_t>(2, unitsLeft);
+                continuationLeft = 3;
+            } else {
+                unitsLeft--;
+                continuationLeft = b >= 0xE0 ? 2 : 1;
+            }
+        }
+
+        if (unitsLeft > 0 || continuationLeft > 0) {
+            // Chunk ended mid-packet
+            partial.insert(partial.end(), data + start, data + length);
+            hasPartial = true;
+            break;
+        }
+
+        PacketFrame frame;
+        if (hasPartial) {
+            partial.insert(partial.end(), data + start, data + i);
+            frame.assembled.swap(partial);
+            frame.length = frame.assembled.size();
+            frame.spansChunks = true;
+            hasPartial = false;
+        } else {
+            frame.offset = start;
+            frame.length = i - start;
+        }
+        frames.push_back(std::move(frame));
+        state = State::Length;
+    }
+}
+
+void PacketFramer::reset() {
+    state = State::Length;
+    unitsLeft = 0;
+    continuationLeft = 0;
+    partial.clear();
+    hasPartial = false;
+}
+
+bool isJSONSpace(uint8_t b) {
+    return b == ' ' || b == '\t' || b == '\n' || b == '\r';
+}
+
+/**
+ * i is on the opening quote, returns the index after the closing one. Only the few escapes
+ * that can appear in a type or id are decoded into out
+ */
+size_t scanJSONString(const uint8_t* data, size_t length, size_t i, std::string* out) {
+    i++;
+    size_t start = i;
+    bool escaped = false;
+    while (i < length && data[i] != '"') {
+        if (data[i] == '\\') {
+            escaped = true;
+            i++;
+        }
+        i++;
+    }
+    if (out != nullptr) {
+        if (!escaped) {
+            out->assign((const char*)data + start, std::min(i, length) - start);
+        } else {
+            out->clear();
+            for (size_t j = start; j < i && j < length; j++) {
+                if (data[j] == '\\' && j + 1 < i) {
+                    j++;
+                }
+                out->push_back((char)data[j]);
+            }
+        }
+    }
+    return i + 1;
+}
+
+bool scanPacketHeader(const uint8_t* data, size_t length, std::string& type, std::string& id) {
+    size_t i = 0;
+    while (i < length && isJSONSpace(data[i])) {
+        i++;
+    }
+    if (i >= length || data[i] != '{') {
+        return false;
+    }
+    i++;
+
+    int depth = 1;
+    bool expectingKey = true;
+    bool foundType = false, foundId = false;
+    while (i < length && depth > 0 && !(foundType && foundId)) {
+        uint8_t b = data[i];
+        if (b == '"') {
+            if (depth != 1 || !expectingKey) {
+                i = scanJSONString(data, length, i, nullptr);
+                continue;
+            }
+            std::string key;
+            i = scanJSONString(data, length, i, &key);
+            while (i < length && (isJSONSpace(data[i]) || data[i] == ':')) {
+                i++;
+            }
+            expectingKey = false;
+            std::string* target = key == "type" ? &type : key == "id" ? &id : nullptr;
+            if (target == nullptr || i >= length) {
+                continue;
+            }
+            (key == "type" ? foundType : foundId) = true;
+            if (data[i] == '"') {
+                i = scanJSONString(data, length, i, target);
+            } else if (data[i] != '{' && data[i] != '[') {
+                // Number, true/false/null
+                size_t start = i;
+                while (i < length && data[i] != ',' && data[i] != '}' && !isJSONSpace(data[i])) {
+                    i++;
+                }
+                target->assign((const char*)data + start, i - start);
+            }
+        } else {
+            if (b == '{' || b == '[') {
+                depth++;
+            } else if (b == '}' || b == ']') {
+                depth--;
+            } else if (b == ',' && depth == 1) {
+                expectingKey = true;
+            }
+            i++;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Splits the controller script's stream into packets. Each packet is its length in decimal
+ * followed by that much JSON, where the length counts UTF-16 code units (it's a JS string
+ * length on the other side) but the bytes are UTF-8. No N-API in here so it can be
+ * benchmarked on its own.
+ */
+struct PacketFrame {
+    // Points into the chunk passed to push() when the packet was wholly inside it (offset
+    // valid, assembled empty), otherwise the bytes were gathered across chunks into assembled
+    size_t offset = 0;
+    size_t length = 0;
+    std::vector<uint8_t> assembled;
+    bool spansChunks = false;
+};
+
+class PacketFramer {
+    // Skip is the rest of a length prefix too long to be real
+    enum class State { Length, Skip, Body };
+    State state = State::Length;
+    // UTF-16 units still to come in the current packet
+    size_t unitsLeft = 0;
+    // Continuation bytes still owed by the last lead byte seen
+    int continuationLeft = 0;
+    // Partial packet (or length prefix) carried over from previous chunks
+    std::vector<uint8_t> partial;
+    bool hasPartial = false;
+public:
+    // Appends every packet completed by this chunk to frames
+    void push(const uint8_t* data, size_t length, std::vector<PacketFrame>& frames);
+    void reset();
+};
+
+/**
+ * Pulls the top level "type" and "id" out of a packet without parsing the rest. Numbers come
+ * back as their text. Returns false if the packet isn't an object
+ */
+bool scanPacketHeader(const uint8_t* data, size_t length, std::string& type, std::string& id);
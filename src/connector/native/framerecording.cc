@@ -0,0 +1,395 @@
+#include "framerecording.h"
+#include "lzblock.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char RECORDING_MAGIC[8] = {'B', 'E', 'S', 'F', 'R', 'A', 'M', '1'};
+const char RECORDING_INDEX_MAGIC[8] = {'B', 'E', 'S', 'I', 'N', 'D', 'X', '1'};
+const uint32_t FRAME_KEY = 1;
+const uint32_t FRAME_DELTA = 2;
+// Set on a tile's encodedBytes when compressing it didn't save anything and it's stored as is
+const uint32_t TILE_STORED = 0x80000000;
+
+struct RecordingHeader {
+    char magic[8];
+    uint32_t tileSize;
+    uint32_t reserved;
+};
+
+struct FrameRecordHeader {
+    uint32_t kind;
+    uint32_t tileCount;
+    int32_t width, height;
+    double time;
+    // Bytes of tile records that follow
+    uint64_t payloadBytes;
+};
+
+struct TileRecordHeader {
+    uint32_t tile;
+    uint32_t encodedBytes;
+};
+
+struct RecordingTrailer {
+    uint64_t indexOffset;
+    uint64_t frameCount;
+    char magic[8];
+};
+
+static_assert(sizeof(RecordingHeader) == 16, "");
+static_assert(sizeof(FrameRecordHeader) == 32, "");
+static_assert(sizeof(TileRecordHeader) == 8, "");
+static_assert(sizeof(RecordingIndexEntry) == 24, "");
+static_assert(sizeof(RecordingTrailer) == 24, "");
+
+template <typename T>
+void appendRecord(std::vector<uint8_t>& out, const T& record) {
+    auto bytes = reinterpret_cast<const uint8_t*>(&record);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+// Records in the mapping are unaligned, so they're copied out
+template <typename T>
+T readRecord(const uint8_t* at) {
+    T record;
+    memcpy(&record, at, sizeof(T));
+    return record;
+}
+
+FrameRecorder::FrameRecorder(const std::string& path, FrameRecorderOptions options)
+    : path(path), file(path, std::ios::binary | std::ios::trunc), options(options) {
+    if (!file) {
+        throw std::runtime_error("Couldn't open " + path + " for recording");
+    }
+    if (options.tileSize < 16 || options.tileSize % 16 != 0 || options.tileSize > 1024) {
+        throw std::runtime_error("Recording tileSize must be a multiple of 16 up to 1024");
+    }
+    if (options.keyframeInterval < 1) {
+        throw std::runtime_error("Recording keyframeInterval must be at least 1");
+    }
+    RecordingHeader header = {};
+    memcpy(header.magic, RECORDING_MAGIC, sizeof header.magic);
+    header.tileSize = (uint32_t)options.tileSize;
+    write(&header, sizeof header);
+    if (!writeError.empty()) {
+        throw std::runtime_error(writeError);
+    }
+}
+
+FrameRecorder::~FrameRecorder() {
+    close();
+}
+
+void FrameRecorder::write(const void* data, size_t size) {
+    if (!file.is_open()) {
+        return;
+    }
+    if (!file.write(static_cast<const char*>(data), size)) {
+        fail();
+        return;
+    }
+    offset += size;
+}
+
+// Stops recording, nothing more is written so the file ends at (or within) the last record
+void FrameRecorder::fail() {
+    static auto& writeFailures = metricCounter("recording.write.failures");
+    writeFailures.add();
+    writeError = "Couldn't write to recording " + path + " after " + std::to_string(offset) + " bytes";
+    std::cout << writeError << std::endl;
+    file.close();
+}
+
+void FrameRecorder::addFrame(FrameImage* frame, double time) {
+    static auto& encodeTime = metricHistogram("recording.encode.time");
+    static auto& tilesChanged = metricCounter("recording.tiles.changed");
+    static auto& bytesRecorded = metricCounter("recording.bytes");
+    if (!file.is_open() || frame->width <= 0 || frame->height <= 0) {
+        return;
+    }
+    MetricTimer timer(encodeTime);
+    auto ts = options.tileSize;
+    auto tilesX = (frame->width + ts - 1) / ts;
+    auto tilesY = (frame->height + ts - 1) / ts;
+    auto frameRowBytes = (size_t)frame->width * 4;
+
+    bool key = index.empty()
+        || frame->width != width
+        || frame->height != height
+        || sinceKeyframe >= options.keyframeInterval;
+    if (key) {
+        width = frame->width;
+        height = frame->height;
+        previous.resize(frameRowBytes * height);
+    } else {
+        changedTiles.assign(tilesX * tilesY, 0);
+        int changed = 0;
+        for (int ty = 0; ty < tilesY; ty++) {
+            auto y0 = ty * ts, th = std::min(ts, height - y0);
+            for (int tx = 0; tx < tilesX; tx++) {
+                auto x0 = tx * ts;
+                auto rowBytes = (size_t)std::min(ts, width - x0) * 4;
+                for (int y = y0; y < y0 + th; y++) {
+                    if (memcmp(frame->data + y * frame->bytesPerRow + x0 * 4, previous.data() + y * frameRowBytes + x0 * 4, rowBytes) != 0) {
+                        changedTiles[ty * tilesX + tx] = 1;
+                        changed++;
+                        break;
+                    }
+                }
+            }
+        }
+        // Deltas are no use when most of the frame changed (a panel opening, scrolling), a
+        // keyframe is about as big and saves seeking from the one before
+        key = changed * 2 > tilesX * tilesY;
+    }
+
+    encoded.clear();
+    uint32_t tileCount = 0;
+    for (int ty = 0; ty < tilesY; ty++) {
+        auto y0 = ty * ts, th = std::min(ts, height - y0);
+        for (int tx = 0; tx < tilesX; tx++) {
+            if (!key && !changedTiles[ty * tilesX + tx]) {
+                continue;
+            }
+            auto x0 = tx * ts;
+            auto rowBytes = (size_t)std::min(ts, width - x0) * 4;
+            tile.resize(rowBytes * th);
+            for (int y = y0; y < y0 + th; y++) {
+                auto src = frame->data + y * frame->bytesPerRow + x0 * 4;
+                auto prev = previous.data() + y * frameRowBytes + x0 * 4;
+                auto dst = tile.data() + (y - y0) * rowBytes;
+                if (key) {
+                    memcpy(dst, src, rowBytes);
+                } else {
+                    for (size_t i = 0; i < rowBytes; i++) {
+                        dst[i] = src[i] ^ prev[i];
+                    }
+                }
+                memcpy(prev, src, rowBytes);
+            }
+
+            auto headerAt = encoded.size();
+            appendRecord(encoded, TileRecordHeader{(uint32_t)(ty * tilesX + tx), 0});
+            auto encodedBytes = compressBlock(tile.data(), tile.size(), encoded);
+            uint32_t flags = 0;
+            if (encodedBytes >= tile.size()) {
+                encoded.resize(headerAt + sizeof(TileRecordHeader));
+                encoded.insert(encoded.end(), tile.begin(), tile.end());
+                encodedBytes = tile.size();
+                flags = TILE_STORED;
+            }
+            auto header = TileRecordHeader{(uint32_t)(ty * tilesX + tx), (uint32_t)encodedBytes | flags};
+            memcpy(encoded.data() + headerAt, &header, sizeof header);
+            tileCount++;
+        }
+    }
+
+    if (key) {
+        sinceKeyframe = 0;
+        lastKeyframe = (uint32_t)index.size();
+    }
+    sinceKeyframe++;
+    index.push_back(RecordingIndexEntry{offset, time, lastKeyframe, key ? FRAME_KEY : FRAME_DELTA});
+    auto header = FrameRecordHeader{key ? FRAME_KEY : FRAME_DELTA, tileCount, width, height, time, encoded.size()};
+    write(&header, sizeof header);
+    write(encoded.data(), encoded.size());
+    tilesChanged.add(tileCount);
+    bytesRecorded.add(sizeof header + encoded.size());
+}
+
+void FrameRecorder::close() {
+    if (!file.is_open()) {
+        return;
+    }
+    RecordingTrailer trailer = {};
+    trailer.indexOffset = offset;
+    trailer.frameCount = index.size();
+    memcpy(trailer.magic, RECORDING_INDEX_MAGIC, sizeof trailer.magic);
+    write(index.data(), index.size() * sizeof(RecordingIndexEntry));
+    write(&trailer, sizeof trailer);
+    if (!file.is_open()) {
+        return;
+    }
+    // Anything still buffered is only written now, and can fail just the same
+    file.flush();
+    if (!file) {
+        fail();
+        return;
+    }
+    file.close();
+}
+
+FrameReplay::FrameReplay(const std::string& path) {
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Couldn't open recording " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(RecordingHeader)) {
+        ::close(fd);
+        throw std::runtime_error(path + " is too short to be a recording");
+    }
+    size = (size_t)info.st_size;
+    auto mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Couldn't map recording " + path);
+    }
+    data = static_cast<const uint8_t*>(mapped);
+
+    auto header = readRecord<RecordingHeader>(data);
+    if (memcmp(header.magic, RECORDING_MAGIC, sizeof header.magic) != 0
+        || header.tileSize < 16 || header.tileSize > 1024) {
+        munmap(const_cast<uint8_t*>(data), size);
+        ::close(fd);
+        throw std::runtime_error(path + " isn't a recording");
+    }
+    tileSize = (int)header.tileSize;
+    readIndex();
+}
+
+FrameReplay::~FrameReplay() {
+    munmap(const_cast<uint8_t*>(data), size);
+    ::close(fd);
+}
+
+void FrameReplay::readIndex() {
+    if (size >= sizeof(RecordingHeader) + sizeof(RecordingTrailer)) {
+        auto trailer = readRecord<RecordingTrailer>(data + size - sizeof(RecordingTrailer));
+        auto indexBytes = size - sizeof(RecordingTrailer) - trailer.indexOffset;
+        if (memcmp(trailer.magic, RECORDING_INDEX_MAGIC, sizeof trailer.magic) == 0
+            && trailer.indexOffset >= sizeof(RecordingHeader)
+            && trailer.indexOffset <= size - sizeof(RecordingTrailer)
+            && indexBytes % sizeof(RecordingIndexEntry) == 0
+            && indexBytes / sizeof(RecordingIndexEntry) == trailer.frameCount) {
+            index.resize(trailer.frameCount);
+            memcpy(index.data(), data + trailer.indexOffset, indexBytes);
+            return;
+        }
+    }
+    rebuildIndex();
+}
+
+// Walks the records up to the first that's cut short
+void FrameReplay::rebuildIndex() {
+    static auto& rebuilds = metricCounter("replay.index.rebuilds");
+    rebuilds.add(1);
+    index.clear();
+    size_t at = sizeof(RecordingHeader);
+    uint32_t keyframe = 0;
+    while (size - at >= sizeof(FrameRecordHeader)) {
+        auto header = readRecord<FrameRecordHeader>(data + at);
+        if ((header.kind != FRAME_KEY && header.kind != FRAME_DELTA)
+            || header.payloadBytes > size - at - sizeof(FrameRecordHeader)
+            || (header.kind == FRAME_DELTA && index.empty())) {
+            break;
+        }
+        if (header.kind == FRAME_KEY) {
+            keyframe = (uint32_t)index.size();
+        }
+        index.push_back(RecordingIndexEntry{at, header.time, keyframe, header.kind});
+        at += sizeof(FrameRecordHeader) + header.payloadBytes;
+    }
+}
+
+bool FrameReplay::apply(size_t frame) {
+    auto at = index[frame].offset;
+    if (at > size || size - at < sizeof(FrameRecordHeader)) {
+        return false;
+    }
+    auto header = readRecord<FrameRecordHeader>(data + at);
+    if (header.width <= 0 || header.height <= 0 || header.width > 32768 || header.height > 32768
+        || header.payloadBytes > size - at - sizeof(FrameRecordHeader)) {
+        return false;
+    }
+    auto width = header.width, height = header.height;
+    auto frameRowBytes = (size_t)width * 4;
+    if (header.kind == FRAME_KEY) {
+        pixels.resize(frameRowBytes * height);
+        image = FrameImage(pixels.data(), frameRowBytes, WindowInfo{0, MWRect{0, 0, width, height}});
+    } else if (header.kind != FRAME_DELTA || width != image.width || height != image.height) {
+        return false;
+    }
+
+    auto ts = tileSize;
+    auto tilesX = (width + ts - 1) / ts;
+    auto tilesY = (height + ts - 1) / ts;
+    auto p = data + at + sizeof(FrameRecordHeader);
+    auto end = p + header.payloadBytes;
+    for (uint32_t i = 0; i < header.tileCount; i++) {
+        if ((size_t)(end - p) < sizeof(TileRecordHeader)) {
+            return false;
+        }
+        auto tileHeader = readRecord<TileRecordHeader>(p);
+        p += sizeof(TileRecordHeader);
+        auto encodedBytes = (size_t)(tileHeader.encodedBytes & ~TILE_STORED);
+        if (tileHeader.tile >= (uint32_t)(tilesX * tilesY) || encodedBytes > (size_t)(end - p)) {
+            return false;
+        }
+        auto x0 = (int)(tileHeader.tile % tilesX) * ts;
+        auto y0 = (int)(tileHeader.tile / tilesX) * ts;
+        auto rowBytes = (size_t)std::min(ts, width - x0) * 4;
+        auto th = std::min(ts, height - y0);
+        auto tileBytes = rowBytes * th;
+
+        const uint8_t* decoded = p;
+        if (tileHeader.encodedBytes & TILE_STORED) {
+            if (encodedBytes != tileBytes) {
+                return false;
+            }
+        } else {
+            tile.resize(tileBytes);
+            if (!decompressBlock(p, encodedBytes, tile.data(), tileBytes)) {
+                return false;
+            }
+            decoded = tile.data();
+        }
+        p += encodedBytes;
+
+        for (int y = 0; y < th; y++) {
+            auto src = decoded + y * rowBytes;
+            auto dst = pixels.data() + (y0 + y) * frameRowBytes + x0 * 4;
+            if (header.kind == FRAME_KEY) {
+                memcpy(dst, src, rowBytes);
+            } else {
+                for (size_t b = 0; b < rowBytes; b++) {
+                    dst[b] ^= src[b];
+                }
+            }
+        }
+    }
+    return true;
+}
+
+FrameImage* FrameReplay::seek(size_t frame) {
+    static auto& decodeTime = metricHistogram("replay.decode.time");
+    if (frame >= index.size()) {
+        return nullptr;
+    }
+    if ((long)frame == current) {
+        return &image;
+    }
+    MetricTimer timer(decodeTime);
+    // Stepping forward only needs the next frame's tiles
+    bool step = current != -1 && (long)frame == current + 1 && index[frame].kind == FRAME_DELTA;
+    size_t from = step ? frame : index[frame].keyframe;
+    if (from > frame || (!step && index[from].kind != FRAME_KEY)) {
+        current = -1;
+        return nullptr;
+    }
+    for (auto i = from; i <= frame; i++) {
+        if (!apply(i)) {
+            current = -1;
+            return nullptr;
+        }
+    }
+    current = (long)frame;
+    return &image;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "detect.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/**
+ * Recorded sequences of captured frames, for tuning detection against real sessions and
+ * replaying them in bes_bench. Frames are cut into square tiles. A keyframe stores every tile,
+ * anything else only the tiles that changed since the frame before, each XORed with what was
+ * there so the unchanged pixels inside it are zero. Tiles are compressed with lzblock.h.
+ *
+ * The file is a header, the frame records one after another, then an index of where each frame
+ * starts and its keyframe so any frame can be found without reading the rest. A recording cut
+ * short before its index is written still replays, the index is rebuilt from the records.
+ * Little endian, like everything we run on.
+ *
+ * Recorded with BitwigWindow.startRecording(path) / stopRecording(), see ui.cc
+ */
+// Where each frame's record starts, and the keyframe it decodes from
+struct RecordingIndexEntry {
+    uint64_t offset;
+    double time;
+    uint32_t keyframe;
+    uint32_t kind;
+};
+
+struct FrameRecorderOptions {
+    // Pixels, a multiple of 16
+    int tileSize = 64;
+    // Frames between keyframes, bounding how far seeking has to decode
+    int keyframeInterval = 120;
+};
+
+class FrameRecorder {
+    std::string path;
+    std::ofstream file;
+    std::string writeError;
+    FrameRecorderOptions options;
+    uint64_t offset = 0;
+    // The last frame written, changed tiles are found and delta encoded against it
+    std::vector<uint8_t> previous;
+    int width = 0, height = 0;
+    int sinceKeyframe = 0;
+    uint32_t lastKeyframe = 0;
+    std::vector<uint8_t> tile, encoded, changedTiles;
+    std::vector<RecordingIndexEntry> index;
+    void write(const void* data, size_t size);
+    void fail();
+public:
+    /**
+     * Throws std::runtime_error if path can't be written
+     */
+    FrameRecorder(const std::string& path, FrameRecorderOptions options = FrameRecorderOptions());
+    ~FrameRecorder();
+    /**
+     * time is milliseconds from whenever the caller likes, kept for replay to pace by
+     */
+    void addFrame(FrameImage* frame, double time);
+    // Writes the index, nothing can be added after
+    void close();
+    size_t frameCount() const {
+        return index.size();
+    }
+    uint64_t bytesWritten() const {
+        return offset;
+    }
+    /**
+     * Empty unless a write failed (e.g. the disk filled up). The recording stops there, what
+     * was written before replays without an index like any other recording cut short
+     */
+    const std::string& error() const {
+        return writeError;
+    }
+};
+
+/**
+ * Reads a recording through a read-only mapping, so only the pages of the frames being decoded
+ * are ever in memory. Frames are decoded into one buffer owned by the replay: stepping forward
+ * applies just the next frame's tiles, seeking anywhere else starts from its keyframe.
+ */
+class FrameReplay {
+    int fd = -1;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    int tileSize = 0;
+    std::vector<RecordingIndexEntry> index;
+    std::vector<uint8_t> pixels, tile;
+    FrameImage image;
+    // Frame in pixels, -1 before the first seek
+    long current = -1;
+    void readIndex();
+    void rebuildIndex();
+    bool apply(size_t frame);
+public:
+    /**
+     * Throws std::runtime_error if path isn't a readable recording
+     */
+    explicit FrameReplay(const std::string& path);
+    ~FrameReplay();
+    FrameReplay(const FrameReplay&) = delete;
+    FrameReplay& operator=(const FrameReplay&) = delete;
+    size_t frameCount() const {
+        return index.size();
+    }
+    double frameTime(size_t frame) const {
+        return index[frame].time;
+    }
+    /**
+     * Frame number frame, valid until the next seek. nullptr if it's out of range or its
+     * record is damaged
+     */
+    FrameImage* seek(size_t frame);
+};
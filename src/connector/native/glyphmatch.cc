@@ -0,0 +1,157 @@
+#include "glyphmatch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+GlyphMask makeGlyph(const char* const* rows, size_t count, float scale) {
+    GlyphMask mask;
+    int w = (int)strlen(rows[0]), h = (int)count;
+    mask.w = std::min(64, (int)round(w * scale));
+    mask.h = (int)round(h * scale);
+    // 1x pixel i covers [round(i * scale), round((i + 1) * scale)), the same as anything else
+    // Bitwig draws on the pixel grid at that scale
+    auto source = [&](int scaled, int size) {
+        int i = 0;
+        while (i + 1 < size && (int)round((i + 1) * scale) <= scaled) {
+            i++;
+        }
+        return i;
+    };
+    for (int y = 0; y < mask.h; y++) {
+        uint64_t bits = 0;
+        auto row = rows[source(y, h)];
+        for (int x = 0; x < mask.w; x++) {
+            if (row[source(x, w)] == '#') {
+                bits |= 1ull << x;
+            }
+        }
+        mask.rows.push_back(bits);
+        mask.order.push_back(y);
+        mask.litCount += __builtin_popcountll(bits);
+        if (bits) {
+            auto left = __builtin_ctzll(bits), right = 64 - __builtin_clzll(bits);
+            if (mask.litRect.w == 0) {
+                mask.litRect = MWRect{left, y, right - left, 1};
+            } else {
+                auto x0 = std::min(mask.litRect.x, left), x1 = std::max(mask.litRect.x + mask.litRect.w, right);
+                mask.litRect = MWRect{x0, mask.litRect.y, x1 - x0, y + 1 - mask.litRect.y};
+            }
+        }
+    }
+    std::stable_sort(mask.order.begin(), mask.order.end(), [&](int a, int b) {
+        return __builtin_popcountll(mask.rows[a]) > __builtin_popcountll(mask.rows[b]);
+    });
+    return mask;
+}
+
+/**
+ * LitBits
+ */
+void LitBits::fill(FrameImage* screenshot, MWRect area, int threshold) {
+    w = area.w;
+    h = area.h;
+    stride = w / 64 + 2;
+    words.assign((size_t)stride * h, 0);
+    columns.assign(stride, 0);
+    for (int y = 0; y < h; y++) {
+        auto pixel = screenshot->data + (size_t)(area.y + y) * screenshot->bytesPerRow + (size_t)area.x * 4;
+        auto row = &words[(size_t)y * stride];
+        int x = 0;
+        for (; x + 16 <= w; x += 16) {
+            row[x >> 6] |= (uint64_t)litPixels16(pixel + x * 4, threshold) << (x & 63);
+        }
+        if (x < w && w >= 16) {
+            // Last few pixels from a block overlapping the one before, rather than one by one.
+            // x is a multiple of 16 so they never straddle two words
+            auto last = (uint64_t)litPixels16(pixel + (w - 16) * 4, threshold) >> (x - (w - 16));
+            row[x >> 6] |= last << (x & 63);
+            x = w;
+        }
+        for (; x < w; x++) {
+            if (isLitPixel(pixel + x * 4, threshold)) {
+                row[x >> 6] |= 1ull << (x & 63);
+            }
+        }
+        for (int i = 0; i < stride; i++) {
+            columns[i] |= row[i];
+        }
+    }
+}
+
+bool LitBits::anyLitRows(FrameImage* screenshot, MWRect area, int threshold, int rowStep) {
+    for (int y = 0; y < area.h; y += rowStep) {
+        auto pixel = screenshot->data + (size_t)(area.y + y) * screenshot->bytesPerRow + (size_t)area.x * 4;
+        int x = 0;
+        for (; x + 16 <= area.w; x += 16) {
+            if (litPixels16(pixel + x * 4, threshold)) {
+                return true;
+            }
+        }
+        for (; x < area.w; x++) {
+            if (isLitPixel(pixel + x * 4, threshold)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void findLitBlobs(const LitBits& bits, int maxWidth, std::vector<MWRect>& blobs) {
+    blobs.clear();
+    for (int x = 0; x < bits.w;) {
+        if (!bits.columnLit(x)) {
+            x++;
+            continue;
+        }
+        auto start = x;
+        while (x < bits.w && bits.columnLit(x)) {
+            x++;
+        }
+        auto runWidth = x - start;
+        if (runWidth > maxWidth) {
+            continue;
+        }
+        auto runBits = (1ull << runWidth) - 1;
+        for (int y = 0; y < bits.h;) {
+            if (!(bits.at(start, y) & runBits)) {
+                y++;
+                continue;
+            }
+            auto top = y;
+            while (y < bits.h && (bits.at(start, y) & runBits)) {
+                y++;
+            }
+            blobs.push_back(MWRect{start, top, runWidth, y - top});
+        }
+    }
+}
+
+GlyphMatch matchGlyph(const LitBits& bits, const std::vector<MWRect>& blobs, const GlyphMask& mask, bool inverted) {
+    GlyphMatch best;
+    best.mismatches = std::max(1, std::min(mask.litCount, mask.w * mask.h - mask.litCount) / 8);
+    uint64_t widthBits = mask.w == 64 ? ~0ull : (1ull << mask.w) - 1;
+    auto expected = inverted ? MWRect{0, 0, mask.w, mask.h} : mask.litRect;
+
+    for (auto& blob : blobs) {
+        if (abs(blob.w - expected.w) > 2 || abs(blob.h - expected.h) > 2) {
+            continue;
+        }
+        for (int y = blob.y - expected.y - 1; y <= blob.y - expected.y + 1; y++) {
+            for (int x = blob.x - expected.x - 1; x <= blob.x - expected.x + 1; x++) {
+                if (x < 0 || y < 0 || x + mask.w > bits.w || y + mask.h > bits.h) {
+                    continue;
+                }
+                int mismatches = 0;
+                for (int i = 0; i < mask.h && mismatches < best.mismatches; i++) {
+                    auto row = mask.order[i];
+                    auto glyphRow = inverted ? ~mask.rows[row] : mask.rows[row];
+                    mismatches += __builtin_popcountll((bits.at(x, y + row) ^ glyphRow) & widthBits);
+                }
+                if (mismatches < best.mismatches) {
+                    best = GlyphMatch{x, y, mismatches};
+                }
+            }
+        }
+    }
+    return best;
+}
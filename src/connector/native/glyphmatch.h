@@ -0,0 +1,81 @@
+#pragma once
+#include "detect.h"
+#include "pixelrows.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Template matching of small glyphs drawn lighter than what's behind them (track header
+ * controls, footer panel icons). The region searched is thresholded to one bit per pixel, and a
+ * mask is compared 64 pixels at a time by counting the bits that differ, i.e. the sum of
+ * absolute differences between two black and white images.
+ */
+
+/**
+ * One glyph at one UI scale. Bit x of rows[y] is set where the glyph is lit, everything else in
+ * the w by h box has to be dark
+ */
+struct GlyphMask {
+    int w = 0, h = 0, litCount = 0;
+    // Bounds of the lit pixels within the box
+    MWRect litRect{0, 0, 0, 0};
+    std::vector<uint64_t> rows;
+    // Row indices, most lit first. Most places are given up on after comparing one or two
+    std::vector<int> order;
+};
+
+/**
+ * A mask from rows of '#' (lit) and anything else drawn at 1x, resampled to scale. At most
+ * 64 pixels wide once scaled
+ */
+GlyphMask makeGlyph(const char* const* rows, size_t count, float scale);
+template <size_t N>
+GlyphMask makeGlyph(const char* const (&rows)[N], float scale) {
+    return makeGlyph(rows, N, scale);
+}
+
+/**
+ * The search area thresholded to one bit per pixel, a row of 64 bit words per pixel row with a
+ * spare word on the end so any 64 pixels can be read from two. columns has a bit set for each
+ * column with anything lit in it
+ */
+struct LitBits {
+    std::vector<uint64_t> words, columns;
+    int w = 0, h = 0, stride = 0;
+
+    void fill(FrameImage* screenshot, MWRect area, int threshold);
+
+    /**
+     * Whether anything is lit in every rowStep'th row of area, enough to rule out a glyph with
+     * at least that many lit rows together without thresholding the rest
+     */
+    static bool anyLitRows(FrameImage* screenshot, MWRect area, int threshold, int rowStep);
+
+    uint64_t at(int x, int y) const {
+        auto row = &words[(size_t)y * stride + (x >> 6)];
+        auto shift = x & 63;
+        return shift == 0 ? row[0] : (row[0] >> shift) | (row[1] << (64 - shift));
+    }
+
+    bool columnLit(int x) const {
+        return (columns[x >> 6] >> (x & 63)) & 1;
+    }
+};
+
+/**
+ * Bounding boxes of whatever's lit, split into runs of lit columns and then runs of rows within
+ * each. Anything wider than maxWidth is text or such, not a glyph
+ */
+void findLitBlobs(const LitBits& bits, int maxWidth, std::vector<MWRect>& blobs);
+
+struct GlyphMatch {
+    int x = -1, y = -1;
+    int mismatches;
+};
+
+/**
+ * Best place for mask with fewer than an eighth of its glyph's worth of pixels wrong, only trying
+ * places within a pixel of where a blob lines up with it. inverted looks for a lit box with a
+ * dark glyph, which shows up as a blob the size of the whole box
+ */
+GlyphMatch matchGlyph(const LitBits& bits, const std::vector<MWRect>& blobs, const GlyphMask& mask, bool inverted);
@@ -0,0 +1,157 @@
+#include "headercontrols.h"
+#include "metrics.h"
+#include <algorithm>
+
+// 1x masks, '#' lit. Buttons include the dark box around the glyph so a bare header can't match.
+// Drawn by hand after Bitwig 5's track header rather than traced from a capture, like the footer's
+const char* const MUTE_GLYPH[] = {
+    ".............",
+    ".............",
+    "....#...#....",
+    "....##.##....",
+    "....#.#.#....",
+    "....#...#....",
+    "....#...#....",
+    "....#...#....",
+    "....#...#....",
+    ".............",
+    ".............",
+};
+const char* const SOLO_GLYPH[] = {
+    ".............",
+    ".............",
+    ".....###.....",
+    "....#...#....",
+    "....#........",
+    ".....###.....",
+    "........#....",
+    "....#...#....",
+    ".....###.....",
+    ".............",
+    ".............",
+};
+const char* const ARM_GLYPH[] = {
+    ".............",
+    ".............",
+    ".............",
+    ".....###.....",
+    "....#####....",
+    "....#####....",
+    "....#####....",
+    ".....###.....",
+    ".............",
+    ".............",
+    ".............",
+};
+const char* const FOLDED_GLYPH[] = {
+    ".........",
+    "...#.....",
+    "...##....",
+    "...###...",
+    "...####..",
+    "...###...",
+    "...##....",
+    "...#.....",
+    ".........",
+};
+const char* const UNFOLDED_GLYPH[] = {
+    ".........",
+    ".........",
+    ".........",
+    ".#######.",
+    "..#####..",
+    "...###...",
+    "....#....",
+    ".........",
+    ".........",
+};
+
+// Lit is this much brighter than the header, and never darker than the minimum
+const int GLYPH_MIN_CONTRAST = 30;
+const int GLYPH_MIN_BRIGHTNESS = 110;
+
+/**
+ * Where to look, unscaled and relative to the header's top left (or top right for buttons).
+ * Bitwig moves everything up into one row for small track heights
+ */
+struct ControlSearch {
+    int fromX, toX, fromY, toY;
+};
+const ControlSearch LARGE_BUTTONS{-100, -8, 2, 20};
+const ControlSearch LARGE_FOLD{2, 96, 23, 42};
+const ControlSearch SMALL_BUTTONS{-140, -8, 1, 24};
+const ControlSearch SMALL_FOLD{2, 96, 1, 24};
+
+const HeaderGlyphs& getHeaderGlyphs(float scale) {
+    thread_local float cachedScale = 0;
+    thread_local HeaderGlyphs glyphs;
+    if (scale != cachedScale) {
+        glyphs.buttons[0] = makeGlyph(MUTE_GLYPH, scale);
+        glyphs.buttons[1] = makeGlyph(SOLO_GLYPH, scale);
+        glyphs.buttons[2] = makeGlyph(ARM_GLYPH, scale);
+        glyphs.folded = makeGlyph(FOLDED_GLYPH, scale);
+        glyphs.unfolded = makeGlyph(UNFOLDED_GLYPH, scale);
+        cachedScale = scale;
+    }
+    return glyphs;
+}
+
+/**
+ * The search area in pixels, cut down to what's on screen. Empty if none of it is
+ */
+MWRect controlSearchArea(FrameImage* screenshot, const LayoutProfile& profile, const ArrangerTrack& track, ControlSearch search, bool fromRight) {
+    auto originX = fromRight ? track.rect.x + track.rect.w : track.rect.x;
+    auto x0 = std::max(0, originX + profile.scale(search.fromX));
+    auto x1 = std::min(screenshot->width, originX + profile.scale(search.toX));
+    auto y0 = std::max(track.visibleRect.y, track.rect.y + profile.scale(search.fromY));
+    auto y1 = std::min(
+        std::min(track.visibleRect.y + track.visibleRect.h, screenshot->height),
+        track.rect.y + profile.scale(search.toY)
+    );
+    return MWRect{x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0)};
+}
+
+void findHeaderControls(FrameImage* screenshot, const LayoutProfile& profile, MWColor background, ArrangerTrack& track) {
+    static auto& controlsFound = metricCounter("detect.controls.found");
+    thread_local LitBits bits;
+    thread_local std::vector<MWRect> blobs;
+    if (track.header == HEADER_HIDDEN) {
+        return;
+    }
+    auto& glyphs = getHeaderGlyphs(profile.uiScale);
+    auto threshold = std::min(254, std::max(GLYPH_MIN_BRIGHTNESS, std::max(background.r, std::max(background.g, background.b)) + GLYPH_MIN_CONTRAST));
+    auto large = track.isLargeTrackHeight;
+
+    auto area = controlSearchArea(screenshot, profile, track, large ? LARGE_BUTTONS : SMALL_BUTTONS, true);
+    if (area.w > 0 && area.h > 0) {
+        bits.fill(screenshot, area, threshold);
+        findLitBlobs(bits, glyphs.buttons[0].w + 2, blobs);
+        std::experimental::optional<HeaderControl>* buttons[] = {&track.mute, &track.solo, &track.arm};
+        for (int i = 0; i < 3; i++) {
+            auto& mask = glyphs.buttons[i];
+            auto off = matchGlyph(bits, blobs, mask, false);
+            auto on = matchGlyph(bits, blobs, mask, true);
+            auto& match = on.x != -1 && (off.x == -1 || on.mismatches < off.mismatches) ? on : off;
+            if (match.x != -1) {
+                *buttons[i] = HeaderControl{MWRect{area.x + match.x, area.y + match.y, mask.w, mask.h}, &match == &on};
+                controlsFound.add();
+            }
+        }
+    }
+
+    // Only group tracks have a fold arrow, usually there's nothing here. Its shortest version has
+    // 4 lit rows
+    area = controlSearchArea(screenshot, profile, track, large ? LARGE_FOLD : SMALL_FOLD, false);
+    if (area.w > 0 && area.h > 0 && LitBits::anyLitRows(screenshot, area, threshold, std::max(1, profile.scale(4)))) {
+        bits.fill(screenshot, area, threshold);
+        findLitBlobs(bits, glyphs.folded.w + 2, blobs);
+        auto folded = matchGlyph(bits, blobs, glyphs.folded, false);
+        auto unfolded = matchGlyph(bits, blobs, glyphs.unfolded, false);
+        auto& match = unfolded.x != -1 && (folded.x == -1 || unfolded.mismatches < folded.mismatches) ? unfolded : folded;
+        if (match.x != -1) {
+            auto& mask = &match == &unfolded ? glyphs.unfolded : glyphs.folded;
+            track.fold = HeaderControl{MWRect{area.x + match.x, area.y + match.y, mask.w, mask.h}, &match == &unfolded};
+            controlsFound.add();
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "detect.h"
+#include "glyphmatch.h"
+#include <cstdint>
+#include <vector>
+
+struct HeaderGlyphs {
+    // Mute, solo and arm buttons, then the fold arrow folded and unfolded
+    GlyphMask buttons[3];
+    GlyphMask folded, unfolded;
+};
+
+/**
+ * The masks are drawn at 1x and resampled for other scales, cached per thread by scale
+ */
+const HeaderGlyphs& getHeaderGlyphs(float scale);
+
+/**
+ * Mute, solo, arm and fold controls inside a track header, found by template matching small
+ * glyph masks against the header's pixels. Buttons are a dark box with a light glyph, or a
+ * coloured box with a dark glyph when engaged, so each button mask is tried both ways round.
+ * The fold arrow has no box and a mask for each direction.
+ *
+ * background is the header's own colour, what counts as lit is relative to it so a selected
+ * header still works. Tracks with a hidden header are left alone
+ */
+void findHeaderControls(FrameImage* screenshot, const LayoutProfile& profile, MWColor background, ArrangerTrack& track);
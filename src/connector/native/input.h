@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+/**
+ * Input synthesis primitives shared by the Mouse/Keyboard bindings and the sequence scheduler.
+ * Implemented per platform in mouse.cc/keyboard.cc (and linux/). Safe to call from any thread,
+ * positions are global screen coordinates and nothing in here sleeps - callers choose the gaps.
+ */
+struct InputModifiers {
+    bool Meta = false, Shift = false, Control = false, Alt = false, Fn = false;
+};
+
+/**
+ * Buttons use JS numbering (left 0, middle 1, right 2)
+ */
+void getMousePosition(int& x, int& y);
+void postMouseMove(int x, int y, bool modwigListeners = false);
+void postMouseButton(int button, bool down, int x, int y, InputModifiers modifiers, bool modwigListeners = false, bool doubleClick = false);
+
+/**
+ * Key names as in macKeycodeMap (or keySymMap on Linux), false if unknown
+ */
+bool postKey(const std::string& key, bool down, InputModifiers modifiers, bool modwigListeners = false);
+
+/**
+ * What listeners receive for input events, from the event tap on macOS and XRecord on Linux
+ */
+struct JSEvent {
+    uint16_t nativeKeyCode;
+    std::string type;
+    std::string lowerKey;
+    bool Meta, Shift, Control, Alt, Fn;
+    int button, x, y;
+    ~JSEvent() {
+        // std::cout << "deleting jsevent";
+    }
+};
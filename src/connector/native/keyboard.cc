@@ -1,6 +1,11 @@
 #include "point.h"
 #include "keyboard.h"
+#include "input.h"
+#include "constraint.h"
+#include "sequence.h"
 #include "eventsource.h"
+#include "metrics.h"
+#include "windowlist.h"
 
 #include <CoreGraphics/CoreGraphics.h>
 #include <iostream>
@@ -153,6 +158,7 @@ std::map<std::string, int> macKeycodeMapReverse;
 
 forward_list<CallbackInfo*> callbacks; 
 int lastMouseDownButton = 0;
+CallbackInfo* pointerConstraintInfo = nullptr;
 
 void processCallback(Napi::Env env, Napi::Function jsCallback, JSEvent* value) {
     Napi::Object obj = Napi::Object::New(env);
@@ -171,6 +177,15 @@ void processCallback(Napi::Env env, Napi::Function jsCallback, JSEvent* value) {
 }
 
 CGEventRef eventtap_callback(CGEventTapProxy proxy, CGEventType type, CGEventRef event, void *refcon) {
+    // Events handed to JS but not yet delivered, and how long each takes once it is
+    static auto& queueDepth = metricGauge("events.queueDepth");
+    static auto& marshalTime = metricHistogram("napi.event.time");
+
+    if (type == kCGEventLeftMouseUp || type == kCGEventRightMouseUp || type == kCGEventOtherMouseUp || type == kCGEventKeyUp) {
+        // Clicks and shortcuts (ours too) are what open, close and move windows
+        invalidateWindowList();
+    }
+
     if (CGEventGetIntegerValueField(event, kCGEventSourceUserData) == 42) {
         // Skip our own events
         return event;
@@ -187,6 +202,19 @@ CGEventRef eventtap_callback(CGEventTapProxy proxy, CGEventType type, CGEventRef
         return event;
     }
 
+    if (e->eventType == "pointerconstraint") {
+        // This tap is at the HID level, ahead of every session tap, so Bitwig and all of our
+        // listeners only ever see the constrained position
+        CGPoint point = CGEventGetLocation(event);
+        double x = point.x, y = point.y;
+        double dx = CGEventGetDoubleValueField(event, kCGMouseEventDeltaX);
+        double dy = CGEventGetDoubleValueField(event, kCGMouseEventDeltaY);
+        if (pointerConstrainer.constrain(x, y, dx, dy)) {
+            CGEventSetLocation(event, CGPointMake((CGFloat)x, (CGFloat)y));
+        }
+        return event;
+    }
+
     JSEvent *jsEvent = new JSEvent();
     jsEvent->type = e->eventType;
 
@@ -217,6 +245,8 @@ CGEventRef eventtap_callback(CGEventTapProxy proxy, CGEventType type, CGEventRef
         // Keyboard event
 
         auto callback = []( Napi::Env env, Napi::Function jsCallback, JSEvent* value ) {
+        queueDepth.add(-1);
+        MetricTimer timer(marshalTime);
         Napi::Object obj = Napi::Object::New(env);
 
             obj.Set(Napi::String::New(env, "nativeKeyCode"), Napi::Number::New(env, value->nativeKeyCode));
@@ -236,6 +266,7 @@ CGEventRef eventtap_callback(CGEventTapProxy proxy, CGEventType type, CGEventRef
         jsEvent->lowerKey = macKeycodeMap[jsEvent->nativeKeyCode];
 
         if (e->cb != nullptr) {
+            queueDepth.add(1);
             e->cb.BlockingCall( jsEvent, callback );  
         } 
         if (e->nativeFn != nullptr) {
@@ -275,10 +306,14 @@ CGEventRef eventtap_callback(CGEventTapProxy proxy, CGEventType type, CGEventRef
         lastMouseDownButton = button;
     
         auto callback = []( Napi::Env env, Napi::Function jsCallback, JSEvent* value ) {
+            queueDepth.add(-1);
+            MetricTimer timer(marshalTime);
             processCallback(env, jsCallback, value);
             delete value;   
         };
         auto callbackNoDelete = []( Napi::Env env, Napi::Function jsCallback, JSEvent* value ) {
+            queueDepth.add(-1);
+            MetricTimer timer(marshalTime);
             processCallback(env, jsCallback, value);
         };
 
@@ -301,14 +336,17 @@ CGEventRef eventtap_callback(CGEventTapProxy proxy, CGEventType type, CGEventRef
                 if (cbInfo->eventType == e->eventType && cbInfo != e) {
                     // Call all other listeners except for this one
                     if (cbInfo->cb != nullptr) {
+                        queueDepth.add(1);
                         cbInfo->cb.BlockingCall( jsEvent, callbackNoDelete );  
                     }
                 }
             }
+            queueDepth.add(1);
             e->cb.BlockingCall( jsEvent, callback );  
             return NULL;
         } else {
             if (e->cb != nullptr) {
+                queueDepth.add(1);
                 e->cb.BlockingCall( jsEvent, callback );  
             } 
             if (e->nativeFn != nullptr) {
@@ -336,6 +374,9 @@ CallbackInfo* addEventListener(EventListenerSpec spec) {
         mask = CGEventMaskBit(kCGEventLeftMouseUp) | CGEventMaskBit(kCGEventRightMouseUp) | CGEventMaskBit(kCGEventOtherMouseUp);
     } else if ("scroll" == spec.eventType) {
         mask = CGEventMaskBit(kCGEventScrollWheel);
+    } else if ("pointerconstraint" == spec.eventType) {
+        mask = CGEventMaskBit(kCGEventMouseMoved) | CGEventMaskBit(kCGEventLeftMouseDragged) 
+            | CGEventMaskBit(kCGEventRightMouseDragged) | CGEventMaskBit(kCGEventOtherMouseDragged);
     } else {
         throw std::invalid_argument("Unrecognised event type: " + spec.eventType);
     }
@@ -356,8 +397,10 @@ CallbackInfo* addEventListener(EventListenerSpec spec) {
         );                      
     }
 
+    // Listeners are session taps, each inserted ahead of the ones before. Constraints go in
+    // at the HID level, which comes before all of them however many are added later
     ourInfo->tap = CGEventTapCreate(
-        kCGSessionEventTap,
+        spec.eventType == "pointerconstraint" ? kCGHIDEventTap : kCGSessionEventTap,
         kCGHeadInsertEventTap,
         kCGEventTapOptionDefault,
         mask,
@@ -441,46 +484,77 @@ Napi::Value isEnabled(const Napi::CallbackInfo &info) {
     return Napi::Boolean::New(env, false);
 }
 
-Napi::Value keyPresser(const Napi::CallbackInfo &info, bool down) {
-    Napi::Env env = info.Env();
-
-    if (macKeycodeMapReverse.size() == 0) {
+bool postKey(const std::string& key, bool down, InputModifiers modifiers, bool modwigListeners) {
+    static std::once_flag reverseMapFlag;
+    std::call_once(reverseMapFlag, []() {
         // Initalise our reverse map
         auto it = macKeycodeMap.begin();
         while(it != macKeycodeMap.end()) {
             macKeycodeMapReverse[it->second] = it->first;
             it++;
         }
+    });
+
+    auto found = macKeycodeMapReverse.find(key);
+    if (found == macKeycodeMapReverse.end()) {
+        std::cout << "Unknown key: " << key << std::endl;
+        return false;
+    }
+    CGKeyCode keyCode = (CGKeyCode)found->second;    
+    CGEventFlags flags = (CGEventFlags)0;
+    if (modifiers.Meta) {
+        flags |= kCGEventFlagMaskCommand;
+    }
+    if (modifiers.Shift) {
+        flags |= kCGEventFlagMaskShift;
+    }
+    if (modifiers.Alt) {
+        flags |= kCGEventFlagMaskAlternate;
+    }
+    if (modifiers.Control) {
+        flags |= kCGEventFlagMaskControl;
+    }
+    if (modifiers.Fn) {
+        flags |= kCGEventFlagMaskSecondaryFn;
+    }
+    CGEventRef keyevent = CGEventCreateKeyboardEvent(getCGEventSource(modwigListeners), keyCode, down);
+    CGEventSetFlags(keyevent, flags);
+    CGEventPost(kCGSessionEventTap, keyevent);
+    CFRelease(keyevent);
+    return true;
+}
+
+/**
+ * Constraints get their own tap so they're applied exactly once per event, whether or
+ * not anything is listening to mouse moves
+ */
+void ensurePointerConstraintTap() {
+    if (pointerConstraintInfo == nullptr) {
+        pointerConstraintInfo = addEventListener(EventListenerSpec{
+            "pointerconstraint",
+            [](JSEvent* event) -> void {},
+            nullptr,
+            nullptr
+        });
     }
+}
+
+Napi::Value keyPresser(const Napi::CallbackInfo &info, bool down) {
+    Napi::Env env = info.Env();
 
     std::string s = info[0].As<Napi::String>();
-    CGKeyCode keyCode = (CGKeyCode)macKeycodeMapReverse[s];    
-    CGEventFlags flags = (CGEventFlags)0;
+    InputModifiers modifiers;
     bool modwigListeners = false;
     if (info[1].IsObject()) {
         Napi::Object obj = info[1].As<Napi::Object>();
-        if (obj.Has("Meta")) {
-            flags |= kCGEventFlagMaskCommand;
-        }
-        if (obj.Has("Shift")) {
-            flags |= kCGEventFlagMaskShift;
-        }
-        if (obj.Has("Alt")) {
-            flags |= kCGEventFlagMaskAlternate;
-        }
-        if (obj.Has("Control")) {
-            flags |= kCGEventFlagMaskControl;
-        }
-        if (obj.Has("Fn")) {
-            flags |= kCGEventFlagMaskSecondaryFn;
-        }
+        modifiers.Meta = obj.Has("Meta");
+        modifiers.Shift = obj.Has("Shift");
+        modifiers.Alt = obj.Has("Alt");
+        modifiers.Control = obj.Has("Control");
+        modifiers.Fn = obj.Has("Fn");
         modwigListeners = obj.Has("modwigListeners") && obj.Get("modwigListeners").As<Napi::Boolean>();
     }
-    CGEventRef keyevent = CGEventCreateKeyboardEvent(getCGEventSource(modwigListeners), keyCode, down);
-    CGEventSetFlags(keyevent, flags);
-    CGEventPost(kCGSessionEventTap, keyevent);
-    CFRelease(keyevent);
-    return Napi::Boolean::New(env, true);
+    return Napi::Boolean::New(env, postKey(s, down, modifiers, modwigListeners));
 }
 
 Napi::Value keyDown(const Napi::CallbackInfo &info) {
@@ -506,6 +580,8 @@ Napi::Value InitKeyboard(Napi::Env env, Napi::Object exports)
     obj.Set(Napi::String::New(env, "keyDown"), Napi::Function::New(env, keyDown));
     obj.Set(Napi::String::New(env, "keyUp"), Napi::Function::New(env, keyUp));
     obj.Set(Napi::String::New(env, "keyPress"), Napi::Function::New(env, keyPress));
+    obj.Set(Napi::String::New(env, "sequence"), Napi::Function::New(env, Sequence));
+    addPointerConstraintFunctions(env, obj);
     exports.Set("Keyboard", obj);
     return exports;
 }
\ No newline at end of file
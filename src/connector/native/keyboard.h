@@ -1,29 +1,25 @@
 #pragma once
 #include <napi.h>
+#include "input.h"
 #include <functional>
 #include <string>
+#include <cstdint>
+#ifdef __APPLE__
 #include <CoreGraphics/CoreGraphics.h>
+#endif
 #include <iostream>
 
-struct JSEvent {
-    UInt16 nativeKeyCode;
-    std::string type;
-    std::string lowerKey;
-    bool Meta, Shift, Control, Alt, Fn;
-    int button, x, y;
-    ~JSEvent() {
-        // std::cout << "deleting jsevent";
-    }
-};
 
 struct CallbackInfo {
     Napi::ThreadSafeFunction cb = nullptr;
     std::function<void(JSEvent*)> nativeFn = nullptr;
-    CGEventMask mask;
     int id;
-    CFMachPortRef tap;
     std::string eventType;
+#ifdef __APPLE__
+    CGEventMask mask;
+    CFMachPortRef tap;
     CFRunLoopSourceRef runloopsrc;
+#endif
 
     bool operator ==(const CallbackInfo& other) const {
         return other.cb == cb;
@@ -36,12 +32,14 @@ struct CallbackInfo {
 
         // std::cout << "removing callbackinfo";
 
+#ifdef __APPLE__
         if (CGEventTapIsEnabled(tap)) CGEventTapEnable(tap, false);
 
         CFMachPortInvalidate(tap);
         CFRunLoopRemoveSource(CFRunLoopGetMain(), runloopsrc, kCFRunLoopCommonModes);
         CFRelease(runloopsrc);
         CFRelease(tap);
+#endif
     }
 };
 
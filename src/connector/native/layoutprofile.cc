@@ -0,0 +1,183 @@
+#include "layoutprofile.h"
+#include "detect.h"
+#include "metrics.h"
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#define LAYOUT_CONSTANT_VALUE(name, value) value,
+#define LAYOUT_CONSTANT_NAME(name, value) #name,
+
+// Constant initialised, so detection in other files' static initialisers can't see it unset
+const LayoutProfile builtinLayoutProfile = {
+    1,
+    {LAYOUT_CONSTANTS(LAYOUT_CONSTANT_VALUE)},
+    {LAYOUT_CONSTANTS(LAYOUT_CONSTANT_VALUE)}
+};
+const char* layoutConstantNames[LAYOUT_CONSTANT_COUNT] = {
+    LAYOUT_CONSTANTS(LAYOUT_CONSTANT_NAME)
+};
+std::atomic<const LayoutProfile*> activeLayoutProfile(&builtinLayoutProfile);
+std::string bitwigVersion = "";
+
+struct ProfileSection {
+    std::string name;
+    std::string version;
+    // Percent, -1 for any
+    int scale = -1;
+    bool anyLayout = true;
+    std::string layout;
+    std::vector<std::pair<LayoutConstant, int>> values;
+
+    bool matches(const std::string& version, int scale, const std::string& layout) const {
+        if (this->version != "" && version != this->version && version.compare(0, this->version.size() + 1, this->version + ".") != 0) {
+            return false;
+        }
+        return (this->scale == -1 || scale == this->scale) && (anyLayout || layout == this->layout);
+    }
+};
+
+std::mutex layoutProfileMutex;
+std::vector<ProfileSection> profileSections;
+// By version, scale and layout. Replaced profiles move to retiredProfiles rather than being
+// freed, see activeLayoutProfile
+std::map<std::string, std::unique_ptr<LayoutProfile>> compiledProfiles;
+std::vector<std::unique_ptr<LayoutProfile>> retiredProfiles;
+
+int LayoutProfile::scale(int point) const {
+    return (int)round((float)point * uiScale);
+}
+
+bool findLayoutConstant(const std::string& name, LayoutConstant& constant) {
+    for (int i = 0; i < LAYOUT_CONSTANT_COUNT; i++) {
+        if (name == layoutConstantNames[i]) {
+            constant = (LayoutConstant)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string trimProfileText(const std::string& str) {
+    auto start = str.find_first_not_of(" \t\r");
+    if (start == std::string::npos) {
+        return "";
+    }
+    return str.substr(start, str.find_last_not_of(" \t\r") - start + 1);
+}
+
+int parseProfileInt(const std::string& value, const std::string& error) {
+    size_t used = 0;
+    int parsed = 0;
+    try {
+        parsed = std::stoi(value, &used);
+    } catch (const std::exception&) {
+        throw std::runtime_error(error);
+    }
+    if (used != value.size()) {
+        throw std::runtime_error(error);
+    }
+    return parsed;
+}
+
+size_t parseLayoutProfiles(const std::string& text) {
+    std::vector<ProfileSection> sections;
+    std::istringstream stream(text);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(stream, line)) {
+        lineNumber++;
+        line = trimProfileText(line.substr(0, line.find('#')));
+        if (line == "") {
+            continue;
+        }
+        auto where = "Layout profiles line " + std::to_string(lineNumber) + ": ";
+        if (line[0] == '[') {
+            if (line.back() != ']') {
+                throw std::runtime_error(where + "unterminated section name");
+            }
+            sections.push_back(ProfileSection());
+            sections.back().name = trimProfileText(line.substr(1, line.size() - 2));
+            continue;
+        }
+        auto equals = line.find('=');
+        if (equals == std::string::npos) {
+            throw std::runtime_error(where + "expected key = value");
+        }
+        if (sections.empty()) {
+            throw std::runtime_error(where + "setting outside of a [section]");
+        }
+        auto key = trimProfileText(line.substr(0, equals));
+        auto value = trimProfileText(line.substr(equals + 1));
+        auto& section = sections.back();
+        LayoutConstant constant;
+        if (key == "version") {
+            section.version = value;
+        } else if (key == "scale") {
+            section.scale = parseProfileInt(value, where + "scale should be a whole percentage");
+        } else if (key == "layout") {
+            section.anyLayout = false;
+            section.layout = value;
+        } else if (findLayoutConstant(key, constant)) {
+            section.values.push_back({constant, parseProfileInt(value, where + key + " should be a whole number")});
+        } else {
+            throw std::runtime_error(where + "unknown setting " + key);
+        }
+    }
+
+    auto count = sections.size();
+    {
+        std::lock_guard<std::mutex> lock(layoutProfileMutex);
+        profileSections = std::move(sections);
+        for (auto& compiled : compiledProfiles) {
+            retiredProfiles.push_back(std::move(compiled.second));
+        }
+        compiledProfiles.clear();
+    }
+    selectLayoutProfile();
+    return count;
+}
+
+size_t loadLayoutProfiles(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Couldn't open layout profiles at " + path);
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return parseLayoutProfiles(text.str());
+}
+
+const LayoutProfile* findLayoutProfile(float scale, const std::string& layout) {
+    static auto& compiles = metricCounter("layout.profile.compiles");
+    std::lock_guard<std::mutex> lock(layoutProfileMutex);
+    auto scalePercent = (int)lround(scale * 100);
+    auto key = bitwigVersion + "|" + std::to_string(scalePercent) + "|" + layout;
+    auto& profile = compiledProfiles[key];
+    if (!profile) {
+        compiles.add();
+        profile.reset(new LayoutProfile(builtinLayoutProfile));
+        profile->uiScale = scale;
+        for (auto& section : profileSections) {
+            if (section.matches(bitwigVersion, scalePercent, layout)) {
+                for (auto& value : section.values) {
+                    profile->values[value.first] = value.second;
+                }
+            }
+        }
+        for (int i = 0; i < LAYOUT_CONSTANT_COUNT; i++) {
+            profile->scaled[i] = profile->scale(profile->values[i]);
+        }
+    }
+    return profile.get();
+}
+
+void selectLayoutProfile() {
+    activeLayoutProfile.store(findLayoutProfile(uiScale, uiLayout), std::memory_order_release);
+}
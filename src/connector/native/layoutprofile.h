@@ -0,0 +1,118 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+/**
+ * Fixed sizes and offsets in Bitwig's UI, unscaled, with the values Bitwig 4/5 at 100% uses.
+ * Anything that moves between versions, scales or display layouts belongs here rather than
+ * in an if on uiScale.
+ */
+#define LAYOUT_CONSTANTS(X) \
+    X(BITWIG_HEADER_HEIGHT, 83) \
+    X(BITWIG_HEADER_TOOLBAR_HEIGHT, 48) \
+    X(BITWIG_FOOTER_HEIGHT, 36) \
+    X(INSPECTOR_WIDTH, 170) \
+    X(ARRANGER_HEADER_HEIGHT, 45) \
+    X(ARRANGER_FOOTER_HEIGHT, 26) \
+    X(AUTOMATION_LANE_MINIMUM_HEIGHT, 53) \
+    X(MINIMUM_DOUBLE_TRACK_HEIGHT, 45) \
+    X(MINIMUM_TRACK_HEIGHT, 25) \
+    /* Window width (in pixels, not scaled) at or under which the toolbar docks below the header */ \
+    X(TOOLBAR_DOCK_WIDTH, 1440) \
+    /* Points read from the bottom left of the window: a modal's backdrop and the footer icons */ \
+    X(MODAL_PROBE_X, 2) \
+    X(MODAL_PROBE_Y, 2) \
+    X(INSPECTOR_ICON_X, 20) \
+    X(INSPECTOR_ICON_Y, 17) \
+    X(DEVICE_ICON_X, 276) \
+    X(DEVICE_ICON_Y, 20) \
+    X(MIXER_ICON_X, 309) \
+    X(MIXER_ICON_Y, 20) \
+    X(AUTOMATION_ICON_X, 250) \
+    X(AUTOMATION_ICON_Y, 17) \
+    X(DETAIL_ICON_X, 224) \
+    X(DETAIL_ICON_Y, 18) \
+    /* How far from the left of the footer to look for the panel glyphs */ \
+    X(FOOTER_PANEL_SEARCH_WIDTH, 640)
+
+#define LAYOUT_CONSTANT_ENUM(name, value) name,
+enum LayoutConstant {
+    LAYOUT_CONSTANTS(LAYOUT_CONSTANT_ENUM)
+    LAYOUT_CONSTANT_COUNT
+};
+#undef LAYOUT_CONSTANT_ENUM
+
+/**
+ * Every constant for one version, scale and display layout, compiled from the profile file so a
+ * lookup is an array read. scaled holds each value already rounded at the scale it was
+ * compiled for. Detection takes the profile of the window it's looking at, so windows on
+ * displays with different layouts are each read with their own
+ */
+struct LayoutProfile {
+    float uiScale;
+    int values[LAYOUT_CONSTANT_COUNT];
+    int scaled[LAYOUT_CONSTANT_COUNT];
+
+    int get(LayoutConstant constant, bool scaleIt = false) const {
+        return scaleIt ? scaled[constant] : values[constant];
+    }
+    int scale(int point) const;
+};
+
+/**
+ * Never null, the built in values at scale 1 until selectLayoutProfile is called. Profiles
+ * aren't freed once compiled, so detection on the pool can keep reading one that has been
+ * swapped out
+ */
+extern std::atomic<const LayoutProfile*> activeLayoutProfile;
+
+/**
+ * The profile for bitwigVersion at the given scale and display layout, compiled the first time
+ * that combination is seen. Never null, and never freed (as for activeLayoutProfile)
+ */
+const LayoutProfile* findLayoutProfile(float scale, const std::string& layout);
+
+// activeLayoutProfile's, for what has no window of its own. Detectors take the window's profile
+inline int getConstant(LayoutConstant constant, bool scaleIt = false) {
+    auto profile = activeLayoutProfile.load(std::memory_order_acquire);
+    return scaleIt ? profile->scaled[constant] : profile->values[constant];
+}
+
+/**
+ * Set from JS with UI.updateUILayoutInfo once the controller script reports it, empty until then
+ */
+extern std::string bitwigVersion;
+
+/**
+ * Profiles are read from a file of sections, each applying to whatever its lowercase selectors
+ * match and setting constants by name. Every matching section applies in order, so later ones
+ * override earlier ones:
+ *
+ *   [base]
+ *   BITWIG_HEADER_HEIGHT = 83
+ *
+ *   [125%]
+ *   scale = 125
+ *   DEVICE_ICON_X = 271
+ *
+ * Selectors are version (matches that version and its point releases, "5.1" matches "5.1.3"),
+ * scale (percent) and layout (Bitwig's display profile name). Constants a file doesn't set keep
+ * their built in values.
+ *
+ * Throws std::runtime_error naming the line of anything it can't parse, and keeps the profiles
+ * it had. Returns how many sections were read
+ */
+size_t loadLayoutProfiles(const std::string& path);
+size_t parseLayoutProfiles(const std::string& text);
+
+/**
+ * Makes the profile for the current bitwigVersion, uiScale and uiLayout active, the one for
+ * windows without a layout of their own
+ */
+void selectLayoutProfile();
+
+/**
+ * By the names in LAYOUT_CONSTANTS, false if there's no such constant
+ */
+bool findLayoutConstant(const std::string& name, LayoutConstant& constant);
@@ -0,0 +1,580 @@
+#include "../bitwig.h"
+#include "../activeapp.h"
+#include "../nativeevents.h"
+#include "../keyboard.h"
+#include "../pluginwindows.h"
+#include "../processtable.h"
+#include "../packetframer.h"
+#include "../resources.h"
+#include "../windowregistry.h"
+#include "x11.h"
+#include <X11/Xatom.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+/**
+ * X11 version of ../bitwig.cc. There's no accessibility API in between us and the windows,
+ * so plugin windows are found by owner (see windowBelongsTo) and moved directly.
+ */
+
+std::vector<Window> getPluginWindows() {
+    auto windows = findWindowsByOwner("Bitwig Plug-in Host 64");
+    return windows.size() > 0 ? windows : findWindowsByOwner("Bitwig Studio Engine");
+}
+
+/**
+ * Follows _NET_ACTIVE_WINDOW on its own connection and reports which of the apps we've been
+ * asked about owns it. Without a window manager setting that property there's nothing to
+ * follow (input focus changes aren't announced to the root), so we query each time instead
+ */
+class ActiveAppWatcher {
+    std::mutex mutex;
+    std::vector<std::string> apps = {"Bitwig Studio", "Bitwig Plug-in Host 64", "Bitwig Studio Engine"};
+    Display* eventDisplay = nullptr;
+    bool started = false;
+    bool tracking = false;
+
+    bool hasActiveWindowProperty(Display* display) {
+        Atom activeWindow = XInternAtom(display, "_NET_ACTIVE_WINDOW", False);
+        int count = 0;
+        Atom* properties = XListProperties(display, DefaultRootWindow(display), &count);
+        bool found = false;
+        for (int i = 0; i < count; i++) {
+            found = found || properties[i] == activeWindow;
+        }
+        if (properties != nullptr) {
+            XFree(properties);
+        }
+        return found;
+    }
+
+    void update(Display* display) {
+        std::vector<std::string> appsNow;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            appsNow = apps;
+        }
+        auto active = getActiveWindow(display);
+        std::string owner = "";
+        for (auto& app : appsNow) {
+            if (active != None && windowBelongsTo(display, active, app)) {
+                owner = app;
+                break;
+            }
+        }
+        getActiveAppTracker().activated(owner);
+    }
+
+    void run() {
+        Window root = DefaultRootWindow(eventDisplay);
+        Atom activeWindow = XInternAtom(eventDisplay, "_NET_ACTIVE_WINDOW", False);
+        while (true) {
+            XEvent event;
+            XNextEvent(eventDisplay, &event);
+            if (event.type == PropertyNotify && event.xproperty.window == root && event.xproperty.atom == activeWindow) {
+                update(eventDisplay);
+            }
+        }
+    }
+
+public:
+    /**
+     * Adds app to the ones we report on. Returns false if the tracker can't be relied on
+     */
+    bool watch(const std::string& app) {
+        bool added = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (std::find(apps.begin(), apps.end(), app) == apps.end()) {
+                apps.push_back(app);
+                added = true;
+            }
+            if (!started) {
+                started = true;
+                eventDisplay = XOpenDisplay(NULL);
+                if (eventDisplay == nullptr) {
+                    std::cout << "Could not open display for active window events" << std::endl;
+                    return false;
+                }
+                XSelectInput(eventDisplay, DefaultRootWindow(eventDisplay), PropertyChangeMask);
+                tracking = hasActiveWindowProperty(eventDisplay);
+                if (tracking) {
+                    added = true;
+                    std::thread([this]() {
+                        run();
+                    }).detach();
+                }
+            }
+            if (!tracking) {
+                return false;
+            }
+        }
+        auto display = getDisplay();
+        if (added && display != nullptr) {
+            // Catch up with whatever is active now
+            update(display);
+        }
+        return true;
+    }
+};
+
+ActiveAppWatcher& getActiveAppWatcher() {
+    static ActiveAppWatcher watcher;
+    return watcher;
+}
+
+void watchActiveApps() {
+    getActiveAppWatcher().watch("Bitwig Studio");
+}
+
+bool isAppActive(std::string app) {
+    if (getActiveAppWatcher().watch(app)) {
+        return getActiveAppTracker().getActive() == app;
+    }
+    auto display = getDisplay();
+    if (display == nullptr) {
+        return false;
+    }
+    auto active = getActiveWindow(display);
+    return active != None && windowBelongsTo(display, active, app);
+}
+
+bool isBitwigActive() {
+    return isAppActive("Bitwig Studio");
+}
+
+bool isPluginWindowActive() {
+    return isAppActive("Bitwig Plug-in Host 64") || isAppActive("Bitwig Studio Engine");
+}
+
+Napi::Value AccessibilityEnabled(const Napi::CallbackInfo &info) {
+    // No permission needed to read other clients' windows on X11
+    return Napi::Boolean::New(info.Env(), getDisplay() != nullptr);
+}
+
+/**
+ * Watches windows on its own connection: the root for windows coming and going (and
+ * _NET_ACTIVE_WINDOW), plus each plugin window for moves, resizes and title changes
+ */
+class X11PluginWindowSource : public PluginWindowSource {
+    std::mutex mutex;
+    PluginWindowRegistry* registry = nullptr;
+    std::set<Window> known;
+    Display* eventDisplay = nullptr;
+    bool started = false;
+
+    bool isKnown(Window window) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return known.count(window) > 0;
+    }
+
+    void run() {
+        Window root = DefaultRootWindow(eventDisplay);
+        Atom clientList = XInternAtom(eventDisplay, "_NET_CLIENT_LIST", False);
+        Atom activeWindow = XInternAtom(eventDisplay, "_NET_ACTIVE_WINDOW", False);
+        Atom netWmName = XInternAtom(eventDisplay, "_NET_WM_NAME", False);
+        while (true) {
+            XEvent event;
+            XNextEvent(eventDisplay, &event);
+            switch (event.type) {
+                case PropertyNotify:
+                    if (event.xproperty.window == root) {
+                        if (event.xproperty.atom == clientList) {
+                            registry->invalidate();
+                            invalidateWindowList();
+                        } else if (event.xproperty.atom == activeWindow) {
+                            // Only which window is focused changed, the cached windows stand
+                            registry->focusChanged(getActiveWindow(eventDisplay));
+                            invalidateWindowList();
+                        }
+                    } else if ((event.xproperty.atom == XA_WM_NAME || event.xproperty.atom == netWmName) && isKnown(event.xproperty.window)) {
+                        registry->windowChanged(event.xproperty.window);
+                    }
+                    break;
+                case ConfigureNotify:
+                    if (isKnown(event.xconfigure.window)) {
+                        registry->windowChanged(event.xconfigure.window);
+                    }
+                    break;
+                case DestroyNotify:
+                    if (isKnown(event.xdestroywindow.window)) {
+                        {
+                            std::lock_guard<std::mutex> lock(mutex);
+                            known.erase(event.xdestroywindow.window);
+                        }
+                        registry->windowDestroyed(event.xdestroywindow.window);
+                    }
+                    break;
+                case MapNotify:
+                case UnmapNotify:
+                case ReparentNotify:
+                    // Could be a new plugin window, without a window manager there's no
+                    // _NET_CLIENT_LIST to tell us
+                    registry->invalidate();
+                    break;
+            }
+        }
+    }
+
+public:
+    bool watch(PluginWindowRegistry* registry) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->registry = registry;
+        if (started) {
+            return eventDisplay != nullptr;
+        }
+        started = true;
+        eventDisplay = XOpenDisplay(NULL);
+        if (eventDisplay == nullptr) {
+            std::cout << "Could not open display for plugin window events" << std::endl;
+            return false;
+        }
+        XSelectInput(eventDisplay, DefaultRootWindow(eventDisplay), SubstructureNotifyMask | PropertyChangeMask);
+        XFlush(eventDisplay);
+        std::thread([this]() {
+            run();
+        }).detach();
+        registry->invalidate();
+        return true;
+    }
+
+    PluginWindowList fetchAll() override {
+        PluginWindowList out;
+        auto display = getDisplay();
+        if (display == nullptr) {
+            return out;
+        }
+        auto active = getActiveWindow(display);
+        std::set<Window> found;
+        for (auto window : getPluginWindows()) {
+            PluginWindow pluginWindow;
+            if (!fetch(window, pluginWindow, active)) {
+                continue;
+            }
+            out.push_back(pluginWindow);
+            found.insert(window);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (eventDisplay != nullptr) {
+            for (auto window : found) {
+                if (!known.count(window)) {
+                    // Client level events, a reparenting window manager only tells the root about frames
+                    XSelectInput(eventDisplay, window, StructureNotifyMask | PropertyChangeMask);
+                }
+            }
+            XFlush(eventDisplay);
+        }
+        known = found;
+        return out;
+    }
+
+    bool fetch(uint64_t key, PluginWindow& window, Window active) {
+        auto display = getDisplay();
+        XWindowAttributes attrs;
+        if (display == nullptr || !XGetWindowAttributes(display, (Window)key, &attrs)) {
+            return false;
+        }
+        auto frame = getWindowFrame(display, (Window)key);
+        window.key = key;
+        window.title = getWindowTitle(display, (Window)key);
+        window.x = frame.x;
+        window.y = frame.y;
+        window.w = frame.w;
+        window.h = frame.h;
+        window.focused = (Window)key == active;
+        return true;
+    }
+
+    bool fetch(uint64_t key, PluginWindow& window) override {
+        auto display = getDisplay();
+        return display != nullptr && fetch(key, window, getActiveWindow(display));
+    }
+
+    bool move(uint64_t key, double x, double y) override {
+        auto display = getDisplay();
+        if (display == nullptr || !isKnown((Window)key)) {
+            return false;
+        }
+        // Requests are asynchronous, errors (the window going) end up in the error handler
+        XMoveWindow(display, (Window)key, (int)x, (int)y);
+        XFlush(display);
+        return true;
+    }
+
+    bool resize(uint64_t key, double w, double h) override {
+        auto display = getDisplay();
+        if (display == nullptr || !isKnown((Window)key) || w < 1 || h < 1) {
+            return false;
+        }
+        XResizeWindow(display, (Window)key, (unsigned int)w, (unsigned int)h);
+        XFlush(display);
+        return true;
+    }
+
+    void focus(uint64_t key) override {
+        auto display = getDisplay();
+        if (display != nullptr) {
+            activateWindow(display, (Window)key);
+        }
+    }
+
+    void awayPosition(double& x, double& y) override {
+        auto display = getDisplay();
+        x = display != nullptr ? DisplayWidth(display, DefaultScreen(display)) - 1 : 0;
+        y = display != nullptr ? DisplayHeight(display, DefaultScreen(display)) - 1 : 0;
+    }
+};
+
+PluginWindowRegistry& getPluginWindowRegistry() {
+    static X11PluginWindowSource source;
+    static PluginWindowRegistry registry(&source);
+    return registry;
+}
+
+void closeWindows(std::vector<Window> windows) {
+    auto display = getDisplay();
+    if (display == nullptr) {
+        return;
+    }
+    Atom protocols = XInternAtom(display, "WM_PROTOCOLS", False);
+    Atom deleteWindow = XInternAtom(display, "WM_DELETE_WINDOW", False);
+    for (auto window : windows) {
+        // Equivalent of pressing the close button, lets the plugin host clean up
+        XEvent event = {};
+        event.xclient.type = ClientMessage;
+        event.xclient.window = window;
+        event.xclient.message_type = protocols;
+        event.xclient.format = 32;
+        event.xclient.data.l[0] = deleteWindow;
+        event.xclient.data.l[1] = CurrentTime;
+        XSendEvent(display, window, False, NoEventMask, &event);
+    }
+    XFlush(display);
+}
+
+Napi::Value IsActiveApplication(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    if (info[0].IsString()) {
+        return Napi::Boolean::New(
+            env, 
+            isAppActive(info[0].As<Napi::String>())
+        );
+    }
+    return Napi::Boolean::New(
+        env, 
+        isBitwigActive() || isPluginWindowActive()
+    );
+}
+
+Napi::Value MakeMainWindowActive(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto display = getDisplay();
+    auto windows = getWindowList();
+    auto window = windows->findOwned("Bitwig Studio", 100);
+    auto success = window != nullptr;
+    if (success) {
+        activateWindow(display, window->id);
+    }
+    return Napi::Boolean::New(
+        env, 
+        success
+    );
+}
+
+Napi::Value IsPluginWindowActive(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    return Napi::Boolean::New(
+        env, 
+        isPluginWindowActive()
+    );
+}
+
+Napi::Value CloseFloatingWindows(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    closeWindows(getPluginWindows());
+    return Napi::Boolean::New(env, true);
+}
+
+/**
+ * Finds processes through their windows' _NET_WM_PID and waits on a pidfd for each to exit.
+ * Kernels before 5.3 don't have pidfd_open, then the table checks the pid on each access.
+ * Launches would need the netlink proc connector, which needs CAP_NET_ADMIN, so processes
+ * that weren't running are looked for again after a short while instead
+ */
+class PidfdProcessSource : public ProcessSource {
+    std::mutex mutex;
+    ProcessTable* table = nullptr;
+    std::map<int, pid_t> pidByFd;
+    // Wakes the poll thread when there's a new fd to wait on
+    int wakeFd = -1;
+    bool started = false;
+
+    void run() {
+        while (true) {
+            std::vector<struct pollfd> fds = {{wakeFd, POLLIN, 0}};
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (auto& pair : pidByFd) {
+                    fds.push_back({pair.first, POLLIN, 0});
+                }
+            }
+            if (poll(fds.data(), fds.size(), -1) <= 0) {
+                continue;
+            }
+            if (fds[0].revents & POLLIN) {
+                // Only drains the counter, EAGAIN means someone else already did
+                uint64_t count;
+                while (read(wakeFd, &count, sizeof(count)) == -1 && errno == EINTR) {}
+            }
+            std::vector<pid_t> exited;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (size_t i = 1; i < fds.size(); i++) {
+                    if (fds[i].revents != 0) {
+                        exited.push_back(pidByFd[fds[i].fd]);
+                        pidByFd.erase(fds[i].fd);
+                        close(fds[i].fd);
+                    }
+                }
+            }
+            // Outside the lock, the table calls back into watch()
+            for (auto pid : exited) {
+                table->exited(pid);
+            }
+        }
+    }
+
+public:
+    pid_t lookup(const std::string& name) override {
+        auto windows = getWindowList();
+        for (auto window : windows->ownedBy(name)) {
+            if (window->pid != -1) {
+                return window->pid;
+            }
+        }
+        return -1;
+    }
+
+    bool watch(pid_t pid, ProcessTable* table) override {
+        int fd = syscall(SYS_pidfd_open, pid, 0);
+        if (fd == -1) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        this->table = table;
+        if (!started) {
+            started = true;
+            wakeFd = eventfd(0, EFD_NONBLOCK);
+            if (wakeFd != -1) {
+                std::thread([this]() {
+                    run();
+                }).detach();
+            }
+        }
+        if (wakeFd == -1) {
+            close(fd);
+            return false;
+        }
+        pidByFd[fd] = pid;
+        uint64_t one = 1;
+        ssize_t written;
+        while ((written = write(wakeFd, &one, sizeof(one))) == -1 && errno == EINTR) {}
+        // EAGAIN is a saturated counter, the poll thread is due to wake anyway
+        if (written == -1 && errno != EAGAIN) {
+            pidByFd.erase(fd);
+            close(fd);
+            return false;
+        }
+        return true;
+    }
+};
+
+bool readProcessResources(pid_t pid, ProcessResources& out) {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/stat");
+    std::string stat;
+    if (!std::getline(file, stat)) {
+        return false;
+    }
+    // The command name is in parentheses and may contain spaces, fields are counted after it
+    auto commEnd = stat.rfind(')');
+    if (commEnd == std::string::npos) {
+        return false;
+    }
+    std::istringstream fields(stat.substr(commEnd + 2));
+    std::vector<std::string> values;
+    std::string value;
+    while (fields >> value) {
+        values.push_back(value);
+    }
+    // state is field 3 in proc(5), so field n is values[n - 3]
+    if (values.size() < 22) {
+        return false;
+    }
+    static const double ticksPerSecond = sysconf(_SC_CLK_TCK);
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    out.cpuTime = (std::stod(values[14 - 3]) + std::stod(values[15 - 3])) / ticksPerSecond;
+    out.threads = std::stoi(values[20 - 3]);
+    out.rss = std::stoull(values[24 - 3]) * pageSize;
+    return true;
+}
+
+ProcessTable& getProcessTable() {
+    static PidfdProcessSource source;
+    static ProcessTable table(&source);
+    return table;
+}
+
+Napi::Value GetAudioEnginePid(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto pid = getProcessTable().find("Bitwig Plug-in Host 64");
+    if (pid == -1) {
+        pid = getProcessTable().find("Bitwig Studio Engine");
+    }
+    return Napi::Number::New(env, pid);
+}
+
+Napi::Value GetPid(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    return Napi::Number::New(env, getProcessTable().find("Bitwig Studio"));
+}
+
+Napi::Value InitBitwig(Napi::Env env, Napi::Object exports)
+{
+    Napi::Object obj = Napi::Object::New(env);
+    getProcessTable().addExitListener([](const std::string& name, pid_t) -> void {
+        getActiveAppTracker().deactivated(name);
+        getPluginWindowRegistry().invalidate();
+    });
+    obj.Set("isActiveApplication", Napi::Function::New(env, IsActiveApplication));
+    obj.Set("isPluginWindowActive", Napi::Function::New(env, IsPluginWindowActive));
+    obj.Set("makeMainWindowActive", Napi::Function::New(env, MakeMainWindowActive));
+    obj.Set("closeFloatingWindows", Napi::Function::New(env, CloseFloatingWindows));
+    obj.Set("isAccessibilityEnabled", Napi::Function::New(env, AccessibilityEnabled));
+    addPluginWindowFunctions(env, obj);
+    addNativeEventFunctions(env, obj);
+    addActiveAppFunctions(env, obj);
+    addResourceFunctions(env, obj);
+    BESPacketFramer::Init(env, obj);
+    obj.Set("getAudioEnginePid", Napi::Function::New(env, GetAudioEnginePid));
+    obj.Set("getPid", Napi::Function::New(env, GetPid));
+    exports.Set("Bitwig", obj);
+    return exports;
+}
@@ -0,0 +1,206 @@
+#include "../capture.h"
+#include "x11.h"
+#include <X11/Xutil.h>
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+/**
+ * A window sized XImage, backed by a MIT-SHM segment when the extension is available so the
+ * server writes pixels straight into memory we read from (no copy through the socket).
+ * Images are pooled, so steady state capture allocates nothing. Two are normally alive,
+ * the one the current ImageDeets points at and the one being captured into.
+ */
+struct ShmImage {
+    XImage* image = nullptr;
+    XShmSegmentInfo shmInfo = {};
+    bool usingShm = false;
+    int width = 0, height = 0;
+};
+
+std::mutex imagePoolMutex;
+std::vector<ShmImage*> freeImages;
+const size_t MAX_POOLED_IMAGES = 4;
+
+void destroyShmImage(Display* display, ShmImage* shmImage) {
+    if (shmImage->usingShm) {
+        XShmDetach(display, &shmImage->shmInfo);
+        XDestroyImage(shmImage->image);
+        shmdt(shmImage->shmInfo.shmaddr);
+    } else if (shmImage->image != nullptr) {
+        XDestroyImage(shmImage->image);
+    }
+    delete shmImage;
+}
+
+ShmImage* createShmImage(Display* display, XWindowAttributes& attrs, int width, int height) {
+    auto shmImage = new ShmImage();
+    shmImage->width = width;
+    shmImage->height = height;
+    if (!XShmQueryExtension(display)) {
+        // Remote displays etc. Captures fall back to XGetImage, which allocates its own image
+        return shmImage;
+    }
+    shmImage->image = XShmCreateImage(display, attrs.visual, attrs.depth, ZPixmap, NULL, &shmImage->shmInfo, width, height);
+    if (shmImage->image == nullptr) {
+        return shmImage;
+    }
+    shmImage->shmInfo.shmid = shmget(IPC_PRIVATE, shmImage->image->bytes_per_line * shmImage->image->height, IPC_CREAT | 0600);
+    if (shmImage->shmInfo.shmid == -1) {
+        XDestroyImage(shmImage->image);
+        shmImage->image = nullptr;
+        return shmImage;
+    }
+    auto shmaddr = (char*)shmat(shmImage->shmInfo.shmid, 0, 0);
+    if (shmaddr == (char*)-1) {
+        shmctl(shmImage->shmInfo.shmid, IPC_RMID, 0);
+        XDestroyImage(shmImage->image);
+        shmImage->image = nullptr;
+        return shmImage;
+    }
+    shmImage->shmInfo.shmaddr = shmImage->image->data = shmaddr;
+    shmImage->shmInfo.readOnly = False;
+    // The server can refuse the segment (e.g. a remote or sandboxed client), which only shows
+    // up as an error
+    trapXErrors();
+    bool attached = XShmAttach(display, &shmImage->shmInfo);
+    attached = untrapXErrors(display) == 0 && attached;
+    // Mark for removal now, the segment lives until both we and the server detach
+    shmctl(shmImage->shmInfo.shmid, IPC_RMID, 0);
+    if (!attached) {
+        std::cout << "Couldn't attach shared memory, capturing with XGetImage" << std::endl;
+        XDestroyImage(shmImage->image);
+        shmdt(shmaddr);
+        shmImage->image = nullptr;
+        return shmImage;
+    }
+    shmImage->usingShm = true;
+    return shmImage;
+}
+
+ShmImage* takeShmImage(Display* display, XWindowAttributes& attrs, int width, int height) {
+    std::lock_guard<std::mutex> lock(imagePoolMutex);
+    for (auto it = freeImages.begin(); it != freeImages.end(); it++) {
+        if ((*it)->width == width && (*it)->height == height) {
+            auto image = *it;
+            freeImages.erase(it);
+            return image;
+        }
+    }
+    // Normally there's one per size being captured (the window and any sampled regions), the
+    // oldest are from before the window was resized
+    while (freeImages.size() >= MAX_POOLED_IMAGES) {
+        destroyShmImage(display, freeImages.front());
+        freeImages.erase(freeImages.begin());
+    }
+    return createShmImage(display, attrs, width, height);
+}
+
+void returnShmImage(ShmImage* shmImage) {
+    std::lock_guard<std::mutex> lock(imagePoolMutex);
+    if (!shmImage->usingShm && shmImage->image != nullptr) {
+        // XGetImage fallback images are one shot
+        XDestroyImage(shmImage->image);
+        shmImage->image = nullptr;
+    }
+    freeImages.push_back(shmImage);
+}
+
+/**
+ * ImageDeets
+ */
+ImageDeets::ImageDeets(ShmImage* shmImage, WindowInfo frame) {
+    this->frame = frame;
+    this->shmImage = shmImage;
+    auto image = shmImage->image;
+    data = (const uint8_t*)image->data;
+
+    // 24/32 bit TrueColor ZPixmaps are BGRX in memory on little endian, same as the
+    // kCGImageAlphaPremultipliedFirst | kCGBitmapByteOrder32Little layout we get on macOS
+    bytesPerRow = image->bytes_per_line;
+    bytesPerPixel = image->bits_per_pixel / 8;
+
+    width = frame.frame.w;
+    height = frame.frame.h;
+    maxInclOffset = getPixelOffset(XYPoint{width - 1, height - 1});
+};
+
+ImageDeets::~ImageDeets() {
+    returnShmImage(shmImage);
+};
+
+WindowInfo findBitwigMainWindow() {
+    // Tooltip windows are smaller, same as on macOS
+    auto windows = getWindowList();
+    auto window = windows->findOwned("Bitwig Studio", 100);
+    if (window != nullptr) {
+        return WindowInfo{
+            window->id,
+            window->frame
+        };
+    }
+    return WindowInfo{
+        1,
+        MWRect{0, 0, 0, 0}
+    };
+};
+
+/**
+ * Attributes of a window we can capture from, false if it's unmapped or not true colour
+ */
+bool getCapturableWindow(Display* display, NativeWindowId windowId, XWindowAttributes& attrs) {
+    return display != nullptr
+        && XGetWindowAttributes(display, windowId, &attrs)
+        && attrs.map_state == IsViewable
+        && attrs.depth >= 24;
+}
+
+// region has already been checked against attrs
+ImageDeets* captureRegion(Display* display, XWindowAttributes& attrs, WindowInfo info, MWRect region) {
+    auto shmImage = takeShmImage(display, attrs, region.w, region.h);
+    bool captured = false;
+    if (shmImage->usingShm) {
+        captured = XShmGetImage(display, info.windowId, shmImage->image, region.x, region.y, AllPlanes);
+    } else {
+        trapXErrors();
+        shmImage->image = XGetImage(display, info.windowId, region.x, region.y, region.w, region.h, AllPlanes, ZPixmap);
+        captured = untrapXErrors(display) == 0 && shmImage->image != nullptr;
+        if (!captured && shmImage->image != nullptr) {
+            XDestroyImage(shmImage->image);
+            shmImage->image = nullptr;
+        }
+    }
+    if (!captured) {
+        returnShmImage(shmImage);
+        return nullptr;
+    }
+    return new ImageDeets(shmImage, info);
+}
+
+ImageDeets* captureWindow(WindowInfo info) {
+    auto display = getDisplay();
+    XWindowAttributes attrs;
+    if (!getCapturableWindow(display, info.windowId, attrs)) {
+        return nullptr;
+    }
+    // Frame size must agree with the image, the window may have been resized since lookup
+    info.frame.w = attrs.width;
+    info.frame.h = attrs.height;
+    return captureRegion(display, attrs, info, MWRect{0, 0, attrs.width, attrs.height});
+}
+
+ImageDeets* captureWindowRegion(WindowInfo info, MWRect region) {
+    auto display = getDisplay();
+    XWindowAttributes attrs;
+    if (!getCapturableWindow(display, info.windowId, attrs)) {
+        return nullptr;
+    }
+    if (region.w <= 0 || region.h <= 0 || region.x < 0 || region.y < 0 || region.x + region.w > attrs.width || region.y + region.h > attrs.height) {
+        return nullptr;
+    }
+    info.frame = MWRect{info.frame.x + region.x, info.frame.y + region.y, region.w, region.h};
+    return captureRegion(display, attrs, info, region);
+}
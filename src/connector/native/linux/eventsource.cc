@@ -0,0 +1,51 @@
+#include "eventsource.h"
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+struct ExpectedEvent {
+    int type;
+    unsigned int detail;
+    std::chrono::steady_clock::time_point at;
+};
+
+std::mutex expectedMutex;
+std::deque<ExpectedEvent> expectedEvents;
+
+// Events reach the record thread within a few ms, anything older was lost (e.g. grabbed)
+const auto EXPECTED_EVENT_TIMEOUT = std::chrono::milliseconds(500);
+// Nothing consumes expectations while the record thread isn't running (no Keyboard.on
+// listener), so they're also dropped as new ones come in, and never more than this are kept
+const size_t EXPECTED_EVENT_LIMIT = 256;
+
+// Called with expectedMutex held
+void pruneExpectedEvents(std::chrono::steady_clock::time_point now) {
+    while (expectedEvents.size() > 0 && now - expectedEvents.front().at > EXPECTED_EVENT_TIMEOUT) {
+        expectedEvents.pop_front();
+    }
+}
+
+void expectSyntheticEvent(int type, unsigned int detail, bool modwigListeners) {
+    if (modwigListeners) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(expectedMutex);
+    auto now = std::chrono::steady_clock::now();
+    pruneExpectedEvents(now);
+    if (expectedEvents.size() >= EXPECTED_EVENT_LIMIT) {
+        expectedEvents.pop_front();
+    }
+    expectedEvents.push_back(ExpectedEvent{type, detail, now});
+}
+
+bool isOwnSyntheticEvent(int type, unsigned int detail) {
+    std::lock_guard<std::mutex> lock(expectedMutex);
+    pruneExpectedEvents(std::chrono::steady_clock::now());
+    for (auto it = expectedEvents.begin(); it != expectedEvents.end(); it++) {
+        if (it->type == type && it->detail == detail) {
+            expectedEvents.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * XRecord sees our own XTest events like any other input, and unlike CGEventSource there's no
+ * user data field to tag them with. Instead we note each event just before synthesising it and
+ * the record thread consumes the match, which is the equivalent of the macOS "42" check.
+ * 
+ * Pass modwigListeners = true to let our own listeners see the event (user data 41 on macOS).
+ */
+void expectSyntheticEvent(int type, unsigned int detail, bool modwigListeners = false);
+bool isOwnSyntheticEvent(int type, unsigned int detail);
@@ -0,0 +1,357 @@
+#include "../point.h"
+#include "../keyboard.h"
+#include "../input.h"
+#include "../constraint.h"
+#include "../sequence.h"
+#include "../metrics.h"
+#include "x11.h"
+#include "keymap.h"
+#include "eventsource.h"
+
+#include <X11/XKBlib.h>
+#include <X11/Xproto.h>
+#include <X11/extensions/record.h>
+#include <X11/extensions/XTest.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <forward_list>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <stdexcept>
+
+using std::forward_list;
+
+/**
+ * Linux equivalent of the event tap in ../keyboard.cc. XRecord gives us a copy of every device
+ * event on a dedicated thread, but can't modify or swallow them like a CGEventTap can, so
+ * returning early for mouse buttons > 2 has no equivalent here.
+ */
+bool recordThreadSetup = false;
+bool recordEnabled = false;
+std::thread recordThread;
+XRecordContext recordContext;
+// Where the pointer was left by the last motion seen, ours included. Motion carries no deltas,
+// so they're measured from here
+int pointerX = 0, pointerY = 0;
+bool pointerKnown = false;
+
+int nextId = 0;
+std::mutex m;
+forward_list<CallbackInfo*> callbacks;
+
+void processKeyCallback(Napi::Env env, Napi::Function jsCallback, JSEvent* value) {
+    Napi::Object obj = Napi::Object::New(env);
+
+    obj.Set(Napi::String::New(env, "nativeKeyCode"), Napi::Number::New(env, value->nativeKeyCode));
+    obj.Set(Napi::String::New(env, "lowerKey"), Napi::String::New(env, value->lowerKey));
+    obj.Set(Napi::String::New(env, "Meta"), Napi::Boolean::New(env, value->Meta));
+    obj.Set(Napi::String::New(env, "Shift"), Napi::Boolean::New(env, value->Shift));
+    obj.Set(Napi::String::New(env, "Control"), Napi::Boolean::New(env, value->Control));
+    obj.Set(Napi::String::New(env, "Alt"), Napi::Boolean::New(env, value->Alt));
+    obj.Set(Napi::String::New(env, "Fn"), Napi::Boolean::New(env, value->Fn));
+
+    jsCallback.Call( {obj} );
+}
+
+void processMouseCallback(Napi::Env env, Napi::Function jsCallback, JSEvent* value) {
+    Napi::Object obj = Napi::Object::New(env);
+
+    obj.Set(Napi::String::New(env, "Meta"), Napi::Boolean::New(env, value->Meta));
+    obj.Set(Napi::String::New(env, "Shift"), Napi::Boolean::New(env, value->Shift));
+    obj.Set(Napi::String::New(env, "Control"), Napi::Boolean::New(env, value->Control));
+    obj.Set(Napi::String::New(env, "Alt"), Napi::Boolean::New(env, value->Alt));
+    obj.Set(Napi::String::New(env, "Fn"), Napi::Boolean::New(env, value->Fn));
+
+    obj.Set(Napi::String::New(env, "x"), Napi::Number::New(env, value->x));
+    obj.Set(Napi::String::New(env, "y"), Napi::Number::New(env, value->y));
+    obj.Set(Napi::String::New(env, "button"), Napi::Number::New(env, value->button));
+
+    jsCallback.Call( {obj} );
+}
+
+void dispatchEvent(const JSEvent& event, bool isKeyEvent) {
+    // Events handed to JS but not yet delivered, and how long each takes once it is
+    static auto& queueDepth = metricGauge("events.queueDepth");
+    static auto& marshalTime = metricHistogram("napi.event.time");
+    auto keyCallback = []( Napi::Env env, Napi::Function jsCallback, JSEvent* value ) {
+        queueDepth.add(-1);
+        MetricTimer timer(marshalTime);
+        processKeyCallback(env, jsCallback, value);
+        delete value;
+    };
+    auto mouseCallback = []( Napi::Env env, Napi::Function jsCallback, JSEvent* value ) {
+        queueDepth.add(-1);
+        MetricTimer timer(marshalTime);
+        processMouseCallback(env, jsCallback, value);
+        delete value;
+    };
+
+    m.lock();
+    for (auto cbInfo : callbacks) {
+        if (cbInfo->eventType != event.type) {
+            continue;
+        }
+        if (cbInfo->cb != nullptr) {
+            // Each listener gets its own copy, deleted by the JS side callback
+            queueDepth.add(1);
+            if (isKeyEvent) {
+                cbInfo->cb.BlockingCall( new JSEvent(event), keyCallback );
+            } else {
+                cbInfo->cb.BlockingCall( new JSEvent(event), mouseCallback );
+            }
+        }
+        if (cbInfo->nativeFn != nullptr) {
+            JSEvent copy = event;
+            cbInfo->nativeFn( &copy );
+        }
+    }
+    m.unlock();
+}
+
+void record_callback(XPointer closure, XRecordInterceptData* data) {
+    if (data->category != XRecordFromServer) {
+        XRecordFreeData(data);
+        return;
+    }
+    auto event = (xEvent*)data->data;
+    int type = event->u.u.type & 0x7F;
+    unsigned int detail = event->u.u.detail;
+    unsigned int state = event->u.keyButtonPointer.state;
+
+    if (type == ButtonRelease || type == KeyRelease) {
+        // Clicks and shortcuts (ours too) are what open, close and move windows
+        invalidateWindowList();
+    }
+
+    int rootX = event->u.keyButtonPointer.rootX;
+    int rootY = event->u.keyButtonPointer.rootY;
+    int dx = 0, dy = 0;
+    if (type == MotionNotify) {
+        dx = pointerKnown ? rootX - pointerX : 0;
+        dy = pointerKnown ? rootY - pointerY : 0;
+        pointerX = rootX;
+        pointerY = rootY;
+        pointerKnown = true;
+    }
+
+    if (isOwnSyntheticEvent(type, detail)) {
+        // Skip our own events
+        XRecordFreeData(data);
+        return;
+    }
+
+    if (type == MotionNotify) {
+        double x = rootX, y = rootY;
+        if (pointerConstrainer.constrain(x, y, dx, dy)) {
+            // RECORD can only watch, not rewrite, so put the pointer where it should be. Unlike
+            // the macOS tap, clients will already have seen the original motion
+            auto display = getDisplay();
+            rootX = (int)std::lround(x);
+            rootY = (int)std::lround(y);
+            expectSyntheticEvent(MotionNotify, 0, false);
+            XWarpPointer(display, None, DefaultRootWindow(display), 0, 0, 0, 0, rootX, rootY);
+            XFlush(display);
+            pointerX = rootX;
+            pointerY = rootY;
+        }
+    }
+
+    bool isKeyEvent = type == KeyPress || type == KeyRelease;
+    KeySym sym = isKeyEvent ? XkbKeycodeToKeysym(getDisplay(), detail, 0, 0) : NoSymbol;
+    XRecordFreeData(data);
+
+    JSEvent jsEvent = JSEvent();
+    if (!translateRecordedEvent(type, detail, state, rootX, rootY, sym, jsEvent)) {
+        return;
+    }
+    dispatchEvent(jsEvent, isKeyEvent);
+}
+
+void ensureRecordThread() {
+    if (recordThreadSetup) {
+        return;
+    }
+    recordThreadSetup = true;
+    auto controlDisplay = getDisplay();
+    if (controlDisplay == nullptr) {
+        return;
+    }
+    int major, minor;
+    if (!XRecordQueryVersion(controlDisplay, &major, &minor)) {
+        std::cout << "RECORD extension not available, input events won't be received" << std::endl;
+        return;
+    }
+    XRecordRange* range = XRecordAllocRange();
+    range->device_events.first = KeyPress;
+    range->device_events.last = MotionNotify;
+    XRecordClientSpec clients = XRecordAllClients;
+    recordContext = XRecordCreateContext(controlDisplay, 0, &clients, 1, &range, 1);
+    XFree(range);
+    if (!recordContext) {
+        std::cout << "Could not create record context." << std::endl;
+        return;
+    }
+    XSync(controlDisplay, False);
+
+    recordThread = std::thread( [=] {
+        // XRecord needs its own connection for the data, which this thread blocks on
+        Display* dataDisplay = XOpenDisplay(NULL);
+        if (dataDisplay == nullptr) {
+            std::cout << "Could not open record display." << std::endl;
+            return;
+        }
+        recordEnabled = true;
+        XRecordEnableContext(dataDisplay, recordContext, record_callback, nullptr);
+        recordEnabled = false;
+        XCloseDisplay(dataDisplay);
+    } );
+    recordThread.detach();
+}
+
+CallbackInfo* addEventListener(EventListenerSpec spec) {
+    if (!("keyup" == spec.eventType
+        || "keydown" == spec.eventType
+        || "mousemove" == spec.eventType
+        || "mousedown" == spec.eventType
+        || "mouseup" == spec.eventType
+        || "scroll" == spec.eventType)) {
+        throw std::invalid_argument("Unrecognised event type: " + spec.eventType);
+    }
+
+    CallbackInfo *ourInfo = new CallbackInfo;
+    ourInfo->nativeFn = spec.cb;
+    ourInfo->id = nextId++;
+    ourInfo->eventType = spec.eventType;
+    if (spec.jsFunction != nullptr) {
+        ourInfo->cb = Napi::ThreadSafeFunction::New(
+            spec.env,
+            *spec.jsFunction, // JavaScript function called asynchronously                      
+            "Resource Name", // Name         
+            0, // Unlimited queue                      
+            1 // Initial thread count 
+        );                      
+    }
+
+    m.lock();
+    callbacks.push_front(ourInfo);
+    m.unlock();
+    ensureRecordThread();
+    return ourInfo;
+}
+
+/**
+ * Motion is only seen while the record thread is running, which otherwise waits for a listener
+ */
+void ensurePointerConstraintTap() {
+    ensureRecordThread();
+}
+
+Napi::Value on(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto eventType = info[0].As<Napi::String>().Utf8Value();
+    auto cb = info[1].As<Napi::Function>();
+    auto ourInfo = addEventListener(EventListenerSpec({
+        eventType,
+        nullptr,
+        &cb,
+        env
+    }));
+    return Napi::Number::New(env, ourInfo->id);
+}
+
+Napi::Value off(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    int id = info[0].As<Napi::Number>();
+    m.lock();
+    callbacks.remove_if([=](CallbackInfo *e){ 
+        bool willRemove = e->id == id;     
+        if (willRemove) {
+            // free it
+            delete e;
+        }
+        return willRemove;
+    });
+    m.unlock();
+    return Napi::Boolean::New(env, true);
+}
+
+Napi::Value isEnabled(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    int id = info[0].As<Napi::Number>();
+
+    m.lock();
+    auto it = std::find_if (callbacks.begin(), callbacks.end(), [=](CallbackInfo *e){ 
+        return e->id == id;
+    });
+    bool found = it != callbacks.end();
+    m.unlock();
+    return Napi::Boolean::New(env, found && recordEnabled);
+}
+
+bool postKey(const std::string& key, bool down, InputModifiers modifiers, bool modwigListeners) {
+    auto display = getDisplay();
+    if (display == nullptr) {
+        return false;
+    }
+    KeySym sym = keySymForKey(key);
+    if (sym == NoSymbol) {
+        return false;
+    }
+
+    // X events don't carry modifier flags, the server state does. Hold them around the key.
+    // No Fn modifier on X11
+    fakeModifiers(display, modifiers.Meta, modifiers.Control, modifiers.Shift, modifiers.Alt, true, modwigListeners);
+    fakeKey(display, sym, down, modwigListeners);
+    fakeModifiers(display, modifiers.Meta, modifiers.Control, modifiers.Shift, modifiers.Alt, false, modwigListeners);
+    XFlush(display);
+    return true;
+}
+
+Napi::Value keyPresser(const Napi::CallbackInfo &info, bool down) {
+    Napi::Env env = info.Env();
+
+    std::string s = info[0].As<Napi::String>();
+    InputModifiers modifiers;
+    bool modwigListeners = false;
+    if (info[1].IsObject()) {
+        Napi::Object obj = info[1].As<Napi::Object>();
+        modifiers.Meta = obj.Has("Meta");
+        modifiers.Shift = obj.Has("Shift");
+        modifiers.Alt = obj.Has("Alt");
+        modifiers.Control = obj.Has("Control");
+        modwigListeners = obj.Has("modwigListeners") && obj.Get("modwigListeners").As<Napi::Boolean>();
+    }
+    return Napi::Boolean::New(env, postKey(s, down, modifiers, modwigListeners));
+}
+
+Napi::Value keyDown(const Napi::CallbackInfo &info) {
+    return keyPresser(info, true);
+}
+
+Napi::Value keyUp(const Napi::CallbackInfo &info) {
+    return keyPresser(info, false);
+}
+
+Napi::Value keyPress(const Napi::CallbackInfo &info) {
+    keyDown(info);
+    usleep(10000);
+    return keyUp(info);
+}
+
+Napi::Value InitKeyboard(Napi::Env env, Napi::Object exports)
+{
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set(Napi::String::New(env, "on"), Napi::Function::New(env, on));
+    obj.Set(Napi::String::New(env, "off"), Napi::Function::New(env, off));
+    obj.Set(Napi::String::New(env, "isEnabled"), Napi::Function::New(env, isEnabled));
+    obj.Set(Napi::String::New(env, "keyDown"), Napi::Function::New(env, keyDown));
+    obj.Set(Napi::String::New(env, "keyUp"), Napi::Function::New(env, keyUp));
+    obj.Set(Napi::String::New(env, "keyPress"), Napi::Function::New(env, keyPress));
+    obj.Set(Napi::String::New(env, "sequence"), Napi::Function::New(env, Sequence));
+    addPointerConstraintFunctions(env, obj);
+    exports.Set("Keyboard", obj);
+    return exports;
+}
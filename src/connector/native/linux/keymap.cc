@@ -0,0 +1,178 @@
+#include "keymap.h"
+#include "eventsource.h"
+#include <X11/keysym.h>
+#include <X11/XF86keysym.h>
+#include <X11/extensions/XTest.h>
+#include <map>
+#include <mutex>
+#include <vector>
+
+std::map<KeySym, std::string> keySymMap = {
+  {XK_section, "§"},
+  {XK_equal, "="},
+  {XK_minus, "-"},
+  {XK_bracketright, "]"},
+  {XK_bracketleft, "["},
+  {XK_apostrophe, "\'"},
+  {XK_semicolon, ";"},
+  {XK_backslash, "\\"},
+  {XK_comma, ","},
+  {XK_slash, "/"},
+  {XK_period, "."},
+  {XK_grave, "`"},
+  {XK_KP_Decimal, "NumpadDecimal"},
+  {XK_KP_Multiply, "NumpadMultiply"},
+  {XK_KP_Add, "NumpadAdd"},
+  // Mac keyboards have Clear where PC keyboards have Num Lock
+  {XK_Num_Lock, "Clear"},
+  {XK_KP_Divide, "NumpadDivide"},
+  {XK_KP_Enter, "NumpadEnter"},
+  {XK_KP_Subtract, "NumpadSubtract"},
+  {XK_KP_Equal, "NumpadEquals"},
+  {XK_KP_0, "Numpad0"},
+  {XK_KP_1, "Numpad1"},
+  {XK_KP_2, "Numpad2"},
+  {XK_KP_3, "Numpad3"},
+  {XK_KP_4, "Numpad4"},
+  {XK_KP_5, "Numpad5"},
+  {XK_KP_6, "Numpad6"},
+  {XK_KP_7, "Numpad7"},
+  {XK_KP_8, "Numpad8"},
+  {XK_KP_9, "Numpad9"},
+
+  {XK_Return, "Enter"},
+  {XK_Tab, "Tab"},
+  {XK_space, "Space"},
+  {XK_BackSpace, "Backspace"},
+  {XK_Escape, "Escape"},
+  {XK_Super_L, "Meta"},
+  {XK_Shift_L, "Shift"},
+  {XK_Caps_Lock, "CapsLock"},
+  {XK_Alt_L, "Alt"},
+  {XK_Control_L, "Control"},
+  {XK_Shift_R, "RightShift"},
+  {XK_Alt_R, "RightAlt"},
+  {XK_ISO_Level3_Shift, "RightAlt"},
+  {XK_Control_R, "RightControl"},
+  {XK_Super_R, "Meta"},
+
+  {XF86XK_AudioRaiseVolume, "VolumeUp"},
+  {XF86XK_AudioLowerVolume, "VolumeDown"},
+  {XF86XK_AudioMute, "Mute"},
+  {XK_Help, "Help"},
+  {XK_Home, "Home"},
+  {XK_Prior, "PageUp"},
+  {XK_Delete, "Delete"},
+  {XK_End, "End"},
+  {XK_Next, "PageDown"},
+  {XK_Left, "ArrowLeft"},
+  {XK_Right, "ArrowRight"},
+  {XK_Down, "ArrowDown"},
+  {XK_Up, "ArrowUp"}
+};
+std::map<std::string, KeySym> keySymMapReverse;
+
+void ensureKeySymMaps() {
+    // Called from the record thread and the sequence scheduler as well as JS
+    static std::once_flag flag;
+    std::call_once(flag, []() {
+        for (KeySym sym = XK_a; sym <= XK_z; sym++) {
+            keySymMap[sym] = std::string(1, (char)sym);
+        }
+        for (KeySym sym = XK_0; sym <= XK_9; sym++) {
+            keySymMap[sym] = std::string(1, (char)sym);
+        }
+        for (int i = 0; i < 20; i++) {
+            keySymMap[XK_F1 + i] = "F" + std::to_string(i + 1);
+        }
+        for (auto& pair : keySymMap) {
+            // Left hand keys come first in the map, prefer them when synthesising
+            if (!keySymMapReverse.count(pair.second)) {
+                keySymMapReverse[pair.second] = pair.first;
+            }
+        }
+    });
+}
+
+std::string keyForKeySym(KeySym sym) {
+    ensureKeySymMaps();
+    auto it = keySymMap.find(sym);
+    return it != keySymMap.end() ? it->second : "";
+}
+
+KeySym keySymForKey(const std::string& key) {
+    ensureKeySymMaps();
+    auto it = keySymMapReverse.find(key);
+    return it != keySymMapReverse.end() ? it->second : NoSymbol;
+}
+
+/**
+ * X buttons are 1 indexed, with 4-7 used for scrolling and 8/9 for back/forward.
+ * Match the JS numbering used on macOS (left 0, middle 1, right 2, then 3, 4...)
+ */
+int jsButtonForXButton(unsigned int xButton) {
+    if (xButton == 1) return 0;
+    if (xButton == 2) return 1;
+    if (xButton == 3) return 2;
+    if (xButton >= 8) return xButton - 5;
+    return -1;
+}
+
+bool isScrollButton(unsigned int xButton) {
+    return xButton >= 4 && xButton <= 7;
+}
+
+std::string eventTypeForXEvent(int type, unsigned int detail, unsigned int state) {
+    switch (type) {
+        case KeyPress: return "keydown";
+        case KeyRelease: return "keyup";
+        case ButtonPress: return isScrollButton(detail) ? "scroll" : "mousedown";
+        case ButtonRelease: return isScrollButton(detail) ? "" : "mouseup";
+        case MotionNotify:
+            // macOS only sends us moves and middle drags for "mousemove", keep that behaviour
+            return (state & (Button1Mask | Button3Mask)) ? "" : "mousemove";
+    }
+    return "";
+}
+
+bool translateRecordedEvent(int type, unsigned int detail, unsigned int state, int rootX, int rootY, KeySym sym, JSEvent& event) {
+    event.type = eventTypeForXEvent(type, detail, state);
+    if (event.type == "") {
+        return false;
+    }
+    event.Shift = (state & (ShiftMask | LockMask)) != 0;
+    event.Control = (state & ControlMask) != 0;
+    event.Alt = (state & Mod1Mask) != 0;
+    event.Meta = (state & Mod4Mask) != 0;
+    event.Fn = false;
+
+    if (type == KeyPress || type == KeyRelease) {
+        event.nativeKeyCode = detail;
+        event.lowerKey = keyForKeySym(sym);
+    } else {
+        event.x = rootX;
+        event.y = rootY;
+        event.button = type == MotionNotify ? -1 : jsButtonForXButton(detail);
+    }
+    return true;
+}
+
+void fakeKey(Display* display, KeySym sym, bool down, bool modwigListeners) {
+    KeyCode keyCode = XKeysymToKeycode(display, sym);
+    if (keyCode == 0) {
+        return;
+    }
+    expectSyntheticEvent(down ? KeyPress : KeyRelease, keyCode, modwigListeners);
+    XTestFakeKeyEvent(display, keyCode, down, CurrentTime);
+}
+
+void fakeModifiers(Display* display, bool meta, bool control, bool shift, bool alt, bool down, bool modwigListeners) {
+    std::vector<KeySym> syms;
+    if (meta) syms.push_back(XK_Super_L);
+    if (control) syms.push_back(XK_Control_L);
+    if (shift) syms.push_back(XK_Shift_L);
+    if (alt) syms.push_back(XK_Alt_L);
+    for (auto sym : syms) {
+        fakeKey(display, sym, down, modwigListeners);
+    }
+}
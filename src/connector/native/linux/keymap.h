@@ -0,0 +1,22 @@
+#pragma once
+#include "../input.h"
+#include <X11/Xlib.h>
+#include <string>
+
+/**
+ * Translation between X keysyms and the key names we use everywhere else (macKeycodeMap on macOS)
+ */
+std::string keyForKeySym(KeySym sym);
+KeySym keySymForKey(const std::string& key);
+
+/**
+ * Turns a recorded device event into what listeners get, false for the ones we don't report
+ * (scroll button releases, drags). sym is only used for key events
+ */
+bool translateRecordedEvent(int type, unsigned int detail, unsigned int state, int rootX, int rootY, KeySym sym, JSEvent& event);
+
+/**
+ * Fakes a key via XTest, registering it as our own event so listeners skip it
+ */
+void fakeKey(Display* display, KeySym sym, bool down, bool modwigListeners = false);
+void fakeModifiers(Display* display, bool meta, bool control, bool shift, bool alt, bool down, bool modwigListeners = false);
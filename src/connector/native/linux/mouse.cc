@@ -0,0 +1,183 @@
+#include "../point.h"
+#include "../mouse.h"
+#include "../input.h"
+#include "../sequence.h"
+#include "x11.h"
+#include "keymap.h"
+#include "eventsource.h"
+
+#include <X11/extensions/XTest.h>
+#include <X11/extensions/Xfixes.h>
+#include <unistd.h>
+#include <iostream>
+
+int SLEEP_TIME = 2000;
+
+/**
+ * JS buttons (left 0, middle 1, right 2, back 3, forward 4) to X buttons, which skip 4-7 for scrolling
+ */
+unsigned int xButtonForJSButton(int button) {
+    if (button == 0) return 1;
+    if (button == 1) return 2;
+    if (button == 2) return 3;
+    return button + 5;
+}
+
+XYPoint getPointerPosition(Display* display) {
+    Window rootReturn, childReturn;
+    int rootX = 0, rootY = 0, winX, winY;
+    unsigned int mask;
+    XQueryPointer(display, DefaultRootWindow(display), &rootReturn, &childReturn, &rootX, &rootY, &winX, &winY, &mask);
+    return XYPoint{rootX, rootY};
+}
+
+void fakeMotion(Display* display, int x, int y, bool modwigListeners = false) {
+    auto current = getPointerPosition(display);
+    if (current.x == x && current.y == y) {
+        // No MotionNotify will be generated, don't leave an expectation hanging around
+        return;
+    }
+    expectSyntheticEvent(MotionNotify, 0, modwigListeners);
+    XTestFakeMotionEvent(display, -1, x, y, CurrentTime);
+}
+
+void getMousePosition(int& x, int& y) {
+    auto display = getDisplay();
+    auto point = display != nullptr ? getPointerPosition(display) : XYPoint{0, 0};
+    x = point.x;
+    y = point.y;
+}
+
+void postMouseMove(int x, int y, bool modwigListeners) {
+    auto display = getDisplay();
+    if (display == nullptr) {
+        return;
+    }
+    // Unlike Quartz, X turns motion with a button held into a drag by itself, so there's
+    // no need to track which buttons are waiting on a drag event
+    fakeMotion(display, x, y, modwigListeners);
+    XFlush(display);
+}
+
+void postMouseButton(int button, bool down, int x, int y, InputModifiers modifiers, bool modwigListeners, bool doubleClick) {
+    // X events have no click count, clients detect double clicks by timing
+    auto display = getDisplay();
+    if (display == nullptr) {
+        return;
+    }
+    // Button events happen wherever the pointer is, so move there first
+    fakeMotion(display, x, y, modwigListeners);
+    fakeModifiers(display, modifiers.Meta, modifiers.Control, modifiers.Shift, modifiers.Alt, true, modwigListeners);
+    auto xButton = xButtonForJSButton(button);
+    expectSyntheticEvent(down ? ButtonPress : ButtonRelease, xButton, modwigListeners);
+    XTestFakeButtonEvent(display, xButton, down, CurrentTime);
+    fakeModifiers(display, modifiers.Meta, modifiers.Control, modifiers.Shift, modifiers.Alt, false, modwigListeners);
+    XFlush(display);
+}
+
+Napi::Value GetMousePosition(const Napi::CallbackInfo &info)
+{
+    Napi::Env env = info.Env();
+    int x, y;
+    getMousePosition(x, y);
+
+    return BESPoint::constructor.New({ 
+        Napi::Number::New(env, x),
+        Napi::Number::New(env, y)
+    });
+}
+
+Napi::Value SetMousePosition(const Napi::CallbackInfo &info)
+{
+    Napi::Number x = info[0].As<Napi::Number>();
+    Napi::Number y = info[1].As<Napi::Number>();
+    postMouseMove((int)x.DoubleValue(), (int)y.DoubleValue());
+    usleep(SLEEP_TIME);
+
+    return Napi::Value();
+}
+
+void mouseUpDown(const Napi::CallbackInfo &info, bool down) {
+    int button = info[0].As<Napi::Number>().Uint32Value();
+    int x, y;
+    getMousePosition(x, y);
+    InputModifiers modifiers;
+    bool modwigListeners = false;
+
+    if (info[1].IsObject()) {
+        // We got options
+        Napi::Object options = info[1].As<Napi::Object>();
+        modifiers.Meta = options.Has("Meta");
+        modifiers.Control = options.Has("Control");
+        modifiers.Shift = options.Has("Shift");
+        modifiers.Alt = options.Has("Alt");
+        if (options.Has("x")) {
+            x = (int)options.Get("x").As<Napi::Number>().DoubleValue();
+        }
+        if (options.Has("y")) {
+            y = (int)options.Get("y").As<Napi::Number>().DoubleValue();
+        }
+        modwigListeners = options.Has("modwigListeners") && options.Get("modwigListeners").As<Napi::Boolean>();
+    }
+
+    postMouseButton(button, down, x, y, modifiers, modwigListeners);
+    usleep(SLEEP_TIME);
+}
+
+Napi::Value MouseDown(const Napi::CallbackInfo &info)
+{
+    mouseUpDown(info, true);
+    return Napi::Value();
+}
+
+Napi::Value MouseUp(const Napi::CallbackInfo &info)
+{
+    mouseUpDown(info, false);
+    return Napi::Value();
+}
+
+Napi::Value Click(const Napi::CallbackInfo &info)
+{
+    mouseUpDown(info, true);
+    usleep(SLEEP_TIME);
+    mouseUpDown(info, false);
+    return Napi::Value();
+}
+
+Napi::Value DoubleClick(const Napi::CallbackInfo &info)
+{
+    // X events have no click count, clients detect double clicks by timing so send two clicks
+    Click(info);
+    usleep(SLEEP_TIME);
+    return Click(info);
+}
+
+Napi::Value SetCursorVisibility(const Napi::CallbackInfo &info) 
+{
+    auto visible = info[0].As<Napi::Boolean>();
+    auto display = getDisplay();
+    if (display != nullptr) {
+        if (visible) {
+            XFixesShowCursor(display, DefaultRootWindow(display));
+        } else {
+            XFixesHideCursor(display, DefaultRootWindow(display));
+        }
+        XFlush(display);
+    }
+    return visible;
+}
+
+Napi::Object InitMouse(Napi::Env env, Napi::Object exports)
+{
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set(Napi::String::New(env, "getPosition"), Napi::Function::New(env, GetMousePosition));
+    obj.Set(Napi::String::New(env, "setPosition"), Napi::Function::New(env, SetMousePosition));
+    obj.Set(Napi::String::New(env, "up"), Napi::Function::New(env, MouseUp));
+    obj.Set(Napi::String::New(env, "down"), Napi::Function::New(env, MouseDown));
+    obj.Set(Napi::String::New(env, "click"), Napi::Function::New(env, Click));
+    obj.Set(Napi::String::New(env, "doubleClick"), Napi::Function::New(env, DoubleClick));
+    obj.Set(Napi::String::New(env, "setCursorVisibility"), Napi::Function::New(env, SetCursorVisibility));
+    obj.Set(Napi::String::New(env, "sequence"), Napi::Function::New(env, Sequence));
+    exports.Set("Mouse", obj);
+    return exports;
+}
@@ -0,0 +1,42 @@
+#include "../point.h"
+#include "../window.h"
+#include "../rect.h"
+#include "x11.h"
+
+#include <napi.h>
+#include <iostream>
+#include <string>
+
+Napi::Value GetMainScreen(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+
+    auto display = getDisplay();
+    int screenWidth = 0, screenHeight = 0;
+    if (display != nullptr) {
+        screenWidth = DisplayWidth(display, DefaultScreen(display));
+        screenHeight = DisplayHeight(display, DefaultScreen(display));
+    }
+    
+    auto obj = Napi::Object::New(env);
+    obj.Set(Napi::String::New(env, "w"), Napi::Number::New(env, screenWidth));
+    obj.Set(Napi::String::New(env, "h"), Napi::Number::New(env, screenHeight));
+    return obj;
+}
+
+Napi::Value ClosePluginWindows(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto display = getDisplay();
+    for (auto window : findWindowsByOwner("Bitwig Studio")) {
+        std::cout << "window name: " << getWindowTitle(display, window) << std::endl;
+    }
+    return env.Null();
+}
+
+Napi::Value InitWindow(Napi::Env env, Napi::Object exports)
+{
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set(Napi::String::New(env, "getMainScreen"), Napi::Function::New(env, GetMainScreen));
+    obj.Set(Napi::String::New(env, "closePluginWindows"), Napi::Function::New(env, ClosePluginWindows));
+    exports.Set("MainWindow", obj);
+    return exports;
+}
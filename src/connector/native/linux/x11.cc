@@ -0,0 +1,242 @@
+#include "x11.h"
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <iostream>
+
+Display* sharedDisplay = nullptr;
+std::once_flag displayOnce;
+
+// Errors are reported to the thread that reads the reply, see trapXErrors
+thread_local bool trappingXErrors = false;
+thread_local int trappedXError = 0;
+
+// Ignore BadWindow etc. from windows that disappear between listing and querying them.
+// Xlib's default handler would exit the whole process
+int ignoreXErrors(Display* display, XErrorEvent* error) {
+    if (trappingXErrors && trappedXError == 0) {
+        trappedXError = error->error_code;
+    }
+    return 0;
+}
+
+void trapXErrors() {
+    trappingXErrors = true;
+    trappedXError = 0;
+}
+
+int untrapXErrors(Display* display) {
+    XSync(display, False);
+    trappingXErrors = false;
+    return trappedXError;
+}
+
+Display* getDisplay() {
+    std::call_once(displayOnce, [] {
+        XInitThreads();
+        sharedDisplay = XOpenDisplay(NULL);
+        if (sharedDisplay == nullptr) {
+            std::cout << "Could not open X display, is DISPLAY set?" << std::endl;
+        } else {
+            XSetErrorHandler(ignoreXErrors);
+        }
+    });
+    return sharedDisplay;
+}
+
+std::vector<unsigned char> getProperty(Display* display, Window window, const char* name, Atom type, int format, unsigned long& nItems) {
+    Atom property = XInternAtom(display, name, True);
+    std::vector<unsigned char> out;
+    nItems = 0;
+    if (property == None) {
+        return out;
+    }
+    Atom actualType;
+    int actualFormat;
+    unsigned long bytesAfter;
+    unsigned char* data = nullptr;
+    if (XGetWindowProperty(display, window, property, 0, (~0L), False, type, &actualType, &actualFormat, &nItems, &bytesAfter, &data) == Success && data != nullptr) {
+        if (actualFormat == format) {
+            // Xlib returns format 32 items as longs regardless of the platform's long size
+            size_t itemSize = format == 32 ? sizeof(long) : format / 8;
+            out.assign(data, data + nItems * itemSize);
+        } else {
+            nItems = 0;
+        }
+        XFree(data);
+    }
+    return out;
+}
+
+std::vector<Window> getClientWindows(Display* display) {
+    std::vector<Window> windows;
+    if (display == nullptr) {
+        return windows;
+    }
+    Window root = DefaultRootWindow(display);
+    unsigned long nItems;
+    auto data = getProperty(display, root, "_NET_CLIENT_LIST", XA_WINDOW, 32, nItems);
+    if (nItems > 0) {
+        auto ids = (unsigned long*)data.data();
+        windows.assign(ids, ids + nItems);
+        return windows;
+    }
+
+    Window rootReturn, parentReturn;
+    Window* children = nullptr;
+    unsigned int nChildren = 0;
+    if (XQueryTree(display, root, &rootReturn, &parentReturn, &children, &nChildren) && children != nullptr) {
+        for (unsigned int i = 0; i < nChildren; i++) {
+            XWindowAttributes attrs;
+            if (XGetWindowAttributes(display, children[i], &attrs) && attrs.map_state == IsViewable) {
+                windows.push_back(children[i]);
+            }
+        }
+        XFree(children);
+    }
+    return windows;
+}
+
+std::string getProcessName(pid_t pid) {
+    std::ifstream comm("/proc/" + std::to_string(pid) + "/comm");
+    std::string name;
+    std::getline(comm, name);
+    return name;
+}
+
+bool windowBelongsTo(Display* display, Window window, const std::string& ownerName) {
+    XClassHint hint;
+    if (XGetClassHint(display, window, &hint)) {
+        bool matches = (hint.res_class && ownerName == hint.res_class) || (hint.res_name && ownerName == hint.res_name);
+        if (hint.res_class) XFree(hint.res_class);
+        if (hint.res_name) XFree(hint.res_name);
+        if (matches) {
+            return true;
+        }
+    }
+    auto pid = getWindowPid(display, window);
+    return pid != -1 && getProcessName(pid) == ownerName;
+}
+
+// Process names by pid, so each enumeration doesn't reread /proc for every window
+std::mutex processNamesMutex;
+std::unordered_map<pid_t, const std::string*> processNames;
+
+const std::string* getInternedProcessName(pid_t pid) {
+    std::lock_guard<std::mutex> lock(processNamesMutex);
+    auto it = processNames.find(pid);
+    if (it != processNames.end()) {
+        return it->second;
+    }
+    if (processNames.size() > 256) {
+        // Pids get reused eventually
+        processNames.clear();
+    }
+    return processNames[pid] = internWindowOwner(getProcessName(pid));
+}
+
+void enumerateWindows(WindowListSnapshot& snapshot) {
+    auto display = getDisplay();
+    for (auto window : getClientWindows(display)) {
+        ListedWindow listed;
+        listed.id = window;
+        listed.pid = getWindowPid(display, window);
+        listed.frame = getWindowFrame(display, window);
+
+        // Indexed under everything windowBelongsTo would match
+        std::vector<const std::string*> owners;
+        XClassHint hint;
+        if (XGetClassHint(display, window, &hint)) {
+            if (hint.res_class) {
+                owners.push_back(internWindowOwner(hint.res_class));
+                XFree(hint.res_class);
+            }
+            if (hint.res_name) {
+                owners.push_back(internWindowOwner(hint.res_name));
+                XFree(hint.res_name);
+            }
+        }
+        if (listed.pid != -1) {
+            owners.push_back(getInternedProcessName(listed.pid));
+        }
+        if (owners.empty()) {
+            continue;
+        }
+        listed.owner = owners[0];
+        snapshot.add(std::move(listed), owners);
+    }
+}
+
+std::vector<Window> findWindowsByOwner(const std::string& ownerName) {
+    std::vector<Window> out;
+    auto windows = getWindowList();
+    for (auto window : windows->ownedBy(ownerName)) {
+        out.push_back(window->id);
+    }
+    return out;
+}
+
+std::string getWindowTitle(Display* display, Window window) {
+    unsigned long nItems;
+    Atom utf8 = XInternAtom(display, "UTF8_STRING", False);
+    auto data = getProperty(display, window, "_NET_WM_NAME", utf8, 8, nItems);
+    if (nItems > 0) {
+        return std::string(data.begin(), data.end());
+    }
+    char* name = nullptr;
+    if (XFetchName(display, window, &name) && name != nullptr) {
+        std::string out(name);
+        XFree(name);
+        return out;
+    }
+    return "";
+}
+
+pid_t getWindowPid(Display* display, Window window) {
+    unsigned long nItems;
+    auto data = getProperty(display, window, "_NET_WM_PID", XA_CARDINAL, 32, nItems);
+    if (nItems == 0) {
+        return -1;
+    }
+    return (pid_t)*(unsigned long*)data.data();
+}
+
+Window getActiveWindow(Display* display) {
+    unsigned long nItems;
+    auto data = getProperty(display, DefaultRootWindow(display), "_NET_ACTIVE_WINDOW", XA_WINDOW, 32, nItems);
+    if (nItems > 0) {
+        return (Window)*(unsigned long*)data.data();
+    }
+    // No window manager, fall back to input focus
+    Window focused;
+    int revertTo;
+    XGetInputFocus(display, &focused, &revertTo);
+    return focused;
+}
+
+void activateWindow(Display* display, Window window) {
+    XEvent event = {};
+    event.xclient.type = ClientMessage;
+    event.xclient.window = window;
+    event.xclient.message_type = XInternAtom(display, "_NET_ACTIVE_WINDOW", False);
+    event.xclient.format = 32;
+    event.xclient.data.l[0] = 2; // Source indication: pager, so the WM doesn't refuse focus stealing
+    event.xclient.data.l[1] = CurrentTime;
+    XSendEvent(display, DefaultRootWindow(display), False, SubstructureRedirectMask | SubstructureNotifyMask, &event);
+    XRaiseWindow(display, window);
+    XSetInputFocus(display, window, RevertToParent, CurrentTime);
+    XFlush(display);
+}
+
+MWRect getWindowFrame(Display* display, Window window) {
+    XWindowAttributes attrs;
+    if (!XGetWindowAttributes(display, window, &attrs)) {
+        return MWRect{0, 0, 0, 0};
+    }
+    int x, y;
+    Window child;
+    XTranslateCoordinates(display, window, DefaultRootWindow(display), 0, 0, &x, &y, &child);
+    return MWRect{x, y, attrs.width, attrs.height};
+}
@@ -0,0 +1,47 @@
+#pragma once
+// ui.h (and napi.h) before Xlib, which #defines Bool, Status, None etc.
+#include "../ui.h"
+#include "../windowlist.h"
+#include <X11/Xlib.h>
+#include <sys/types.h>
+#include <string>
+#include <vector>
+
+/**
+ * Shared X11 connection for the Linux backend. Xlib is initialised for threads since the
+ * record thread and the JS thread both talk to the server. Never close this display.
+ */
+Display* getDisplay();
+
+/**
+ * Errors are otherwise ignored. To find out whether requests failed, trapXErrors() before
+ * making them and untrapXErrors() after, which waits for the server and returns the first
+ * error code (0 if none). Per thread
+ */
+void trapXErrors();
+int untrapXErrors(Display* display);
+
+/**
+ * Windows managed by the window manager (_NET_CLIENT_LIST), falling back to the children
+ * of the root window when there is no EWMH compliant manager (e.g. bare Xvfb)
+ */
+std::vector<Window> getClientWindows(Display* display);
+
+/**
+ * The equivalent of a macOS window's owner name. Bitwig doesn't run as separately named
+ * processes on Linux, so we match on the WM_CLASS class/instance, then the process name of
+ * _NET_WM_PID
+ */
+bool windowBelongsTo(Display* display, Window window, const std::string& ownerName);
+// From the shared window list snapshot, see ../windowlist.h
+std::vector<Window> findWindowsByOwner(const std::string& ownerName);
+
+std::string getWindowTitle(Display* display, Window window);
+pid_t getWindowPid(Display* display, Window window);
+Window getActiveWindow(Display* display);
+void activateWindow(Display* display, Window window);
+
+/**
+ * Frame in root window coordinates, w/h of 0 if the window has gone
+ */
+MWRect getWindowFrame(Display* display, Window window);
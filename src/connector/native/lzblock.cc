@@ -0,0 +1,163 @@
+#include "lzblock.h"
+#include <algorithm>
+#include <cstring>
+
+const int LZ_HASH_BITS = 12;
+const size_t LZ_MIN_MATCH = 4;
+// The format's end of block rules: the last 5 bytes are always literals, and the last match
+// starts at least 12 bytes before the end
+const size_t LZ_LAST_LITERALS = 5;
+const size_t LZ_MATCH_LIMIT = 12;
+const size_t LZ_MAX_OFFSET = 65535;
+
+uint32_t readLz32(const uint8_t* p) {
+    uint32_t value;
+    memcpy(&value, p, 4);
+    return value;
+}
+
+uint32_t lzHash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// Lengths of 15 and over continue in bytes of 255 until one that isn't
+void writeLzLength(std::vector<uint8_t>& out, size_t length) {
+    while (length >= 255) {
+        out.push_back(255);
+        length -= 255;
+    }
+    out.push_back((uint8_t)length);
+}
+
+bool readLzLength(const uint8_t* src, size_t srcSize, size_t& s, size_t& length) {
+    uint8_t byte;
+    do {
+        if (s >= srcSize) {
+            return false;
+        }
+        byte = src[s++];
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// matchLength of 0 for the literals that end the block
+void writeLzSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+    auto tokenAt = out.size();
+    out.push_back(0);
+    uint8_t token = (uint8_t)(std::min<size_t>(literalLength, 15) << 4);
+    if (literalLength >= 15) {
+        writeLzLength(out, literalLength - 15);
+    }
+    out.insert(out.end(), literals, literals + literalLength);
+    if (matchLength > 0) {
+        out.push_back((uint8_t)(offset & 0xFF));
+        out.push_back((uint8_t)(offset >> 8));
+        auto length = matchLength - LZ_MIN_MATCH;
+        token |= (uint8_t)std::min<size_t>(length, 15);
+        if (length >= 15) {
+            writeLzLength(out, length - 15);
+        }
+    }
+    out[tokenAt] = token;
+}
+
+// Bytes from a and b that are the same, up to limit - a
+size_t commonLength(const uint8_t* a, const uint8_t* b, const uint8_t* limit) {
+    auto start = a;
+    while (a + 8 <= limit) {
+        uint64_t x, y;
+        memcpy(&x, a, 8);
+        memcpy(&y, b, 8);
+        if (x != y) {
+            return (a - start) + (__builtin_ctzll(x ^ y) >> 3);
+        }
+        a += 8;
+        b += 8;
+    }
+    while (a < limit && *a == *b) {
+        a++;
+        b++;
+    }
+    return a - start;
+}
+
+size_t compressBlock(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+    // Never cleared: a stale position is either ahead of where we are or fails the comparison,
+    // both of which are just a missed match
+    thread_local uint32_t table[1 << LZ_HASH_BITS] = {0};
+    auto start = out.size();
+    size_t anchor = 0;
+    if (size > LZ_MATCH_LIMIT) {
+        auto matchLimit = size - LZ_MATCH_LIMIT;
+        size_t i = 0;
+        while (i < matchLimit) {
+            auto sequence = readLz32(src + i);
+            auto& slot = table[lzHash(sequence)];
+            size_t candidate = slot;
+            slot = (uint32_t)i;
+            if (candidate >= i || i - candidate > LZ_MAX_OFFSET || readLz32(src + candidate) != sequence) {
+                // Step further the longer nothing has matched, incompressible data goes quickly
+                i += 1 + ((i - anchor) >> 6);
+                continue;
+            }
+            while (i > anchor && candidate > 0 && src[i - 1] == src[candidate - 1]) {
+                i--;
+                candidate--;
+            }
+            auto matchEnd = i + LZ_MIN_MATCH + commonLength(src + i + LZ_MIN_MATCH, src + candidate + LZ_MIN_MATCH, src + size - LZ_LAST_LITERALS);
+            writeLzSequence(out, src + anchor, i - anchor, i - candidate, matchEnd - i);
+            i = anchor = matchEnd;
+            if (i >= 2 && i < matchLimit) {
+                table[lzHash(readLz32(src + i - 2))] = (uint32_t)(i - 2);
+            }
+        }
+    }
+    writeLzSequence(out, src + anchor, size - anchor, 0, 0);
+    return out.size() - start;
+}
+
+bool decompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+    size_t s = 0, d = 0;
+    while (s < srcSize) {
+        auto token = src[s++];
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLzLength(src, srcSize, s, literalLength)) {
+            return false;
+        }
+        if (literalLength > srcSize - s || literalLength > dstSize - d) {
+            return false;
+        }
+        memcpy(dst + d, src + s, literalLength);
+        s += literalLength;
+        d += literalLength;
+        if (s == srcSize) {
+            // The last sequence is only literals
+            break;
+        }
+
+        if (srcSize - s < 2) {
+            return false;
+        }
+        size_t offset = src[s] | (src[s + 1] << 8);
+        s += 2;
+        size_t matchLength = (token & 15) + LZ_MIN_MATCH;
+        if ((token & 15) == 15 && !readLzLength(src, srcSize, s, matchLength)) {
+            return false;
+        }
+        if (offset == 0 || offset > d || matchLength > dstSize - d) {
+            return false;
+        }
+        // A match can overlap what it writes (a run of one pixel is an offset of 4). Copying whole
+        // periods at a time keeps each memcpy's source and destination apart
+        auto from = dst + d - offset;
+        size_t copied = 0;
+        while (copied < matchLength) {
+            auto chunk = std::min(matchLength - copied, copied + offset);
+            memcpy(dst + d + copied, from, chunk);
+            copied += chunk;
+        }
+        d += matchLength;
+    }
+    return d == dstSize;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Byte-oriented LZ77 in the LZ4 block format (a token of literal and match lengths, the
+ * literals, then a 16 bit offset back into what's been decoded). Greedy with a small hash table,
+ * no entropy coding: screenshots are mostly long runs of one colour, which this gets nearly all
+ * of at memcpy-like speeds.
+ */
+
+/**
+ * Appends size bytes of src compressed to out, returns how many bytes were appended
+ */
+size_t compressBlock(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+/**
+ * Decompresses exactly dstSize bytes into dst. False if src is malformed or doesn't decode to
+ * exactly that many bytes, never reads or writes out of bounds
+ */
+bool decompressBlock(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
@@ -1,6 +1,8 @@
 #include <napi.h>
+#ifdef __APPLE__
 #include <CoreFoundation/CoreFoundation.h>
 #include <ApplicationServices/ApplicationServices.h>
+#endif
 
 #include "bitwig.h"
 #include "color.h"
@@ -11,6 +13,7 @@
 #include "screen.h"
 #include "window.h"
 #include "ui.h"
+#include "stats.h"
 #include <iostream>
 
 Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
@@ -23,6 +26,7 @@ Napi::Object InitAll(Napi::Env env, Napi::Object exports) {
     InitWindow(env, exports);
     InitBitwig(env, exports);
     InitUI(env, exports);
+    InitStats(env, exports);
     return Screenshot::Init(env, exports); 
   } catch (const std::exception &e) {
     std::cerr << e.what() << std::endl;
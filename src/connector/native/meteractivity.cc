@@ -0,0 +1,74 @@
+#include "meteractivity.h"
+#include "mixerstrips.h"
+#include <algorithm>
+
+// A strip's level is the loudest of its last few ticks, so a meter flickering between frames
+// doesn't toggle
+const size_t ACTIVITY_LEVEL_TICKS = 3;
+
+/**
+ * LevelRing
+ */
+void LevelRing::resize(size_t capacity) {
+    levels.assign(capacity > 0 ? capacity : 1, 0);
+    next = 0;
+    count = 0;
+}
+
+void LevelRing::push(float level) {
+    levels[next] = level;
+    next = (next + 1) % levels.size();
+    count = std::min(count + 1, levels.size());
+}
+
+float LevelRing::recentMax(size_t n) const {
+    float loudest = 0;
+    for (size_t i = 1; i <= std::min(n, count); i++) {
+        loudest = std::max(loudest, levels[(next + levels.size() - i) % levels.size()]);
+    }
+    return loudest;
+}
+
+std::vector<float> LevelRing::ordered() const {
+    std::vector<float> out;
+    out.reserve(count);
+    size_t start = (next + levels.size() - count) % levels.size();
+    for (size_t i = 0; i < count; i++) {
+        out.push_back(levels[(start + i) % levels.size()]);
+    }
+    return out;
+}
+
+/**
+ * MeterActivity
+ */
+void MeterActivity::reset(size_t stripCount, float threshold, size_t capacity) {
+    this->threshold = threshold;
+    strips.assign(stripCount, Strip());
+    for (auto& strip : strips) {
+        strip.ring.resize(capacity);
+    }
+}
+
+void MeterActivity::record(const std::vector<float>& levels, std::vector<ActivityChange>& changes) {
+    for (size_t i = 0; i < strips.size() && i < levels.size(); i++) {
+        auto& strip = strips[i];
+        strip.ring.push(levels[i]);
+        auto level = strip.ring.recentMax(ACTIVITY_LEVEL_TICKS);
+        if (!strip.active && level >= threshold) {
+            strip.active = true;
+            changes.push_back({(int)i, true, level});
+        } else if (strip.active && level < threshold / 2) {
+            strip.active = false;
+            changes.push_back({(int)i, false, level});
+        }
+    }
+}
+
+bool sampleMeters(FrameImage* image, XYPoint origin, const std::vector<int32_t>& meters, std::vector<float>& levels) {
+    if (!metersShown(image, origin, meters)) {
+        return false;
+    }
+    readMeterLevels(image, origin, meters, levels);
+    return true;
+}
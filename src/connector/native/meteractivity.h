@@ -0,0 +1,64 @@
+#pragma once
+#include "detect.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * What activity.cc does each tick, without the capturing or the thread, so it can be run on
+ * painted frames. No N-API in here.
+ */
+struct ActivityChange {
+    int strip;
+    bool active;
+    float level;
+};
+
+/**
+ * Fixed capacity, the oldest level is overwritten once full
+ */
+class LevelRing {
+    std::vector<float> levels;
+    size_t next = 0;
+    size_t count = 0;
+public:
+    void resize(size_t capacity);
+    void push(float level);
+    // Loudest of the last n
+    float recentMax(size_t n) const;
+    // Oldest first
+    std::vector<float> ordered() const;
+};
+
+/**
+ * Each sampled strip's recent levels and whether it's active
+ */
+class MeterActivity {
+    struct Strip {
+        LevelRing ring;
+        // Edge triggered like the resource thresholds, re-arms once back under half the threshold
+        bool active = false;
+    };
+    std::vector<Strip> strips;
+    float threshold = 0;
+public:
+    void reset(size_t stripCount, float threshold, size_t capacity);
+    // Appends a change for each strip that crossed the threshold with these levels
+    void record(const std::vector<float>& levels, std::vector<ActivityChange>& changes);
+    size_t stripCount() const {
+        return strips.size();
+    }
+    std::vector<float> history(size_t strip) const {
+        return strips[strip].ring.ordered();
+    }
+    bool isActive(size_t strip) const {
+        return strips[strip].active;
+    }
+};
+
+/**
+ * One tick's levels from image, which holds the window from origin on. False (levels untouched)
+ * if any meter's top or bottom isn't well coloured, so the mixer has been closed or something
+ * drawn over it. readMeterLevels would read whatever is there instead as lit
+ */
+bool sampleMeters(FrameImage* image, XYPoint origin, const std::vector<int32_t>& meters, std::vector<float>& levels);
@@ -0,0 +1,245 @@
+#include "metrics.h"
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+struct MetricsRegistry {
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<MetricCounter>> counters;
+    std::map<std::string, std::unique_ptr<MetricGauge>> gauges;
+    std::map<std::string, std::unique_ptr<MetricHistogram>> histograms;
+};
+
+MetricsRegistry& metricsRegistry() {
+    // Metrics can be looked up during static initialisation of other files
+    static MetricsRegistry registry;
+    return registry;
+}
+
+template <typename T>
+T& findOrRegister(std::map<std::string, std::unique_ptr<T>>& metrics, const std::string& name) {
+    std::lock_guard<std::mutex> lock(metricsRegistry().mutex);
+    auto& metric = metrics[name];
+    if (metric == nullptr) {
+        metric.reset(new T());
+        metric->name = name;
+    }
+    return *metric;
+}
+
+MetricCounter& metricCounter(const std::string& name) {
+    return findOrRegister(metricsRegistry().counters, name);
+}
+
+MetricGauge& metricGauge(const std::string& name) {
+    return findOrRegister(metricsRegistry().gauges, name);
+}
+
+MetricHistogram& metricHistogram(const std::string& name) {
+    return findOrRegister(metricsRegistry().histograms, name);
+}
+
+/**
+ * Tracing
+ */
+struct TraceEvent {
+    const std::string* name;
+    char phase; // 'X' span, 'C' counter
+    int thread;
+    int64_t at; // ns since the trace started
+    int64_t durationOrValue;
+};
+
+std::atomic<bool> traceRunning(false);
+std::mutex traceMutex;
+std::vector<TraceEvent> traceEvents;
+size_t traceMaxEvents = 0, traceDropped = 0;
+std::chrono::steady_clock::time_point traceStart;
+
+int traceThreadId() {
+    // Small stable numbers read better in the viewer than hashed std::thread ids
+    static std::atomic<int> nextThreadId(1);
+    thread_local int threadId = nextThreadId++;
+    return threadId;
+}
+
+void addTraceEvent(const std::string* name, char phase, std::chrono::steady_clock::time_point at, int64_t durationOrValue) {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if (!traceRunning) {
+        return;
+    }
+    if (traceEvents.size() >= traceMaxEvents) {
+        traceDropped++;
+        return;
+    }
+    auto sinceStart = std::chrono::duration_cast<std::chrono::nanoseconds>(at - traceStart).count();
+    traceEvents.push_back(TraceEvent{name, phase, traceThreadId(), sinceStart, durationOrValue});
+}
+
+void startTrace(size_t maxEvents) {
+    std::lock_guard<std::mutex> lock(traceMutex);
+    traceEvents.clear();
+    traceEvents.reserve(std::min(maxEvents, (size_t)100000));
+    traceMaxEvents = maxEvents;
+    traceDropped = 0;
+    traceStart = std::chrono::steady_clock::now();
+    traceRunning = true;
+}
+
+bool isTracing() {
+    return traceRunning;
+}
+
+TraceResult stopTrace(const std::string& path) {
+    std::vector<TraceEvent> events;
+    TraceResult result;
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+        traceRunning = false;
+        events.swap(traceEvents);
+        result.dropped = traceDropped;
+    }
+    result.events = events.size();
+
+    std::ofstream file(path);
+    if (!file) {
+        return result;
+    }
+    auto pid = getpid();
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); i++) {
+        auto& event = events[i];
+        // Trace viewers want microseconds
+        file << (i > 0 ? ",\n" : "\n")
+            << "{\"name\":\"" << *event.name << "\",\"cat\":\"bes\",\"ph\":\"" << event.phase
+            << "\",\"pid\":" << pid << ",\"tid\":" << event.thread
+            << ",\"ts\":" << (double)event.at / 1000.0;
+        if (event.phase == 'X') {
+            file << ",\"dur\":" << (double)event.durationOrValue / 1000.0 << "}";
+        } else {
+            file << ",\"args\":{\"value\":" << event.durationOrValue << "}}";
+        }
+    }
+    file << "\n]}\n";
+    result.written = file.good();
+    return result;
+}
+
+/**
+ * MetricGauge
+ */
+void MetricGauge::set(int64_t newValue) {
+    value.store(newValue, std::memory_order_relaxed);
+    if (traceRunning) {
+        addTraceEvent(&name, 'C', std::chrono::steady_clock::now(), newValue);
+    }
+}
+
+void MetricGauge::add(int64_t amount) {
+    auto newValue = value.fetch_add(amount, std::memory_order_relaxed) + amount;
+    if (traceRunning) {
+        addTraceEvent(&name, 'C', std::chrono::steady_clock::now(), newValue);
+    }
+}
+
+/**
+ * MetricHistogram
+ */
+int bucketFor(uint64_t value) {
+    int bucket = 0;
+    while (value > 0 && bucket < MetricHistogram::BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void MetricHistogram::record(uint64_t value) {
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+    buckets[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+    auto lowest = min.load(std::memory_order_relaxed);
+    while (value < lowest && !min.compare_exchange_weak(lowest, value, std::memory_order_relaxed)) {}
+    auto highest = max.load(std::memory_order_relaxed);
+    while (value > highest && !max.compare_exchange_weak(highest, value, std::memory_order_relaxed)) {}
+}
+
+uint64_t MetricHistogram::percentile(double fraction) const {
+    uint64_t total = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        total += buckets[i].load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(fraction * (double)total), seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen > target || seen == total) {
+            // Never claim more than we actually saw
+            uint64_t upper = i == 0 ? 0 : ((uint64_t)1 << i) - 1;
+            return std::min(upper, max.load(std::memory_order_relaxed));
+        }
+    }
+    return max;
+}
+
+MetricsSnapshot snapshotMetrics() {
+    MetricsSnapshot snapshot;
+    auto& registry = metricsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& pair : registry.counters) {
+        snapshot.counters.push_back({pair.first, pair.second->value.load()});
+    }
+    for (auto& pair : registry.gauges) {
+        snapshot.gauges.push_back({pair.first, pair.second->value.load()});
+    }
+    for (auto& pair : registry.histograms) {
+        auto& histogram = *pair.second;
+        auto count = histogram.count.load();
+        snapshot.histograms.push_back({pair.first, HistogramSummary{
+            count,
+            histogram.sum.load(),
+            count > 0 ? histogram.min.load() : 0,
+            histogram.max.load(),
+            histogram.percentile(0.5),
+            histogram.percentile(0.9),
+            histogram.percentile(0.99)
+        }});
+    }
+    return snapshot;
+}
+
+void resetMetrics() {
+    auto& registry = metricsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& pair : registry.counters) {
+        pair.second->value = 0;
+    }
+    for (auto& pair : registry.histograms) {
+        auto& histogram = *pair.second;
+        histogram.count = 0;
+        histogram.sum = 0;
+        histogram.min = UINT64_MAX;
+        histogram.max = 0;
+        for (auto& bucket : histogram.buckets) {
+            bucket = 0;
+        }
+    }
+}
+
+/**
+ * MetricTimer
+ */
+MetricTimer::MetricTimer(MetricHistogram& histogram) : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+
+MetricTimer::~MetricTimer() {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    histogram.record((uint64_t)elapsed);
+    if (traceRunning) {
+        addTraceEvent(&histogram.name, 'X', start, elapsed);
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Process wide counters, gauges and histograms. Each is registered by name on first use and
+ * lives forever, so call sites keep the reference in a static and updates are lock free:
+ *
+ *   static auto& captureTime = metricHistogram("capture.time");
+ *   MetricTimer timer(captureTime);
+ *
+ * Names ending in .time are nanoseconds. No N-API in here so detect.cc and bes_bench can use
+ * it, Stats.snapshot() and friends are in stats.cc.
+ */
+struct MetricCounter {
+    std::string name;
+    std::atomic<int64_t> value{0};
+    void add(int64_t amount = 1) {
+        value.fetch_add(amount, std::memory_order_relaxed);
+    }
+};
+
+struct MetricGauge {
+    std::string name;
+    std::atomic<int64_t> value{0};
+    void set(int64_t newValue);
+    void add(int64_t amount);
+};
+
+struct MetricHistogram {
+    // Bucket i counts values below 2^i (and at least 2^(i-1)), plenty for ns and bytes
+    static const int BUCKETS = 48;
+    std::string name;
+    std::atomic<uint64_t> count{0}, sum{0}, min{UINT64_MAX}, max{0};
+    std::atomic<uint64_t> buckets[BUCKETS] = {};
+    void record(uint64_t value);
+    // Upper bound of the bucket holding the given fraction (0-1) of values
+    uint64_t percentile(double fraction) const;
+};
+
+MetricCounter& metricCounter(const std::string& name);
+MetricGauge& metricGauge(const std::string& name);
+MetricHistogram& metricHistogram(const std::string& name);
+
+template <typename T>
+struct NamedMetric {
+    std::string name;
+    T value;
+};
+struct HistogramSummary {
+    uint64_t count, sum, min, max, p50, p90, p99;
+};
+struct MetricsSnapshot {
+    std::vector<NamedMetric<int64_t>> counters, gauges;
+    std::vector<NamedMetric<HistogramSummary>> histograms;
+};
+MetricsSnapshot snapshotMetrics();
+// Zeroes counters and histograms, gauges are current state so are left alone
+void resetMetrics();
+
+/**
+ * Chrome trace event recording (chrome://tracing, Perfetto). While a trace is running every
+ * MetricTimer also records a span, and gauges record their changes. Events are kept in memory
+ * up to maxEvents and written out by stopTrace.
+ */
+void startTrace(size_t maxEvents = 1000000);
+bool isTracing();
+struct TraceResult {
+    size_t events = 0, dropped = 0;
+    bool written = false;
+};
+TraceResult stopTrace(const std::string& path);
+
+/**
+ * Records how long the enclosing scope took into a histogram, and a span named after it
+ * while tracing
+ */
+class MetricTimer {
+    MetricHistogram& histogram;
+    std::chrono::steady_clock::time_point start;
+public:
+    MetricTimer(MetricHistogram& histogram);
+    ~MetricTimer();
+};
@@ -0,0 +1,212 @@
+#include "mixerstrips.h"
+#include "metrics.h"
+#include "pixelrows.h"
+#include <climits>
+
+// Strips are lighter than the panel behind them, a selected strip lighter again
+const int MIXER_STRIP_BRIGHTNESS = 60;
+const int MIXER_SELECTED_BRIGHTNESS = 85;
+// Strip backgrounds are within this range, fader tracks and unlit meters below it, fader caps
+// and lit meters above
+const int MIXER_WELL_LOW = 40;
+const int MIXER_WELL_HIGH = 150;
+// Unscaled, from the top of the mixer rect: a row through the strips above their wells and where
+// their bodies start
+const int MIXER_STRIP_ROW = 14;
+const int MIXER_BODY_TOP = 30;
+// Unscaled, from the bottom of the mixer rect
+const int MIXER_BODY_BOTTOM = 8;
+const int MIXER_MIN_STRIP_WIDTH = 16;
+const int MIXER_MIN_WELL_WIDTH = 2;
+// Unscaled rows between the ones projected. Wells run most of the way down a strip so a sample
+// finds them, their ends are then found to the pixel down one column
+const int MIXER_ROW_STEP = 4;
+
+const uint8_t* mixerPixel(FrameImage* screenshot, int x, int y) {
+    return screenshot->data + (size_t)y * screenshot->bytesPerRow + (size_t)x * screenshot->bytesPerPixel;
+}
+
+// Dark well, or lit by a meter or fader cap, anything but a strip's own background
+bool isWellPixel(const uint8_t* pixel) {
+    return !isLitPixel(pixel, MIXER_WELL_LOW - 1) || isLitPixel(pixel, MIXER_WELL_HIGH);
+}
+
+bool getMixerRect(const LayoutProfile& profile, const BitwigLayout& layout, MWRect& rect) {
+    if (!layout.editor || layout.editor->type != "mixer" || layout.modalOpen) {
+        return false;
+    }
+    // Same insets as the device panel, see getDeviceChainRect
+    auto& editor = layout.editor->rect;
+    auto top = profile.scale(5) + 1;
+    rect = MWRect{
+        editor.x + profile.scale(4),
+        editor.y + top,
+        editor.w - profile.scale(8),
+        editor.h - top
+    };
+    return rect.w > 0 && rect.h > profile.scale(MIXER_BODY_TOP + MIXER_BODY_BOTTOM);
+}
+
+void detectMixerStrips(FrameImage* screenshot, const LayoutProfile& profile, MWRect rect, MixerStrips& mixer) {
+    static auto& detectTime = metricHistogram("detect.mixer.time");
+    static auto& stripsFound = metricCounter("detect.mixer.strips.found");
+    MetricTimer timer(detectTime);
+    thread_local std::vector<int32_t> spans, wells;
+    thread_local std::vector<uint16_t> columns;
+    thread_local std::vector<int> rows;
+    mixer.clear();
+    mixer.rect = rect;
+    if (rect.x < 0 || rect.y < 0 || rect.x + rect.w > screenshot->width || rect.y + rect.h > screenshot->height) {
+        return;
+    }
+
+    spans.clear();
+    auto stripRow = mixerPixel(screenshot, rect.x, rect.y + profile.scale(MIXER_STRIP_ROW));
+    findLitSpans(stripRow, rect.w, MIXER_STRIP_BRIGHTNESS, profile.scale(MIXER_MIN_STRIP_WIDTH), spans);
+    if (spans.empty()) {
+        return;
+    }
+
+    // Both projections of the strips' bodies in one pass
+    auto bodyTop = rect.y + profile.scale(MIXER_BODY_TOP);
+    auto bodyBottom = rect.y + rect.h - profile.scale(MIXER_BODY_BOTTOM);
+    auto step = std::max(1, profile.scale(MIXER_ROW_STEP));
+    columns.assign(rect.w, 0);
+    rows.clear();
+    int most = 0;
+    for (int y = bodyTop; y < bodyBottom; y += step) {
+        auto count = countOutsideBand(mixerPixel(screenshot, rect.x, y), rect.w, MIXER_WELL_LOW, MIXER_WELL_HIGH, columns.data());
+        rows.push_back(count);
+        most = std::max(most, count);
+    }
+
+    // Every strip's wells start and end on the same rows, anything well coloured outside them
+    // (labels, fader caps) is a small part of a row
+    int wellTop = -1, wellBottom = -1;
+    for (int i = 0; most > 0 && i < (int)rows.size(); i++) {
+        if (rows[i] * 2 >= most) {
+            if (wellTop == -1) {
+                wellTop = i;
+            }
+            wellBottom = i;
+        }
+    }
+    auto wellSamples = wellTop == -1 ? 0 : wellBottom - wellTop + 1;
+
+    for (size_t i = 0; i < spans.size(); i += 2) {
+        auto start = spans[i], width = spans[i + 1];
+        mixer.strips.insert(mixer.strips.end(), {rect.x + start, rect.y, width, rect.h});
+        if (mixer.selected == -1 && isLitPixel(stripRow + (start + width / 2) * 4, MIXER_SELECTED_BRIGHTNESS)) {
+            mixer.selected = i / 2;
+        }
+
+        // Columns that are well coloured for most of the wells' height
+        wells.clear();
+        int runStart = -1;
+        for (int x = start; x <= start + width; x++) {
+            bool inWell = x < start + width && wellSamples > 0 && columns[x] * 2 >= wellSamples;
+            if (inWell && runStart == -1) {
+                runStart = x;
+            } else if (!inWell && runStart != -1) {
+                if (x - runStart >= profile.scale(MIXER_MIN_WELL_WIDTH)) {
+                    wells.push_back(runStart);
+                    wells.push_back(x - runStart);
+                }
+                runStart = -1;
+            }
+        }
+        // The fader is left of the meter, the wells' top and bottom are filled in below
+        if (wells.size() >= 4) {
+            auto last = wells.size() - 2;
+            mixer.faders.insert(mixer.faders.end(), {rect.x + wells[0], 0, wells[1], 0});
+            mixer.meters.insert(mixer.meters.end(), {rect.x + wells[last], 0, wells[last + 1], 0});
+        } else {
+            mixer.faders.insert(mixer.faders.end(), {0, 0, 0, 0});
+            mixer.meters.insert(mixer.meters.end(), {0, 0, 0, 0});
+        }
+    }
+
+    // Walk out from the sampled ends down the middle of the first fader track
+    size_t first = 0;
+    while (first < mixer.faders.size() && mixer.faders[first + 2] == 0) {
+        first += 4;
+    }
+    if (first < mixer.faders.size()) {
+        auto wellX = mixer.faders[first] + mixer.faders[first + 2] / 2;
+        auto inWell = [&](int y) {
+            return isWellPixel(mixerPixel(screenshot, wellX, y));
+        };
+        auto top = bodyTop + wellTop * step, bottom = bodyTop + wellBottom * step;
+        while (top > bodyTop && inWell(top - 1)) {
+            top--;
+        }
+        while (bottom + 1 < bodyBottom && inWell(bottom + 1)) {
+            bottom++;
+        }
+        for (size_t i = first; i < mixer.faders.size(); i += 4) {
+            if (mixer.faders[i + 2] != 0) {
+                mixer.faders[i + 1] = mixer.meters[i + 1] = top;
+                mixer.faders[i + 3] = mixer.meters[i + 3] = bottom - top + 1;
+            }
+        }
+    }
+    stripsFound.add(mixer.stripCount());
+}
+
+MWRect meterBounds(const std::vector<int32_t>& meters) {
+    int left = INT32_MAX, top = INT32_MAX, right = INT32_MIN, bottom = INT32_MIN;
+    for (size_t i = 0; i < meters.size(); i += 4) {
+        if (meters[i + 2] == 0) {
+            continue;
+        }
+        left = std::min(left, meters[i]);
+        top = std::min(top, meters[i + 1]);
+        right = std::max(right, meters[i] + meters[i + 2]);
+        bottom = std::max(bottom, meters[i + 1] + meters[i + 3]);
+    }
+    if (left == INT32_MAX) {
+        return MWRect{0, 0, 0, 0};
+    }
+    return MWRect{left, top, right - left, bottom - top};
+}
+
+bool metersShown(FrameImage* image, XYPoint origin, const std::vector<int32_t>& meters) {
+    for (size_t i = 0; i < meters.size(); i += 4) {
+        if (meters[i + 3] == 0) {
+            continue;
+        }
+        auto x = meters[i] + meters[i + 2] / 2 - origin.x;
+        auto top = meters[i + 1] - origin.y, bottom = top + meters[i + 3] - 1;
+        if (x < 0 || x >= image->width || top < 0 || bottom >= image->height) {
+            return false;
+        }
+        if (!isWellPixel(mixerPixel(image, x, top)) || !isWellPixel(mixerPixel(image, x, bottom))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void readMeterLevels(FrameImage* image, XYPoint origin, const std::vector<int32_t>& meters, std::vector<float>& levels) {
+    levels.assign(meters.size() / 4, 0);
+    for (size_t i = 0; i < meters.size(); i += 4) {
+        auto x = meters[i] + meters[i + 2] / 2 - origin.x;
+        auto top = meters[i + 1] - origin.y, height = meters[i + 3];
+        if (height == 0 || x < 0 || x >= image->width || top < 0 || top + height > image->height) {
+            continue;
+        }
+        // Meters fill solid from the bottom and anything not the dark well is lit, so the top of
+        // the fill can be found in a few reads instead of one per row
+        auto bottom = mixerPixel(image, x, top + height - 1);
+        int lit = 0, unlit = height;
+        while (lit < unlit) {
+            auto mid = (lit + unlit) / 2;
+            if (isLitPixel(bottom - (size_t)mid * image->bytesPerRow, MIXER_WELL_LOW)) {
+                lit = mid + 1;
+            } else {
+                unlit = mid;
+            }
+        }
+        levels[i / 4] = (float)lit / height;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "detect.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Channel strips in the mixer panel, left to right. Packed like DeviceChain: strips, faders and
+ * meters each hold x, y, w, h per strip. A strip whose fader or meter couldn't be told apart
+ * has zeros there.
+ *
+ * Strips are lighter than the panel between them, so one row through their tops split into runs
+ * gives the columns. Fader tracks and meters are dark wells (or bright, where a meter is lit or the
+ * fader cap sits) running most of the way down each strip. Counting those pixels per column and
+ * per row in one pass over the strips' bodies finds the wells' columns and how far down they go.
+ */
+struct MixerStrips {
+    // Where strips are drawn, inside the panel's border
+    MWRect rect{0, 0, 0, 0};
+    std::vector<int32_t> strips, faders, meters;
+    int selected = -1;
+    size_t stripCount() const {
+        return strips.size() / 4;
+    }
+    void clear() {
+        strips.clear();
+        faders.clear();
+        meters.clear();
+        selected = -1;
+    }
+    Napi::Object toJSObject(Napi::Env env);
+};
+
+/**
+ * False unless the mixer panel is open
+ */
+bool getMixerRect(const LayoutProfile& profile, const BitwigLayout& layout, MWRect& rect);
+void detectMixerStrips(FrameImage* screenshot, const LayoutProfile& profile, MWRect rect, MixerStrips& mixer);
+
+/**
+ * Smallest rect holding every meter that was found, meters packed as in MixerStrips
+ */
+MWRect meterBounds(const std::vector<int32_t>& meters);
+
+/**
+ * Whether the top and bottom of every meter found are still well coloured (dark, or lit by the
+ * meter) in image, which holds the window from origin on. Anything else drawn there, like the
+ * panel under a closed mixer, is in the strips' own brightness range
+ */
+bool metersShown(FrameImage* image, XYPoint origin, const std::vector<int32_t>& meters);
+
+/**
+ * How much of each meter is lit, 0 to 1, from one column up its middle. image holds the window
+ * from origin on (e.g. a capture of just meterBounds), meters it doesn't cover read 0
+ */
+void readMeterLevels(FrameImage* image, XYPoint origin, const std::vector<int32_t>& meters, std::vector<float>& levels);
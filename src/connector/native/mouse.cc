@@ -1,13 +1,17 @@
 #include "point.h"
 #include "mouse.h"
+#include "input.h"
+#include "sequence.h"
 #include "eventsource.h"
 
 #include <iostream>
+#include <atomic>
  
 int SLEEP_TIME = 2000;
-bool middleDownDragWaiting = false;
-bool leftDownDragWaiting = false;
-bool rightDownDragWaiting = false;
+// Atomic as the sequence scheduler posts from its own thread
+std::atomic<bool> middleDownDragWaiting(false);
+std::atomic<bool> leftDownDragWaiting(false);
+std::atomic<bool> rightDownDragWaiting(false);
 
 CGEventType cgEventType(int button, bool down) {
     if (button == 0) {
@@ -19,17 +23,88 @@ CGEventType cgEventType(int button, bool down) {
     }
 } 
 
+void getMousePosition(int& x, int& y) {
+    CGEventRef event = CGEventCreate(getCGEventSource());
+    CGPoint point = CGEventGetLocation(event);
+    CFRelease(event);
+    x = (int)point.x;
+    y = (int)point.y;
+}
+
+void postMouseMove(int x, int y, bool modwigListeners) {
+    // A move with a button held needs to be a drag, or Bitwig won't see it
+    CGEventType type = kCGEventMouseMoved;
+    CGMouseButton button = kCGMouseButtonLeft; // Ignored for mouse moved events apparently
+    if (leftDownDragWaiting) {
+        type = kCGEventLeftMouseDragged;
+    } else if (rightDownDragWaiting) {
+        type = kCGEventRightMouseDragged;
+        button = kCGMouseButtonRight;
+    } else if (middleDownDragWaiting) {
+        type = kCGEventOtherMouseDragged;
+        button = kCGMouseButtonCenter;
+    }
+    CGEventRef move = CGEventCreateMouseEvent(
+        getCGEventSource(modwigListeners), 
+        type,
+        CGPointMake((CGFloat)x, (CGFloat)y),
+        button
+    );
+    CGEventPost(kCGSessionEventTap, move);
+    CFRelease(move);
+}
+
+void postMouseButton(int jsButton, bool down, int x, int y, InputModifiers modifiers, bool modwigListeners, bool doubleClick) {
+    CGMouseButton button = (CGMouseButton)jsButton;
+    CGEventFlags flags = (CGEventFlags)0;
+    if (modifiers.Meta) {
+        flags |= kCGEventFlagMaskCommand;
+    }
+    if (modifiers.Control) {
+        flags |= kCGEventFlagMaskControl;
+    }
+    if (modifiers.Shift) {
+        flags |= kCGEventFlagMaskShift;
+    }
+    if (modifiers.Alt) {
+        flags |= kCGEventFlagMaskAlternate;
+    }
+
+    // Swapped from Javascript paradigm
+    if (button == 2) {
+        button = (CGMouseButton)1;
+        rightDownDragWaiting = down;
+    } else if (button == 1) {
+        middleDownDragWaiting = down;
+        button = (CGMouseButton)2;
+    } else {
+        leftDownDragWaiting = down;
+    }
+
+	CGEventRef event = CGEventCreateMouseEvent(
+        getCGEventSource(modwigListeners),
+        cgEventType(button, down),
+        CGPointMake((CGFloat)x, (CGFloat)y),
+        button
+    );
+    CGEventSetFlags(event, flags);
+    if (doubleClick) {
+        CGEventSetIntegerValueField(event, kCGMouseEventClickState, 2);
+    }
+	CGEventPost(kCGSessionEventTap, event);
+	CFRelease(event);
+}
+
 Napi::Value GetMousePosition(const Napi::CallbackInfo &info)
 {
     Napi::Env env = info.Env();
 
-    CGEventRef event = CGEventCreate(getCGEventSource());
-    CGPoint point = CGEventGetLocation(event);
-    CFRelease(event);
+    int x, y;
+    getMousePosition(x, y);
 
     return BESPoint::constructor.New({ 
-        Napi::Number::New(env, point.x),
-        Napi::Number::New(env, point.y)
+        Napi::Number::New(env, x),
+        Napi::Number::New(env, y)
     });
 }
 
@@ -61,75 +136,39 @@ Napi::Value SetMousePosition(const Napi::CallbackInfo &info)
         usleep(SLEEP_TIME);
     }
 
-    CGEventRef move = CGEventCreateMouseEvent(
-        getCGEventSource(), 
-        middleDownDragWaiting ? kCGEventOtherMouseDragged : kCGEventMouseMoved,
-        CGPointMake((CGFloat)x.DoubleValue(), (CGFloat)y.DoubleValue()),
-        middleDownDragWaiting ? kCGMouseButtonCenter : kCGMouseButtonLeft // Ignored for mouse moved events apparently
-    );
-	CGEventPost(kCGSessionEventTap, move);
-	CFRelease(move);
+    postMouseMove((int)x.DoubleValue(), (int)y.DoubleValue());
     usleep(SLEEP_TIME);
 
     return Napi::Value();
 }
 
 void mouseUpDown(const Napi::CallbackInfo &info, bool down, bool doubleClick = false) {
-    CGMouseButton button = (CGMouseButton)info[0].As<Napi::Number>().Uint32Value();
+    int button = info[0].As<Napi::Number>().Uint32Value();
 
-    CGPoint pos = BESPoint::Unwrap(GetMousePosition(info).As<Napi::Object>())->asCGPoint();
-    CGEventFlags flags = (CGEventFlags)0;
+    int x, y;
+    getMousePosition(x, y);
+    InputModifiers modifiers;
     // std::cout << "Button is " << button;
     bool modwigListeners = false;
     
     if (info[1].IsObject()) {
         // We got options
         Napi::Object options = info[1].As<Napi::Object>();
-        if (options.Has("Meta")) {
-            flags |= kCGEventFlagMaskCommand;
-        }
-        if (options.Has("Control")) {
-            flags |= kCGEventFlagMaskControl;
-        }
-        if (options.Has("Shift")) {
-            flags |= kCGEventFlagMaskShift;
-        }
-        if (options.Has("Alt")) {
-            flags |= kCGEventFlagMaskAlternate;
-        }
+        modifiers.Meta = options.Has("Meta");
+        modifiers.Control = options.Has("Control");
+        modifiers.Shift = options.Has("Shift");
+        modifiers.Alt = options.Has("Alt");
         
         if (options.Has("x")) {
-            pos.x = (CGFloat)options.Get("x").As<Napi::Number>().DoubleValue();
+            x = (int)options.Get("x").As<Napi::Number>().DoubleValue();
         }
         if (options.Has("y")) {
-            pos.y = (CGFloat)options.Get("y").As<Napi::Number>().DoubleValue();
+            y = (int)options.Get("y").As<Napi::Number>().DoubleValue();
         }
         modwigListeners = options.Has("modwigListeners") && options.Get("modwigListeners").As<Napi::Boolean>();
     }
 
-    // Swapped from Javascript paradigm
-    if (button == 2) {
-        button = (CGMouseButton)1;
-        rightDownDragWaiting = down;
-    } else if (button == 1) {
-        middleDownDragWaiting = down;
-        button = (CGMouseButton)2;
-    } else {
-        leftDownDragWaiting = down;
-    }
-
-	CGEventRef event = CGEventCreateMouseEvent(
-        getCGEventSource(modwigListeners),
-        cgEventType(button, down),
-        pos,
-        button
-    );
-    CGEventSetFlags(event, flags);
-    if (doubleClick) {
-        CGEventSetIntegerValueField(event, kCGMouseEventClickState, 2);
-    }
-	CGEventPost(kCGSessionEventTap, event);
-	CFRelease(event);
+    postMouseButton(button, down, x, y, modifiers, modwigListeners, doubleClick);
     usleep(SLEEP_TIME);
 }
 
@@ -182,6 +221,7 @@ Napi::Object InitMouse(Napi::Env env, Napi::Object exports)
     obj.Set(Napi::String::New(env, "click"), Napi::Function::New(env, Click));
     obj.Set(Napi::String::New(env, "doubleClick"), Napi::Function::New(env, DoubleClick));
     obj.Set(Napi::String::New(env, "setCursorVisibility"), Napi::Function::New(env, SetCursorVisibility));
+    obj.Set(Napi::String::New(env, "sequence"), Napi::Function::New(env, Sequence));
     exports.Set("Mouse", obj);
     return exports;
 }
\ No newline at end of file
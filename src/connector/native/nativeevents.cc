@@ -0,0 +1,99 @@
+#include "nativeevents.h"
+#include "metrics.h"
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+struct NativeEventListener {
+    int id;
+    std::string type;
+    Napi::ThreadSafeFunction tsfn;
+};
+
+std::mutex nativeEventsMutex;
+std::map<std::string, std::function<void()>> nativeEventTypes;
+std::vector<NativeEventListener> nativeEventListeners;
+int nextNativeEventListenerId = 0;
+
+void registerNativeEventType(const std::string& type, std::function<void()> onListen) {
+    std::lock_guard<std::mutex> lock(nativeEventsMutex);
+    nativeEventTypes[type] = onListen;
+}
+
+bool hasNativeEventListeners(const std::string& type) {
+    std::lock_guard<std::mutex> lock(nativeEventsMutex);
+    for (auto& listener : nativeEventListeners) {
+        if (listener.type == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void emitNativeEvent(const std::string& type, NativeEventPayload payload) {
+    static auto& queueDepth = metricGauge("events.native.queueDepth");
+    static auto& marshalTime = metricHistogram("napi.nativeEvent.time");
+    std::lock_guard<std::mutex> lock(nativeEventsMutex);
+    for (auto& listener : nativeEventListeners) {
+        if (listener.type != type) {
+            continue;
+        }
+        queueDepth.add(1);
+        listener.tsfn.BlockingCall(new NativeEventPayload(payload), [](Napi::Env env, Napi::Function jsCallback, NativeEventPayload* payload) {
+            queueDepth.add(-1);
+            MetricTimer timer(marshalTime);
+            jsCallback.Call({(*payload)(env)});
+            delete payload;
+        });
+    }
+}
+
+Napi::Value OnNativeEvent(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto eventType = info[0].As<Napi::String>().Utf8Value();
+    std::function<void()> onListen;
+    {
+        std::lock_guard<std::mutex> lock(nativeEventsMutex);
+        if (!nativeEventTypes.count(eventType)) {
+            throw std::invalid_argument("Unrecognised event type: " + eventType);
+        }
+        onListen = nativeEventTypes[eventType];
+    }
+    auto tsfn = Napi::ThreadSafeFunction::New(
+        env,
+        info[1].As<Napi::Function>(),
+        "Native Event " + eventType,
+        0, // Unlimited queue
+        1 // Initial thread count
+    );
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(nativeEventsMutex);
+        id = nextNativeEventListenerId++;
+        nativeEventListeners.push_back({id, eventType, tsfn});
+    }
+    if (onListen) {
+        onListen();
+    }
+    return Napi::Number::New(env, id);
+}
+
+Napi::Value OffNativeEvent(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    int id = info[0].As<Napi::Number>();
+    std::lock_guard<std::mutex> lock(nativeEventsMutex);
+    for (auto it = nativeEventListeners.begin(); it != nativeEventListeners.end(); it++) {
+        if (it->id == id) {
+            it->tsfn.Release();
+            nativeEventListeners.erase(it);
+            break;
+        }
+    }
+    return env.Undefined();
+}
+
+void addNativeEventFunctions(Napi::Env env, Napi::Object obj) {
+    obj.Set("on", Napi::Function::New(env, OnNativeEvent));
+    obj.Set("off", Napi::Function::New(env, OffNativeEvent));
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <napi.h>
+#include <functional>
+#include <string>
+
+/**
+ * Bitwig.on(type, cb) / Bitwig.off(id) for events raised on our own threads (activation
+ * notifications, the resource sampler...). Modules register the types they raise, emitting
+ * is safe from any thread and cheap when nobody is listening.
+ */
+
+// Builds the callback's argument, called on the JS thread
+typedef std::function<Napi::Value(Napi::Env)> NativeEventPayload;
+
+// onListen runs (on the JS thread) each time a listener is added, e.g. to start a watcher
+void registerNativeEventType(const std::string& type, std::function<void()> onListen = nullptr);
+bool hasNativeEventListeners(const std::string& type);
+void emitNativeEvent(const std::string& type, NativeEventPayload payload);
+
+void addNativeEventFunctions(Napi::Env env, Napi::Object obj);
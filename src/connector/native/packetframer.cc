@@ -0,0 +1,60 @@
+#include "packetframer.h"
+
+Napi::FunctionReference BESPacketFramer::constructor;
+
+BESPacketFramer::BESPacketFramer(const Napi::CallbackInfo &info) : Napi::ObjectWrap<BESPacketFramer>(info) {}
+
+Napi::Value BESPacketFramer::Push(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    if (!info[0].IsBuffer()) {
+        throw Napi::TypeError::New(env, "PacketFramer.push expects a Buffer");
+    }
+    auto chunk = info[0].As<Napi::Buffer<uint8_t>>();
+    frames.clear();
+    framer.push(chunk.Data(), chunk.Length(), frames);
+
+    auto out = Napi::Array::New(env, frames.size());
+    for (size_t i = 0; i < frames.size(); i++) {
+        auto& frame = frames[i];
+        Napi::Value data;
+        const uint8_t* bytes;
+        if (frame.spansChunks) {
+            auto copy = Napi::Buffer<uint8_t>::Copy(env, frame.assembled.data(), frame.assembled.size());
+            bytes = copy.Data();
+            data = copy;
+        } else {
+            // A view on the chunk's memory. node-addon-api can't make a Buffer over part of
+            // another, but a Uint8Array is all Buffer.from(data.buffer, ...) or ws.send need
+            auto view = Napi::Uint8Array::New(env, frame.length, chunk.ArrayBuffer(), chunk.ByteOffset() + frame.offset);
+            bytes = view.Data();
+            data = view;
+        }
+        std::string type, id;
+        scanPacketHeader(bytes, frame.length, type, id);
+        Napi::Object obj = Napi::Object::New(env);
+        obj.Set(Napi::String::New(env, "data"), data);
+        if (type.size() > 0) {
+            obj.Set(Napi::String::New(env, "type"), Napi::String::New(env, type));
+        }
+        if (id.size() > 0) {
+            obj.Set(Napi::String::New(env, "id"), Napi::String::New(env, id));
+        }
+        out.Set(i, obj);
+    }
+    return out;
+}
+
+Napi::Value BESPacketFramer::Reset(const Napi::CallbackInfo &info) {
+    framer.reset();
+    return info.Env().Undefined();
+}
+
+void BESPacketFramer::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function func = DefineClass(env, "PacketFramer", {
+        InstanceMethod<&BESPacketFramer::Push>("push"),
+        InstanceMethod<&BESPacketFramer::Reset>("reset")
+    });
+    exports.Set("PacketFramer", func);
+    BESPacketFramer::constructor = Napi::Persistent(func);
+    BESPacketFramer::constructor.SuppressDestruct();
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <napi.h>
+#include "framer.h"
+
+/**
+ * JS side of PacketFramer, exported as Bitwig.PacketFramer:
+ *
+ *   const framer = new Bitwig.PacketFramer()
+ *   framer.push(chunk) -> [{ data: Uint8Array, type?, id? }]
+ *
+ * data is a view on chunk's memory unless the packet spanned chunks. type and id are read
+ * without parsing the JSON so routing can skip JSON.parse entirely
+ */
+class BESPacketFramer : public Napi::ObjectWrap<BESPacketFramer>
+{
+    PacketFramer framer;
+    std::vector<PacketFrame> frames;
+public:
+    static Napi::FunctionReference constructor;
+    static void Init(Napi::Env env, Napi::Object exports);
+    BESPacketFramer(const Napi::CallbackInfo &info);
+    Napi::Value Push(const Napi::CallbackInfo &info);
+    Napi::Value Reset(const Napi::CallbackInfo &info);
+};
@@ -0,0 +1,119 @@
+#include "pixelrows.h"
+#include <cstring>
+
+int brightestChannel(const uint8_t* bgra) {
+    return std::max(bgra[0], std::max(bgra[1], bgra[2]));
+}
+
+void findLitSpans(const uint8_t* row, int pixels, int threshold, int minWidth, std::vector<int32_t>& spans) {
+    int runStart = -1;
+    auto endRun = [&](int end) {
+        if (end - runStart >= minWidth) {
+            spans.push_back(runStart);
+            spans.push_back(end - runStart);
+        }
+        runStart = -1;
+    };
+
+    int x = 0;
+    for (; x + 16 <= pixels; x += 16) {
+        uint32_t mask = litPixels16(row + x * 4, threshold);
+        // Nothing to do unless the block isn't all the same as the run we're in (or not in)
+        if (mask == (runStart == -1 ? 0u : 0xFFFFu)) {
+            continue;
+        }
+        int i = 0;
+        while (i < 16) {
+            uint32_t rest = (runStart == -1 ? mask : ~mask & 0xFFFF) >> i;
+            if (rest == 0) {
+                break;
+            }
+            i += __builtin_ctz(rest);
+            if (runStart == -1) {
+                runStart = x + i;
+            } else {
+                endRun(x + i);
+            }
+        }
+    }
+    for (; x < pixels; x++) {
+        bool lit = isLitPixel(row + x * 4, threshold);
+        if (lit && runStart == -1) {
+            runStart = x;
+        } else if (!lit && runStart != -1) {
+            endRun(x);
+        }
+    }
+    if (runStart != -1) {
+        endRun(pixels);
+    }
+}
+
+uint64_t hashPixelRow(const uint8_t* row, int pixels, uint64_t hash) {
+    const uint64_t prime = 1099511628211ull;
+    auto bytes = (size_t)pixels * 4;
+    // Four independent lanes so the multiplies overlap instead of waiting on each other
+    uint64_t lanes[4] = {hash, hash ^ 1, hash ^ 2, hash ^ 3};
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            uint64_t word;
+            memcpy(&word, row + i + lane * 8, 8);
+            lanes[lane] = (lanes[lane] ^ word) * prime;
+        }
+    }
+    for (auto lane : lanes) {
+        hash = (hash ^ lane) * prime;
+    }
+    for (; i < bytes; i++) {
+        hash = (hash ^ row[i]) * prime;
+    }
+    return hash;
+}
+
+int countOutsideBand(const uint8_t* row, int pixels, int low, int high, uint16_t* columns) {
+    int count = 0;
+    int x = 0;
+#if defined(__SSE2__)
+    const __m128i lowBytes = _mm_set1_epi8((char)low), highBytes = _mm_set1_epi8((char)high);
+    for (; x + 16 <= pixels; x += 16) {
+        __m128i bytes = brightest16(row + x * 4);
+        // All ones where the brightness is from low to high inclusive
+        __m128i inside = _mm_and_si128(
+            _mm_cmpeq_epi8(_mm_subs_epu8(lowBytes, bytes), _mm_setzero_si128()),
+            _mm_cmpeq_epi8(_mm_subs_epu8(bytes, highBytes), _mm_setzero_si128())
+        );
+        auto insideMask = (uint32_t)_mm_movemask_epi8(inside);
+        if (insideMask == 0xFFFF) {
+            continue;
+        }
+        count += 16 - __builtin_popcount(insideMask);
+        // Each outside byte is 0xFF, widened to -1 and subtracted
+        __m128i outside = _mm_xor_si128(inside, _mm_set1_epi8((char)0xFF));
+        auto counts = (__m128i*)(columns + x);
+        _mm_storeu_si128(counts, _mm_sub_epi16(_mm_loadu_si128(counts), _mm_unpacklo_epi8(outside, outside)));
+        _mm_storeu_si128(counts + 1, _mm_sub_epi16(_mm_loadu_si128(counts + 1), _mm_unpackhi_epi8(outside, outside)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t lowBytes = vdupq_n_u8((uint8_t)low), highBytes = vdupq_n_u8((uint8_t)high);
+    for (; x + 16 <= pixels; x += 16) {
+        uint8x16_t bytes = brightest16(row + x * 4);
+        uint8x16_t outside = vorrq_u8(vcltq_u8(bytes, lowBytes), vcgtq_u8(bytes, highBytes));
+        uint8x16_t ones = vshrq_n_u8(outside, 7);
+        if (vmaxvq_u8(ones) == 0) {
+            continue;
+        }
+        count += vaddvq_u8(ones);
+        vst1q_u16(columns + x, vaddw_u8(vld1q_u16(columns + x), vget_low_u8(ones)));
+        vst1q_u16(columns + x + 8, vaddw_high_u8(vld1q_u16(columns + x + 8), ones));
+    }
+#endif
+    for (; x < pixels; x++) {
+        auto brightness = brightestChannel(row + x * 4);
+        if (brightness < low || brightness > high) {
+            columns[x]++;
+            count++;
+        }
+    }
+    return count;
+}
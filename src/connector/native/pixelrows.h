@@ -0,0 +1,81 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Rows of BGRA pixels classified by brightness, for things drawn lighter than what's behind them
+ * (control glyphs, device headers, scrollbar thumbs). Lit is the brightest of blue, green and red
+ * over a threshold.
+ */
+inline bool isLitPixel(const uint8_t* bgra, int threshold) {
+    return std::max(bgra[0], std::max(bgra[1], bgra[2])) > threshold;
+}
+
+#if defined(__SSE2__)
+/**
+ * Brightest channel of each of the 16 pixels at bgra, one byte each
+ */
+inline __m128i brightest16(const uint8_t* bgra) {
+    const __m128i lowByte = _mm_set1_epi32(0xFF);
+    __m128i brightest[4];
+    for (int i = 0; i < 4; i++) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(bgra + i * 16));
+        // Brightest of blue, green and red ends up in the low byte of each pixel
+        __m128i hi = _mm_max_epu8(pixels, _mm_max_epu8(_mm_srli_epi32(pixels, 8), _mm_srli_epi32(pixels, 16)));
+        brightest[i] = _mm_and_si128(hi, lowByte);
+    }
+    return _mm_packus_epi16(_mm_packs_epi32(brightest[0], brightest[1]), _mm_packs_epi32(brightest[2], brightest[3]));
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+inline uint8x16_t brightest16(const uint8_t* bgra) {
+    uint8x16x4_t pixels = vld4q_u8(bgra);
+    return vmaxq_u8(pixels.val[0], vmaxq_u8(pixels.val[1], pixels.val[2]));
+}
+
+// One bit per byte of a 0x00/0xFF mask, like _mm_movemask_epi8
+inline uint32_t movemask16(uint8x16_t mask) {
+    static const uint8_t bitValues[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t bits = vandq_u8(mask, vld1q_u8(bitValues));
+    return (uint32_t)vaddv_u8(vget_low_u8(bits)) | ((uint32_t)vaddv_u8(vget_high_u8(bits)) << 8);
+}
+#endif
+
+/**
+ * Bit i set if pixel i of the 16 at bgra is lit, threshold under 255
+ */
+inline uint32_t litPixels16(const uint8_t* bgra, int threshold) {
+#if defined(__SSE2__)
+    __m128i over = _mm_subs_epu8(brightest16(bgra), _mm_set1_epi8((char)threshold));
+    return ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(over, _mm_setzero_si128())) & 0xFFFF;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return movemask16(vcgtq_u8(brightest16(bgra), vdupq_n_u8((uint8_t)threshold)));
+#else
+    uint32_t mask = 0;
+    for (int i = 0; i < 16; i++) {
+        mask |= (uint32_t)isLitPixel(bgra + i * 4, threshold) << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * Appends start, length pairs for each run of lit pixels in a row at least minWidth long
+ */
+void findLitSpans(const uint8_t* row, int pixels, int threshold, int minWidth, std::vector<int32_t>& spans);
+
+/**
+ * FNV-1a style hash of a row of pixels a word at a time, continuing from hash
+ */
+uint64_t hashPixelRow(const uint8_t* row, int pixels, uint64_t hash = 14695981039346656037ull);
+
+/**
+ * Adds one to columns[x] for each pixel in the row whose brightest channel is under low or over
+ * high, returns how many there were. Called once per row it gives both projections of a region
+ */
+int countOutsideBand(const uint8_t* row, int pixels, int low, int high, uint16_t* columns);
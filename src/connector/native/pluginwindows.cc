@@ -0,0 +1,288 @@
+#include "pluginwindows.h"
+#include "windowgeometry.h"
+#include "windowregistry.h"
+#include "workerpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+Napi::Object pluginWindowToJSObject(Napi::Env env, const std::string& id, const PluginWindow& window) {
+    auto obj = Napi::Object::New(env);
+    obj.Set(Napi::String::New(env, "x"), Napi::Number::New(env, window.x));
+    obj.Set(Napi::String::New(env, "y"), Napi::Number::New(env, window.y));
+    obj.Set(Napi::String::New(env, "w"), Napi::Number::New(env, window.w));
+    obj.Set(Napi::String::New(env, "h"), Napi::Number::New(env, window.h));
+    obj.Set(Napi::String::New(env, "id"), Napi::String::New(env, id));
+    obj.Set(Napi::String::New(env, "focused"), Napi::Boolean::New(env, window.focused));
+    // Strings as CFHash keys don't fit in a double
+    obj.Set(Napi::String::New(env, "windowId"), Napi::String::New(env, std::to_string(window.key)));
+    return obj;
+}
+
+Napi::Value GetPluginWindowsPosition(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    Napi::Object outObj = Napi::Object::New(env);
+    auto windows = getPluginWindowRegistry().windows();
+    for (auto& pair : pluginWindowsById(*windows)) {
+        outObj.Set(Napi::String::New(env, pair.first), pluginWindowToJSObject(env, pair.first, pair.second));
+    }
+    return outObj;
+}
+
+Napi::Value GetPluginWindowsCount(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    return Napi::Number::New(env, getPluginWindowRegistry().windows()->size());
+}
+
+/**
+ * Plugin window under a point, or false. Cheaper than getPluginWindowsPosition for
+ * checking mouse events as it only builds one object
+ */
+Napi::Value GetPluginWindowAt(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    double x = info[0].As<Napi::Number>().DoubleValue();
+    double y = info[1].As<Napi::Number>().DoubleValue();
+    auto windows = getPluginWindowRegistry().windows();
+    for (auto& pair : pluginWindowsById(*windows)) {
+        if (pair.second.intersects(x, y, 1, 1)) {
+            return pluginWindowToJSObject(env, pair.first, pair.second);
+        }
+    }
+    return Napi::Boolean::New(env, false);
+}
+
+/**
+ * A GeometryTransaction and the Promise it settles. Changes are applied concurrently,
+ * whichever worker finishes last settles it
+ */
+struct PendingGeometry {
+    GeometryTransaction transaction;
+    std::atomic<size_t> remaining;
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+
+    PendingGeometry(Napi::Env env, bool rollback, bool alwaysMove)
+        : transaction(getPluginWindowRegistry(), rollback, alwaysMove),
+        remaining(0),
+        deferred(Napi::Promise::Deferred::New(env)) {}
+};
+
+WorkerPool& getGeometryPool() {
+    // Each Accessibility set is a synchronous round trip to the plugin host, a few at once
+    // overlaps them without flooding it
+    static WorkerPool pool(std::min(4u, std::max(1u, std::thread::hardware_concurrency())));
+    return pool;
+}
+
+Napi::Object geometryResults(Napi::Env env, const GeometryTransaction& transaction) {
+    auto results = Napi::Object::New(env);
+    for (auto& pair : transaction.results()) {
+        results.Set(pair.first, Napi::String::New(env, pair.second));
+    }
+    return results;
+}
+
+/**
+ * Diffs targets ({ [id or windowId]: {x, y, w?, h?} }) against the registry and applies only
+ * what differs, returning a Promise of { [key]: 'applied' | 'unchanged' | 'missing' | 'failed' | 'rolledBack' }.
+ * See GeometryTransaction for rollback and alwaysMove
+ */
+Napi::Promise applyGeometry(Napi::Env env, Napi::Object targets, bool rollback, bool alwaysMove = false) {
+    auto pending = new PendingGeometry(env, rollback, alwaysMove);
+    auto& transaction = pending->transaction;
+    auto promise = pending->deferred.Promise();
+
+    auto keys = targets.GetPropertyNames();
+    for (uint32_t i = 0; i < keys.Length(); i++) {
+        std::string id = keys.Get(i).ToString().Utf8Value();
+        if (!targets.Get(id).IsObject()) {
+            transaction.add(id, nullptr);
+            continue;
+        }
+        auto targetObj = targets.Get(id).As<Napi::Object>();
+        auto read = [&](const char* name, std::experimental::optional<double>& out) {
+            if (targetObj.Has(name)) {
+                out = targetObj.Get(name).As<Napi::Number>().DoubleValue();
+            }
+        };
+        GeometryTarget target;
+        read("x", target.x);
+        read("y", target.y);
+        read("w", target.w);
+        read("h", target.h);
+        transaction.add(id, &target);
+    }
+
+    if (transaction.changes.size() == 0) {
+        pending->deferred.Resolve(geometryResults(env, transaction));
+        delete pending;
+        return promise;
+    }
+
+    pending->tsfn = Napi::ThreadSafeFunction::New(
+        env,
+        Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+        "Plugin Window Geometry",
+        0, // Unlimited queue
+        1 // Initial thread count
+    );
+    pending->remaining = transaction.changes.size();
+    for (size_t i = 0; i < transaction.changes.size(); i++) {
+        getGeometryPool().post([pending, i]() {
+            pending->transaction.apply(i);
+            if (--pending->remaining > 0) {
+                return;
+            }
+            pending->transaction.finish();
+            auto tsfn = pending->tsfn;
+            tsfn.BlockingCall(pending, [](Napi::Env env, Napi::Function, PendingGeometry* pending) {
+                pending->deferred.Resolve(geometryResults(env, pending->transaction));
+                delete pending;
+            });
+            tsfn.Release();
+        });
+    }
+    return promise;
+}
+
+/**
+ * setPluginWindowsPosition({ [id]: {x, y, w?, h?} }, { rollback = false }). Only windows whose
+ * frame actually differs are touched, see applyGeometry
+ */
+Napi::Value SetPluginWindowsPosition(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    bool rollback = info[1].IsObject()
+        && info[1].As<Napi::Object>().Has("rollback")
+        && info[1].As<Napi::Object>().Get("rollback").ToBoolean().Value();
+    return applyGeometry(env, info[0].As<Napi::Object>(), rollback);
+}
+
+Napi::Value FocusPluginWindow(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    std::string id = info[0].As<Napi::String>();
+    auto& registry = getPluginWindowRegistry();
+    auto windows = registry.windows();
+    for (auto& pair : pluginWindowsById(*windows)) {
+        if (pair.first == id) {
+            registry.getSource()->focus(pair.second.key);
+            break;
+        }
+    }
+    return env.Undefined();
+}
+
+/**
+ * A ClearTransaction and the Promise it settles, whichever worker finishes last settles it
+ */
+struct PendingClear {
+    ClearTransaction transaction;
+    std::atomic<size_t> remaining;
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+
+    PendingClear(Napi::Env env, double x, double y, double w, double h, int timeoutMs)
+        : transaction(getPluginWindowRegistry(), x, y, w, h, std::chrono::milliseconds(timeoutMs)),
+        remaining(0),
+        deferred(Napi::Promise::Deferred::New(env)) {}
+};
+
+Napi::Array clearResults(Napi::Env env, const ClearTransaction& transaction) {
+    auto moved = Napi::Array::New(env);
+    for (auto& pair : transaction.windows) {
+        moved.Set(moved.Length(), pluginWindowToJSObject(env, pair.first, pair.second));
+    }
+    return moved;
+}
+
+/**
+ * clearPluginWindowsFrom({x, y, w?, h?}, {timeout = 50}) moves only the plugin windows that
+ * overlap the region out of the way. Returns a Promise of their original frames (to hand back
+ * to restorePluginWindows), settled once they've actually moved or the timeout has passed
+ */
+Napi::Value ClearPluginWindowsFrom(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto regionObj = info[0].As<Napi::Object>();
+    int timeoutMs = 50;
+    if (info[1].IsObject() && info[1].As<Napi::Object>().Has("timeout")) {
+        timeoutMs = info[1].As<Napi::Object>().Get("timeout").As<Napi::Number>();
+    }
+
+    auto pending = new PendingClear(
+        env,
+        regionObj.Get("x").As<Napi::Number>().DoubleValue(),
+        regionObj.Get("y").As<Napi::Number>().DoubleValue(),
+        regionObj.Has("w") ? regionObj.Get("w").As<Napi::Number>().DoubleValue() : 1,
+        regionObj.Has("h") ? regionObj.Get("h").As<Napi::Number>().DoubleValue() : 1,
+        timeoutMs
+    );
+    auto& transaction = pending->transaction;
+    auto promise = pending->deferred.Promise();
+
+    if (transaction.windows.size() == 0) {
+        pending->deferred.Resolve(clearResults(env, transaction));
+        delete pending;
+        return promise;
+    }
+
+    pending->tsfn = Napi::ThreadSafeFunction::New(
+        env,
+        Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+        "Plugin Window Clear",
+        0, // Unlimited queue
+        1 // Initial thread count
+    );
+    pending->remaining = transaction.windows.size();
+    for (size_t i = 0; i < transaction.windows.size(); i++) {
+        getGeometryPool().post([pending, i, timeoutMs]() {
+            pending->transaction.clear(i);
+            if (--pending->remaining > 0) {
+                return;
+            }
+            if (pending->transaction.unconfirmed > 0) {
+                std::cout << pending->transaction.unconfirmed << " plugin window(s) didn't move within " << timeoutMs << "ms" << std::endl;
+            }
+            auto tsfn = pending->tsfn;
+            tsfn.BlockingCall(pending, [](Napi::Env env, Napi::Function, PendingClear* pending) {
+                pending->deferred.Resolve(clearResults(env, pending->transaction));
+                delete pending;
+            });
+            tsfn.Release();
+        });
+    }
+    return promise;
+}
+
+/**
+ * Puts back windows moved by clearPluginWindowsFrom. Returns a Promise as for
+ * setPluginWindowsPosition
+ */
+Napi::Value RestorePluginWindows(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto movedArr = info[0].As<Napi::Array>();
+    auto targets = Napi::Object::New(env);
+    for (uint32_t i = 0; i < movedArr.Length(); i++) {
+        auto obj = movedArr.Get(i).As<Napi::Object>();
+        if (obj.Has("windowId")) {
+            targets.Set(obj.Get("windowId"), obj);
+        }
+    }
+    // The windows were moved away by us, if the registry hasn't seen that yet (the move wasn't
+    // confirmed in time) diffing against it would leave them off screen
+    return applyGeometry(env, targets, false, true);
+}
+
+void addPluginWindowFunctions(Napi::Env env, Napi::Object obj) {
+    obj.Set("getPluginWindowsPosition", Napi::Function::New(env, GetPluginWindowsPosition));
+    obj.Set("setPluginWindowsPosition", Napi::Function::New(env, SetPluginWindowsPosition));
+    obj.Set("getPluginWindowAt", Napi::Function::New(env, GetPluginWindowAt));
+    obj.Set("clearPluginWindowsFrom", Napi::Function::New(env, ClearPluginWindowsFrom));
+    obj.Set("restorePluginWindows", Napi::Function::New(env, RestorePluginWindows));
+    obj.Set("focusPluginWindow", Napi::Function::New(env, FocusPluginWindow));
+    obj.Set("getPluginWindowsCount", Napi::Function::New(env, GetPluginWindowsCount));
+}
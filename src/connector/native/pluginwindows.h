@@ -0,0 +1,8 @@
+#pragma once
+#include <napi.h>
+
+/**
+ * The plugin window part of the Bitwig module, shared between platforms as it only talks to
+ * the registry (see windowregistry.h)
+ */
+void addPluginWindowFunctions(Napi::Env env, Napi::Object obj);
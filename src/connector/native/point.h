@@ -1,8 +1,10 @@
 #pragma once
 
 #include <napi.h>
+#ifdef __APPLE__
 #include <CoreFoundation/CoreFoundation.h>
 #include <CoreGraphics/CoreGraphics.h>
+#endif
 
 class BESPoint : public Napi::ObjectWrap<BESPoint>
 {
@@ -13,7 +15,9 @@ public:
     Napi::Value GetX(const Napi::CallbackInfo &info);
     Napi::Value GetY(const Napi::CallbackInfo &info);
     int _x, _y;
+#ifdef __APPLE__
     CGPoint asCGPoint() {
         return CGPointMake((CGFloat)this->_x, (CGFloat)this->_y);
     }
+#endif
 };
\ No newline at end of file
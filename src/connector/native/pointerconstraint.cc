@@ -0,0 +1,48 @@
+#include "pointerconstraint.h"
+#include <algorithm>
+
+void PointerConstrainer::set(const PointerConstraint& newConstraint, double x, double y) {
+    std::lock_guard<std::mutex> lock(mutex);
+    constraint = newConstraint;
+    anchorX = lastX = x;
+    anchorY = lastY = y;
+    active = constraint.lockX || constraint.lockY || constraint.clamp || constraint.scale != 1;
+}
+
+void PointerConstrainer::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    active = false;
+}
+
+bool PointerConstrainer::isActive() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return active;
+}
+
+bool PointerConstrainer::constrain(double& x, double& y, double dx, double dy) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active) {
+        return false;
+    }
+    double newX = x, newY = y;
+    if (constraint.scale != 1) {
+        newX = lastX + dx * constraint.scale;
+        newY = lastY + dy * constraint.scale;
+    }
+    if (constraint.lockX) {
+        newX = anchorX;
+    }
+    if (constraint.lockY) {
+        newY = anchorY;
+    }
+    if (constraint.clamp) {
+        newX = std::min(std::max(newX, constraint.clampX), constraint.clampX + std::max(constraint.clampW - 1, 0.0));
+        newY = std::min(std::max(newY, constraint.clampY), constraint.clampY + std::max(constraint.clampH - 1, 0.0));
+    }
+    lastX = newX;
+    lastY = newY;
+    bool changed = newX != x || newY != y;
+    x = newX;
+    y = newY;
+    return changed;
+}
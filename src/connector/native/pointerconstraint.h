@@ -0,0 +1,39 @@
+#pragma once
+#include <mutex>
+
+/**
+ * Pointer constraints applied to mouse moves before anything else sees them. No platform
+ * or N-API code in here, the backends feed it moves from the event tap (or XRecord) and
+ * constraint.cc has the Keyboard functions that set it.
+ */
+struct PointerConstraint {
+    // Hold x (or y) where the pointer was when the constraint was set
+    bool lockX = false;
+    bool lockY = false;
+    // Keep the pointer within x, y, w, h
+    bool clamp = false;
+    double clampX = 0, clampY = 0, clampW = 0, clampH = 0;
+    // Multiplier for movement, < 1 for fine adjustment
+    double scale = 1;
+};
+
+class PointerConstrainer {
+    std::mutex mutex;
+    bool active = false;
+    PointerConstraint constraint;
+    double anchorX = 0, anchorY = 0;
+    // Where we last sent the pointer, scaled movement is added to this
+    double lastX = 0, lastY = 0;
+public:
+    void set(const PointerConstraint& constraint, double anchorX, double anchorY);
+    void clear();
+    bool isActive();
+
+    /**
+     * Takes where the pointer is about to go, having moved dx, dy with the event, and moves it
+     * to where it should go instead. Returns true if it changed. The deltas are the device's,
+     * not the difference from lastX/Y, so scaling still works if the cursor didn't follow
+     * where we last sent it
+     */
+    bool constrain(double& x, double& y, double dx, double dy);
+};
@@ -0,0 +1,100 @@
+#include "processtable.h"
+#include <algorithm>
+#include <signal.h>
+
+// How long "not running" is believed when nothing we watch has forked since
+const auto notRunningRetry = std::chrono::milliseconds(500);
+
+ProcessTable::ProcessTable(ProcessSource* source) : source(source) {}
+
+pid_t ProcessTable::find(const std::string& name) {
+    pid_t gone = -1;
+    pid_t pid = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& entry = entries[name];
+        if (entry.pid != -1) {
+            if (entry.watched || kill(entry.pid, 0) == 0) {
+                return entry.pid;
+            }
+            // Unwatched and gone, tell listeners below the same as if we'd been notified
+            gone = entry.pid;
+            entry.pid = -1;
+        } else if (Clock::now() - entry.lookedUpAt < notRunningRetry) {
+            return -1;
+        }
+
+        entry.pid = source->lookup(name);
+        entry.lookedUpAt = Clock::now();
+        entry.watched = entry.pid != -1 && source->watch(entry.pid, this);
+        pid = entry.pid;
+    }
+    if (gone != -1) {
+        // The entry already holds the new lookup, so exited() wouldn't find it by pid
+        notifyExited({name}, gone);
+    }
+    return pid;
+}
+
+bool ProcessTable::isAlive(pid_t pid) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& pair : entries) {
+            if (pair.second.pid == pid && pair.second.watched) {
+                return true;
+            }
+        }
+    }
+    return pid > 0 && kill(pid, 0) == 0;
+}
+
+int ProcessTable::addExitListener(ExitListener listener) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int id = nextListenerId++;
+    listeners.push_back({id, listener});
+    return id;
+}
+
+void ProcessTable::removeExitListener(int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    listeners.erase(std::remove_if(listeners.begin(), listeners.end(), [=](const std::pair<int, ExitListener>& pair) {
+        return pair.first == id;
+    }), listeners.end());
+}
+
+void ProcessTable::notifyExited(const std::vector<std::string>& names, pid_t pid) {
+    std::vector<std::pair<int, ExitListener>> toCall;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        toCall = listeners;
+    }
+    // Outside the lock, listeners are free to look things up again
+    for (auto& name : names) {
+        for (auto& pair : toCall) {
+            pair.second(name, pid);
+        }
+    }
+}
+
+void ProcessTable::exited(pid_t pid) {
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& pair : entries) {
+            if (pair.second.pid == pid) {
+                names.push_back(pair.first);
+                pair.second = Entry();
+            }
+        }
+    }
+    notifyExited(names, pid);
+}
+
+void ProcessTable::launched() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& pair : entries) {
+        if (pair.second.pid == -1) {
+            pair.second.lookedUpAt = Clock::time_point();
+        }
+    }
+}
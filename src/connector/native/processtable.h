@@ -0,0 +1,73 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <utility>
+#include <vector>
+
+class ProcessTable;
+
+/**
+ * Where processes come from and how we hear about them going away. One per platform (kqueue
+ * on macOS, pidfd on Linux). Like PluginWindowSource, a source tells the table about changes
+ * by calling its notification methods from whatever thread it receives them on.
+ */
+class ProcessSource {
+public:
+    virtual ~ProcessSource() {}
+    // Slow path, find a running process by name (window owner). -1 if there isn't one
+    virtual pid_t lookup(const std::string& name) = 0;
+    // Ask to be told when pid exits. Returns false if the platform can't, then the table
+    // checks the pid itself on each access
+    virtual bool watch(pid_t pid, ProcessTable* table) = 0;
+};
+
+/**
+ * Pids of the processes we care about by name, kept current by exit (and, where the platform
+ * has them, fork) notifications so lookups don't have to scan the window list. No N-API or
+ * platform code in here, see ProcessSource.
+ */
+class ProcessTable {
+public:
+    typedef std::function<void(const std::string& name, pid_t pid)> ExitListener;
+private:
+    typedef std::chrono::steady_clock Clock;
+    struct Entry {
+        // -1 when it wasn't running last time we looked
+        pid_t pid = -1;
+        bool watched = false;
+        Clock::time_point lookedUpAt;
+    };
+    ProcessSource* source;
+    std::mutex mutex;
+    std::map<std::string, Entry> entries;
+    std::vector<std::pair<int, ExitListener>> listeners;
+    int nextListenerId = 0;
+
+    // Takes the lock itself, call without it
+    void notifyExited(const std::vector<std::string>& names, pid_t pid);
+public:
+    ProcessTable(ProcessSource* source);
+
+    // -1 if not running
+    pid_t find(const std::string& name);
+    // Whether pid is one we know to be running, without asking the kernel if it's watched
+    bool isAlive(pid_t pid);
+    int addExitListener(ExitListener listener);
+    void removeExitListener(int id);
+
+    /**
+     * Notifications, safe from any thread
+     */
+    void exited(pid_t pid);
+    // Something we watch forked or exec'd, so anything we didn't find before might be there now
+    void launched();
+};
+
+/**
+ * Defined per platform in bitwig.cc
+ */
+ProcessTable& getProcessTable();
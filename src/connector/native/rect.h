@@ -1,6 +1,10 @@
 #pragma once
 #include <napi.h>
+#ifdef __APPLE__
 #include <CoreGraphics/CoreGraphics.h>
+#else
+typedef double CGFloat;
+#endif
 
 class BESRect : public Napi::ObjectWrap<BESRect>
 {
@@ -25,8 +29,10 @@ public:
     }
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     BESRect(const Napi::CallbackInfo &info);
+#ifdef __APPLE__
     static Napi::Object FromCGRect(const Napi::Env env, CGRect cgRect);
     CGRect asCGRect() {
         return CGRectMake(_x, _y, _w, _h);
     }
+#endif
 };
\ No newline at end of file
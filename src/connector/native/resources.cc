@@ -0,0 +1,237 @@
+#include "resources.h"
+#include "nativeevents.h"
+#include "processtable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ResourceSample {
+    // ms since the epoch, like Date.now()
+    double time;
+    pid_t pid;
+    uint64_t rss;
+    // Percent of one core since the previous sample
+    double cpu;
+    double cpuTime;
+    int threads;
+};
+
+/**
+ * Fixed capacity, the oldest sample is overwritten once full
+ */
+class ResourceRing {
+    std::vector<ResourceSample> samples;
+    size_t next = 0;
+    size_t count = 0;
+public:
+    void resize(size_t capacity) {
+        samples.assign(capacity > 0 ? capacity : 1, ResourceSample());
+        next = 0;
+        count = 0;
+    }
+
+    void push(const ResourceSample& sample) {
+        samples[next] = sample;
+        next = (next + 1) % samples.size();
+        count = std::min(count + 1, samples.size());
+    }
+
+    // Oldest first
+    std::vector<ResourceSample> ordered() const {
+        std::vector<ResourceSample> out;
+        out.reserve(count);
+        size_t start = (next + samples.size() - count) % samples.size();
+        for (size_t i = 0; i < count; i++) {
+            out.push_back(samples[(start + i) % samples.size()]);
+        }
+        return out;
+    }
+};
+
+struct SampledApp {
+    std::string name;
+    ResourceRing ring;
+    pid_t lastPid = -1;
+    double lastCpuTime = 0;
+    std::chrono::steady_clock::time_point lastSampledAt;
+    // Thresholds are edge triggered, these re-arm once the value drops back below
+    bool rssOver = false;
+    bool cpuOver = false;
+};
+
+struct ResourceThresholdEvent {
+    std::string app;
+    pid_t pid;
+    std::string kind;
+    double value, threshold;
+};
+
+std::mutex resourceMutex;
+std::condition_variable resourceCondition;
+std::vector<SampledApp> sampledApps;
+std::chrono::milliseconds resourceInterval(1000);
+size_t resourceCapacity = 600;
+// 0 for no threshold
+double rssThreshold = 0;
+double cpuThreshold = 0;
+bool resourceThreadStarted = false;
+
+// Called with resourceMutex held, pid is -1 if the process couldn't be read
+void recordSample(SampledApp& app, pid_t pid, const ProcessResources& resources, std::vector<ResourceThresholdEvent>& events) {
+    if (pid == -1) {
+        app.lastPid = -1;
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    double cpu = 0;
+    if (pid == app.lastPid) {
+        double elapsed = std::chrono::duration<double>(now - app.lastSampledAt).count();
+        cpu = elapsed > 0 ? (resources.cpuTime - app.lastCpuTime) / elapsed * 100 : 0;
+    }
+    app.lastPid = pid;
+    app.lastCpuTime = resources.cpuTime;
+    app.lastSampledAt = now;
+
+    double time = std::chrono::duration<double, std::milli>(std::chrono::system_clock::now().time_since_epoch()).count();
+    app.ring.push(ResourceSample{time, pid, resources.rss, cpu, resources.cpuTime, resources.threads});
+
+    if (rssThreshold > 0 && !app.rssOver && resources.rss >= rssThreshold) {
+        events.push_back({app.name, pid, "rss", (double)resources.rss, rssThreshold});
+    }
+    app.rssOver = rssThreshold > 0 && resources.rss >= rssThreshold;
+    if (cpuThreshold > 0 && !app.cpuOver && cpu >= cpuThreshold) {
+        events.push_back({app.name, pid, "cpu", cpu, cpuThreshold});
+    }
+    app.cpuOver = cpuThreshold > 0 && cpu >= cpuThreshold;
+}
+
+void ensureResourceThread() {
+    if (resourceThreadStarted) {
+        return;
+    }
+    resourceThreadStarted = true;
+    for (auto name : {"Bitwig Studio", "Bitwig Studio Engine", "Bitwig Plug-in Host 64"}) {
+        SampledApp app;
+        app.name = name;
+        app.ring.resize(resourceCapacity);
+        sampledApps.push_back(app);
+    }
+    std::vector<std::string> names;
+    for (auto& app : sampledApps) {
+        names.push_back(app.name);
+    }
+    std::thread([names]() {
+        while (true) {
+            // Finding and reading processes happens outside the lock, so getResourceHistory
+            // never waits on the window server
+            std::vector<std::pair<pid_t, ProcessResources>> read;
+            for (auto& name : names) {
+                pid_t pid = getProcessTable().find(name);
+                ProcessResources resources;
+                if (pid != -1 && !readProcessResources(pid, resources)) {
+                    pid = -1;
+                }
+                read.push_back({pid, resources});
+            }
+
+            std::vector<ResourceThresholdEvent> events;
+            std::unique_lock<std::mutex> lock(resourceMutex);
+            for (size_t i = 0; i < sampledApps.size(); i++) {
+                recordSample(sampledApps[i], read[i].first, read[i].second, events);
+            }
+            if (events.size() > 0) {
+                lock.unlock();
+                for (auto& event : events) {
+                    emitNativeEvent("resourceThreshold", [=](Napi::Env env) -> Napi::Value {
+                        Napi::Object obj = Napi::Object::New(env);
+                        obj.Set(Napi::String::New(env, "app"), Napi::String::New(env, event.app));
+                        obj.Set(Napi::String::New(env, "pid"), Napi::Number::New(env, event.pid));
+                        obj.Set(Napi::String::New(env, "kind"), Napi::String::New(env, event.kind));
+                        obj.Set(Napi::String::New(env, "value"), Napi::Number::New(env, event.value));
+                        obj.Set(Napi::String::New(env, "threshold"), Napi::Number::New(env, event.threshold));
+                        return obj;
+                    });
+                }
+                lock.lock();
+            }
+            // Woken early when the settings change
+            resourceCondition.wait_for(lock, resourceInterval);
+        }
+    }).detach();
+}
+
+Napi::Value SetResourceSampling(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto options = info[0].As<Napi::Object>();
+    {
+        std::lock_guard<std::mutex> lock(resourceMutex);
+        if (options.Has("interval")) {
+            // Reading a handful of counters is cheap, but not worth doing more than 100 times a second
+            resourceInterval = std::chrono::milliseconds(std::max(10, options.Get("interval").As<Napi::Number>().Int32Value()));
+        }
+        if (options.Has("capacity")) {
+            resourceCapacity = std::max(1, options.Get("capacity").As<Napi::Number>().Int32Value());
+            for (auto& app : sampledApps) {
+                app.ring.resize(resourceCapacity);
+            }
+        }
+        if (options.Has("thresholds")) {
+            auto thresholds = options.Get("thresholds").As<Napi::Object>();
+            rssThreshold = thresholds.Has("rss") ? thresholds.Get("rss").As<Napi::Number>().DoubleValue() : 0;
+            cpuThreshold = thresholds.Has("cpu") ? thresholds.Get("cpu").As<Napi::Number>().DoubleValue() : 0;
+            for (auto& app : sampledApps) {
+                app.rssOver = false;
+                app.cpuOver = false;
+            }
+        }
+        ensureResourceThread();
+    }
+    resourceCondition.notify_one();
+    return env.Undefined();
+}
+
+Napi::Value GetResourceHistory(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    std::string only = info[0].IsString() ? info[0].As<Napi::String>().Utf8Value() : "";
+    std::vector<std::pair<std::string, std::vector<ResourceSample>>> histories;
+    {
+        std::lock_guard<std::mutex> lock(resourceMutex);
+        ensureResourceThread();
+        for (auto& app : sampledApps) {
+            if (only.size() == 0 || only == app.name) {
+                histories.push_back({app.name, app.ring.ordered()});
+            }
+        }
+    }
+
+    Napi::Object out = Napi::Object::New(env);
+    for (auto& history : histories) {
+        auto arr = Napi::Array::New(env, history.second.size());
+        for (size_t i = 0; i < history.second.size(); i++) {
+            auto& sample = history.second[i];
+            Napi::Object obj = Napi::Object::New(env);
+            obj.Set(Napi::String::New(env, "time"), Napi::Number::New(env, sample.time));
+            obj.Set(Napi::String::New(env, "pid"), Napi::Number::New(env, sample.pid));
+            obj.Set(Napi::String::New(env, "rss"), Napi::Number::New(env, (double)sample.rss));
+            obj.Set(Napi::String::New(env, "cpu"), Napi::Number::New(env, sample.cpu));
+            obj.Set(Napi::String::New(env, "cpuTime"), Napi::Number::New(env, sample.cpuTime));
+            obj.Set(Napi::String::New(env, "threads"), Napi::Number::New(env, sample.threads));
+            arr.Set(i, obj);
+        }
+        out.Set(Napi::String::New(env, history.first), arr);
+    }
+    return out;
+}
+
+void addResourceFunctions(Napi::Env env, Napi::Object obj) {
+    // A listener alone doesn't start sampling, there are no thresholds to cross until
+    // setResourceSampling sets some (and starts the thread)
+    registerNativeEventType("resourceThreshold");
+    obj.Set("setResourceSampling", Napi::Function::New(env, SetResourceSampling));
+    obj.Set("getResourceHistory", Napi::Function::New(env, GetResourceHistory));
+}
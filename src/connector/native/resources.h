@@ -0,0 +1,33 @@
+#pragma once
+#include <napi.h>
+#include <cstdint>
+#include <sys/types.h>
+
+/**
+ * Memory, CPU and thread count of one process, read straight from the kernel
+ */
+struct ProcessResources {
+    uint64_t rss = 0;
+    // User + system, seconds
+    double cpuTime = 0;
+    int threads = 0;
+};
+
+/**
+ * Defined per platform in bitwig.cc (proc_pidinfo on macOS, /proc on Linux). False if the
+ * process has gone or can't be read
+ */
+bool readProcessResources(pid_t pid, ProcessResources& out);
+
+/**
+ * Samples the Bitwig processes found through the process table on a background thread into
+ * fixed size ring buffers:
+ *
+ *   Bitwig.setResourceSampling({ interval = 1000, capacity = 600, thresholds: { rss, cpu } })
+ *   Bitwig.getResourceHistory(app?) -> { [app]: [{ time, pid, rss, cpu, cpuTime, threads }] }
+ *
+ * Crossing a threshold (rss in bytes, cpu in percent of one core) raises 'resourceThreshold'
+ * ({ app, pid, kind, value, threshold }) through Bitwig.on, once until it drops back below.
+ * Nothing is sampled until the first setResourceSampling or getResourceHistory call.
+ */
+void addResourceFunctions(Napi::Env env, Napi::Object obj);
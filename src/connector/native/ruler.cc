@@ -0,0 +1,267 @@
+#include "ruler.h"
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+MWColor rulerTickColor = MWColor{110, 110, 110};
+MWColor rulerSelectionColor = MWColor{72, 72, 72};
+MWColor playheadColor = MWColor{230, 230, 230};
+
+// Rows read, unscaled: ticks are drawn up from the bottom edge, the selection band along the top
+const int RULER_TICK_ROW_FROM_BOTTOM = 4;
+const int RULER_SELECTION_ROW = 8;
+const int RULER_TILE_WIDTH = 32;
+
+const uint8_t* rulerPixel(FrameImage* screenshot, int x, int y) {
+    return screenshot->data + (size_t)y * screenshot->bytesPerRow + (size_t)x * screenshot->bytesPerPixel;
+}
+
+bool rulerPixelIs(const uint8_t* bgra, MWColor color, int amount) {
+    return abs(bgra[2] - color.r) < amount && abs(bgra[1] - color.g) < amount && abs(bgra[0] - color.b) < amount;
+}
+
+int rulerTickY(const LayoutProfile& profile, const MWRect& rect) {
+    return rect.y + rect.h - profile.scale(RULER_TICK_ROW_FROM_BOTTOM);
+}
+
+int rulerSelectionY(const LayoutProfile& profile, const MWRect& rect) {
+    return rect.y + profile.scale(RULER_SELECTION_ROW);
+}
+
+bool getRulerRect(FrameImage* screenshot, const LayoutProfile& profile, const BitwigLayout& layout, int timelineStartX, MWRect& rect) {
+    if (!layout.arranger || layout.modalOpen) {
+        return false;
+    }
+    auto& arranger = layout.arranger->rect;
+    auto endX = std::min(arranger.x + arranger.w, screenshot->width);
+    rect = MWRect{
+        timelineStartX,
+        arranger.y,
+        endX - timelineStartX,
+        profile.get(ARRANGER_HEADER_HEIGHT, true)
+    };
+    return rect.w > 0 && rect.y >= 0 && rect.y + rect.h <= screenshot->height;
+}
+
+/**
+ * Ticks the playhead covers go missing, so work from the typical gap rather than the first one
+ */
+double rulerTickSpacing(const std::vector<int>& ticks) {
+    if (ticks.size() < 2) {
+        return 0;
+    }
+    std::vector<int> gaps;
+    for (size_t i = 1; i < ticks.size(); i++) {
+        gaps.push_back(ticks[i] - ticks[i - 1]);
+    }
+    std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+    auto typical = std::max(1, gaps[gaps.size() / 2]);
+    double span = ticks.back() - ticks.front();
+    return span / std::max(1.0, round(span / typical));
+}
+
+void detectRuler(FrameImage* screenshot, const LayoutProfile& profile, MWRect rect, RulerState& state) {
+    static auto& detectTime = metricHistogram("detect.ruler.time");
+    MetricTimer timer(detectTime);
+    state.rect = rect;
+    state.ticks.clear();
+    state.playheadX = -1;
+    state.selectionStart = state.selectionEnd = -1;
+
+    auto tickRow = rulerPixel(screenshot, rect.x, rulerTickY(profile, rect));
+    bool inTick = false;
+    for (int x = 0; x < rect.w; x++) {
+        auto pixel = tickRow + x * 4;
+        if (state.playheadX == -1 && rulerPixelIs(pixel, playheadColor, 12)) {
+            state.playheadX = rect.x + x;
+        }
+        bool tick = rulerPixelIs(pixel, rulerTickColor, 8);
+        if (tick && !inTick) {
+            state.ticks.push_back(rect.x + x);
+        }
+        inTick = tick;
+    }
+    state.tickSpacing = rulerTickSpacing(state.ticks);
+
+    // One band, which the playhead may be running through
+    auto selectionRow = rulerPixel(screenshot, rect.x, rulerSelectionY(profile, rect));
+    for (int x = 0; x < rect.w; x++) {
+        auto pixel = selectionRow + x * 4;
+        if (rulerPixelIs(pixel, rulerSelectionColor, 8)) {
+            if (state.selectionStart == -1) {
+                state.selectionStart = rect.x + x;
+            }
+            state.selectionEnd = rect.x + x + 1;
+        } else if (state.selectionStart != -1 && !rulerPixelIs(pixel, playheadColor, 12)) {
+            break;
+        }
+    }
+}
+
+/**
+ * RulerTracker
+ */
+void RulerTracker::hashTiles(FrameImage* screenshot, const LayoutProfile& profile, const MWRect& rect, std::vector<uint64_t>& out) {
+    out.clear();
+    auto tickRow = rulerPixel(screenshot, rect.x, rulerTickY(profile, rect));
+    auto selectionRow = rulerPixel(screenshot, rect.x, rulerSelectionY(profile, rect));
+    for (int x = 0; x < rect.w; x += RULER_TILE_WIDTH) {
+        auto bytes = (size_t)std::min(RULER_TILE_WIDTH, rect.w - x) * 4;
+        // FNV-1a a word at a time, both rows into one hash per tile
+        uint64_t hash = 14695981039346656037ull;
+        for (auto row : {tickRow, selectionRow}) {
+            size_t i = 0;
+            for (; i + 8 <= bytes; i += 8) {
+                uint64_t word;
+                memcpy(&word, row + x * 4 + i, 8);
+                hash = (hash ^ word) * 1099511628211ull;
+            }
+            for (; i < bytes; i++) {
+                hash = (hash ^ row[x * 4 + i]) * 1099511628211ull;
+            }
+        }
+        out.push_back(hash);
+    }
+}
+
+void RulerTracker::ticksChanged(const RulerState& previous) {
+    auto spacing = state.tickSpacing;
+    if (spacing == 0 || previous.tickSpacing == 0 || fabs(spacing - previous.tickSpacing) > 0.5) {
+        // Zoomed (or we can't tell), nothing we knew holds
+        transform = BeatTransform{};
+        originKnown = false;
+        tickGeneration++;
+        return;
+    }
+    // Same zoom, but moved along unless the ticks are where they were (give or take a whole tick,
+    // which we can't tell apart)
+    auto shift = fmod((double)(state.ticks.front() - previous.ticks.front()), spacing);
+    if (shift > spacing / 2) shift -= spacing;
+    if (shift < -spacing / 2) shift += spacing;
+    if (fabs(shift) > 1) {
+        originKnown = false;
+        tickGeneration++;
+    }
+}
+
+const RulerState& RulerTracker::update(FrameImage* screenshot, const LayoutProfile& profile, const BitwigLayout& layout, int timelineStartX) {
+    static auto& updateTime = metricHistogram("ruler.update.time");
+    static auto& incrementalUpdates = metricCounter("ruler.incremental");
+    static auto& fullUpdates = metricCounter("ruler.full");
+    MetricTimer timer(updateTime);
+    thread_local std::vector<uint64_t> hashes;
+
+    lastUpdateIncremental = false;
+    MWRect rect;
+    if (!getRulerRect(screenshot, profile, layout, timelineStartX, rect)) {
+        // Covered by a modal or such, what we had is still right once it's gone
+        static const RulerState none;
+        return none;
+    }
+    hashTiles(screenshot, profile, rect, hashes);
+
+    if (rect == state.rect && hashes.size() == tileHashes.size()) {
+        auto tileOf = [&](int x) {
+            return (x - rect.x) / RULER_TILE_WIDTH;
+        };
+        // Where the playhead is now, if it's in any of the tiles that changed
+        int playheadX = -1;
+        bool anyChanged = false;
+        auto tickRow = rulerPixel(screenshot, rect.x, rulerTickY(profile, rect));
+        for (size_t tile = 0; tile < hashes.size(); tile++) {
+            if (hashes[tile] == tileHashes[tile]) {
+                continue;
+            }
+            anyChanged = true;
+            auto end = std::min(rect.w, (int)(tile + 1) * RULER_TILE_WIDTH);
+            for (int x = (int)tile * RULER_TILE_WIDTH; playheadX == -1 && x < end; x++) {
+                if (rulerPixelIs(tickRow + x * 4, playheadColor, 12)) {
+                    playheadX = rect.x + x;
+                }
+            }
+        }
+        // A tile either side too, the playhead can straddle two
+        auto nearPlayhead = [&](int tile, int x) {
+            return x != -1 && abs(tile - tileOf(x)) <= 1;
+        };
+        bool onlyPlayhead = true;
+        for (size_t tile = 0; anyChanged && tile < hashes.size(); tile++) {
+            if (hashes[tile] != tileHashes[tile] && !nearPlayhead(tile, state.playheadX) && !nearPlayhead(tile, playheadX)) {
+                onlyPlayhead = false;
+                break;
+            }
+        }
+        if (onlyPlayhead) {
+            if (anyChanged) {
+                state.playheadX = playheadX;
+            }
+            tileHashes.swap(hashes);
+            lastUpdateIncremental = true;
+            incrementalUpdates.add();
+            return state;
+        }
+    }
+
+    fullUpdates.add();
+    auto previous = state;
+    detectRuler(screenshot, profile, rect, state);
+    tileHashes.swap(hashes);
+    ticksChanged(previous);
+    return state;
+}
+
+/**
+ * Ticks are bars or some power of two of beats either side of them, 3s for bars of 3/4
+ */
+bool isPlausibleBeatsPerTick(double beatsPerTick) {
+    for (double base : {1.0, 3.0}) {
+        auto exponent = round(log2(beatsPerTick / base));
+        if (fabs(beatsPerTick / (base * pow(2, exponent)) - 1) < 0.04) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RulerTracker::anchor(int x, double beat) {
+    if (state.rect.w == 0 || x < state.rect.x || x >= state.rect.x + state.rect.w) {
+        return false;
+    }
+    Anchor newAnchor{x, beat, tickGeneration};
+    if (transform.pixelsPerBeat == 0) {
+        if (!lastAnchor || lastAnchor->tickGeneration != tickGeneration || lastAnchor->x == x || lastAnchor->beat == beat) {
+            lastAnchor = newAnchor;
+            return true;
+        }
+        auto pixelsPerBeat = (x - lastAnchor->x) / (beat - lastAnchor->beat);
+        lastAnchor = newAnchor;
+        if (pixelsPerBeat <= 0 || (state.tickSpacing > 0 && !isPlausibleBeatsPerTick(state.tickSpacing / pixelsPerBeat))) {
+            return false;
+        }
+        transform.pixelsPerBeat = pixelsPerBeat;
+    } else if (originKnown && fabs(transform.xAt(beat) - x) > 2) {
+        // Doesn't agree with what we have, more likely a bad anchor than a bad transform
+        return false;
+    }
+    lastAnchor = newAnchor;
+    transform.originX = x - beat * transform.pixelsPerBeat;
+    originKnown = true;
+    return true;
+}
+
+std::experimental::optional<BeatTransform> RulerTracker::getTransform() const {
+    if (transform.pixelsPerBeat > 0 && originKnown) {
+        return transform;
+    }
+    return {};
+}
+
+void RulerTracker::reset() {
+    state = RulerState();
+    tileHashes.clear();
+    transform = BeatTransform{};
+    originKnown = false;
+    tickGeneration++;
+    lastAnchor = std::experimental::nullopt;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "detect.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * The arranger's ruler: the strip above the first track over the timeline. Bar ticks run
+ * along its bottom, the time selection (or loop) shows as a lighter band near its top, and
+ * the playhead is a bright column through it.
+ */
+struct RulerState {
+    MWRect rect{0, 0, 0, 0};
+    std::vector<int> ticks;
+    // Average pixels between ticks, 0 with fewer than two
+    double tickSpacing = 0;
+    int playheadX = -1;
+    int selectionStart = -1, selectionEnd = -1;
+};
+
+/**
+ * x = originX + beat * pixelsPerBeat, for as long as the arranger isn't scrolled or zoomed
+ */
+struct BeatTransform {
+    double originX = 0;
+    double pixelsPerBeat = 0;
+    double beatAt(double x) const {
+        return (x - originX) / pixelsPerBeat;
+    }
+    double xAt(double beat) const {
+        return originX + beat * pixelsPerBeat;
+    }
+};
+
+/**
+ * Where the ruler is, given where the track headers end. False if there's no arranger
+ */
+bool getRulerRect(FrameImage* screenshot, const LayoutProfile& profile, const BitwigLayout& layout, int timelineStartX, MWRect& rect);
+void detectRuler(FrameImage* screenshot, const LayoutProfile& profile, MWRect rect, RulerState& state);
+
+/**
+ * Keeps a window's ruler and pixel/beat transform between captures. The rows the detector reads
+ * are hashed in tiles, if the only tiles that changed are the ones the playhead left and
+ * arrived in (it's playing and nothing else moved) only the playhead is looked for again.
+ *
+ * The ruler has no idea what beat anything is, so the transform comes from anchors: a pixel
+ * known to be at a beat, like the playhead after the play start moves. Two anchors over the
+ * same ticks give the scale, after that one is enough to place it. Scrolling keeps the scale
+ * and loses the origin, zooming loses both.
+ */
+class RulerTracker {
+    RulerState state;
+    std::vector<uint64_t> tileHashes;
+    BeatTransform transform;
+    bool originKnown = false;
+    // Bumped whenever the ticks move, anchors from before don't line up with anything now
+    int tickGeneration = 0;
+    struct Anchor {
+        int x;
+        double beat;
+        int tickGeneration;
+    };
+    std::experimental::optional<Anchor> lastAnchor;
+    void hashTiles(FrameImage* screenshot, const LayoutProfile& profile, const MWRect& rect, std::vector<uint64_t>& out);
+    void ticksChanged(const RulerState& previous);
+public:
+    // Whether the last update only had to look for the playhead
+    bool lastUpdateIncremental = false;
+
+    const RulerState& update(FrameImage* screenshot, const LayoutProfile& profile, const BitwigLayout& layout, int timelineStartX);
+    // False if the anchor doesn't fit the ticks (e.g. the playhead wasn't where we were told)
+    bool anchor(int x, double beat);
+    std::experimental::optional<BeatTransform> getTransform() const;
+    const RulerState& getState() const {
+        return state;
+    }
+    void reset();
+};
@@ -1,13 +1,17 @@
 #pragma once
 #include <napi.h>
+#ifdef __APPLE__
 #include <CoreGraphics/CoreGraphics.h>
+#endif
 
 class Screenshot : public Napi::ObjectWrap<Screenshot>
 {
 public:
+#ifdef __APPLE__
     CGImageRef image;
     CFDataRef dataRef;
     CGColorSpaceRef colorSpace;
+#endif
     static Napi::Object Init(Napi::Env env, Napi::Object exports);
     Screenshot(const Napi::CallbackInfo &info);
     ~Screenshot();
@@ -0,0 +1,292 @@
+#include "sequence.h"
+#include "input.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+enum class StepType {
+    Move,
+    Down,
+    Up,
+    Click,
+    DoubleClick,
+    KeyDown,
+    KeyUp,
+    KeyPress,
+    Wait
+};
+
+struct SequenceStep {
+    StepType type;
+    int x = 0, y = 0;
+    bool hasPosition = false;
+    int button = 0;
+    std::string key;
+    InputModifiers modifiers;
+    bool modwigListeners = false;
+    // Time to leave after this step before the next one
+    std::chrono::microseconds after;
+};
+
+struct SequenceJob {
+    std::vector<SequenceStep> steps;
+    // Time between the down and up of clicks/key presses
+    std::chrono::microseconds holdFor;
+    Napi::Promise::Deferred deferred;
+    Napi::ThreadSafeFunction tsfn;
+    std::vector<double> timings;
+
+    SequenceJob(Napi::Env env) : deferred(Napi::Promise::Deferred::New(env)) {}
+};
+
+std::mutex sequenceMutex;
+std::condition_variable sequenceCondition;
+std::deque<SequenceJob*> sequenceQueue;
+bool sequenceThreadStarted = false;
+
+/**
+ * Sleep most of the way then yield-spin the rest. Targets are absolute from the start of the
+ * sequence, so wakeup latency on one step doesn't push every later step back
+ */
+void sleepUntil(Clock::time_point target) {
+    const auto spinFor = std::chrono::microseconds(500);
+    if (target - Clock::now() > spinFor) {
+        std::this_thread::sleep_until(target - spinFor);
+    }
+    while (Clock::now() < target) {
+        std::this_thread::yield();
+    }
+}
+
+void runStep(const SequenceStep& step, std::chrono::microseconds holdFor) {
+    bool isMouseStep = step.type == StepType::Down || step.type == StepType::Up
+        || step.type == StepType::Click || step.type == StepType::DoubleClick;
+    int x = step.x, y = step.y;
+    if (isMouseStep && !step.hasPosition) {
+        getMousePosition(x, y);
+    }
+    switch (step.type) {
+        case StepType::Move:
+            postMouseMove(x, y, step.modwigListeners);
+            break;
+        case StepType::Down:
+        case StepType::Up:
+            postMouseButton(step.button, step.type == StepType::Down, x, y, step.modifiers, step.modwigListeners);
+            break;
+        case StepType::Click:
+        case StepType::DoubleClick: {
+            int clicks = step.type == StepType::DoubleClick ? 2 : 1;
+            for (int i = 0; i < clicks; i++) {
+                // Second click of a double click carries the click count where the platform has one
+                bool secondClick = i == 1;
+                postMouseButton(step.button, true, x, y, step.modifiers, step.modwigListeners, secondClick);
+                sleepUntil(Clock::now() + holdFor);
+                postMouseButton(step.button, false, x, y, step.modifiers, step.modwigListeners, secondClick);
+                if (i + 1 < clicks) {
+                    sleepUntil(Clock::now() + holdFor);
+                }
+            }
+            break;
+        }
+        case StepType::KeyDown:
+        case StepType::KeyUp:
+            if (!postKey(step.key, step.type == StepType::KeyDown, step.modifiers, step.modwigListeners)) {
+                std::cout << "Sequence couldn't post key: " << step.key << std::endl;
+            }
+            break;
+        case StepType::KeyPress:
+            if (postKey(step.key, true, step.modifiers, step.modwigListeners)) {
+                sleepUntil(Clock::now() + holdFor);
+                postKey(step.key, false, step.modifiers, step.modwigListeners);
+            } else {
+                std::cout << "Sequence couldn't post key: " << step.key << std::endl;
+            }
+            break;
+        case StepType::Wait:
+            break;
+    }
+}
+
+void runJob(SequenceJob* job) {
+    auto start = Clock::now();
+    auto target = start;
+    for (auto& step : job->steps) {
+        sleepUntil(target);
+        auto stepStart = Clock::now();
+        job->timings.push_back(std::chrono::duration<double, std::milli>(stepStart - start).count());
+        runStep(step, job->holdFor);
+        // Steps that hold (clicks, key presses) take their own time, measure the gap from the end
+        target = std::max(target, Clock::now()) + step.after;
+    }
+
+    auto tsfn = job->tsfn;
+    tsfn.BlockingCall(job, [](Napi::Env env, Napi::Function, SequenceJob* job) {
+        auto timings = Napi::Array::New(env, job->timings.size());
+        for (size_t i = 0; i < job->timings.size(); i++) {
+            timings.Set(i, Napi::Number::New(env, job->timings[i]));
+        }
+        job->deferred.Resolve(timings);
+        delete job;
+    });
+    tsfn.Release();
+}
+
+void ensureSequenceThread() {
+    if (sequenceThreadStarted) {
+        return;
+    }
+    sequenceThreadStarted = true;
+    // Sequences run one at a time in the order they were queued, so two mods can't interleave
+    // their clicks
+    std::thread([]() {
+        while (true) {
+            SequenceJob* job;
+            {
+                std::unique_lock<std::mutex> lock(sequenceMutex);
+                sequenceCondition.wait(lock, [] { return !sequenceQueue.empty(); });
+                job = sequenceQueue.front();
+                sequenceQueue.pop_front();
+            }
+            runJob(job);
+        }
+    }).detach();
+}
+
+std::chrono::microseconds msOption(Napi::Object obj, const char* name, std::chrono::microseconds defaultValue) {
+    if (obj.Has(name) && obj.Get(name).IsNumber()) {
+        return std::chrono::microseconds((int64_t)(obj.Get(name).As<Napi::Number>().DoubleValue() * 1000));
+    }
+    return defaultValue;
+}
+
+bool parseStep(Napi::Object obj, SequenceStep& step, std::chrono::microseconds gap, bool modwigListeners, std::string& error) {
+    std::string type = obj.Has("type") ? obj.Get("type").ToString().Utf8Value() : "";
+    if (type == "move") {
+        step.type = StepType::Move;
+    } else if (type == "down") {
+        step.type = StepType::Down;
+    } else if (type == "up") {
+        step.type = StepType::Up;
+    } else if (type == "click") {
+        step.type = StepType::Click;
+    } else if (type == "doubleClick") {
+        step.type = StepType::DoubleClick;
+    } else if (type == "keyDown") {
+        step.type = StepType::KeyDown;
+    } else if (type == "keyUp") {
+        step.type = StepType::KeyUp;
+    } else if (type == "keyPress" || type == "key") {
+        step.type = StepType::KeyPress;
+    } else if (type == "wait") {
+        step.type = StepType::Wait;
+    } else {
+        error = "Unrecognised sequence step type: " + type;
+        return false;
+    }
+
+    step.hasPosition = obj.Has("x") && obj.Has("y");
+    if (step.hasPosition) {
+        step.x = (int)obj.Get("x").As<Napi::Number>().DoubleValue();
+        step.y = (int)obj.Get("y").As<Napi::Number>().DoubleValue();
+    } else if (step.type == StepType::Move) {
+        error = "Sequence move step needs x and y";
+        return false;
+    }
+    if (obj.Has("button")) {
+        step.button = obj.Get("button").As<Napi::Number>().Int32Value();
+    }
+    if (step.type == StepType::KeyDown || step.type == StepType::KeyUp || step.type == StepType::KeyPress) {
+        if (!obj.Has("key")) {
+            error = "Sequence " + type + " step needs a key";
+            return false;
+        }
+        step.key = obj.Get("key").ToString().Utf8Value();
+    }
+    step.modifiers.Meta = obj.Has("Meta");
+    step.modifiers.Control = obj.Has("Control");
+    step.modifiers.Shift = obj.Has("Shift");
+    step.modifiers.Alt = obj.Has("Alt");
+    step.modifiers.Fn = obj.Has("Fn");
+    step.modwigListeners = obj.Has("modwigListeners") ? obj.Get("modwigListeners").ToBoolean().Value() : modwigListeners;
+
+    if (step.type == StepType::Wait) {
+        step.after = msOption(obj, "ms", std::chrono::microseconds(0));
+    } else {
+        step.after = msOption(obj, "after", gap);
+    }
+    return true;
+}
+
+/**
+ * sequence(steps, { gap = 2, holdFor = 2, modwigListeners = false })
+ *
+ * Steps are { type: 'move' | 'down' | 'up' | 'click' | 'doubleClick' | 'keyDown' | 'keyUp' | 'keyPress' | 'key' | 'wait' }
+ * with x, y, button, key, Meta/Shift/Control/Alt/Fn as in the single event functions, plus
+ * `after` to override the gap following it, or `ms` for waits. Mouse steps without x/y use
+ * wherever the pointer is when the step runs
+ */
+Napi::Value Sequence(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto job = new SequenceJob(env);
+    auto promise = job->deferred.Promise();
+
+    // Defaults match the sleeps in the single event functions
+    auto gap = std::chrono::microseconds(2000);
+    job->holdFor = std::chrono::microseconds(2000);
+    bool modwigListeners = false;
+    if (info[1].IsObject()) {
+        Napi::Object options = info[1].As<Napi::Object>();
+        gap = msOption(options, "gap", gap);
+        job->holdFor = msOption(options, "holdFor", job->holdFor);
+        modwigListeners = options.Has("modwigListeners") && options.Get("modwigListeners").ToBoolean().Value();
+    }
+
+    if (!info[0].IsArray()) {
+        job->deferred.Reject(Napi::TypeError::New(env, "Sequence expects an array of steps").Value());
+        delete job;
+        return promise;
+    }
+    Napi::Array steps = info[0].As<Napi::Array>();
+    for (uint32_t i = 0; i < steps.Length(); i++) {
+        Napi::Value value = steps.Get(i);
+        SequenceStep step;
+        std::string error;
+        if (!value.IsObject()) {
+            error = "Sequence step " + std::to_string(i) + " isn't an object";
+        } else if (!parseStep(value.As<Napi::Object>(), step, gap, modwigListeners, error)) {
+            error = "Step " + std::to_string(i) + ": " + error;
+        }
+        if (error.size() > 0) {
+            // Nothing has been posted yet, so a bad step rejects the whole sequence
+            job->deferred.Reject(Napi::TypeError::New(env, error).Value());
+            delete job;
+            return promise;
+        }
+        job->steps.push_back(step);
+    }
+
+    job->tsfn = Napi::ThreadSafeFunction::New(
+        env,
+        Napi::Function::New(env, [](const Napi::CallbackInfo&) {}),
+        "Input Sequence",
+        0, // Unlimited queue
+        1 // Initial thread count
+    );
+
+    {
+        std::lock_guard<std::mutex> lock(sequenceMutex);
+        ensureSequenceThread();
+        sequenceQueue.push_back(job);
+    }
+    sequenceCondition.notify_one();
+    return promise;
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <napi.h>
+
+/**
+ * Runs a list of synthetic input steps on a dedicated thread so the gaps between them
+ * don't depend on the JS event loop. Exposed as both Mouse.sequence and Keyboard.sequence,
+ * returns a Promise resolved with the time (ms from start) each step was posted.
+ */
+Napi::Value Sequence(const Napi::CallbackInfo &info);
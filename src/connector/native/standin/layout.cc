@@ -0,0 +1,495 @@
+#include "layout.h"
+#include <algorithm>
+#include <cmath>
+
+struct StandinColor {
+    uint8_t r, g, b;
+};
+
+// Mirrors the colours in ui.cc
+const StandinColor
+    background = {44, 44, 44},
+    header = {50, 50, 50},
+    footer = {40, 40, 40},
+    inspector = {58, 58, 58},
+    timeline = {48, 48, 48},
+    editor = {52, 52, 52},
+    panelBorder = {104, 104, 104},
+    panelOpenIcon = {236, 113, 37},
+    panelIcon = {150, 150, 150},
+    automationIcon = {253, 115, 42},
+    modalBg = {35, 35, 35},
+    trackColor = {68, 68, 68},
+    trackSelectedColor = {141, 141, 141},
+    trackAutomationBg = {34, 34, 34},
+    automationLaneDivider = {24, 24, 24},
+    clipHeader = {217, 120, 46},
+    clipBody = {120, 82, 52},
+    clipEdge = {30, 22, 16},
+    rulerBg = {38, 38, 38},
+    rulerTick = {110, 110, 110},
+    rulerSelection = {72, 72, 72},
+    playhead = {230, 230, 230},
+    buttonBox = {40, 40, 40},
+    buttonGlyph = {200, 200, 200},
+    buttonGlyphOn = {30, 30, 30},
+    mutedBox = {242, 170, 40},
+    soloedBox = {236, 222, 60},
+    armedBox = {230, 70, 60},
+    deviceHeader = {82, 82, 82},
+    deviceHeaderSelected = {118, 118, 118},
+    deviceBody = {62, 62, 62},
+    scrollTrack = {44, 44, 44},
+    scrollThumb = {96, 96, 96},
+    mixerStrip = {70, 70, 70},
+    mixerStripSelected = {100, 100, 100},
+    mixerWell = {22, 22, 22},
+    faderCap = {180, 180, 180},
+    meterLevel = {80, 200, 90},
+    trackDivider = {6, 6, 6};
+
+// Mirrors the glyphs in headercontrols.cc, buttons are the whole box
+const char* const muteGlyph[] = {
+    ".............",
+    ".............",
+    "....#...#....",
+    "....##.##....",
+    "....#.#.#....",
+    "....#...#....",
+    "....#...#....",
+    "....#...#....",
+    "....#...#....",
+    ".............",
+    ".............",
+};
+const char* const soloGlyph[] = {
+    ".............",
+    ".............",
+    ".....###.....",
+    "....#...#....",
+    "....#........",
+    ".....###.....",
+    "........#....",
+    "....#...#....",
+    ".....###.....",
+    ".............",
+    ".............",
+};
+const char* const armGlyph[] = {
+    ".............",
+    ".............",
+    ".............",
+    ".....###.....",
+    "....#####....",
+    "....#####....",
+    "....#####....",
+    ".....###.....",
+    ".............",
+    ".............",
+    ".............",
+};
+const char* const foldedGlyph[] = {
+    ".........",
+    "...#.....",
+    "...##....",
+    "...###...",
+    "...####..",
+    "...###...",
+    "...##....",
+    "...#.....",
+    ".........",
+};
+const char* const unfoldedGlyph[] = {
+    ".........",
+    ".........",
+    ".........",
+    ".#######.",
+    "..#####..",
+    "...###...",
+    "....#....",
+    ".........",
+    ".........",
+};
+
+// Mirrors the glyphs in footerpanels.cc
+const char* const devicePanelGlyph[] = {
+    "...#####...",
+    "..#.....#..",
+    ".#.......#.",
+    "#.........#",
+    "#....#....#",
+    "#....#....#",
+    "#.........#",
+    ".#.......#.",
+    "..#.....#..",
+    "...#####...",
+};
+const char* const mixerPanelGlyph[] = {
+    ".#...#...#.",
+    ".#...#...#.",
+    "###..#...#.",
+    ".#...#..###",
+    ".#...#...#.",
+    ".#..###..#.",
+    ".#...#...#.",
+    ".#...#...#.",
+    ".#...#...#.",
+    "###########",
+};
+const char* const automationPanelGlyph[] = {
+    "..........#",
+    ".........#.",
+    "........#..",
+    ".......#...",
+    "......#....",
+    ".....#.....",
+    "....#......",
+    "...#.......",
+    "..#........",
+    "###########",
+};
+const char* const detailPanelGlyph[] = {
+    "###########",
+    "#.........#",
+    "#.###.....#",
+    "#.........#",
+    "#.........#",
+    "#....####.#",
+    "#.........#",
+    "#.##......#",
+    "#.........#",
+    "###########",
+};
+
+struct Painter {
+    uint8_t* pixels;
+    size_t bytesPerRow;
+    int width, height;
+    float scale;
+    int clipTop = 0; // Nothing is painted above this row
+
+    int s(int value) const {
+        return (int)round((float)value * scale);
+    }
+
+    void fill(int x, int y, int w, int h, StandinColor color) {
+        int x0 = std::max(0, x), y0 = std::max(clipTop, y);
+        int x1 = std::min(width, x + w), y1 = std::min(height, y + h);
+        for (int py = y0; py < y1; py++) {
+            uint8_t* row = pixels + py * bytesPerRow;
+            for (int px = x0; px < x1; px++) {
+                row[px * 4 + 0] = color.b;
+                row[px * 4 + 1] = color.g;
+                row[px * 4 + 2] = color.r;
+                row[px * 4 + 3] = 255;
+            }
+        }
+    }
+
+    // Each '#' in rows as a scaled pixel with its top left at x, y
+    template <size_t N>
+    void glyph(int x, int y, const char* const (&rows)[N], StandinColor color) {
+        for (size_t row = 0; row < N; row++) {
+            for (int col = 0; rows[row][col]; col++) {
+                if (rows[row][col] == '#') {
+                    fill(x + s(col), y + s(row), s(col + 1) - s(col), s(row + 1) - s(row), color);
+                }
+            }
+        }
+    }
+
+    // Box and glyph centred on a point, an engaged button is coloured with a dark glyph
+    template <size_t N>
+    void button(int centerX, int centerY, const char* const (&rows)[N], bool on, StandinColor onColor) {
+        int w = s(13), h = s(11);
+        int x = centerX - w / 2, y = centerY - h / 2;
+        fill(x, y, w, h, on ? onColor : buttonBox);
+        glyph(x, y, rows, on ? buttonGlyphOn : buttonGlyph);
+    }
+
+    // Centered on a point measured from the bottom left, like MWRect::fromBottomLeft
+    void icon(int fromLeft, int fromBottom, StandinColor color) {
+        fill(s(fromLeft) - s(3), height - s(fromBottom) - s(3), s(7), s(7), color);
+    }
+
+    // A footer panel toggle centred the same way, lit in the middle so a single pixel at the
+    // centre tells open from closed too
+    template <size_t N>
+    void panelIcon(int fromLeft, int fromBottom, const char* const (&rows)[N], bool open) {
+        glyph(s(fromLeft) - s(5), height - s(fromBottom) - s(5), rows, open ? panelOpenIcon : ::panelIcon);
+    }
+};
+
+std::vector<StandinClip> makeStandinClips(int count, uint32_t seed) {
+    std::vector<StandinClip> clips;
+    int x = 0;
+    for (int i = 0; i < count; i++) {
+        seed = seed * 1664525 + 1013904223;
+        // Mostly back to back, like a recorded part, sometimes with a gap
+        x += (seed >> 8) % 3 == 0 ? 10 + (seed >> 12) % 60 : 0;
+        int length = 16 + (seed >> 16) % 120;
+        clips.push_back(StandinClip{x, length});
+        x += length;
+    }
+    return clips;
+}
+
+std::vector<StandinDevice> makeStandinDevices(int count) {
+    std::vector<StandinDevice> devices(count);
+    for (int i = 0; i < count; i++) {
+        devices[i].width = 120 + (i * 7 % 5) * 45;
+    }
+    return devices;
+}
+
+/**
+ * Devices left to right inside the device panel, each a header band over a darker body or, when
+ * collapsed, one narrow header coloured strip. A scrollbar along the bottom when they don't fit
+ */
+void drawStandinDevices(Painter& p, const StandinLayout& layout, const StandinGeometry& g) {
+    auto left = g.editor.x + p.s(4), right = g.editor.x + g.editor.w - p.s(4);
+    auto bottom = g.editor.y + g.editor.h;
+    auto fillClipped = [&](int x, int y, int w, int h, StandinColor color) {
+        auto x0 = std::max(x, left), x1 = std::min(x + w, right);
+        if (x1 > x0) {
+            p.fill(x0, y, x1 - x0, h, color);
+        }
+    };
+    auto stripBottom = bottom - p.s(12);
+    for (size_t i = 0; i < g.devices.size(); i++) {
+        auto& device = layout.devices[i];
+        auto& rect = g.devices[i];
+        fillClipped(rect.x, rect.y, rect.w, rect.h, device.selected ? deviceHeaderSelected : deviceHeader);
+        if (!device.collapsed) {
+            fillClipped(rect.x, rect.y + rect.h, rect.w, stripBottom - rect.y - rect.h, deviceBody);
+        }
+    }
+    auto& thumb = g.deviceScrollThumb;
+    if (thumb.w > 0) {
+        p.fill(left, thumb.y, right - left, thumb.h, scrollTrack);
+        p.fill(thumb.x, thumb.y, thumb.w, thumb.h, scrollThumb);
+    }
+}
+
+std::vector<StandinStrip> makeStandinStrips(int count) {
+    std::vector<StandinStrip> strips(count);
+    for (int i = 0; i < count; i++) {
+        strips[i].level = (float)(i * 37 % 100) / 100;
+        strips[i].fader = 0.3f + (float)(i * 13 % 7) / 10;
+    }
+    return strips;
+}
+
+/**
+ * Channel strips left to right inside the mixer panel, each with a dark fader track and meter
+ * running most of the way down. Strips that don't fit aren't drawn
+ */
+void drawStandinMixer(Painter& p, const StandinLayout& layout, const StandinGeometry& g) {
+    auto capHeight = p.s(6);
+    for (size_t i = 0; i < g.strips.size(); i++) {
+        auto& strip = layout.strips[i];
+        auto& rect = g.strips[i];
+        auto& meter = g.meters[i];
+        auto wellTop = meter.y, wellHeight = meter.h, wellBottom = meter.y + meter.h;
+        p.fill(rect.x, rect.y, rect.w, rect.h, strip.selected ? mixerStripSelected : mixerStrip);
+        p.fill(rect.x + p.s(4), wellTop, p.s(4), wellHeight, mixerWell);
+        auto capY = wellBottom - capHeight - (int)(std::min(1.f, std::max(0.f, strip.fader)) * (wellHeight - capHeight));
+        p.fill(rect.x + p.s(1), capY, p.s(10), capHeight, faderCap);
+        auto lit = (int)(std::min(1.f, std::max(0.f, strip.level)) * wellHeight);
+        p.fill(meter.x, wellTop, meter.w, wellHeight - lit, mixerWell);
+        p.fill(meter.x, wellBottom - lit, meter.w, lit, meterLevel);
+    }
+}
+
+StandinGeometry standinGeometry(const StandinLayout& layout) {
+    auto s = [&](int value) {
+        return (int)round((float)value * layout.scale);
+    };
+    StandinGeometry g;
+    int w = layout.width, h = layout.height;
+    if (layout.modalOpen) {
+        return g;
+    }
+    auto headerHeight = s(w <= 1440 ? 83 + 48 : 83);
+    auto footerHeight = s(36);
+    auto arrangerStartX = s(layout.inspectorOpen ? 170 : 4);
+    auto arrangerBottom = h - footerHeight;
+    if (layout.panel != "") {
+        // Editor panel sits below the arranger, each with its own 1px border and a small gap
+        auto panelTop = h - footerHeight - s(layout.panelHeight);
+        g.editor = StandinRect{arrangerStartX, panelTop, w - arrangerStartX, h - footerHeight - panelTop};
+        arrangerBottom = panelTop - s(5);
+        // What's in the panel is inset from its sides and starts under the border
+        auto left = arrangerStartX + s(4), top = panelTop + 1, right = w - s(4), bottom = h - footerHeight;
+        if (layout.panel == "device") {
+            auto stripBottom = bottom - s(12);
+            auto total = s(4);
+            auto x = left + s(4) - s(layout.deviceScroll);
+            for (auto& device : layout.devices) {
+                auto deviceW = device.collapsed ? s(26) : s(device.width);
+                auto headerH = device.collapsed ? stripBottom - top - s(4) : s(22);
+                g.devices.push_back(StandinRect{x, top + s(4), deviceW, headerH});
+                x += deviceW + s(6);
+                total += deviceW + s(6);
+            }
+            auto visible = right - left;
+            if (total > visible) {
+                auto thumbX = left + (int)((long)visible * s(layout.deviceScroll) / total);
+                g.deviceScrollThumb = StandinRect{thumbX, bottom - s(8), std::max(1, (int)((long)visible * visible / total)), s(4)};
+            }
+        } else if (layout.panel == "mixer") {
+            auto stripWidth = s(layout.stripWidth);
+            auto wellTop = top + s(40), wellBottom = bottom - s(30);
+            auto x = left + s(4);
+            for (size_t i = 0; i < layout.strips.size() && x + stripWidth <= right; i++) {
+                g.strips.push_back(StandinRect{x, top + s(4), stripWidth, bottom - top - s(8)});
+                g.meters.push_back(StandinRect{x + stripWidth - s(10), wellTop, s(6), wellBottom - wellTop});
+                x += stripWidth + s(2);
+            }
+        }
+    }
+
+    g.arranger = StandinRect{arrangerStartX, headerHeight, w - arrangerStartX - s(28), arrangerBottom - headerHeight};
+    g.tracksTop = headerHeight + s(45);
+    g.tracksBottom = arrangerBottom - s(26);
+    g.trackWidth = s(layout.trackWidth);
+    g.timelineX = arrangerStartX + g.trackWidth + s(2);
+    g.timelineEnd = g.arranger.x + g.arranger.w;
+    auto y = g.tracksTop - s(layout.scroll);
+    for (auto& track : layout.tracks) {
+        if (y >= g.tracksBottom) {
+            break;
+        }
+        g.tracks.push_back(StandinRect{arrangerStartX, y, g.trackWidth, s(track.height)});
+        y += s(track.height);
+    }
+    return g;
+}
+
+void drawStandinLayout(const StandinLayout& layout, uint8_t* pixels, size_t bytesPerRow) {
+    Painter p{pixels, bytesPerRow, layout.width, layout.height, layout.scale};
+    int w = layout.width, h = layout.height;
+    auto g = standinGeometry(layout);
+
+    if (layout.modalOpen) {
+        p.fill(0, 0, w, h, modalBg);
+        return;
+    }
+
+    auto headerHeight = g.arranger.y;
+    auto footerHeight = p.s(36);
+    p.fill(0, 0, w, h, background);
+    p.fill(0, 0, w, headerHeight, header);
+    p.fill(0, h - footerHeight, w, footerHeight, footer);
+
+    auto arrangerStartX = g.arranger.x;
+    if (layout.inspectorOpen) {
+        p.fill(0, headerHeight, arrangerStartX, h - headerHeight - footerHeight, inspector);
+        p.icon(20, 17, panelOpenIcon);
+    }
+
+    p.panelIcon(276, 20, devicePanelGlyph, layout.panel == "device");
+    p.panelIcon(309, 20, mixerPanelGlyph, layout.panel == "mixer");
+    p.panelIcon(250, 20, automationPanelGlyph, layout.panel == "automation");
+    p.panelIcon(224, 18, detailPanelGlyph, layout.panel == "detail");
+    if (layout.panel != "") {
+        auto& panel = g.editor;
+        p.fill(panel.x, panel.y, panel.w, panel.h, editor);
+        p.fill(panel.x, panel.y, panel.w, 1, panelBorder);
+        if (layout.panel == "device") {
+            drawStandinDevices(p, layout, g);
+        } else if (layout.panel == "mixer") {
+            drawStandinMixer(p, layout, g);
+        }
+        p.fill(arrangerStartX, g.arranger.y + g.arranger.h, w - arrangerStartX, 1, panelBorder);
+    }
+
+    // Arranger, ruler and then the track list
+    auto arrangerW = g.arranger.w;
+    p.fill(arrangerStartX, headerHeight, arrangerW, g.arranger.h, timeline);
+    auto tracksTop = g.tracksTop;
+    auto tracksBottom = g.tracksBottom;
+    auto trackWidth = g.trackWidth;
+    auto dividerX = arrangerStartX + trackWidth;
+
+    // Everything below the last track is empty (divider coloured) in the header column
+    p.fill(arrangerStartX, tracksTop, trackWidth, tracksBottom - tracksTop, trackDivider);
+    p.fill(dividerX, headerHeight, p.s(2), tracksBottom - headerHeight, trackDivider);
+
+    // Ruler over the timeline: bar ticks along the bottom, the time selection along the top
+    auto timelineX = g.timelineX, timelineEnd = g.timelineEnd;
+    p.fill(timelineX, headerHeight, timelineEnd - timelineX, tracksTop - headerHeight, rulerBg);
+    if (layout.selectionStart != -1) {
+        auto startX = timelineX + p.s(layout.selectionStart - layout.timelineScroll);
+        auto endX = std::min(timelineEnd, timelineX + p.s(layout.selectionEnd - layout.timelineScroll));
+        p.fill(std::max(timelineX, startX), headerHeight + p.s(3), endX - std::max(timelineX, startX), p.s(10), rulerSelection);
+    }
+    auto barWidth = std::max(4, layout.barWidth);
+    for (int bar = -(layout.timelineScroll % barWidth); timelineX + p.s(bar) < timelineEnd; bar += barWidth) {
+        if (bar >= 0) {
+            p.fill(timelineX + p.s(bar), tracksTop - p.s(10), p.s(1), p.s(10), rulerTick);
+        }
+    }
+
+    // Tracks scrolled above the ruler are clipped, like the first track's header in Bitwig
+    p.clipTop = tracksTop;
+    for (size_t i = 0; i < g.tracks.size(); i++) {
+        auto& track = layout.tracks[i];
+        auto y = g.tracks[i].y, trackH = g.tracks[i].h;
+        // A taller track's header grows with it, unless lanes are open below a standard one
+        auto headerH = track.automationOpen ? std::min(trackH, p.s(45)) : trackH;
+        auto bg = track.selected ? trackSelectedColor : trackColor;
+        p.fill(arrangerStartX, y + 1, trackWidth, headerH - 1, bg);
+        if (track.automationOpen) {
+            p.fill(arrangerStartX, y + headerH, trackWidth, trackH - headerH, trackAutomationBg);
+            p.fill(dividerX - p.s(21) - p.s(2), y + p.s(33) - p.s(2), p.s(5), p.s(5), automationIcon);
+            // Every lane after the first starts with a divider the width of the arranger
+            auto lanes = std::max(1, track.automationLanes);
+            for (int lane = 1; lane < lanes; lane++) {
+                p.fill(arrangerStartX, y + headerH + (trackH - headerH) * lane / lanes, arrangerW, 1, automationLaneDivider);
+            }
+        }
+        // Buttons along the top right of the header and the fold arrow below the name, where
+        // hoverSolo.js and toggleExpandedWithMouse used to guess they were
+        auto buttonY = y + p.s(10);
+        p.button(dividerX - p.s(30), buttonY, muteGlyph, track.muted, mutedBox);
+        p.button(dividerX - p.s(54), buttonY, soloGlyph, track.soloed, soloedBox);
+        if (track.group) {
+            auto foldX = arrangerStartX + p.s(10) - p.s(4), foldY = y + p.s(32) - p.s(4);
+            if (track.unfolded) {
+                p.glyph(foldX, foldY, unfoldedGlyph, buttonGlyph);
+            } else {
+                p.glyph(foldX, foldY, foldedGlyph, buttonGlyph);
+            }
+        } else {
+            p.button(dividerX - p.s(78), buttonY, armGlyph, track.armed, armedBox);
+        }
+        // Clips fill the track's own row on the timeline, name strip on top and a dark edge
+        // where one clip meets the next
+        for (auto& clip : track.clips) {
+            auto clipX = timelineX + p.s(clip.start);
+            // Scaling the end rather than the length, so back to back clips don't overlap by a
+            // rounded pixel and paint over the edge between them
+            auto clipW = std::min(timelineX + p.s(clip.start + clip.length), timelineEnd) - clipX;
+            if (clipW <= 0) {
+                break;
+            }
+            p.fill(clipX, y + 1, clipW, headerH - 1, clipBody);
+            p.fill(clipX, y + 1, clipW, p.s(12), clipHeader);
+            p.fill(clipX + clipW - 1, y + 1, 1, headerH - 1, clipEdge);
+        }
+        // Divider at the top of each track runs the width of the arranger
+        p.fill(arrangerStartX, y, arrangerW, 1, trackDivider);
+    }
+    auto tracksEnd = g.tracks.empty() ? tracksTop - p.s(layout.scroll) : g.tracks.back().y + g.tracks.back().h;
+    p.fill(arrangerStartX, std::min(tracksEnd, tracksBottom), arrangerW, 1, trackDivider);
+    p.clipTop = 0;
+
+    // Playhead runs down from the ruler through every track
+    if (layout.playhead != -1) {
+        auto playheadX = timelineX + p.s(layout.playhead - layout.timelineScroll);
+        if (playheadX >= timelineX && playheadX < timelineEnd) {
+            p.fill(playheadX, headerHeight, p.s(1), tracksBottom - headerHeight, playhead);
+        }
+    }
+}
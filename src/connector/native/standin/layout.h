@@ -0,0 +1,106 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Paints a Bitwig-like window into a BGRA buffer, using the same colours and offsets that
+ * ui.cc looks for. Used by the X11 stand-in window so the addon can be exercised under Xvfb
+ * without Bitwig. Only "Single Display (Large)" with large track heights is drawn.
+ */
+struct StandinClip {
+    int start, length; // Unscaled, from the start of the timeline
+};
+
+struct StandinTrack {
+    int height = 45; // Unscaled, including the divider line at the top
+    bool selected = false;
+    bool automationOpen = false;
+    int automationLanes = 1; // Split evenly over whatever height is below the header
+    bool muted = false, soloed = false, armed = false;
+    bool group = false, unfolded = true; // Groups have a fold arrow and no arm button
+    std::vector<StandinClip> clips;
+};
+
+struct StandinDevice {
+    int width = 180; // Unscaled, collapsed devices are a narrow strip whatever this is
+    bool collapsed = false;
+    bool selected = false;
+};
+
+struct StandinStrip {
+    bool selected = false;
+    float level = 0; // Meter, 0 to 1
+    float fader = 0.75; // 0 at the bottom to 1 at the top
+};
+
+struct StandinLayout {
+    int width = 1600, height = 1000; // Pixels
+    float scale = 1;
+    bool modalOpen = false;
+    bool inspectorOpen = true;
+    std::string panel = ""; // "", "device", "mixer", "automation" or "detail"
+    int panelHeight = 300;
+    int trackWidth = 260;
+    int scroll = 0; // Unscaled pixels the track list is scrolled down by
+    // Ruler, all unscaled and measured from the start of the timeline
+    int barWidth = 80;
+    int timelineScroll = 0;
+    int selectionStart = -1, selectionEnd = -1;
+    int playhead = -1;
+    std::vector<StandinTrack> tracks;
+    // Device panel contents, scrolled by deviceScroll unscaled pixels
+    std::vector<StandinDevice> devices;
+    int deviceScroll = 0;
+    // Mixer panel channel strips, stripWidth unscaled
+    std::vector<StandinStrip> strips;
+    int stripWidth = 64;
+};
+
+/**
+ * count clips of varying lengths and gaps, the same for the same seed
+ */
+std::vector<StandinClip> makeStandinClips(int count, uint32_t seed);
+
+/**
+ * count devices of varying widths, none collapsed or selected
+ */
+std::vector<StandinDevice> makeStandinDevices(int count);
+
+/**
+ * count strips with varying meter levels and fader positions, none selected
+ */
+std::vector<StandinStrip> makeStandinStrips(int count);
+
+struct StandinRect {
+    int x = 0, y = 0, w = 0, h = 0;
+};
+
+/**
+ * Where drawStandinLayout paints things, in pixels, so what's detected can be checked against
+ * what was drawn. Everything is empty with a modal open
+ */
+struct StandinGeometry {
+    // Track headers, ruler and timeline, down to the editor panel's gap or the footer
+    StandinRect arranger;
+    // With its top border, empty with no panel open
+    StandinRect editor;
+    // Track rows run from tracksTop to tracksBottom, anything past them isn't painted
+    int tracksTop = 0, tracksBottom = 0;
+    int trackWidth = 0;
+    // The timeline, right of the track headers
+    int timelineX = 0, timelineEnd = 0;
+    // Each track that's drawn at all, header and lanes, before clipping to the track rows
+    std::vector<StandinRect> tracks;
+    // Each device's header band (the whole strip when collapsed), before clipping to the panel
+    std::vector<StandinRect> devices;
+    // Empty when every device fits
+    StandinRect deviceScrollThumb;
+    // Each channel strip that fits and the meter well down its right side
+    std::vector<StandinRect> strips, meters;
+};
+
+StandinGeometry standinGeometry(const StandinLayout& layout);
+
+void drawStandinLayout(const StandinLayout& layout, uint8_t* pixels, size_t bytesPerRow);
@@ -0,0 +1,276 @@
+#include "layout.h"
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+#include <sys/select.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Stand-in for Bitwig when running under Xvfb. Opens a "Bitwig Studio" window drawn by
+ * drawStandinLayout, plus optional "Bitwig Plug-in Host 64" windows, then reads commands
+ * from stdin so scripts can change the layout:
+ * 
+ *   panel <device|mixer|detail|none>
+ *   inspector <on|off>
+ *   modal <on|off>
+ *   tracks <count>
+ *   select <index>
+ *   automation <index> <on|off> [lanes]
+ *   scroll <pixels>
+ *   clips <index> <count>
+ *   button <index> <mute|solo|arm> <on|off>
+ *   group <index> <folded|unfolded|off>
+ *   devices <count> [scroll]
+ *   device <index> <collapsed|expanded|selected>
+ *   strips <count> [width]
+ *   strip <index> <selected|level <0-1>|fader <0-1>>
+ *   ruler <bar width> <timeline scroll>
+ *   selection <start> <end>|none
+ *   playhead <x>|none
+ *   activate <main|plugin N|none>
+ *   quit
+ * 
+ * Each command is answered with "ok" once the window has been redrawn.
+ */
+
+struct StandinWindow {
+    Display* display;
+    Window window;
+    XImage* image;
+};
+
+void setOwner(Display* display, Window window, const char* owner, const char* title) {
+    XClassHint hint;
+    hint.res_name = (char*)owner;
+    hint.res_class = (char*)owner;
+    XSetClassHint(display, window, &hint);
+    XStoreName(display, window, title);
+    Atom utf8 = XInternAtom(display, "UTF8_STRING", False);
+    XChangeProperty(display, window, XInternAtom(display, "_NET_WM_NAME", False), utf8, 8, PropModeReplace, (const unsigned char*)title, strlen(title));
+    unsigned long pid = getpid();
+    XChangeProperty(display, window, XInternAtom(display, "_NET_WM_PID", False), XA_CARDINAL, 32, PropModeReplace, (const unsigned char*)&pid, 1);
+}
+
+void redraw(StandinWindow& standin, const StandinLayout& layout) {
+    drawStandinLayout(layout, (uint8_t*)standin.image->data, standin.image->bytes_per_line);
+    XPutImage(standin.display, standin.window, DefaultGC(standin.display, DefaultScreen(standin.display)), standin.image, 0, 0, 0, 0, layout.width, layout.height);
+    XSync(standin.display, False);
+}
+
+/**
+ * Sets _NET_ACTIVE_WINDOW on the root the way a window manager would, there isn't one under Xvfb
+ */
+void setActiveWindow(Display* display, Window window) {
+    unsigned long value = window;
+    XChangeProperty(display, DefaultRootWindow(display), XInternAtom(display, "_NET_ACTIVE_WINDOW", False), XA_WINDOW, 32, PropModeReplace, (const unsigned char*)&value, 1);
+}
+
+void setTrackCount(StandinLayout& layout, int count) {
+    layout.tracks.resize(count);
+    for (auto& track : layout.tracks) {
+        track.height = track.automationOpen ? 45 + 60 * track.automationLanes : 45;
+    }
+}
+
+bool runCommand(StandinLayout& layout, StandinWindow& standin, const std::vector<Window>& pluginWindows, const std::string& line) {
+    std::istringstream in(line);
+    std::string command, arg, arg2;
+    in >> command >> arg >> arg2;
+    if (command == "panel") {
+        layout.panel = arg == "none" ? "" : arg;
+    } else if (command == "inspector") {
+        layout.inspectorOpen = arg == "on";
+    } else if (command == "modal") {
+        layout.modalOpen = arg == "on";
+    } else if (command == "tracks") {
+        setTrackCount(layout, atoi(arg.c_str()));
+    } else if (command == "select") {
+        int index = atoi(arg.c_str());
+        for (size_t i = 0; i < layout.tracks.size(); i++) {
+            layout.tracks[i].selected = (int)i == index;
+        }
+    } else if (command == "automation") {
+        int index = atoi(arg.c_str());
+        if (index >= 0 && index < (int)layout.tracks.size()) {
+            layout.tracks[index].automationOpen = arg2 == "on";
+            std::string lanes;
+            if (in >> lanes) {
+                layout.tracks[index].automationLanes = std::max(1, atoi(lanes.c_str()));
+            }
+            setTrackCount(layout, layout.tracks.size());
+        }
+    } else if (command == "clips") {
+        int index = atoi(arg.c_str());
+        if (index >= 0 && index < (int)layout.tracks.size()) {
+            layout.tracks[index].clips = makeStandinClips(std::max(0, atoi(arg2.c_str())), index);
+        }
+    } else if (command == "button") {
+        int index = atoi(arg.c_str());
+        std::string state;
+        in >> state;
+        if (index >= 0 && index < (int)layout.tracks.size()) {
+            auto& track = layout.tracks[index];
+            auto& button = arg2 == "mute" ? track.muted : arg2 == "solo" ? track.soloed : track.armed;
+            button = state == "on";
+        }
+    } else if (command == "group") {
+        int index = atoi(arg.c_str());
+        if (index >= 0 && index < (int)layout.tracks.size()) {
+            layout.tracks[index].group = arg2 != "off";
+            layout.tracks[index].unfolded = arg2 == "unfolded";
+        }
+    } else if (command == "devices") {
+        layout.devices = makeStandinDevices(std::max(0, atoi(arg.c_str())));
+        layout.deviceScroll = std::max(0, atoi(arg2.c_str()));
+    } else if (command == "device") {
+        int index = atoi(arg.c_str());
+        if (index >= 0 && index < (int)layout.devices.size()) {
+            if (arg2 == "selected") {
+                for (size_t i = 0; i < layout.devices.size(); i++) {
+                    layout.devices[i].selected = (int)i == index;
+                }
+            } else {
+                layout.devices[index].collapsed = arg2 == "collapsed";
+            }
+        }
+    } else if (command == "strips") {
+        layout.strips = makeStandinStrips(std::max(0, atoi(arg.c_str())));
+        if (arg2 != "") {
+            layout.stripWidth = std::max(24, atoi(arg2.c_str()));
+        }
+    } else if (command == "strip") {
+        int index = atoi(arg.c_str());
+        if (index >= 0 && index < (int)layout.strips.size()) {
+            if (arg2 == "selected") {
+                for (size_t i = 0; i < layout.strips.size(); i++) {
+                    layout.strips[i].selected = (int)i == index;
+                }
+            } else {
+                float value = 0;
+                in >> value;
+                (arg2 == "level" ? layout.strips[index].level : layout.strips[index].fader) = value;
+            }
+        }
+    } else if (command == "ruler") {
+        layout.barWidth = std::max(4, atoi(arg.c_str()));
+        layout.timelineScroll = std::max(0, atoi(arg2.c_str()));
+    } else if (command == "selection") {
+        layout.selectionStart = arg == "none" ? -1 : atoi(arg.c_str());
+        layout.selectionEnd = arg == "none" ? -1 : atoi(arg2.c_str());
+    } else if (command == "playhead") {
+        layout.playhead = arg == "none" ? -1 : atoi(arg.c_str());
+    } else if (command == "scroll") {
+        layout.scroll = std::max(0, atoi(arg.c_str()));
+    } else if (command == "activate") {
+        Window window = None;
+        if (arg == "main") {
+            window = standin.window;
+        } else if (arg == "plugin") {
+            int index = atoi(arg2.c_str()) - 1;
+            if (index >= 0 && index < (int)pluginWindows.size()) {
+                window = pluginWindows[index];
+            }
+        }
+        setActiveWindow(standin.display, window);
+    } else if (command == "quit") {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    StandinLayout layout;
+    int trackCount = 8, pluginCount = 0;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() { return i + 1 < argc ? std::string(argv[++i]) : std::string(); };
+        if (arg == "--width") layout.width = atoi(next().c_str());
+        else if (arg == "--height") layout.height = atoi(next().c_str());
+        else if (arg == "--scale") layout.scale = atof(next().c_str());
+        else if (arg == "--panel") layout.panel = next();
+        else if (arg == "--no-inspector") layout.inspectorOpen = false;
+        else if (arg == "--tracks") trackCount = atoi(next().c_str());
+        else if (arg == "--plugins") pluginCount = atoi(next().c_str());
+    }
+    setTrackCount(layout, trackCount);
+
+    Display* display = XOpenDisplay(NULL);
+    if (display == nullptr) {
+        std::cerr << "Could not open display" << std::endl;
+        return 1;
+    }
+    int screen = DefaultScreen(display);
+    if (DefaultDepth(display, screen) < 24) {
+        std::cerr << "Need a 24 bit display (Xvfb -screen 0 WxHx24)" << std::endl;
+        return 1;
+    }
+
+    StandinWindow standin;
+    standin.display = display;
+    standin.window = XCreateSimpleWindow(display, RootWindow(display, screen), 0, 0, layout.width, layout.height, 0, 0, 0);
+    setOwner(display, standin.window, "Bitwig Studio", "Bitwig Studio");
+    XSelectInput(display, standin.window, ExposureMask);
+    standin.image = XCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen), ZPixmap, 0,
+        (char*)calloc(layout.width * layout.height, 4), layout.width, layout.height, 32, 0);
+    XMapRaised(display, standin.window);
+
+    std::vector<Window> pluginWindows;
+    for (int i = 0; i < pluginCount; i++) {
+        auto plugin = XCreateSimpleWindow(display, RootWindow(display, screen), 200 + i * 60, 200 + i * 60, 400, 300, 0, 0, 0x808080);
+        auto title = "Plugin " + std::to_string(i + 1);
+        setOwner(display, plugin, "Bitwig Plug-in Host 64", title.c_str());
+        XMapRaised(display, plugin);
+        pluginWindows.push_back(plugin);
+    }
+    setActiveWindow(display, standin.window);
+    XSync(display, False);
+    redraw(standin, layout);
+
+    int xfd = ConnectionNumber(display);
+    std::string pending;
+    bool running = true;
+    while (running) {
+        while (XPending(display)) {
+            XEvent event;
+            XNextEvent(display, &event);
+            if (event.type == Expose && event.xexpose.window == standin.window && event.xexpose.count == 0) {
+                redraw(standin, layout);
+            }
+        }
+
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(xfd, &fds);
+        FD_SET(STDIN_FILENO, &fds);
+        if (select(std::max(xfd, STDIN_FILENO) + 1, &fds, NULL, NULL, NULL) < 0) {
+            break;
+        }
+        if (FD_ISSET(STDIN_FILENO, &fds)) {
+            char buffer[256];
+            auto n = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if (n <= 0) {
+                // Parent went away
+                break;
+            }
+            pending.append(buffer, n);
+            size_t newline;
+            while (running && (newline = pending.find('\n')) != std::string::npos) {
+                running = runCommand(layout, standin, pluginWindows, pending.substr(0, newline));
+                pending.erase(0, newline + 1);
+                redraw(standin, layout);
+                std::cout << "ok" << std::endl;
+            }
+        }
+    }
+
+    XDestroyImage(standin.image);
+    XCloseDisplay(display);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "stats.h"
+#include "metrics.h"
+#include <algorithm>
+
+Napi::Value StatsSnapshot(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto snapshot = snapshotMetrics();
+    auto obj = Napi::Object::New(env);
+
+    auto counters = Napi::Object::New(env);
+    for (auto& counter : snapshot.counters) {
+        counters.Set(counter.name, Napi::Number::New(env, (double)counter.value));
+    }
+    obj.Set("counters", counters);
+
+    auto gauges = Napi::Object::New(env);
+    for (auto& gauge : snapshot.gauges) {
+        gauges.Set(gauge.name, Napi::Number::New(env, (double)gauge.value));
+    }
+    obj.Set("gauges", gauges);
+
+    auto histograms = Napi::Object::New(env);
+    for (auto& histogram : snapshot.histograms) {
+        auto& summary = histogram.value;
+        auto h = Napi::Object::New(env);
+        h.Set("count", Napi::Number::New(env, (double)summary.count));
+        h.Set("sum", Napi::Number::New(env, (double)summary.sum));
+        h.Set("min", Napi::Number::New(env, (double)summary.min));
+        h.Set("max", Napi::Number::New(env, (double)summary.max));
+        h.Set("mean", Napi::Number::New(env, summary.count > 0 ? (double)summary.sum / summary.count : 0));
+        h.Set("p50", Napi::Number::New(env, (double)summary.p50));
+        h.Set("p90", Napi::Number::New(env, (double)summary.p90));
+        h.Set("p99", Napi::Number::New(env, (double)summary.p99));
+        histograms.Set(histogram.name, h);
+    }
+    obj.Set("histograms", histograms);
+    return obj;
+}
+
+Napi::Value StatsReset(const Napi::CallbackInfo &info) {
+    resetMetrics();
+    return info.Env().Undefined();
+}
+
+Napi::Value StatsStartTrace(const Napi::CallbackInfo &info) {
+    size_t maxEvents = 1000000;
+    if (info.Length() > 0 && info[0].IsObject()) {
+        auto options = info[0].As<Napi::Object>();
+        if (options.Has("maxEvents")) {
+            maxEvents = (size_t)std::max(1.0, options.Get("maxEvents").As<Napi::Number>().DoubleValue());
+        }
+    }
+    startTrace(maxEvents);
+    return info.Env().Undefined();
+}
+
+Napi::Value StatsStopTrace(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto result = stopTrace(info[0].As<Napi::String>().Utf8Value());
+    auto obj = Napi::Object::New(env);
+    obj.Set("events", Napi::Number::New(env, (double)result.events));
+    obj.Set("dropped", Napi::Number::New(env, (double)result.dropped));
+    obj.Set("written", Napi::Boolean::New(env, result.written));
+    return obj;
+}
+
+Napi::Value InitStats(Napi::Env env, Napi::Object exports) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("snapshot", Napi::Function::New(env, StatsSnapshot));
+    obj.Set("reset", Napi::Function::New(env, StatsReset));
+    obj.Set("startTrace", Napi::Function::New(env, StatsStartTrace));
+    obj.Set("stopTrace", Napi::Function::New(env, StatsStopTrace));
+    exports.Set("Stats", obj);
+    return exports;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <napi.h>
+
+/**
+ * What the native layer is doing, from the registry in metrics.h:
+ *
+ *   Stats.snapshot() -> { counters: { name: n }, gauges: { name: n },
+ *                         histograms: { name: { count, sum, min, max, mean, p50, p90, p99 } } }
+ *   Stats.reset()
+ *   Stats.startTrace({ maxEvents = 1000000 })
+ *   Stats.stopTrace(path) -> { events, dropped, written }
+ *
+ * The trace is Chrome trace event JSON, load it in chrome://tracing or Perfetto.
+ */
+Napi::Value InitStats(Napi::Env env, Napi::Object exports);
@@ -1,14 +1,22 @@
 #include "string.h"
+#include <cstring>
 
 std::string CFStringToString(CFStringRef cfString) {
-    CFIndex bufferSize = CFStringGetLength(cfString) + 1; // The +1 is for having space for the string to be NUL terminated
-    char buffer[bufferSize];
+    if (cfString == NULL) {
+        return "";
+    }
+    // Most strings are already stored in a compatible encoding and can be copied straight out
+    const char* direct = CFStringGetCStringPtr(cfString, kCFStringEncodingUTF8);
+    if (direct != NULL) {
+        return std::string(direct);
+    }
 
-    // CFStringGetCString is documented to return a false if the buffer is too small 
-    // (which shouldn't happen in this example) or if the conversion generally fails    
-    if (CFStringGetCString(cfString, buffer, bufferSize, kCFStringEncodingUTF8))
-    {
-        return std::string (buffer);
+    // Length is in UTF-16 units, UTF-8 can need up to 3 bytes for each. The +1 is for the NUL
+    CFIndex bufferSize = CFStringGetMaximumSizeForEncoding(CFStringGetLength(cfString), kCFStringEncodingUTF8) + 1;
+    std::string buffer(bufferSize, '\0');
+    if (CFStringGetCString(cfString, &buffer[0], bufferSize, kCFStringEncodingUTF8)) {
+        buffer.resize(strlen(buffer.c_str()));
+        return buffer;
     }
     return "";
-}
\ No newline at end of file
+}
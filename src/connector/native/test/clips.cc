@@ -0,0 +1,146 @@
+#include "test.h"
+#include "standinframe.h"
+#include "../clips.h"
+#include <random>
+
+// What findClipSpans should give, one pixel at a time
+std::vector<int32_t> scalarClipSpans(const uint8_t* row, int pixels, int minWidth) {
+    std::vector<int32_t> spans;
+    int runStart = -1;
+    for (int x = 0; x <= pixels; x++) {
+        bool clip = x < pixels && isClipPixel(row + x * 4);
+        if (clip && runStart == -1) {
+            runStart = x;
+        } else if (!clip && runStart != -1) {
+            if (x - runStart >= minWidth) {
+                spans.insert(spans.end(), {runStart, x - runStart});
+            }
+            runStart = -1;
+        }
+    }
+    return spans;
+}
+
+TEST("clips/vectorMatchesScalar") {
+    auto grey = [](uint8_t* bgra, int level) {
+        bgra[0] = bgra[1] = bgra[2] = (uint8_t)level;
+        bgra[3] = 255;
+    };
+    struct Case {
+        const char* name;
+        // Fills width BGRA pixels at row
+        std::function<void(std::mt19937& random, uint8_t* row, int width)> paint;
+    };
+    const Case cases[] = {
+        // Either side of both thresholds, so an off by one in a SIMD compare shows
+        {"thresholds", [&](std::mt19937& random, uint8_t* row, int width) {
+            for (int x = 0; x < width; x++) {
+                auto bgra = row + x * 4;
+                int base = 40 + random() % 20;
+                grey(bgra, base);
+                bgra[random() % 3] = (uint8_t)(base + 22 + random() % 5);
+                if (random() % 4 == 0) {
+                    grey(bgra, 78 + random() % 5);
+                }
+            }
+        }},
+        // Anything at all, including the top bit set that signed byte ops get wrong
+        {"noise", [&](std::mt19937& random, uint8_t* row, int width) {
+            for (int i = 0; i < width * 4; i++) {
+                row[i] = (uint8_t)random();
+            }
+        }},
+        // Clip and timeline runs, with edges landing anywhere in a 16 pixel block
+        {"runs", [&](std::mt19937& random, uint8_t* row, int width) {
+            bool clip = random() % 2;
+            for (int x = 0; x < width;) {
+                for (int end = std::min(width, x + 1 + (int)(random() % 40)); x < end; x++) {
+                    auto bgra = row + x * 4;
+                    if (clip) {
+                        bgra[0] = 46, bgra[1] = 120, bgra[2] = 217, bgra[3] = 255;
+                    } else {
+                        grey(bgra, 48);
+                    }
+                }
+                clip = !clip;
+            }
+        }},
+    };
+    std::mt19937 random(42);
+    for (auto& c : cases) {
+        int mismatches = 0;
+        // Odd widths either side of each multiple of 16, and rows starting off a 16 byte boundary
+        for (int width = 1; width <= 100; width++) {
+            for (int offset : {0, 1, 3}) {
+                std::vector<uint8_t> pixels((width + offset) * 4);
+                auto row = pixels.data() + offset * 4;
+                c.paint(random, row, width);
+                for (int minWidth : {1, 4}) {
+                    std::vector<int32_t> spans;
+                    findClipSpans(row, width, minWidth, spans);
+                    if (spans != scalarClipSpans(row, width, minWidth)) {
+                        mismatches++;
+                        std::cerr << c.name << " differs at width " << width << " offset " << offset << " minWidth " << minWidth << std::endl;
+                    }
+                }
+            }
+        }
+        CHECK_EQ(mismatches, 0);
+    }
+}
+
+TEST("clips/rectsMatchPaintedClips") {
+    struct Case {
+        float scale;
+        int scroll;
+        int clips;
+    };
+    const Case cases[] = {
+        {1, 0, 12},
+        {1.25f, 0, 12},
+        {2, 0, 6},
+        // First track's header partly scrolled away
+        {1, 20, 12},
+        // Enough to run off the end of the timeline
+        {1, 0, 40},
+    };
+    for (auto& c : cases) {
+        auto layout = standinLayout(c.scale);
+        layout.scroll = c.scroll;
+        for (size_t i = 0; i < layout.tracks.size(); i++) {
+            layout.tracks[i].clips = makeStandinClips(c.clips, (uint32_t)i);
+        }
+        StandinFrame window(layout);
+        auto painted = standinGeometry(layout);
+        auto& profile = window.profile();
+        auto detected = detectLayout(&window.image, profile, window.frame());
+        std::vector<ArrangerTrack> tracks;
+        detectArrangerTracks(&window.image, profile, window.frame(), detected, tracks);
+        ArrangerClips clips;
+        segmentArrangerClips(&window.image, profile, detected, tracks, clips);
+        CHECK_EQ(clips.trackCount(), painted.tracks.size());
+        if (clips.trackCount() != painted.tracks.size() || tracks.size() != painted.tracks.size()) {
+            continue;
+        }
+
+        for (size_t t = 0; t < tracks.size(); t++) {
+            // Each clip ends on a 1px dark edge, which isn't part of it. Cut off by the end of
+            // the timeline, the last pixel is still the edge
+            std::vector<int32_t> expected;
+            auto rowTop = std::max(painted.tracks[t].y + 1, painted.tracksTop);
+            auto rowBottom = painted.tracks[t].y + painted.tracks[t].h;
+            for (auto& clip : layout.tracks[t].clips) {
+                auto x = painted.timelineX + profile.scale(clip.start);
+                auto w = std::min(painted.timelineX + profile.scale(clip.start + clip.length), painted.timelineEnd) - x;
+                if (w <= 0) {
+                    break;
+                }
+                if (w - 1 >= profile.scale(4)) {
+                    expected.insert(expected.end(), {x, rowTop, w - 1, rowBottom - rowTop});
+                }
+            }
+            std::vector<int32_t> found(clips.rects.begin() + clips.offsets[t] * 4, clips.rects.begin() + clips.offsets[t + 1] * 4);
+            CHECK(found == expected);
+        }
+    }
+}
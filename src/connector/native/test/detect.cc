@@ -0,0 +1,142 @@
+#include "test.h"
+#include "standinframe.h"
+#include <thread>
+
+// What a window at the given scale finds, measured with its own profile
+size_t tracksFound(StandinFrame& window, int& firstHeight) {
+    auto& profile = window.profile();
+    auto layout = detectLayout(&window.image, profile, window.frame());
+    std::vector<ArrangerTrack> tracks;
+    detectArrangerTracks(&window.image, profile, window.frame(), layout, tracks);
+    firstHeight = tracks.empty() ? -1 : tracks[0].rect.h;
+    return tracks.size();
+}
+
+TEST("detect/eachWindowUsesItsOwnProfile") {
+    // The global profile stays at 1x, as if another display set it last
+    uiScale = 1;
+    selectLayoutProfile();
+    StandinFrame small(standinLayout(1)), large(standinLayout(2));
+    CHECK(&small.profile() != &large.profile());
+    CHECK_EQ(large.profile().scale(45), 90);
+
+    // Both at once, the way getLayoutStates detects every window on the pool
+    size_t smallTracks = 0, largeTracks = 0;
+    int smallHeight = 0, largeHeight = 0;
+    std::thread a([&]() { smallTracks = tracksFound(small, smallHeight); });
+    std::thread b([&]() { largeTracks = tracksFound(large, largeHeight); });
+    a.join();
+    b.join();
+    CHECK_EQ(smallTracks, 8u);
+    CHECK_EQ(largeTracks, 8u);
+    CHECK_EQ(largeHeight, smallHeight * 2);
+}
+
+std::vector<ArrangerTrack> detectTracks(StandinFrame& window) {
+    auto& profile = window.profile();
+    auto layout = detectLayout(&window.image, profile, window.frame());
+    std::vector<ArrangerTrack> tracks;
+    detectArrangerTracks(&window.image, profile, window.frame(), layout, tracks);
+    return tracks;
+}
+
+TEST("detect/automationLaneRects") {
+    for (float scale : {1.f, 1.25f, 2.f}) {
+        for (int lanes : {1, 2, 3}) {
+            auto layout = standinLayout(scale);
+            auto& track = layout.tracks[1];
+            track.automationOpen = true;
+            track.automationLanes = lanes;
+            track.height = 45 + 60 * lanes;
+            StandinFrame window(layout);
+            auto painted = standinGeometry(layout);
+            auto tracks = detectTracks(window);
+            CHECK_EQ(tracks.size(), layout.tracks.size());
+            if (tracks.size() < 2) {
+                continue;
+            }
+
+            // Lanes split what's below the header evenly, each after the first starting with a
+            // 1px divider
+            auto& found = tracks[1];
+            auto trackRect = painted.tracks[1];
+            auto headerH = window.profile().scale(45);
+            auto laneTop = [&](int lane) {
+                return trackRect.y + headerH + (trackRect.h - headerH) * lane / lanes;
+            };
+            CHECK(found.automationOpen);
+            CHECK_EQ(found.header, HEADER_VISIBLE);
+            CHECK_EQ(found.automationLanes.size(), (size_t)lanes);
+            for (int lane = 0; lane < lanes && lane < (int)found.automationLanes.size(); lane++) {
+                auto& rect = found.automationLanes[lane];
+                auto top = laneTop(lane) + (lane > 0 ? 1 : 0);
+                auto bottom = lane + 1 < lanes ? laneTop(lane + 1) : trackRect.y + trackRect.h;
+                CHECK_EQ(rect.x, painted.arranger.x);
+                CHECK_EQ(rect.w, painted.trackWidth);
+                CHECK_EQ(rect.y, top);
+                CHECK_EQ(rect.h, bottom - top);
+            }
+            CHECK_EQ(found.rect.y + found.rect.h, trackRect.y + trackRect.h);
+            // Neighbours don't get lanes
+            CHECK(tracks[0].automationLanes.empty());
+            CHECK(!tracks[2].automationOpen);
+        }
+    }
+}
+
+TEST("detect/partialAndHiddenHeaders") {
+    struct Case {
+        float scale;
+        int scroll;
+        bool lanes;
+        TrackHeaderState header;
+    };
+    const Case cases[] = {
+        {1, 0, false, HEADER_VISIBLE},
+        {1, 20, false, HEADER_PARTIAL},
+        {1.25f, 20, false, HEADER_PARTIAL},
+        {1, 20, true, HEADER_PARTIAL},
+        // Past the 45px header into the first of two 60px lanes
+        {1, 80, true, HEADER_HIDDEN},
+        {2, 80, true, HEADER_HIDDEN},
+        // Into the second lane
+        {1, 130, true, HEADER_HIDDEN},
+    };
+    for (auto& c : cases) {
+        auto layout = standinLayout(c.scale);
+        layout.scroll = c.scroll;
+        if (c.lanes) {
+            layout.tracks[0].automationOpen = true;
+            layout.tracks[0].automationLanes = 2;
+            layout.tracks[0].height = 45 + 60 * 2;
+        }
+        StandinFrame window(layout);
+        auto painted = standinGeometry(layout);
+        auto tracks = detectTracks(window);
+        CHECK_EQ(tracks.size(), layout.tracks.size());
+        if (tracks.empty()) {
+            continue;
+        }
+        auto& first = tracks[0];
+        auto trackRect = painted.tracks[0];
+        CHECK_EQ(first.header, c.header);
+        // Only what's below the ruler is visible. A partial header's rect is where the whole
+        // track would be, a hidden one's is just what shows
+        CHECK_EQ(first.visibleRect.y, painted.tracksTop);
+        CHECK_EQ(first.visibleRect.y + first.visibleRect.h, trackRect.y + trackRect.h);
+        CHECK_EQ(first.rect.y, c.header == HEADER_HIDDEN ? painted.tracksTop : trackRect.y);
+        CHECK_EQ(first.rect.y + first.rect.h, trackRect.y + trackRect.h);
+        if (c.lanes) {
+            auto headerBottom = trackRect.y + window.profile().scale(45);
+            // Lanes scrolled away entirely aren't reported, the one cut off starts at the ruler
+            size_t lanesShowing = trackRect.y + window.profile().scale(45 + 60) > painted.tracksTop ? 2 : 1;
+            CHECK_EQ(first.automationLanes.size(), lanesShowing);
+            if (!first.automationLanes.empty()) {
+                CHECK_EQ(first.automationLanes[0].y, std::max(headerBottom, painted.tracksTop));
+            }
+        }
+        // The second track is unaffected
+        CHECK_EQ(tracks[1].header, HEADER_VISIBLE);
+        CHECK_EQ(tracks[1].rect.y, painted.tracks[1].y);
+    }
+}
@@ -0,0 +1,155 @@
+#include "test.h"
+#include "standinframe.h"
+#include "../devicechain.h"
+#include <cmath>
+
+StandinLayout deviceLayout(float scale, std::vector<StandinDevice> devices, int deviceScroll = 0) {
+    auto layout = standinLayout(scale);
+    layout.panel = "device";
+    layout.devices = devices;
+    layout.deviceScroll = deviceScroll;
+    return layout;
+}
+
+// The slots detectDeviceChain should find: each painted header band cut to the panel, dropping
+// slivers too narrow to count
+void expectedSlots(const StandinLayout& layout, const StandinGeometry& g, const MWRect& rect, std::vector<int32_t>& slots, std::vector<uint8_t>& flags) {
+    auto s = [&](int value) {
+        return (int)round((float)value * layout.scale);
+    };
+    for (size_t i = 0; i < g.devices.size(); i++) {
+        auto& device = g.devices[i];
+        auto x0 = std::max(device.x, rect.x), x1 = std::min(device.x + device.w, rect.x + rect.w);
+        if (x1 - x0 < s(10)) {
+            continue;
+        }
+        slots.insert(slots.end(), {x0, device.y, x1 - x0, device.h});
+        flags.push_back(
+            (layout.devices[i].collapsed ? DEVICE_COLLAPSED : 0)
+            | (layout.devices[i].selected ? DEVICE_SELECTED : 0)
+            | (x0 == rect.x || x1 == rect.x + rect.w ? DEVICE_CLIPPED : 0)
+        );
+    }
+}
+
+TEST("deviceChain/matchesPainted") {
+    auto some = makeStandinDevices(4);
+    some[1].selected = true;
+    some[2].collapsed = true;
+    auto many = makeStandinDevices(14);
+    many[0].collapsed = true;
+    many[5].selected = true;
+    many[6].collapsed = true;
+    many[6].selected = true;
+    struct Case {
+        const char* name;
+        std::vector<StandinDevice> devices;
+        int deviceScroll;
+    };
+    const Case cases[] = {
+        {"empty", {}, 0},
+        {"fits", some, 0},
+        {"overflowing", many, 0},
+        // The first device cut off on the left, and one on the right
+        {"scrolled", many, 333},
+        {"nearlyAtTheEnd", many, 1200},
+    };
+    for (float scale : {1.f, 1.25f, 2.f}) {
+        for (auto& c : cases) {
+            auto layout = deviceLayout(scale, c.devices, c.deviceScroll);
+            StandinFrame window(layout);
+            auto& profile = window.profile();
+            auto painted = standinGeometry(layout);
+            auto detected = detectLayout(&window.image, profile, window.frame());
+            MWRect rect;
+            CHECK(getDeviceChainRect(profile, detected, rect));
+            // Inside the panel's sides and under its top border
+            CHECK(rect == (MWRect{painted.editor.x + profile.scale(4), painted.editor.y + 1, painted.editor.w - profile.scale(8), painted.editor.h - 1}));
+
+            DeviceChain chain;
+            detectDeviceChain(&window.image, profile, rect, chain);
+            std::vector<int32_t> slots;
+            std::vector<uint8_t> flags;
+            expectedSlots(layout, painted, rect, slots, flags);
+            CHECK(chain.slots == slots);
+            CHECK(chain.flags == flags);
+
+            auto& thumb = painted.deviceScrollThumb;
+            if (thumb.w == 0) {
+                CHECK_EQ(chain.scrollStart, 0);
+                CHECK_EQ(chain.scrollEnd, 1);
+            } else {
+                CHECK_EQ(chain.scrollStart, (double)(thumb.x - rect.x) / rect.w);
+                CHECK_EQ(chain.scrollEnd, (double)(thumb.x + thumb.w - rect.x) / rect.w);
+                CHECK(c.deviceScroll == 0 ? chain.scrollStart == 0 : chain.scrollStart > 0);
+            }
+        }
+    }
+
+    // No device panel, no chain
+    for (auto panel : {"", "mixer"}) {
+        auto layout = standinLayout();
+        layout.panel = panel;
+        StandinFrame window(layout);
+        MWRect rect;
+        CHECK(!getDeviceChainRect(window.profile(), detectLayout(&window.image, window.profile(), window.frame()), rect));
+    }
+}
+
+TEST("deviceChain/cacheHitsUntilTheRowsChange") {
+    auto layout = deviceLayout(1, makeStandinDevices(6));
+    StandinFrame window(layout);
+    auto& profile = window.profile();
+    auto detected = detectLayout(&window.image, profile, window.frame());
+    DeviceChainCache cache;
+    auto chain = cache.update(&window.image, profile, detected);
+    CHECK(chain && !cache.lastUpdateCached);
+    auto devices = chain ? chain->deviceCount() : 0;
+    CHECK_EQ(devices, 6u);
+    CHECK(cache.update(&window.image, profile, detected) == chain);
+    CHECK(cache.lastUpdateCached);
+
+    // Anything outside the rows it reads, like the arranger, leaves it be
+    window.layout.tracks[2].selected = true;
+    window.paint();
+    cache.update(&window.image, profile, detected);
+    CHECK(cache.lastUpdateCached);
+
+    struct Change {
+        const char* name;
+        std::function<void(StandinLayout&)> apply;
+        size_t devices;
+    };
+    const Change changes[] = {
+        {"selected", [](StandinLayout& l) { l.devices[3].selected = true; }, 6},
+        {"collapsed", [](StandinLayout& l) { l.devices[0].collapsed = true; }, 6},
+        {"added", [](StandinLayout& l) { l.devices.push_back(StandinDevice{}); }, 7},
+        {"scrolled", [](StandinLayout& l) { l.devices.resize(14); l.deviceScroll = 200; }, 0},
+    };
+    for (auto& change : changes) {
+        change.apply(window.layout);
+        window.paint();
+        chain = cache.update(&window.image, profile, detected);
+        CHECK(chain && !cache.lastUpdateCached);
+        std::vector<int32_t> slots;
+        std::vector<uint8_t> flags;
+        MWRect rect;
+        getDeviceChainRect(profile, detected, rect);
+        expectedSlots(window.layout, standinGeometry(window.layout), rect, slots, flags);
+        CHECK(chain && chain->slots == slots && chain->flags == flags);
+        if (change.devices != 0) {
+            CHECK_EQ(flags.size(), change.devices);
+        }
+        cache.update(&window.image, profile, detected);
+        CHECK(cache.lastUpdateCached);
+    }
+
+    // A reset or another profile reads it again
+    cache.reset();
+    cache.update(&window.image, profile, detected);
+    CHECK(!cache.lastUpdateCached);
+    auto& other = *findLayoutProfile(1, "Single Display (Small)");
+    CHECK(&other != &profile);
+    cache.update(&window.image, other, detected);
+    CHECK(!cache.lastUpdateCached);
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include "../windowregistry.h"
+#include <map>
+
+/**
+ * A window server in memory, for the registry and plugin window logic. Tests change windows
+ * directly and then notify the registry the way a platform source would, or don't, to see
+ * what happens when a notification is late
+ */
+class FakePluginWindowSource : public PluginWindowSource {
+    std::mutex mutex;
+    std::map<uint64_t, PluginWindow> windows;
+public:
+    bool watching = true;
+    // Calls made by the registry, under mutex
+    int fetchAllCalls = 0, fetchCalls = 0, moveCalls = 0, resizeCalls = 0;
+    // When set, move() is accepted but the window stays where it was
+    bool ignoreMoves = false;
+
+    void put(PluginWindow window) {
+        std::lock_guard<std::mutex> lock(mutex);
+        windows[window.key] = window;
+    }
+
+    void remove(uint64_t key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        windows.erase(key);
+    }
+
+    bool watch(PluginWindowRegistry*) override {
+        return watching;
+    }
+
+    PluginWindowList fetchAll() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        fetchAllCalls++;
+        PluginWindowList out;
+        for (auto& entry : windows) {
+            out.push_back(entry.second);
+        }
+        return out;
+    }
+
+    bool fetch(uint64_t key, PluginWindow& window) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        fetchCalls++;
+        auto it = windows.find(key);
+        if (it == windows.end()) {
+            return false;
+        }
+        window = it->second;
+        return true;
+    }
+
+    bool move(uint64_t key, double x, double y) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        moveCalls++;
+        auto it = windows.find(key);
+        if (it == windows.end()) {
+            return false;
+        }
+        if (!ignoreMoves) {
+            it->second.x = x;
+            it->second.y = y;
+        }
+        return true;
+    }
+
+    bool resize(uint64_t key, double w, double h) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        resizeCalls++;
+        auto it = windows.find(key);
+        if (it == windows.end()) {
+            return false;
+        }
+        it->second.w = w;
+        it->second.h = h;
+        return true;
+    }
+
+    void focus(uint64_t key) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& entry : windows) {
+            entry.second.focused = entry.first == key;
+        }
+    }
+
+    void awayPosition(double& x, double& y) override {
+        x = 1919;
+        y = 1079;
+    }
+};
+
+inline PluginWindow makePluginWindow(uint64_t key, double x, double y, double w = 400, double h = 300) {
+    PluginWindow window;
+    window.key = key;
+    window.title = "Plugin " + std::to_string(key);
+    window.x = x;
+    window.y = y;
+    window.w = w;
+    window.h = h;
+    return window;
+}
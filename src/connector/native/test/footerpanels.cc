@@ -0,0 +1,180 @@
+#include "test.h"
+#include "standinframe.h"
+#include "../footerpanels.h"
+#include <cmath>
+
+TEST("footerPanels/matchPainted") {
+    // Where drawStandinLayout centres each icon, from the bottom left, in FooterPanel order. The
+    // stand-in paints the same masks, so this only shows the search finds what it was given
+    struct Icon {
+        int fromLeft, fromBottom;
+    };
+    const Icon icons[FOOTER_PANEL_COUNT] = {{276, 20}, {309, 20}, {250, 20}, {224, 18}};
+    for (float scale : {1.f, 1.25f, 1.5f, 2.f}) {
+        auto s = [&](int value) {
+            return (int)round((float)value * scale);
+        };
+        for (auto panel : {"", "device", "mixer", "automation", "detail"}) {
+            auto layout = standinLayout(scale);
+            layout.panel = panel;
+            StandinFrame window(layout);
+            FooterPanels panels;
+            CHECK(detectFooterPanels(&window.image, window.profile(), window.frame(), panels));
+            CHECK_EQ(panels.iconsFound(), FOOTER_PANEL_COUNT);
+            CHECK_EQ(std::string(footerPanelName(panels.open)), std::string(panel));
+
+            auto& glyphs = getFooterGlyphs(scale);
+            int wrong = 0;
+            for (int i = 0; i < FOOTER_PANEL_COUNT; i++) {
+                auto painted = MWRect{s(icons[i].fromLeft) - s(5), layout.height - s(icons[i].fromBottom) - s(5), glyphs.icons[i].w, glyphs.icons[i].h};
+                wrong += !(panels.icons[i] == painted);
+            }
+            CHECK_EQ(wrong, 0);
+        }
+    }
+}
+
+// 1x rows like the masks, '#' lit
+using Rows = std::vector<const char*>;
+
+/**
+ * Each mask against rows painted grey on the footer, -1 where it isn't found
+ */
+std::vector<int> matchFooterGlyphs(const Rows& rows, float scale) {
+    auto s = [&](int value) {
+        return (int)round((float)value * scale);
+    };
+    const int w = 60, h = 40, at = 10;
+    std::vector<uint8_t> pixels((size_t)w * h * 4, 40);
+    for (int row = 0; row < (int)rows.size(); row++) {
+        for (int col = 0; rows[row][col]; col++) {
+            if (rows[row][col] != '#') {
+                continue;
+            }
+            for (int y = at + s(row); y < at + s(row + 1); y++) {
+                for (int x = at + s(col); x < at + s(col + 1); x++) {
+                    auto pixel = &pixels[((size_t)y * w + x) * 4];
+                    pixel[0] = pixel[1] = pixel[2] = 150;
+                }
+            }
+        }
+    }
+    FrameImage image(pixels.data(), (size_t)w * 4, WindowInfo{0, MWRect{0, 0, w, h}});
+    LitBits bits;
+    bits.fill(&image, MWRect{0, 0, w, h}, 100);
+    std::vector<MWRect> blobs;
+    findLitBlobs(bits, s(20), blobs);
+
+    std::vector<int> mismatches;
+    for (auto& mask : getFooterGlyphs(scale).icons) {
+        auto match = matchGlyph(bits, blobs, mask, false);
+        mismatches.push_back(match.x == -1 ? -1 : match.mismatches);
+    }
+    return mismatches;
+}
+
+TEST("footerPanels/nearMissesRejected") {
+    struct Case {
+        const char* name;
+        Rows rows;
+        // FooterPanel it's taken for, -1 for none
+        int panel;
+    };
+    const Case cases[] = {
+        {"device", {
+            "...#####...",
+            "..#.....#..",
+            ".#.......#.",
+            "#.........#",
+            "#....#....#",
+            "#....#....#",
+            "#.........#",
+            ".#.......#.",
+            "..#.....#..",
+            "...#####...",
+        }, PANEL_DEVICE},
+        {"detail", {
+            "###########",
+            "#.........#",
+            "#.###.....#",
+            "#.........#",
+            "#.........#",
+            "#....####.#",
+            "#.........#",
+            "#.##......#",
+            "#.........#",
+            "###########",
+        }, PANEL_DETAIL},
+        // The detail icon's outline without the lines inside, e.g. a checkbox
+        {"box", {
+            "###########",
+            "#.........#",
+            "#.........#",
+            "#.........#",
+            "#.........#",
+            "#.........#",
+            "#.........#",
+            "#.........#",
+            "#.........#",
+            "###########",
+        }, -1},
+        {"mirroredAutomation", {
+            "#..........",
+            ".#.........",
+            "..#........",
+            "...#.......",
+            "....#......",
+            ".....#.....",
+            "......#....",
+            ".......#...",
+            "........#..",
+            "###########",
+        }, -1},
+        {"mixerFadersMoved", {
+            ".#...#...#.",
+            ".#..###..#.",
+            ".#...#...#.",
+            ".#...#...#.",
+            ".#...#...#.",
+            ".#...#...#.",
+            "###..#...#.",
+            ".#...#..###",
+            ".#...#...#.",
+            "###########",
+        }, -1},
+        {"deviceFilledCentre", {
+            "...#####...",
+            "..#.....#..",
+            ".#.......#.",
+            "#.........#",
+            "#...###...#",
+            "#...###...#",
+            "#.........#",
+            ".#.......#.",
+            "..#.....#..",
+            "...#####...",
+        }, -1},
+        {"ramp", {
+            "..........#",
+            ".........##",
+            "........###",
+            ".......####",
+            "......#####",
+            ".....######",
+            "....#######",
+            "...########",
+            "..#########",
+            "###########",
+        }, -1},
+    };
+    for (float scale : {1.f, 1.25f, 2.f}) {
+        for (auto& c : cases) {
+            auto mismatches = matchFooterGlyphs(c.rows, scale);
+            int wrong = 0;
+            for (int i = 0; i < FOOTER_PANEL_COUNT; i++) {
+                wrong += i == c.panel ? mismatches[i] != 0 : mismatches[i] != -1;
+            }
+            CHECK_EQ(wrong, 0);
+        }
+    }
+}
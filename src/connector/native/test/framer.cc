@@ -0,0 +1,193 @@
+#include "test.h"
+#include "../framer.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+// What the controller script sends, the prefix is the JS string length (UTF-16 units)
+std::string framePacket(const std::string& json) {
+    size_t units = 0;
+    for (unsigned char c : json) {
+        if ((c & 0xC0) != 0x80) {
+            units += c >= 0xF0 ? 2 : 1;
+        }
+    }
+    return std::to_string(units) + json;
+}
+
+/**
+ * Pushes stream in chunks of the given sizes (the last repeated until it's all pushed) and
+ * returns every packet's bytes, checking each frame is where it says it is
+ */
+std::vector<std::string> pushInChunks(PacketFramer& framer, const std::string& stream, std::vector<size_t> sizes) {
+    std::vector<std::string> out;
+    size_t pos = 0;
+    for (size_t n = 0; pos < stream.size(); n++) {
+        size_t size = std::min(sizes[std::min(n, sizes.size() - 1)], stream.size() - pos);
+        std::vector<PacketFrame> frames;
+        framer.push((const uint8_t*)stream.data() + pos, size, frames);
+        for (auto& frame : frames) {
+            if (frame.spansChunks) {
+                CHECK_EQ(frame.length, frame.assembled.size());
+                out.push_back(std::string(frame.assembled.begin(), frame.assembled.end()));
+            } else {
+                CHECK(frame.assembled.empty());
+                CHECK(frame.offset + frame.length <= size);
+                out.push_back(stream.substr(pos + frame.offset, frame.length));
+            }
+        }
+        pos += size;
+    }
+    return out;
+}
+
+const std::vector<std::string> samplePackets = {
+    "{\"type\":\"tracks\",\"id\":\"internal3\",\"data\":[{\"type\":\"x\"}]}",
+    "{\"data\":{\"id\":5},\"id\":12,\"type\":\"a/b\"}",
+    // 2, 3 and 4 byte sequences, the last a surrogate pair on the JS side
+    "{\"type\":\"caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x8e\xb5\",\"id\":\"q\\\"x\"}"
+};
+
+std::string sampleStream() {
+    std::string stream;
+    for (auto& packet : samplePackets) {
+        stream += framePacket(packet);
+    }
+    return stream;
+}
+
+TEST("framer/everyChunkSize") {
+    auto stream = sampleStream();
+    // Size 1 splits every length prefix and every multibyte sequence somewhere
+    for (size_t size = 1; size <= stream.size(); size++) {
+        PacketFramer framer;
+        auto packets = pushInChunks(framer, stream, {size});
+        CHECK(packets == samplePackets);
+    }
+}
+
+TEST("framer/lengthSplitAcrossChunks") {
+    std::string json(123, 'x');
+    json[0] = '{';
+    json[122] = '}';
+    PacketFramer framer;
+    std::vector<PacketFrame> frames;
+    framer.push((const uint8_t*)"12", 2, frames);
+    CHECK(frames.empty());
+    // The body's first byte is what ends the length, so it must see 123 not 12
+    auto rest = "3" + json;
+    framer.push((const uint8_t*)rest.data(), rest.size(), frames);
+    CHECK_EQ(frames.size(), 1u);
+    CHECK(!frames[0].spansChunks);
+    CHECK_EQ(frames[0].offset, 1u);
+    CHECK_EQ(frames[0].length, 123u);
+}
+
+TEST("framer/manyPacketsInOneChunk") {
+    std::string stream;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 1000; i++) {
+        auto json = "{\"type\":\"t" + std::to_string(i) + "\",\"id\":" + std::to_string(i) + "}";
+        expected.push_back(json);
+        stream += framePacket(json);
+    }
+    PacketFramer framer;
+    std::vector<PacketFrame> frames;
+    framer.push((const uint8_t*)stream.data(), stream.size(), frames);
+    CHECK_EQ(frames.size(), expected.size());
+    int wrong = 0;
+    for (size_t i = 0; i < frames.size() && i < expected.size(); i++) {
+        // All views on the chunk, nothing copied
+        wrong += frames[i].spansChunks || stream.substr(frames[i].offset, frames[i].length) != expected[i];
+    }
+    CHECK_EQ(wrong, 0);
+
+    // And the same with a packet straddling each chunk boundary
+    PacketFramer split;
+    CHECK(pushInChunks(split, stream, {4097, 999, 1}) == expected);
+}
+
+TEST("framer/multibyteSplitAcrossReads") {
+    // Ends on each of the emoji's 4 bytes in turn, the packet mustn't end until it's whole
+    std::string json = "{\"type\":\"\xf0\x9f\x8e\xb5\"}";
+    auto stream = framePacket(json);
+    auto emoji = stream.find('\xf0');
+    for (size_t cut = emoji; cut < emoji + 4; cut++) {
+        PacketFramer framer;
+        std::vector<PacketFrame> frames;
+        framer.push((const uint8_t*)stream.data(), cut, frames);
+        CHECK(frames.empty());
+        framer.push((const uint8_t*)stream.data() + cut, stream.size() - cut, frames);
+        CHECK_EQ(frames.size(), 1u);
+        if (frames.size() == 1) {
+            CHECK(frames[0].spansChunks);
+            CHECK_EQ(std::string(frames[0].assembled.begin(), frames[0].assembled.end()), json);
+        }
+    }
+
+    // A packet ending on a 3 byte sequence, with the next one straight after it
+    std::string euro = "{\"type\":\"\xe2\x82\xac\"}";
+    PacketFramer framer;
+    auto twice = framePacket(euro) + framePacket(euro);
+    CHECK((pushInChunks(framer, twice, {framePacket(euro).size() - 2, 1}) == std::vector<std::string>{euro, euro}));
+}
+
+TEST("framer/zeroLengthIsSkipped") {
+    PacketFramer framer;
+    // Empty packets have nothing to frame, what follows is the next length
+    auto stream = "0" + framePacket("{\"id\":1}") + "0" + "0" + framePacket("{\"id\":2}");
+    CHECK((pushInChunks(framer, stream, {stream.size()}) == std::vector<std::string>{"{\"id\":1}", "{\"id\":2}"}));
+
+    // As is anything before a length
+    PacketFramer noise;
+    auto noisy = "\r\n" + framePacket("{\"id\":3}");
+    CHECK((pushInChunks(noise, noisy, {1}) == std::vector<std::string>{"{\"id\":3}"}));
+}
+
+TEST("framer/oversizeLengthResyncs") {
+    PacketFramer framer;
+    // Enough digits to overflow a size_t if they were all taken as the length
+    auto stream = std::string(40, '9') + "{\"id\":\"lost\"}" + framePacket("{\"id\":4}");
+    auto packets = pushInChunks(framer, stream, {7});
+    CHECK((packets == std::vector<std::string>{"{\"id\":4}"}));
+
+    // A plausible length just waits for the rest, until reset() on reconnect
+    PacketFramer waiting;
+    std::vector<PacketFrame> frames;
+    auto big = "1000000{\"id\":5}";
+    waiting.push((const uint8_t*)big, strlen(big), frames);
+    CHECK(frames.empty());
+    waiting.reset();
+    auto next = framePacket("{\"id\":6}");
+    CHECK((pushInChunks(waiting, next, {next.size()}) == std::vector<std::string>{"{\"id\":6}"}));
+}
+
+TEST("framer/scanPacketHeader") {
+    struct Case {
+        const char* json;
+        bool object;
+        const char* type;
+        const char* id;
+    };
+    const Case cases[] = {
+        {"{\"type\":\"tracks\",\"id\":\"internal3\",\"data\":[{\"type\":\"x\"}]}", true, "tracks", "internal3"},
+        // Nested type/id belong to something else
+        {"{\"data\":{\"id\":5,\"type\":\"no\"},\"id\":12,\"type\":\"a/b\"}", true, "a/b", "12"},
+        {" \n{ \"id\" : true , \"type\" : \"x\" }", true, "x", "true"},
+        {"{\"type\":\"q\\\"x\",\"id\":null}", true, "q\"x", "null"},
+        {"{\"data\":\"\\\"type\\\":\\\"no\\\"\"}", true, "", ""},
+        // Object valued ids aren't read
+        {"{\"id\":{\"a\":1},\"type\":\"t\"}", true, "t", ""},
+        {"[1,2]", false, "", ""},
+        {"", false, "", ""},
+        // Cut short, whatever was read is kept
+        {"{\"type\":\"trunc", true, "trunc", ""},
+    };
+    for (auto& c : cases) {
+        std::string type, id;
+        bool object = scanPacketHeader((const uint8_t*)c.json, strlen(c.json), type, id);
+        CHECK_EQ(object, c.object);
+        CHECK_EQ(type, c.type);
+        CHECK_EQ(id, c.id);
+    }
+}
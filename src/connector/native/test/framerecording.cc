@@ -0,0 +1,166 @@
+#include "test.h"
+#include "../framerecording.h"
+#include "../standin/layout.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <unistd.h>
+
+struct RecordedFrame {
+    int width, height;
+    std::vector<uint8_t> pixels;
+};
+
+/**
+ * A session painted the way the Xvfb stand-in paints its window: the playhead moves every
+ * frame (a few changed tiles, so deltas), the panel switches and the arranger scrolls now and
+ * then (most tiles, so keyframes), and the window is resized part way through
+ */
+std::vector<RecordedFrame> paintSession(int count) {
+    std::vector<RecordedFrame> frames;
+    for (int i = 0; i < count; i++) {
+        StandinLayout layout;
+        layout.tracks.resize(8);
+        for (auto& track : layout.tracks) {
+            track.clips = makeStandinClips(6, 3);
+        }
+        if (i >= count * 2 / 3) {
+            layout.width = 1280;
+            layout.height = 800;
+        }
+        layout.playhead = i * 3;
+        layout.scroll = (i / 50) * 40;
+        layout.panel = i % 97 < 40 ? "device" : "mixer";
+        layout.devices = makeStandinDevices(3);
+        layout.strips = makeStandinStrips(6);
+        RecordedFrame frame{layout.width, layout.height, std::vector<uint8_t>((size_t)layout.width * 4 * layout.height)};
+        drawStandinLayout(layout, frame.pixels.data(), (size_t)layout.width * 4);
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+std::string recordingPath(const char* name) {
+    return "/tmp/bes_tests_" + std::to_string(getpid()) + "_" + name + ".bes";
+}
+
+void recordSession(const std::string& path, std::vector<RecordedFrame>& frames, FrameRecorderOptions options) {
+    FrameRecorder recorder(path, options);
+    for (size_t i = 0; i < frames.size(); i++) {
+        auto& frame = frames[i];
+        FrameImage image(frame.pixels.data(), (size_t)frame.width * 4, WindowInfo{0, MWRect{0, 0, frame.width, frame.height}});
+        recorder.addFrame(&image, i * 16.5);
+    }
+    recorder.close();
+    CHECK_EQ(recorder.error(), "");
+}
+
+bool framesMatch(FrameImage* image, const RecordedFrame& frame) {
+    return image != nullptr
+        && image->width == frame.width
+        && image->height == frame.height
+        && memcmp(image->data, frame.pixels.data(), frame.pixels.size()) == 0;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+TEST("frameRecording/seekForwardBackwardAndRandom") {
+    auto frames = paintSession(150);
+    auto path = recordingPath("roundtrip");
+    recordSession(path, frames, FrameRecorderOptions{64, 30});
+
+    // Mostly deltas, or it'd be about the size of the raw frames
+    size_t rawBytes = 0;
+    for (auto& frame : frames) {
+        rawBytes += frame.pixels.size();
+    }
+    CHECK(readFile(path).size() * 20 < rawBytes);
+
+    FrameReplay replay(path);
+    CHECK_EQ(replay.frameCount(), frames.size());
+    CHECK_EQ(replay.frameTime(10), 165);
+    int mismatched = 0;
+    for (size_t i = 0; i < frames.size(); i++) {
+        mismatched += !framesMatch(replay.seek(i), frames[i]);
+    }
+    CHECK_EQ(mismatched, 0);
+    for (size_t i = frames.size(); i-- > 0;) {
+        mismatched += !framesMatch(replay.seek(i), frames[i]);
+    }
+    CHECK_EQ(mismatched, 0);
+    std::mt19937 random(50);
+    for (int n = 0; n < 200; n++) {
+        auto i = random() % frames.size();
+        mismatched += !framesMatch(replay.seek(i), frames[i]);
+    }
+    CHECK_EQ(mismatched, 0);
+    CHECK(replay.seek(frames.size()) == nullptr);
+    remove(path.c_str());
+}
+
+TEST("frameRecording/truncatedReplaysWholeFrames") {
+    auto frames = paintSession(60);
+    auto path = recordingPath("full");
+    recordSession(path, frames, FrameRecorderOptions{64, 20});
+    auto bytes = readFile(path);
+    auto cutPath = recordingPath("truncated");
+    std::ofstream(cutPath, std::ios::binary).write(bytes.data(), bytes.size() * 2 / 3);
+
+    // No index, it's rebuilt from the records up to the one that was cut
+    FrameReplay replay(cutPath);
+    CHECK(replay.frameCount() > 0);
+    CHECK(replay.frameCount() < frames.size());
+    int mismatched = 0;
+    for (size_t i = replay.frameCount(); i-- > 0;) {
+        mismatched += !framesMatch(replay.seek(i), frames[i]);
+    }
+    CHECK_EQ(mismatched, 0);
+    remove(path.c_str());
+    remove(cutPath.c_str());
+}
+
+TEST("frameRecording/corruptRecordsDontDecode") {
+    auto frames = paintSession(40);
+    auto path = recordingPath("corrupt");
+    recordSession(path, frames, FrameRecorderOptions{64, 20});
+    auto bytes = readFile(path);
+    for (size_t i = 100; i < bytes.size(); i += 97) {
+        bytes[i] ^= 0xff;
+    }
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+
+    // Whatever survives must not read out of bounds (run under a sanitizer to be sure)
+    FrameReplay replay(path);
+    CHECK(replay.frameCount() <= frames.size());
+    for (size_t i = 0; i < replay.frameCount(); i++) {
+        replay.seek(i);
+    }
+    remove(path.c_str());
+
+    bool threw = false;
+    try {
+        FrameReplay missing(recordingPath("missing"));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+TEST("frameRecording/writeFailureIsReported") {
+    // Every write to /dev/full fails with ENOSPC, once the stream's buffer fills or is flushed
+    auto frames = paintSession(3);
+    FrameRecorder recorder("/dev/full");
+    for (auto& frame : frames) {
+        FrameImage image(frame.pixels.data(), (size_t)frame.width * 4, WindowInfo{0, MWRect{0, 0, frame.width, frame.height}});
+        recorder.addFrame(&image, 0);
+    }
+    recorder.close();
+    CHECK(recorder.error() != "");
+    CHECK(recorder.bytesWritten() < frames[0].pixels.size());
+}
@@ -0,0 +1,111 @@
+#include "test.h"
+#include "standinframe.h"
+#include "../headercontrols.h"
+#include <cmath>
+
+std::vector<ArrangerTrack> detectControls(StandinFrame& window) {
+    auto& profile = window.profile();
+    auto layout = detectLayout(&window.image, profile, window.frame());
+    std::vector<ArrangerTrack> tracks;
+    detectArrangerTracks(&window.image, profile, window.frame(), layout, tracks);
+    return tracks;
+}
+
+// The box drawStandinLayout paints a button in, centred on a point
+MWRect paintedButton(float scale, int centerX, int centerY) {
+    auto s = [&](int value) {
+        return (int)round((float)value * scale);
+    };
+    return MWRect{centerX - s(13) / 2, centerY - s(11) / 2, s(13), s(11)};
+}
+
+TEST("headerControls/matchPaintedButtons") {
+    struct Case {
+        bool muted, soloed, armed;
+        bool selected;
+        bool group, unfolded;
+    };
+    const Case cases[] = {
+        {false, false, false, false, false, false},
+        {true, false, false, false, false, false},
+        {false, true, true, false, false, false},
+        {true, true, true, true, false, false},
+        // Groups have no arm button, and a fold arrow either way round
+        {false, false, false, false, true, true},
+        {true, false, false, false, true, false},
+        {false, true, false, true, true, true},
+    };
+    for (float scale : {1.f, 1.25f, 1.5f, 2.f}) {
+        auto s = [&](int value) {
+            return (int)round((float)value * scale);
+        };
+        auto layout = standinLayout(scale);
+        layout.tracks.resize(sizeof(cases) / sizeof(cases[0]));
+        for (size_t i = 0; i < layout.tracks.size(); i++) {
+            auto& c = cases[i];
+            auto& track = layout.tracks[i];
+            track.muted = c.muted;
+            track.soloed = c.soloed;
+            track.armed = c.armed;
+            track.selected = c.selected;
+            track.group = c.group;
+            track.unfolded = c.unfolded;
+        }
+        StandinFrame window(layout);
+        auto painted = standinGeometry(layout);
+        auto tracks = detectControls(window);
+        CHECK_EQ(tracks.size(), layout.tracks.size());
+
+        for (size_t i = 0; i < tracks.size() && i < painted.tracks.size(); i++) {
+            auto& c = cases[i];
+            auto& track = tracks[i];
+            auto& rect = painted.tracks[i];
+            auto dividerX = rect.x + painted.trackWidth, buttonY = rect.y + s(10);
+            CHECK(track.mute && track.mute->rect == paintedButton(scale, dividerX - s(30), buttonY));
+            CHECK(track.solo && track.solo->rect == paintedButton(scale, dividerX - s(54), buttonY));
+            CHECK(track.mute && track.mute->on == c.muted);
+            CHECK(track.solo && track.solo->on == c.soloed);
+            if (c.group) {
+                CHECK(!track.arm);
+                auto foldRect = MWRect{rect.x + s(10) - s(4), rect.y + s(32) - s(4), s(9), s(9)};
+                CHECK(track.fold && track.fold->rect == foldRect);
+                CHECK(track.fold && track.fold->on == c.unfolded);
+            } else {
+                CHECK(track.arm && track.arm->rect == paintedButton(scale, dividerX - s(78), buttonY));
+                CHECK(track.arm && track.arm->on == c.armed);
+                CHECK(!track.fold);
+            }
+        }
+    }
+}
+
+TEST("headerControls/onlyFullyVisible") {
+    // Scrolled so the first header's buttons are under the ruler but its fold arrow isn't
+    auto layout = standinLayout();
+    layout.tracks[0].group = true;
+    layout.tracks[0].muted = true;
+    layout.scroll = 20;
+    StandinFrame window(layout);
+    auto painted = standinGeometry(layout);
+    auto tracks = detectControls(window);
+    CHECK(tracks.size() > 1);
+    if (tracks.size() > 1) {
+        CHECK_EQ(tracks[0].header, HEADER_PARTIAL);
+        CHECK(!tracks[0].mute && !tracks[0].solo && !tracks[0].arm);
+        CHECK(tracks[0].fold && tracks[0].fold->rect.y == painted.tracks[0].y + 28);
+        CHECK(tracks[1].mute && tracks[1].solo && tracks[1].arm);
+    }
+
+    // Scrolled past the header altogether, only automation lanes left showing
+    layout = standinLayout();
+    layout.tracks[0].automationOpen = true;
+    layout.tracks[0].height = 45 + 120;
+    layout.scroll = 60;
+    StandinFrame lanesOnly(layout);
+    tracks = detectControls(lanesOnly);
+    CHECK(!tracks.empty());
+    if (!tracks.empty()) {
+        CHECK_EQ(tracks[0].header, HEADER_HIDDEN);
+        CHECK(!tracks[0].mute && !tracks[0].solo && !tracks[0].arm && !tracks[0].fold);
+    }
+}
@@ -0,0 +1,154 @@
+#include "test.h"
+#include "../detect.h"
+#include "../layoutprofile.h"
+#include <stdexcept>
+
+const char* const LARGE = "Single Display (Large)";
+
+// Puts the built in profiles back for whatever runs next
+struct RestoreProfiles {
+    ~RestoreProfiles() {
+        bitwigVersion = "";
+        parseLayoutProfiles("");
+    }
+};
+
+TEST("layoutProfile/scaleRounds") {
+    struct Case {
+        float scale;
+        int point, scaled;
+    };
+    const Case cases[] = {
+        {1, 45, 45},
+        {1, 0, 0},
+        // Halves round away from zero, the same as the stand-in and glyph masks
+        {1.25f, 10, 13},
+        {1.25f, 45, 56},
+        {1.25f, 6, 8},
+        {1.5f, 45, 68},
+        {1.5f, 83, 125},
+        {1.5f, 1, 2},
+        {1.75f, 3, 5},
+        {2, 45, 90},
+        {2, -4, -8},
+        {1.25f, -2, -3},
+    };
+    for (auto& c : cases) {
+        CHECK_EQ(findLayoutProfile(c.scale, LARGE)->scale(c.point), c.scaled);
+    }
+
+    // Every constant is compiled already scaled, scaled separately rather than summed
+    for (float scale : {1.f, 1.25f, 1.5f, 1.75f, 2.f}) {
+        auto& profile = *findLayoutProfile(scale, LARGE);
+        CHECK_EQ(profile.uiScale, scale);
+        int wrong = 0;
+        for (int i = 0; i < LAYOUT_CONSTANT_COUNT; i++) {
+            wrong += profile.get((LayoutConstant)i, true) != profile.scale(profile.get((LayoutConstant)i));
+        }
+        CHECK_EQ(wrong, 0);
+    }
+    CHECK_EQ(findLayoutProfile(1.5f, LARGE)->get(BITWIG_HEADER_HEIGHT, true) + findLayoutProfile(1.5f, LARGE)->get(ARRANGER_HEADER_HEIGHT, true), 193);
+}
+
+TEST("layoutProfile/compiledOncePerKey") {
+    RestoreProfiles restore;
+    auto profile = findLayoutProfile(1.25f, LARGE);
+    CHECK(findLayoutProfile(1.25f, LARGE) == profile);
+    // Keyed by whole percent, so a scale read back from JS a hair off is the same profile
+    CHECK(findLayoutProfile(1.2500001f, LARGE) == profile);
+    CHECK(findLayoutProfile(1.5f, LARGE) != profile);
+    CHECK(findLayoutProfile(1.25f, "Single Display (Small)") != profile);
+    bitwigVersion = "5.1";
+    CHECK(findLayoutProfile(1.25f, LARGE) != profile);
+    bitwigVersion = "";
+    CHECK(findLayoutProfile(1.25f, LARGE) == profile);
+
+    // Reading profiles again compiles new ones, the old stay readable for whoever has them
+    parseLayoutProfiles("[base]\nINSPECTOR_WIDTH = 171\n");
+    auto reloaded = findLayoutProfile(1.25f, LARGE);
+    CHECK(reloaded != profile);
+    CHECK_EQ(reloaded->get(INSPECTOR_WIDTH), 171);
+    CHECK_EQ(profile->get(INSPECTOR_WIDTH), 170);
+}
+
+TEST("layoutProfile/sectionsOverrideInOrder") {
+    RestoreProfiles restore;
+    auto sections = parseLayoutProfiles(
+        "# Comments and blank lines are skipped\n"
+        "\n"
+        "[base]\n"
+        "INSPECTOR_WIDTH = 171\n"
+        "DEVICE_ICON_X = 270   # trailing comment\n"
+        "\n"
+        "[125%]\n"
+        "scale = 125\n"
+        "DEVICE_ICON_X = 271\n"
+        "\n"
+        "[5.1]\n"
+        "version = 5.1\n"
+        "MIXER_ICON_X = 300\n"
+        "\n"
+        "[small]\n"
+        "layout = Single Display (Small)\n"
+        "INSPECTOR_WIDTH = 150\n"
+        "\n"
+        "[5.1 at 125%]\n"
+        "version = 5.1\n"
+        "scale = 125\n"
+        "DEVICE_ICON_X = 272\n"
+    );
+    CHECK_EQ(sections, 5u);
+    struct Case {
+        const char* version;
+        float scale;
+        const char* layout;
+        int inspectorWidth, deviceIconX, mixerIconX;
+    };
+    const Case cases[] = {
+        {"", 1, LARGE, 171, 270, 309},
+        {"", 1.25f, LARGE, 171, 271, 309},
+        {"", 1, "Single Display (Small)", 150, 270, 309},
+        // A version matches its point releases, not versions that only start the same
+        {"5.1", 1, LARGE, 171, 270, 300},
+        {"5.1.3", 1.25f, LARGE, 171, 272, 300},
+        {"5.10", 1.25f, LARGE, 171, 271, 309},
+        {"5.1.3", 1.25f, "Single Display (Small)", 150, 272, 300},
+    };
+    for (auto& c : cases) {
+        bitwigVersion = c.version;
+        auto& profile = *findLayoutProfile(c.scale, c.layout);
+        CHECK_EQ(profile.get(INSPECTOR_WIDTH), c.inspectorWidth);
+        CHECK_EQ(profile.get(DEVICE_ICON_X), c.deviceIconX);
+        CHECK_EQ(profile.get(MIXER_ICON_X), c.mixerIconX);
+        CHECK_EQ(profile.get(INSPECTOR_WIDTH, true), profile.scale(c.inspectorWidth));
+        // Anything no section sets keeps its built in value
+        CHECK_EQ(profile.get(ARRANGER_HEADER_HEIGHT), 45);
+    }
+}
+
+TEST("layoutProfile/badFilesKeepWhatWasThere") {
+    RestoreProfiles restore;
+    parseLayoutProfiles("[base]\nINSPECTOR_WIDTH = 171\n");
+    struct Case {
+        const char* text;
+        const char* error;
+    };
+    const Case cases[] = {
+        {"[base\nINSPECTOR_WIDTH = 1\n", "line 1: unterminated section name"},
+        {"INSPECTOR_WIDTH = 1\n", "line 1: setting outside of a [section]"},
+        {"[base]\n\nINSPECTOR_WIDTH 1\n", "line 3: expected key = value"},
+        {"[base]\nNOT_A_CONSTANT = 1\n", "line 2: unknown setting NOT_A_CONSTANT"},
+        {"[base]\nINSPECTOR_WIDTH = 17o\n", "line 2: INSPECTOR_WIDTH should be a whole number"},
+        {"[base]\nscale = 1.25\n", "line 2: scale should be a whole percentage"},
+    };
+    for (auto& c : cases) {
+        std::string error;
+        try {
+            parseLayoutProfiles(c.text);
+        } catch (const std::runtime_error& e) {
+            error = e.what();
+        }
+        CHECK(error.find(c.error) != std::string::npos);
+        CHECK_EQ(findLayoutProfile(1, LARGE)->get(INSPECTOR_WIDTH), 171);
+    }
+}
@@ -0,0 +1,38 @@
+#include "test.h"
+#include <chrono>
+
+int failedChecks = 0;
+
+std::vector<TestCase>& testCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+void recordTestFailure(const char* file, int line, const std::string& message) {
+    failedChecks++;
+    std::cout << "    " << file << ":" << line << " " << message << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::string filter = argc > 1 ? argv[1] : "";
+    int ran = 0, failed = 0;
+    for (auto& test : testCases()) {
+        if (filter != "" && std::string(test.name).find(filter) == std::string::npos) {
+            continue;
+        }
+        auto before = failedChecks;
+        auto start = std::chrono::steady_clock::now();
+        try {
+            test.run();
+        } catch (const std::exception& error) {
+            recordTestFailure(__FILE__, __LINE__, std::string("threw ") + error.what());
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        bool ok = failedChecks == before;
+        std::cout << (ok ? "ok     " : "FAILED ") << test.name << " (" << ms << "ms)" << std::endl;
+        ran++;
+        failed += !ok;
+    }
+    std::cout << ran << " tests, " << failed << " failed" << std::endl;
+    return failed == 0 && ran > 0 ? 0 : 1;
+}
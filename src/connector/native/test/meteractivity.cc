@@ -0,0 +1,133 @@
+#include "test.h"
+#include "standinframe.h"
+#include "../meteractivity.h"
+#include "../mixerstrips.h"
+#include <algorithm>
+#include <cstring>
+
+/**
+ * A stand-in window with the mixer open, sampled the way activity.cc's thread does: a capture of
+ * just the meters' bounds each tick
+ */
+struct SampledMixer {
+    StandinFrame window;
+    std::vector<int32_t> meters;
+    MWRect bounds;
+    MeterActivity activity;
+
+    SampledMixer(StandinLayout layout) : window(layout) {
+        auto& profile = window.profile();
+        MWRect rect;
+        getMixerRect(profile, detectLayout(&window.image, profile, window.frame()), rect);
+        MixerStrips mixer;
+        detectMixerStrips(&window.image, profile, rect, mixer);
+        meters = mixer.meters;
+        bounds = meterBounds(meters);
+        activity.reset(mixer.stripCount(), 0.05f, 64);
+    }
+
+    std::vector<uint8_t> capture() {
+        std::vector<uint8_t> pixels((size_t)bounds.w * bounds.h * 4);
+        for (int y = 0; y < bounds.h; y++) {
+            memcpy(&pixels[(size_t)y * bounds.w * 4], &window.pixels[((size_t)(bounds.y + y) * window.layout.width + bounds.x) * 4], (size_t)bounds.w * 4);
+        }
+        return pixels;
+    }
+
+    // False if the tick was skipped
+    bool tick(std::vector<ActivityChange>& changes) {
+        auto pixels = capture();
+        FrameImage image(pixels.data(), (size_t)bounds.w * 4, WindowInfo{0, bounds});
+        std::vector<float> levels;
+        if (!sampleMeters(&image, XYPoint{bounds.x, bounds.y}, meters, levels)) {
+            return false;
+        }
+        activity.record(levels, changes);
+        return true;
+    }
+};
+
+TEST("meterActivity/noActivityOnceTheMixerCloses") {
+    for (float scale : {1.f, 1.25f, 2.f}) {
+        auto layout = standinLayout(scale);
+        layout.panel = "mixer";
+        layout.strips.resize(8);
+        SampledMixer mixer(layout);
+        CHECK_EQ(mixer.activity.stripCount(), 8u);
+        std::vector<ActivityChange> changes;
+
+        // Quiet, then one strip goes over the threshold
+        for (int i = 0; i < 3; i++) {
+            CHECK(mixer.tick(changes));
+        }
+        CHECK(changes.empty());
+        mixer.window.layout.strips[2].level = 0.6f;
+        mixer.window.paint();
+        CHECK(mixer.tick(changes));
+        CHECK_EQ(changes.size(), 1u);
+        CHECK(changes.size() == 1 && changes[0].strip == 2 && changes[0].active);
+        changes.clear();
+
+        // Closed, or swapped for the device panel: what's there now would read as lit meters, but
+        // every tick is skipped and nothing is recorded
+        for (auto panel : {"", "device"}) {
+            mixer.window.layout.panel = panel;
+            mixer.window.layout.devices = makeStandinDevices(6);
+            mixer.window.paint();
+            auto pixels = mixer.capture();
+            FrameImage image(pixels.data(), (size_t)mixer.bounds.w * 4, WindowInfo{0, mixer.bounds});
+            std::vector<float> misread;
+            readMeterLevels(&image, XYPoint{mixer.bounds.x, mixer.bounds.y}, mixer.meters, misread);
+            CHECK(std::any_of(misread.begin(), misread.end(), [](float level) { return level >= 0.05f; }));
+
+            for (int i = 0; i < 10; i++) {
+                CHECK(!mixer.tick(changes));
+            }
+            CHECK(changes.empty());
+            CHECK_EQ(mixer.activity.history(0).size(), 4u);
+            CHECK(mixer.activity.isActive(2));
+            CHECK(!mixer.activity.isActive(0));
+        }
+
+        // Open again with the strip quiet, it goes inactive once it's been quiet a few ticks
+        mixer.window.layout.panel = "mixer";
+        mixer.window.layout.strips[2].level = 0;
+        mixer.window.paint();
+        for (int i = 0; i < 3; i++) {
+            CHECK(mixer.tick(changes));
+        }
+        CHECK_EQ(changes.size(), 1u);
+        CHECK(changes.size() == 1 && changes[0].strip == 2 && !changes[0].active);
+    }
+}
+
+TEST("meterActivity/levelsAndThreshold") {
+    MeterActivity activity;
+    activity.reset(2, 0.2f, 4);
+    std::vector<ActivityChange> changes;
+    struct Case {
+        float level;
+        // Strip 0's state after this tick, the loudest of its last 3 levels against 0.2 and 0.1
+        bool active, changed;
+    };
+    const Case cases[] = {
+        {0.1f, false, false},
+        {0.2f, true, true},
+        {0.05f, true, false},
+        {0.05f, true, false},
+        // Under half the threshold for 3 ticks in a row
+        {0.05f, false, true},
+        {0.15f, false, false},
+        {0.3f, true, true},
+    };
+    for (auto& c : cases) {
+        changes.clear();
+        activity.record({c.level, 0}, changes);
+        CHECK_EQ(activity.isActive(0), c.active);
+        CHECK_EQ(changes.size(), c.changed ? 1u : 0u);
+        CHECK(!activity.isActive(1));
+    }
+    // Capacity 4, oldest first
+    CHECK((activity.history(0) == std::vector<float>{0.05f, 0.05f, 0.15f, 0.3f}));
+    CHECK((activity.history(1) == std::vector<float>{0, 0, 0, 0}));
+}
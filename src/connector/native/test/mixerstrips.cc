@@ -0,0 +1,128 @@
+#include "test.h"
+#include "standinframe.h"
+#include "../mixerstrips.h"
+#include <cmath>
+#include <cstring>
+
+StandinLayout mixerLayout(float scale, std::vector<StandinStrip> strips, int stripWidth = 64) {
+    auto layout = standinLayout(scale);
+    layout.panel = "mixer";
+    layout.strips = strips;
+    layout.stripWidth = stripWidth;
+    return layout;
+}
+
+TEST("mixer/matchesPainted") {
+    auto some = makeStandinStrips(6);
+    some[2].selected = true;
+    // Meters empty and full, faders at either end
+    some[0].level = 0;
+    some[1].level = 1;
+    some[3].fader = 0;
+    some[4].fader = 1;
+    auto many = makeStandinStrips(40);
+    many[17].selected = true;
+    struct Case {
+        const char* name;
+        std::vector<StandinStrip> strips;
+        int stripWidth;
+    };
+    const Case cases[] = {
+        {"some", some, 64},
+        // More than fit, the rest aren't drawn
+        {"many", many, 64},
+        {"wide", some, 90},
+    };
+    for (float scale : {1.f, 1.25f, 2.f}) {
+        for (auto& c : cases) {
+            auto layout = mixerLayout(scale, c.strips, c.stripWidth);
+            StandinFrame window(layout);
+            auto& profile = window.profile();
+            auto painted = standinGeometry(layout);
+            auto detected = detectLayout(&window.image, profile, window.frame());
+            MWRect rect;
+            CHECK(getMixerRect(profile, detected, rect));
+            CHECK(rect == (MWRect{painted.editor.x + profile.scale(4), painted.editor.y + 1, painted.editor.w - profile.scale(8), painted.editor.h - 1}));
+
+            MixerStrips mixer;
+            detectMixerStrips(&window.image, profile, rect, mixer);
+            CHECK_EQ(mixer.stripCount(), painted.strips.size());
+            int selected = -1;
+            for (size_t i = 0; i < painted.strips.size(); i++) {
+                if (layout.strips[i].selected) {
+                    selected = i;
+                }
+            }
+            CHECK_EQ(mixer.selected, selected);
+
+            int wrong = 0;
+            for (size_t i = 0; i < mixer.stripCount() && i < painted.strips.size(); i++) {
+                // Strips are found across, they're given the whole height of the panel
+                auto& strip = painted.strips[i];
+                auto& meter = painted.meters[i];
+                auto s = [&](int value) {
+                    return (int)round((float)value * scale);
+                };
+                auto expectedStrip = MWRect{strip.x, rect.y, strip.w, rect.h};
+                auto expectedFader = MWRect{strip.x + s(4), meter.y, s(4), meter.h};
+                auto expectedMeter = MWRect{meter.x, meter.y, meter.w, meter.h};
+                auto at = [&](std::vector<int32_t>& packed) {
+                    return MWRect{packed[i * 4], packed[i * 4 + 1], packed[i * 4 + 2], packed[i * 4 + 3]};
+                };
+                wrong += !(at(mixer.strips) == expectedStrip);
+                wrong += !(at(mixer.faders) == expectedFader);
+                wrong += !(at(mixer.meters) == expectedMeter);
+            }
+            CHECK_EQ(wrong, 0);
+        }
+    }
+
+    // No mixer open, no strips
+    for (auto panel : {"", "device"}) {
+        auto layout = standinLayout();
+        layout.panel = panel;
+        StandinFrame window(layout);
+        MWRect rect;
+        CHECK(!getMixerRect(window.profile(), detectLayout(&window.image, window.profile(), window.frame()), rect));
+    }
+}
+
+TEST("mixer/meterLevels") {
+    for (float scale : {1.f, 1.25f, 2.f}) {
+        auto layout = mixerLayout(scale, makeStandinStrips(12));
+        layout.strips[0].level = 0;
+        layout.strips[1].level = 1;
+        StandinFrame window(layout);
+        auto& profile = window.profile();
+        auto painted = standinGeometry(layout);
+        MWRect rect;
+        getMixerRect(profile, detectLayout(&window.image, profile, window.frame()), rect);
+        MixerStrips mixer;
+        detectMixerStrips(&window.image, profile, rect, mixer);
+
+        // Read from the whole window, and from a capture of just the meters
+        auto bounds = meterBounds(mixer.meters);
+        CHECK(bounds == (MWRect{painted.meters.front().x, painted.meters.front().y, painted.meters.back().x + painted.meters.back().w - painted.meters.front().x, painted.meters.front().h}));
+        std::vector<uint8_t> capture((size_t)bounds.w * bounds.h * 4);
+        for (int y = 0; y < bounds.h; y++) {
+            memcpy(&capture[(size_t)y * bounds.w * 4], &window.pixels[((size_t)(bounds.y + y) * layout.width + bounds.x) * 4], (size_t)bounds.w * 4);
+        }
+        FrameImage meters(capture.data(), (size_t)bounds.w * 4, WindowInfo{0, bounds});
+
+        std::vector<float> fromWindow, fromCapture;
+        readMeterLevels(&window.image, XYPoint{0, 0}, mixer.meters, fromWindow);
+        readMeterLevels(&meters, XYPoint{bounds.x, bounds.y}, mixer.meters, fromCapture);
+        CHECK_EQ(fromWindow.size(), painted.meters.size());
+        CHECK(fromWindow == fromCapture);
+        for (size_t i = 0; i < fromWindow.size() && i < painted.meters.size(); i++) {
+            auto height = painted.meters[i].h;
+            auto lit = (int)(std::min(1.f, std::max(0.f, layout.strips[i].level)) * height);
+            CHECK_EQ(fromWindow[i], (float)lit / height);
+        }
+
+        // A capture that misses a meter reads it as 0
+        std::vector<float> partial;
+        readMeterLevels(&meters, XYPoint{bounds.x + painted.meters[1].x - painted.meters[0].x, bounds.y}, mixer.meters, partial);
+        CHECK_EQ(partial[0], 0.f);
+    }
+}
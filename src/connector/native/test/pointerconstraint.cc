@@ -0,0 +1,108 @@
+#include "test.h"
+#include "../pointerconstraint.h"
+
+TEST("pointerConstraint/inactiveLeavesMovesAlone") {
+    PointerConstrainer constrainer;
+    double x = 50, y = 60;
+    CHECK(!constrainer.isActive());
+    CHECK(!constrainer.constrain(x, y, 10, 10));
+    CHECK_EQ(x, 50);
+    CHECK_EQ(y, 60);
+
+    // A constraint with nothing set doesn't become active either
+    constrainer.set(PointerConstraint(), 0, 0);
+    CHECK(!constrainer.isActive());
+}
+
+TEST("pointerConstraint/lockX") {
+    PointerConstrainer constrainer;
+    PointerConstraint constraint;
+    constraint.lockX = true;
+    constrainer.set(constraint, 100, 200);
+    CHECK(constrainer.isActive());
+
+    double x = 130, y = 240;
+    CHECK(constrainer.constrain(x, y, 30, 40));
+    CHECK_EQ(x, 100);
+    CHECK_EQ(y, 240);
+
+    // Moving only along the free axis changes nothing
+    x = 100, y = 250;
+    CHECK(!constrainer.constrain(x, y, 0, 10));
+    CHECK_EQ(y, 250);
+}
+
+TEST("pointerConstraint/lockY") {
+    PointerConstrainer constrainer;
+    PointerConstraint constraint;
+    constraint.lockY = true;
+    constrainer.set(constraint, 100, 200);
+    double x = 90, y = 150;
+    CHECK(constrainer.constrain(x, y, -10, -50));
+    CHECK_EQ(x, 90);
+    CHECK_EQ(y, 200);
+}
+
+TEST("pointerConstraint/clamp") {
+    PointerConstrainer constrainer;
+    PointerConstraint constraint;
+    constraint.clamp = true;
+    constraint.clampX = 10, constraint.clampY = 20, constraint.clampW = 100, constraint.clampH = 50;
+    constrainer.set(constraint, 50, 40);
+    double x = 500, y = 0;
+    CHECK(constrainer.constrain(x, y, 450, -40));
+    CHECK_EQ(x, 109);
+    CHECK_EQ(y, 20);
+}
+
+TEST("pointerConstraint/scaleUsesEventDeltas") {
+    PointerConstrainer constrainer;
+    PointerConstraint constraint;
+    constraint.scale = 0.25;
+    constrainer.set(constraint, 100, 100);
+
+    double x = 140, y = 100;
+    CHECK(constrainer.constrain(x, y, 40, 0));
+    CHECK_EQ(x, 110);
+    CHECK_EQ(y, 100);
+
+    // The cursor didn't follow where we sent it (still at 140), the next event's location is
+    // relative to that but its delta isn't. Movement mustn't build up from the difference
+    x = 180, y = 100;
+    constrainer.constrain(x, y, 40, 0);
+    CHECK_EQ(x, 120);
+    x = 220, y = 120;
+    constrainer.constrain(x, y, 40, 20);
+    CHECK_EQ(x, 130);
+    CHECK_EQ(y, 105);
+}
+
+TEST("pointerConstraint/scaleWithLock") {
+    PointerConstrainer constrainer;
+    PointerConstraint constraint;
+    constraint.scale = 0.5;
+    constraint.lockY = true;
+    constrainer.set(constraint, 0, 300);
+    double x = 20, y = 330;
+    constrainer.constrain(x, y, 20, 30);
+    CHECK_EQ(x, 10);
+    CHECK_EQ(y, 300);
+}
+
+TEST("pointerConstraint/clear") {
+    PointerConstrainer constrainer;
+    PointerConstraint constraint;
+    constraint.lockX = true;
+    constrainer.set(constraint, 100, 100);
+    constrainer.clear();
+    CHECK(!constrainer.isActive());
+    double x = 150, y = 150;
+    CHECK(!constrainer.constrain(x, y, 50, 50));
+    CHECK_EQ(x, 150);
+
+    // Setting again anchors where the pointer is now, not where it was the first time
+    constrainer.set(constraint, 150, 150);
+    x = 170;
+    CHECK(constrainer.constrain(x, y, 20, 0));
+    CHECK_EQ(x, 150);
+}
@@ -0,0 +1,151 @@
+#include "test.h"
+#include "../processtable.h"
+#include <thread>
+#include <unistd.h>
+
+// Above any pid_max, so kill(pid, 0) always says it's gone
+const pid_t deadPid = 0x3ffffff0;
+
+/**
+ * Processes by name, and whether the platform would watch them. Tests call the table's
+ * notifications themselves where a platform source would
+ */
+class FakeProcessSource : public ProcessSource {
+public:
+    std::map<std::string, pid_t> running;
+    bool canWatch = true;
+    int lookupCalls = 0, watchCalls = 0;
+
+    pid_t lookup(const std::string& name) override {
+        lookupCalls++;
+        auto it = running.find(name);
+        return it == running.end() ? -1 : it->second;
+    }
+
+    bool watch(pid_t, ProcessTable*) override {
+        watchCalls++;
+        return canWatch;
+    }
+};
+
+TEST("processTable/watchedPidIsCached") {
+    FakeProcessSource source;
+    source.running["Bitwig Studio"] = deadPid;
+    ProcessTable table(&source);
+
+    // Watched, so it's trusted without asking the kernel until we're told it exited
+    CHECK_EQ(table.find("Bitwig Studio"), deadPid);
+    CHECK_EQ(table.find("Bitwig Studio"), deadPid);
+    CHECK_EQ(source.lookupCalls, 1);
+    CHECK_EQ(source.watchCalls, 1);
+    CHECK(table.isAlive(deadPid));
+}
+
+TEST("processTable/exitNotifiesAndLooksUpAgain") {
+    FakeProcessSource source;
+    source.running["Bitwig Studio"] = 100;
+    source.running["Other"] = 200;
+    ProcessTable table(&source);
+    std::vector<std::pair<std::string, pid_t>> exits;
+    table.addExitListener([&](const std::string& name, pid_t pid) {
+        exits.push_back({name, pid});
+    });
+    CHECK_EQ(table.find("Bitwig Studio"), 100);
+    CHECK_EQ(table.find("Other"), 200);
+
+    source.running["Bitwig Studio"] = 101;
+    table.exited(100);
+    CHECK((exits == std::vector<std::pair<std::string, pid_t>>{{"Bitwig Studio", 100}}));
+    CHECK_EQ(table.find("Bitwig Studio"), 101);
+    CHECK_EQ(source.lookupCalls, 3);
+
+    // Pids we don't know about are nobody's business
+    table.exited(300);
+    CHECK_EQ(exits.size(), 1u);
+    CHECK_EQ(table.find("Other"), 200);
+    CHECK_EQ(source.lookupCalls, 3);
+}
+
+TEST("processTable/removedListenerIsntCalled") {
+    FakeProcessSource source;
+    source.running["Bitwig Studio"] = 100;
+    ProcessTable table(&source);
+    int calls = 0;
+    int id = table.addExitListener([&](const std::string&, pid_t) {
+        calls++;
+    });
+    table.find("Bitwig Studio");
+    table.removeExitListener(id);
+    table.exited(100);
+    CHECK_EQ(calls, 0);
+}
+
+TEST("processTable/listenerCanLookUpAgain") {
+    FakeProcessSource source;
+    source.running["Bitwig Studio"] = 100;
+    ProcessTable table(&source);
+    pid_t relaunched = 0;
+    table.addExitListener([&](const std::string& name, pid_t) {
+        // Called outside the table's lock, or this would deadlock
+        source.running[name] = 102;
+        relaunched = table.find(name);
+    });
+    table.find("Bitwig Studio");
+    table.exited(100);
+    CHECK_EQ(relaunched, 102);
+}
+
+TEST("processTable/notRunningIsRememberedUntilLaunch") {
+    FakeProcessSource source;
+    ProcessTable table(&source);
+    CHECK_EQ(table.find("Bitwig Studio"), -1);
+    CHECK_EQ(table.find("Bitwig Studio"), -1);
+    CHECK_EQ(source.lookupCalls, 1);
+
+    // Starting it isn't noticed until something forks (or the retry passes)...
+    source.running["Bitwig Studio"] = 100;
+    CHECK_EQ(table.find("Bitwig Studio"), -1);
+    table.launched();
+    CHECK_EQ(table.find("Bitwig Studio"), 100);
+    CHECK_EQ(source.lookupCalls, 2);
+
+    // ...and a launch doesn't make running entries look up again
+    table.launched();
+    CHECK_EQ(table.find("Bitwig Studio"), 100);
+    CHECK_EQ(source.lookupCalls, 2);
+}
+
+TEST("processTable/notRunningIsRetried") {
+    FakeProcessSource source;
+    ProcessTable table(&source);
+    CHECK_EQ(table.find("Bitwig Studio"), -1);
+    source.running["Bitwig Studio"] = 100;
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    CHECK_EQ(table.find("Bitwig Studio"), 100);
+    CHECK_EQ(source.lookupCalls, 2);
+}
+
+TEST("processTable/unwatchedPidIsChecked") {
+    FakeProcessSource source;
+    source.canWatch = false;
+    source.running["Bitwig Studio"] = getpid();
+    source.running["Gone"] = deadPid;
+    ProcessTable table(&source);
+    std::vector<std::string> exited;
+    table.addExitListener([&](const std::string& name, pid_t) {
+        exited.push_back(name);
+    });
+
+    // We're alive, so no notification is needed to trust it
+    CHECK_EQ(table.find("Bitwig Studio"), getpid());
+    CHECK_EQ(table.find("Bitwig Studio"), getpid());
+    CHECK_EQ(source.lookupCalls, 1);
+    CHECK(table.isAlive(getpid()));
+
+    // Nobody says when this one goes, the next find notices and tells listeners itself
+    CHECK_EQ(table.find("Gone"), deadPid);
+    source.running.erase("Gone");
+    CHECK_EQ(table.find("Gone"), -1);
+    CHECK(exited == std::vector<std::string>{"Gone"});
+    CHECK(!table.isAlive(deadPid));
+}
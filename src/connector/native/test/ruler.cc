@@ -0,0 +1,196 @@
+#include "test.h"
+#include "standinframe.h"
+#include "../ruler.h"
+#include <cmath>
+
+// Where the stand-in paints bar ticks, measured the way drawStandinLayout does
+std::vector<int> paintedTicks(const StandinLayout& layout, const StandinGeometry& g) {
+    auto s = [&](int value) {
+        return (int)round((float)value * layout.scale);
+    };
+    std::vector<int> ticks;
+    auto barWidth = std::max(4, layout.barWidth);
+    for (int bar = -(layout.timelineScroll % barWidth); g.timelineX + s(bar) < g.timelineEnd; bar += barWidth) {
+        if (bar >= 0) {
+            ticks.push_back(g.timelineX + s(bar));
+        }
+    }
+    return ticks;
+}
+
+int paintedX(const StandinLayout& layout, const StandinGeometry& g, int fromTimeline) {
+    return g.timelineX + (int)round((float)(fromTimeline - layout.timelineScroll) * layout.scale);
+}
+
+/**
+ * A stand-in window and the tracker reading it, the way updateRuler does
+ */
+struct RulerWindow {
+    StandinFrame window;
+    BitwigLayout detected;
+    StandinGeometry painted;
+    RulerTracker tracker;
+
+    RulerWindow(StandinLayout layout) : window(layout) {
+        repaint();
+    }
+    void repaint() {
+        window.paint();
+        detected = detectLayout(&window.image, window.profile(), window.frame());
+        painted = standinGeometry(window.layout);
+    }
+    const RulerState& update() {
+        return tracker.update(&window.image, window.profile(), detected, painted.timelineX);
+    }
+};
+
+TEST("ruler/matchesPainted") {
+    struct Case {
+        float scale;
+        int barWidth, timelineScroll;
+        int selectionStart, selectionEnd;
+        int playhead;
+    };
+    const Case cases[] = {
+        {1, 80, 0, -1, -1, -1},
+        {1, 80, 0, 160, 400, 200},
+        // Scrolled, so the first tick isn't at the start of the timeline and the selection is cut off
+        {1, 64, 30, 10, 300, 517},
+        {1.25f, 75, 0, 150, 225, 90},
+        {1.25f, 80, 45, 0, 1000, 333},
+        {2, 40, 0, 80, 120, -1},
+        {2, 100, 250, 300, 700, 610},
+    };
+    for (auto& c : cases) {
+        auto layout = standinLayout(c.scale);
+        layout.barWidth = c.barWidth;
+        layout.timelineScroll = c.timelineScroll;
+        layout.selectionStart = c.selectionStart;
+        layout.selectionEnd = c.selectionEnd;
+        layout.playhead = c.playhead;
+        RulerWindow ruler(layout);
+        auto& g = ruler.painted;
+        auto& state = ruler.update();
+
+        CHECK(!ruler.tracker.lastUpdateIncremental);
+        CHECK(state.rect == (MWRect{g.timelineX, g.arranger.y, g.timelineEnd - g.timelineX, g.tracksTop - g.arranger.y}));
+        CHECK(state.ticks == paintedTicks(layout, g));
+        CHECK(fabs(state.tickSpacing - c.barWidth * c.scale) < 1);
+        CHECK_EQ(state.playheadX, c.playhead == -1 ? -1 : paintedX(layout, g, c.playhead));
+        if (c.selectionStart == -1) {
+            CHECK_EQ(state.selectionStart, -1);
+            CHECK_EQ(state.selectionEnd, -1);
+        } else {
+            CHECK_EQ(state.selectionStart, std::max(g.timelineX, paintedX(layout, g, c.selectionStart)));
+            CHECK_EQ(state.selectionEnd, std::min(g.timelineEnd, paintedX(layout, g, c.selectionEnd)));
+        }
+    }
+
+    // Nothing to read under a modal
+    auto layout = standinLayout();
+    layout.modalOpen = true;
+    RulerWindow covered(layout);
+    CHECK(covered.update().rect == (MWRect{0, 0, 0, 0}));
+}
+
+TEST("ruler/onlyThePlayheadMoving") {
+    for (float scale : {1.f, 1.25f, 2.f}) {
+        auto layout = standinLayout(scale);
+        layout.selectionStart = 160;
+        layout.selectionEnd = 320;
+        layout.playhead = 100;
+        RulerWindow ruler(layout);
+        auto ticks = ruler.update().ticks;
+        CHECK(!ruler.tracker.lastUpdateIncremental);
+
+        // Playing: each step moves it into a new tile or within one, through the selection too
+        for (int playhead : {101, 140, 170, 171, 330, 900}) {
+            ruler.window.layout.playhead = playhead;
+            ruler.repaint();
+            auto& state = ruler.update();
+            CHECK(ruler.tracker.lastUpdateIncremental);
+            CHECK_EQ(state.playheadX, paintedX(ruler.window.layout, ruler.painted, playhead));
+            CHECK(state.ticks == ticks);
+        }
+
+        // The same frame again is nothing to do
+        ruler.update();
+        CHECK(ruler.tracker.lastUpdateIncremental);
+
+        // Anything else changing is a full read
+        struct Change {
+            const char* name;
+            std::function<void(StandinLayout&)> apply;
+        };
+        const Change changes[] = {
+            {"selection", [](StandinLayout& l) { l.selectionEnd = 480; }},
+            {"scroll", [](StandinLayout& l) { l.timelineScroll = 30; }},
+            {"zoom", [](StandinLayout& l) { l.barWidth = 120; }},
+        };
+        for (auto& change : changes) {
+            change.apply(ruler.window.layout);
+            ruler.repaint();
+            auto& state = ruler.update();
+            CHECK(!ruler.tracker.lastUpdateIncremental);
+            CHECK(state.ticks == paintedTicks(ruler.window.layout, ruler.painted));
+            CHECK_EQ(state.selectionEnd, paintedX(ruler.window.layout, ruler.painted, ruler.window.layout.selectionEnd));
+        }
+    }
+}
+
+TEST("ruler/anchoring") {
+    // 80px bars of 4 beats, so 20px a beat with the timeline starting at beat 0
+    auto layout = standinLayout();
+    layout.playhead = 0;
+    RulerWindow ruler(layout);
+    ruler.update();
+    auto xAtBeat = [&](double beat) {
+        return paintedX(ruler.window.layout, ruler.painted, (int)(beat * 20));
+    };
+
+    // One anchor places nothing, the second gives the scale
+    CHECK(ruler.tracker.anchor(xAtBeat(4), 4));
+    CHECK(!ruler.tracker.getTransform());
+    CHECK(ruler.tracker.anchor(xAtBeat(6), 6));
+    auto transform = ruler.tracker.getTransform();
+    CHECK(transform);
+    if (transform) {
+        CHECK(fabs(transform->pixelsPerBeat - 20) < 0.01);
+        CHECK(fabs(transform->beatAt(xAtBeat(10)) - 10) < 0.01);
+        CHECK_EQ((int)round(transform->xAt(2)), xAtBeat(2));
+    }
+    // One that disagrees is turned down, outside the ruler too
+    CHECK(!ruler.tracker.anchor(xAtBeat(6) + 10, 6));
+    CHECK(!ruler.tracker.anchor(ruler.painted.timelineX - 1, 0));
+    CHECK(ruler.tracker.anchor(xAtBeat(8), 8));
+
+    // Scrolled a bar and a half: the scale holds, one anchor puts the origin back
+    ruler.window.layout.timelineScroll = 120;
+    ruler.repaint();
+    ruler.update();
+    CHECK(!ruler.tracker.getTransform());
+    CHECK(ruler.tracker.anchor(xAtBeat(12), 12));
+    transform = ruler.tracker.getTransform();
+    CHECK(transform && fabs(transform->beatAt(xAtBeat(20)) - 20) < 0.01);
+
+    // Zoomed: the scale goes too, and needs two anchors again
+    ruler.window.layout.barWidth = 160;
+    ruler.repaint();
+    ruler.update();
+    CHECK(!ruler.tracker.getTransform());
+    auto zoomedX = [&](double beat) {
+        return paintedX(ruler.window.layout, ruler.painted, (int)(beat * 40));
+    };
+    CHECK(ruler.tracker.anchor(zoomedX(4), 4));
+    CHECK(!ruler.tracker.getTransform());
+    CHECK(ruler.tracker.anchor(zoomedX(5), 5));
+    transform = ruler.tracker.getTransform();
+    CHECK(transform && fabs(transform->pixelsPerBeat - 40) < 0.01);
+
+    // Two anchors that would put a tick 11 and a bit beats apart aren't believed
+    RulerWindow fresh(layout);
+    fresh.update();
+    CHECK(fresh.tracker.anchor(fresh.painted.timelineX + 100, 0));
+    CHECK(!fresh.tracker.anchor(fresh.painted.timelineX + 170, 10));
+    CHECK(!fresh.tracker.getTransform());
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "../detect.h"
+#include "../layoutprofile.h"
+#include "../standin/layout.h"
+#include <vector>
+
+// Eight tracks at the default height and nothing else open, the window sized to match scale
+inline StandinLayout standinLayout(float scale = 1) {
+    StandinLayout layout;
+    layout.scale = scale;
+    layout.width = (int)(layout.width * scale);
+    layout.height = (int)(layout.height * scale);
+    layout.tracks.resize(8);
+    return layout;
+}
+
+/**
+ * A stand-in window painted into memory (see standin/layout.h), for checking what the detectors
+ * find against what was drawn. Call paint() again after changing layout
+ */
+struct StandinFrame {
+    StandinLayout layout;
+    std::vector<uint8_t> pixels;
+    FrameImage image;
+
+    StandinFrame(StandinLayout layout = standinLayout()) : layout(layout) {
+        paint();
+    }
+    // image points into pixels
+    StandinFrame(const StandinFrame&) = delete;
+
+    void paint() {
+        auto bytesPerRow = (size_t)layout.width * 4;
+        pixels.assign(bytesPerRow * layout.height, 0);
+        drawStandinLayout(layout, pixels.data(), bytesPerRow);
+        image = FrameImage(pixels.data(), bytesPerRow, WindowInfo{0, frame()});
+    }
+
+    MWRect frame() const {
+        return MWRect{0, 0, layout.width, layout.height};
+    }
+
+    const LayoutProfile& profile() const {
+        return *findLayoutProfile(layout.scale, "Single Display (Large)");
+    }
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Just enough of a test runner for the native modules that have no N-API or display code:
+ *
+ *   npm run test:native
+ *
+ * TEST(name) { ... } registers a test, CHECK(condition) and CHECK_EQ(a, b) record a failure and
+ * carry on. bes_tests runs every test (or those whose name contains its one argument) and exits
+ * non-zero if any check failed.
+ */
+struct TestCase {
+    const char* name;
+    std::function<void()> run;
+};
+
+std::vector<TestCase>& testCases();
+void recordTestFailure(const char* file, int line, const std::string& message);
+
+struct TestRegistration {
+    TestRegistration(const char* name, std::function<void()> run) {
+        testCases().push_back(TestCase{name, run});
+    }
+};
+
+#define TEST_CONCAT_(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_(a, b)
+#define TEST(name) \
+    static void TEST_CONCAT(test_, __LINE__)(); \
+    static TestRegistration TEST_CONCAT(testRegistration_, __LINE__)(name, TEST_CONCAT(test_, __LINE__)); \
+    static void TEST_CONCAT(test_, __LINE__)()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            recordTestFailure(__FILE__, __LINE__, "CHECK(" #condition ")"); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        auto checkA = (a); \
+        auto checkB = (b); \
+        if (!(checkA == checkB)) { \
+            std::stringstream checkMessage; \
+            checkMessage << "CHECK_EQ(" #a ", " #b "): " << checkA << " != " << checkB; \
+            recordTestFailure(__FILE__, __LINE__, checkMessage.str()); \
+        } \
+    } while (0)
@@ -0,0 +1,233 @@
+#include "test.h"
+#include "fakewindowsource.h"
+#include "../windowgeometry.h"
+#include <algorithm>
+#include <map>
+#include <thread>
+
+GeometryTarget targetAt(double x, double y) {
+    GeometryTarget target;
+    target.x = x;
+    target.y = y;
+    return target;
+}
+
+std::map<std::string, std::string> resultsById(const GeometryTransaction& transaction) {
+    std::map<std::string, std::string> out;
+    for (auto& pair : transaction.results()) {
+        out[pair.first] = pair.second;
+    }
+    return out;
+}
+
+// As pluginwindows.cc does it, minus the Promise
+void applyAll(GeometryTransaction& transaction) {
+    for (size_t i = 0; i < transaction.changes.size(); i++) {
+        transaction.apply(i);
+    }
+    transaction.finish();
+}
+
+PluginWindow fetched(FakePluginWindowSource& source, uint64_t key) {
+    PluginWindow window;
+    source.fetch(key, window);
+    return window;
+}
+
+// key is 0 if the registry doesn't have it
+PluginWindow cached(PluginWindowRegistry& registry, uint64_t key) {
+    auto windows = registry.windows();
+    auto it = std::find_if(windows->begin(), windows->end(), [=](const PluginWindow& window) {
+        return window.key == key;
+    });
+    return it == windows->end() ? PluginWindow() : *it;
+}
+
+TEST("windowGeometry/subPixelChangesAreSkipped") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 100, 100));
+    source.put(makePluginWindow(2, 600, 100));
+    PluginWindowRegistry registry(&source);
+
+    GeometryTransaction transaction(registry, false);
+    auto nudged = targetAt(100.4, 99.6);
+    transaction.add("Plugin 1", &nudged);
+    // Only the size differs by a pixel or more, so it's resized but not moved
+    GeometryTarget wider;
+    wider.w = 401;
+    wider.x = 600.9;
+    transaction.add("Plugin 2", &wider);
+    applyAll(transaction);
+
+    auto results = resultsById(transaction);
+    CHECK_EQ(results["Plugin 1"], "unchanged");
+    CHECK_EQ(results["Plugin 2"], "applied");
+    CHECK_EQ(source.moveCalls, 0);
+    CHECK_EQ(source.resizeCalls, 1);
+    CHECK_EQ(fetched(source, 1).x, 100);
+    CHECK_EQ(fetched(source, 2).w, 401);
+    CHECK_EQ(fetched(source, 2).x, 600);
+}
+
+TEST("windowGeometry/missingWindowsAreReported") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 100, 100));
+    PluginWindowRegistry registry(&source);
+
+    GeometryTransaction transaction(registry, false);
+    auto target = targetAt(0, 0);
+    transaction.add("Not There", &target);
+    // A target that wasn't an object
+    transaction.add("Plugin 1", nullptr);
+    // Found by windowId as well as title
+    transaction.add("1", &target);
+    applyAll(transaction);
+
+    auto results = resultsById(transaction);
+    CHECK_EQ(results["Not There"], "missing");
+    CHECK_EQ(results["Plugin 1"], "missing");
+    CHECK_EQ(results["1"], "applied");
+    CHECK_EQ(source.moveCalls, 1);
+    CHECK_EQ(fetched(source, 1).x, 0);
+}
+
+TEST("windowGeometry/failurePartWayRollsBack") {
+    FakePluginWindowSource source;
+    for (uint64_t key = 1; key <= 3; key++) {
+        source.put(makePluginWindow(key, key * 100.0, 50, 400, 300));
+    }
+    PluginWindowRegistry registry(&source);
+
+    GeometryTransaction transaction(registry, true);
+    GeometryTarget target;
+    target.x = 1000;
+    target.w = 200;
+    for (uint64_t key = 1; key <= 3; key++) {
+        transaction.add("Plugin " + std::to_string(key), &target);
+    }
+    // Closed after we looked, so its resize fails after the first window has changed
+    source.remove(2);
+    applyAll(transaction);
+
+    auto results = resultsById(transaction);
+    CHECK_EQ(results["Plugin 1"], "rolledBack");
+    CHECK_EQ(results["Plugin 2"], "failed");
+    CHECK_EQ(results["Plugin 3"], "rolledBack");
+    for (uint64_t key : {1, 3}) {
+        auto window = fetched(source, key);
+        CHECK_EQ(window.x, key * 100.0);
+        CHECK_EQ(window.w, 400);
+    }
+    // 3 resizes and 2 moves forward (the failed one stops at its resize), 2 of each back
+    CHECK_EQ(source.resizeCalls, 5);
+    CHECK_EQ(source.moveCalls, 4);
+}
+
+TEST("windowGeometry/failureWithoutRollbackKeepsTheRest") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 100, 50));
+    source.put(makePluginWindow(2, 200, 50));
+    PluginWindowRegistry registry(&source);
+
+    GeometryTransaction transaction(registry, false);
+    auto target = targetAt(1000, 50);
+    transaction.add("Plugin 1", &target);
+    transaction.add("Plugin 2", &target);
+    source.remove(2);
+    applyAll(transaction);
+
+    auto results = resultsById(transaction);
+    CHECK_EQ(results["Plugin 1"], "applied");
+    CHECK_EQ(results["Plugin 2"], "failed");
+    CHECK_EQ(fetched(source, 1).x, 1000);
+}
+
+TEST("windowGeometry/restoreMovesWhenTheCacheIsBehind") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 100, 100));
+    PluginWindowRegistry registry(&source);
+    registry.windows();
+
+    // Moved away without the registry hearing about it, as when a clear wasn't confirmed
+    source.move(1, 1919, 1079);
+    auto home = targetAt(100, 100);
+
+    GeometryTransaction diffed(registry, false);
+    diffed.add("1", &home);
+    applyAll(diffed);
+    CHECK_EQ(resultsById(diffed)["1"], "unchanged");
+    CHECK_EQ(fetched(source, 1).x, 1919);
+
+    GeometryTransaction restore(registry, false, true);
+    restore.add("1", &home);
+    applyAll(restore);
+    CHECK_EQ(resultsById(restore)["1"], "applied");
+    CHECK_EQ(fetched(source, 1).x, 100);
+    CHECK_EQ(fetched(source, 1).y, 100);
+    CHECK_EQ(source.resizeCalls, 0);
+}
+
+TEST("windowGeometry/clearMovesOnlyOverlappingWindows") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 100, 100));
+    source.put(makePluginWindow(2, 600, 100));
+    source.put(makePluginWindow(3, 300, 300));
+    PluginWindowRegistry registry(&source);
+
+    ClearTransaction transaction(registry, 350, 350, 10, 10, std::chrono::milliseconds(50));
+    CHECK_EQ(transaction.windows.size(), 2u);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < transaction.windows.size(); i++) {
+        threads.emplace_back([&, i]() {
+            transaction.clear(i);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    CHECK_EQ(transaction.unconfirmed.load(), 0);
+    CHECK_EQ(source.moveCalls, 2);
+    for (uint64_t key : {1, 3}) {
+        CHECK_EQ(fetched(source, key).x, 1919);
+        // Confirmed frames go straight into the cache, without a notification or re-read
+        CHECK_EQ(cached(registry, key).x, 1919);
+    }
+    CHECK_EQ(fetched(source, 2).x, 600);
+    CHECK_EQ(source.fetchAllCalls, 1);
+
+    // What the Promise hands back is where they were
+    CHECK_EQ(transaction.windows[0].second.x, 100);
+    CHECK_EQ(transaction.windows[1].second.x, 300);
+}
+
+TEST("windowGeometry/clearCountsUnconfirmedMoves") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 100, 100));
+    source.put(makePluginWindow(2, 150, 150));
+    PluginWindowRegistry registry(&source);
+
+    ClearTransaction transaction(registry, 200, 200, 10, 10, std::chrono::milliseconds(5));
+    source.ignoreMoves = true;
+    auto start = std::chrono::steady_clock::now();
+    transaction.clear(0);
+    transaction.clear(1);
+    CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(5));
+
+    CHECK_EQ(transaction.unconfirmed.load(), 2);
+    // Nothing confirmed, nothing cached
+    CHECK_EQ(cached(registry, 1).x, 100);
+    CHECK_EQ(cached(registry, 2).x, 150);
+}
+
+TEST("windowGeometry/clearDropsClosedWindows") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 100, 100));
+    PluginWindowRegistry registry(&source);
+
+    ClearTransaction transaction(registry, 200, 200, 10, 10, std::chrono::milliseconds(50));
+    source.remove(1);
+    transaction.clear(0);
+    CHECK_EQ(transaction.unconfirmed.load(), 0);
+    CHECK_EQ(cached(registry, 1).key, 0u);
+}
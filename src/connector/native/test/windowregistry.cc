@@ -0,0 +1,179 @@
+#include "test.h"
+#include "fakewindowsource.h"
+#include <algorithm>
+#include <thread>
+
+const PluginWindow* findWindow(const PluginWindowList& list, uint64_t key) {
+    auto it = std::find_if(list.begin(), list.end(), [=](const PluginWindow& w) {
+        return w.key == key;
+    });
+    return it == list.end() ? nullptr : &*it;
+}
+
+TEST("windowRegistry/cachesWhileWatching") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 0, 0));
+    source.put(makePluginWindow(2, 500, 0));
+    PluginWindowRegistry registry(&source);
+
+    auto first = registry.windows();
+    CHECK_EQ(first->size(), 2u);
+    auto second = registry.windows();
+    CHECK_EQ(source.fetchAllCalls, 1);
+    CHECK(first == second);
+}
+
+TEST("windowRegistry/readsEveryTimeWithoutNotifications") {
+    FakePluginWindowSource source;
+    source.watching = false;
+    source.put(makePluginWindow(1, 0, 0));
+    PluginWindowRegistry registry(&source);
+
+    registry.windows();
+    source.put(makePluginWindow(2, 500, 0));
+    CHECK_EQ(registry.windows()->size(), 2u);
+    CHECK_EQ(source.fetchAllCalls, 2);
+}
+
+TEST("windowRegistry/changeIsCopyOnWrite") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 0, 0));
+    PluginWindowRegistry registry(&source);
+    auto before = registry.windows();
+
+    source.put(makePluginWindow(1, 250, 100));
+    registry.windowChanged(1);
+    auto after = registry.windows();
+
+    // Readers holding the old snapshot keep seeing it as it was
+    CHECK(before != after);
+    CHECK_EQ(findWindow(*before, 1)->x, 0);
+    CHECK_EQ(findWindow(*after, 1)->x, 250);
+    CHECK_EQ(findWindow(*after, 1)->y, 100);
+    CHECK_EQ(source.fetchAllCalls, 1);
+    CHECK_EQ(source.fetchCalls, 1);
+}
+
+TEST("windowRegistry/windowFetchedAheadOfNotification") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 0, 0));
+    PluginWindowRegistry registry(&source);
+    registry.windows();
+
+    // A caller that moved the window and confirmed it publishes what it saw, the window server's
+    // own notification (windowChanged) hasn't arrived yet
+    source.move(1, 1919, 1079);
+    PluginWindow moved;
+    CHECK(source.fetch(1, moved));
+    registry.windowFetched(moved);
+    CHECK_EQ(findWindow(*registry.windows(), 1)->x, 1919);
+    CHECK_EQ(findWindow(*registry.windows(), 1)->y, 1079);
+
+    // And a window it didn't know about yet is added
+    registry.windowFetched(makePluginWindow(2, 500, 0));
+    CHECK_EQ(registry.windows()->size(), 2u);
+    CHECK_EQ(source.fetchAllCalls, 1);
+    CHECK_EQ(source.fetchCalls, 1);
+}
+
+TEST("windowRegistry/createdAndDestroyed") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 0, 0));
+    PluginWindowRegistry registry(&source);
+    registry.windows();
+
+    source.put(makePluginWindow(2, 500, 0));
+    registry.windowChanged(2);
+    CHECK_EQ(registry.windows()->size(), 2u);
+
+    // A change notification for a window that's gone removes it too
+    source.remove(2);
+    registry.windowChanged(2);
+    CHECK(findWindow(*registry.windows(), 2) == nullptr);
+
+    source.remove(1);
+    registry.windowDestroyed(1);
+    CHECK_EQ(registry.windows()->size(), 0u);
+    CHECK_EQ(source.fetchAllCalls, 1);
+}
+
+TEST("windowRegistry/invalidateRereads") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 0, 0));
+    PluginWindowRegistry registry(&source);
+    registry.windows();
+
+    // Without a notification the cache is stale, as it should be
+    source.put(makePluginWindow(2, 500, 0));
+    CHECK_EQ(registry.windows()->size(), 1u);
+
+    registry.invalidate();
+    CHECK_EQ(registry.windows()->size(), 2u);
+    CHECK_EQ(source.fetchAllCalls, 2);
+    registry.windows();
+    CHECK_EQ(source.fetchAllCalls, 2);
+}
+
+TEST("windowRegistry/focusChangedDoesntRefetch") {
+    FakePluginWindowSource source;
+    source.put(makePluginWindow(1, 0, 0));
+    source.put(makePluginWindow(2, 500, 0));
+    PluginWindowRegistry registry(&source);
+    registry.windows();
+
+    registry.focusChanged(2);
+    auto list = registry.windows();
+    CHECK(!findWindow(*list, 1)->focused);
+    CHECK(findWindow(*list, 2)->focused);
+
+    // Focus moving to something that isn't a plugin window
+    registry.focusChanged(99);
+    CHECK(!findWindow(*registry.windows(), 2)->focused);
+
+    // Nothing changed, nothing published
+    auto same = registry.windows();
+    registry.focusChanged(99);
+    CHECK(same == registry.windows());
+
+    CHECK_EQ(source.fetchAllCalls, 1);
+    CHECK_EQ(source.fetchCalls, 0);
+}
+
+TEST("windowRegistry/readersDuringNotifications") {
+    FakePluginWindowSource source;
+    for (uint64_t key = 1; key <= 8; key++) {
+        source.put(makePluginWindow(key, key * 10, 0));
+    }
+    PluginWindowRegistry registry(&source);
+    registry.windows();
+
+    // Every snapshot a reader sees is whole: all 8 windows, each with x and y moved together
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; i++) {
+        readers.emplace_back([&]() {
+            while (!done) {
+                auto list = registry.windows();
+                if (list->size() != 8) {
+                    torn++;
+                }
+                for (auto& window : *list) {
+                    if (window.y != window.x - window.key * 10) {
+                        torn++;
+                    }
+                }
+            }
+        });
+    }
+    for (int step = 1; step <= 2000; step++) {
+        auto key = (uint64_t)(step % 8) + 1;
+        source.put(makePluginWindow(key, key * 10 + step, step));
+        registry.windowChanged(key);
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    CHECK_EQ(torn.load(), 0);
+}
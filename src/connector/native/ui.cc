@@ -1,80 +1,19 @@
 #include "ui.h"
+#include "activity.h"
+#include "capture.h"
 #include "screen.h"
 #include "keyboard.h"
-#include "string.h"
+#include "metrics.h"
+#include "windowlist.h"
+#include "detectgraph.h"
 #include <iostream>
 #include <vector>
-#include <CoreGraphics/CoreGraphics.h>
-#include <ApplicationServices/ApplicationServices.h>
+#include <cmath>
 #include <experimental/optional>
 #include <functional>
 #include <map>
 #include <algorithm>
 
-float uiScale = 1;
-int scale(int point) {
-    return (int)round((float)point * uiScale);
-}
-std::string uiLayout = "Single Display (Large)";
-bool isLargeTrackHeight = true;
-
-int DIRECTION_UP = -1;
-int DIRECTION_DOWN = 1;
-int DIRECTION_LEFT = -1;
-int DIRECTION_RIGHT = 1;
-int AXIS_X = 0;
-int AXIS_Y = 1;
-
-std::experimental::optional<BitwigLayout> prevLayout;
-
-// These are colors for midtones 28, black level 36
-// BenQ screen
-// MWColor trackSelectedColorActive = MWColor{141, 141, 141};
-// MWColor trackSelectedColorInactive = MWColor{97, 97, 97};
-// MWColor trackColor = MWColor{97, 97, 97};
-// MWColor panelBorder = MWColor{104, 104, 104};
-// MWColor trackAutomationBg = MWColor{34, 34, 34};
-// MWColor trackDivider = MWColor{6, 6, 6};
-// MWColor panelBorderInactive = MWColor{68, 68, 68};
-// MWColor panelOpenIcon = MWColor{240, 109, 39};
-// MWColor modalBgColor = MWColor{35, 35, 35};
-
-MWColor trackSelectedColorActive = MWColor{141, 141, 141};
-MWColor trackSelectedColorInactive = MWColor{97, 97, 97};
-MWColor trackColor = MWColor{68, 68, 68};
-MWColor panelBorder = MWColor{104, 104, 104};
-MWColor trackAutomationBg = MWColor{34, 34, 34};
-MWColor trackDivider = MWColor{6, 6, 6};
-MWColor panelBorderInactive = MWColor{68, 68, 68};
-MWColor panelOpenIcon = MWColor{236, 113, 37};
-MWColor modalBgColor = MWColor{35, 35, 35};
-
-const std::string 
-    BITWIG_HEADER_HEIGHT = "BITWIG_HEADER_HEIGHT",
-    BITWIG_HEADER_TOOLBAR_HEIGHT = "BITWIG_HEADER_TOOLBAR_HEIGHT",
-    BITWIG_FOOTER_HEIGHT = "BITWIG_FOOTER_HEIGHT",
-    INSPECTOR_WIDTH = "INSPECTOR_WIDTH",
-    ARRANGER_HEADER_HEIGHT = "ARRANGER_HEADER_HEIGHT",
-    ARRANGER_FOOTER_HEIGHT = "ARRANGER_FOOTER_HEIGHT",
-    AUTOMATION_LANE_MINIMUM_HEIGHT = "AUTOMATION_LANE_MINIMUM_HEIGHT",
-    MINIMUM_DOUBLE_TRACK_HEIGHT = "MINIMUM_DOUBLE_TRACK_HEIGHT",
-    MINIMUM_TRACK_HEIGHT = "MINIMUM_TRACK_HEIGHT";
-std::map<std::string, int> constants = {
-    {BITWIG_HEADER_HEIGHT, 83},
-    {BITWIG_HEADER_TOOLBAR_HEIGHT, 48},
-    {BITWIG_FOOTER_HEIGHT, 36},
-    {INSPECTOR_WIDTH, 170},
-    {ARRANGER_HEADER_HEIGHT, 45},
-    {ARRANGER_FOOTER_HEIGHT, 26},
-    {AUTOMATION_LANE_MINIMUM_HEIGHT, 53},
-    {MINIMUM_DOUBLE_TRACK_HEIGHT, 45},
-    {MINIMUM_TRACK_HEIGHT, 25}
-};
-
-int getConstant(std::string key, bool scaleIt = false) {
-    return scaleIt ? scale(constants[key]) : constants[key];
-}
-
 /**
  * XYPoint
  */
@@ -110,19 +49,6 @@ MWRect MWRect::fromJSObject(Napi::Object obj, Napi::Env env) {
         obj.Get("h").As<Napi::Number>(),
     };
 };
-XYPoint MWRect::fromBottomLeft(int x1, int y1) {
-    return XYPoint{x + x1, y + h - y1};
-}
-XYPoint MWRect::fromTopLeft(int x1, int y1) {
-    return XYPoint{x + x1, y + y1};
-}
-XYPoint MWRect::fromTopRight(int x1, int y1) {
-    return XYPoint{x + w - x1, y + y1};
-}
-XYPoint MWRect::fromBottomRight(int x1, int y1) {
-    return XYPoint{x + w - x1, y + h - y1};
-}
-
 /**
  * MWColor
  */
@@ -140,13 +66,17 @@ MWColor MWColor::fromJSObject(Napi::Object obj, Napi::Env env) {
         obj.Get("b").As<Napi::Number>()
     };
 };
-bool MWColor::isWithinRange(MWColor other, int amount) {
-    return abs(other.r - r) < amount && abs(other.g - g) < amount && abs(other.b - b) < amount;
-};
 
 /**
  * ArrangerTrack
  */ 
+Napi::Object HeaderControl::toJSObject(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("rect", rect.toJSObject(env));
+    obj.Set("on", on);
+    return obj;
+}
+
 Napi::Object ArrangerTrack::toJSObject(Napi::Env env) {
     Napi::Object obj = Napi::Object::New(env);
     obj.Set("rect", rect.toJSObject(env));
@@ -154,6 +84,21 @@ Napi::Object ArrangerTrack::toJSObject(Napi::Env env) {
     obj.Set("selected", selected);
     obj.Set("automationOpen", automationOpen);
     obj.Set("isLargeTrackHeight", isLargeTrackHeight);
+    obj.Set("header", header == HEADER_VISIBLE ? "visible" : header == HEADER_PARTIAL ? "partial" : "hidden");
+    auto lanes = Napi::Array::New(env, automationLanes.size());
+    for (uint32_t i = 0; i < automationLanes.size(); i++) {
+        lanes[i] = automationLanes[i].toJSObject(env);
+    }
+    obj.Set("automationLanes", lanes);
+    auto controls = Napi::Object::New(env);
+    auto setControl = [&](const char* name, std::experimental::optional<HeaderControl>& control) {
+        controls.Set(name, control ? control->toJSObject(env) : env.Null());
+    };
+    setControl("mute", mute);
+    setControl("solo", solo);
+    setControl("arm", arm);
+    setControl("fold", fold);
+    obj.Set("controls", controls);
     return obj;
 }
 ArrangerTrack ArrangerTrack::fromJSObject(Napi::Object obj, Napi::Env env) {
@@ -195,116 +140,84 @@ Napi::Object BitwigLayout::toJSObject(Napi::Env env) {
     return obj;
 }
 
-bool operator==(const MWRect& lhs, const MWRect& rhs)
-{
-    return lhs.x == rhs.x && lhs.y == rhs.y && lhs.w == rhs.w && lhs.h == rhs.h;
-};
-bool operator==(const XYPoint& lhs, const XYPoint& rhs)
-{
-    return lhs.x == rhs.x && lhs.y == rhs.y;
-};
-bool operator==(const UIPoint& lhs, const UIPoint& rhs)
-{
-    return lhs.point == rhs.point && lhs.window == rhs.window;
-};
-bool operator==(const MWColor& lhs, const MWColor& rhs)
-{
-    return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b;
-};
-
-/**
- * ImageDeets
- */
-ImageDeets::ImageDeets(CGImageRef latestImage, WindowInfo frame) {
-    this->frame = frame;
-    this->imageRef = latestImage;
-    CGDataProviderRef provider = CGImageGetDataProvider(latestImage);
-    imageData = CGDataProviderCopyData(provider);
-
-    bytesPerRow = CGImageGetBytesPerRow(latestImage);
-    bytesPerPixel = CGImageGetBitsPerPixel(latestImage) / 8;
-
-    info = CGImageGetBitmapInfo(latestImage);
-    width = frame.frame.w;
-    height = frame.frame.h;
-    maxInclOffset = getPixelOffset(XYPoint{width - 1, height - 1});
-};
-
-size_t ImageDeets::getPixelOffset(XYPoint point) {
-    return (size_t)lround(point.y*bytesPerRow) + (size_t)lround(point.x*bytesPerPixel);
-};
-
-bool ImageDeets::isWithinBounds(XYPoint point) {
-    return point.x >= 0 && point.y >= 0 && getPixelOffset(point) <= maxInclOffset;
-};
-
-MWColor ImageDeets::colorAt(XYPoint point) {
-    size_t offset = getPixelOffset(point);
-    if (offset >= maxInclOffset) {
-        std::cout << "Offset outside range";
-        return MWColor{0, 0, 0};
-    }
-    const UInt8* dataPtr = CFDataGetBytePtr(imageData);
-
-    // int alpha = dataPtr[offset + 3],
-    int red = dataPtr[offset + 2],
-        green = dataPtr[offset + 1],
-        blue = dataPtr[offset + 0];
-    return MWColor{red, green, blue};
-};
-
-std::experimental::optional<XYPoint> ImageDeets::seekUntilColor(
-    XYPoint startPoint,
-    std::function<bool(MWColor)> tester, 
-    int changeAxis,
-    int direction, 
-    int step
-) {
-    auto isYChanging = changeAxis == AXIS_Y;
-    auto endChange = isYChanging ? height - 1 : width - 1;
-    auto decreasing = direction == DIRECTION_UP || direction == DIRECTION_LEFT;
-    if (decreasing) {
-        endChange = 0;
-    }
-    int start = isYChanging ? startPoint.y : startPoint.x;
-    
-    for (int i = start; decreasing ? i >= endChange : i <= endChange; i += (direction * step)) {
-        auto point = isYChanging ? XYPoint{startPoint.x, i} : XYPoint{i, startPoint.y};
-        auto colorAtPoint = colorAt(point);
-        auto pointMatches = tester(colorAtPoint);
-        if (pointMatches) {
-            if (abs(step) > 1 && i != start) {
-                // Backtrack to find earliest match that we may have missed
-                for (int b = i - direction; b != i - (direction * step); b -= direction) {
-                    auto point = isYChanging ? XYPoint{startPoint.x, b} : XYPoint{b, startPoint.y};
-                    auto colorAtPoint = colorAt(point);
-                    auto pointMatches = tester(colorAtPoint);
-                    if (pointMatches) {
-                        return point;
-                    }
-                }
-            }
-            return point;
+Napi::Object UISnapshot::toJSObject(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("layout", layout.toJSObject(env));
+    if (tracksFound) {
+        auto array = Napi::Array::New(env, tracks.size());
+        for (uint32_t i = 0; i < tracks.size(); i++) {
+            array[i] = tracks[i].toJSObject(env);
         }
+        obj.Set("tracks", array);
+    } else {
+        obj.Set("tracks", env.Null());
     }
+    if (clipsFound) {
+        auto clipsObj = Napi::Object::New(env);
+        auto offsets = Napi::Int32Array::New(env, clips.offsets.size());
+        std::copy(clips.offsets.begin(), clips.offsets.end(), offsets.Data());
+        auto rects = Napi::Int32Array::New(env, clips.rects.size());
+        std::copy(clips.rects.begin(), clips.rects.end(), rects.Data());
+        clipsObj.Set("offsets", offsets);
+        clipsObj.Set("rects", rects);
+        obj.Set("clips", clipsObj);
+    }
+    return obj;
+}
 
-    return {};
-};
+Napi::Object DeviceChain::toJSObject(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("rect", rect.toJSObject(env));
+    auto slotsArray = Napi::Int32Array::New(env, slots.size());
+    std::copy(slots.begin(), slots.end(), slotsArray.Data());
+    obj.Set("slots", slotsArray);
+    auto flagsArray = Napi::Uint8Array::New(env, flags.size());
+    std::copy(flags.begin(), flags.end(), flagsArray.Data());
+    obj.Set("flags", flagsArray);
+    auto scroll = Napi::Object::New(env);
+    scroll.Set("start", scrollStart);
+    scroll.Set("end", scrollEnd);
+    obj.Set("scroll", scroll);
+    return obj;
+}
 
-ImageDeets::~ImageDeets() {
-    CFRelease(imageRef);
-    CFRelease(imageData);
-};
+Napi::Object MixerStrips::toJSObject(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("rect", rect.toJSObject(env));
+    auto packed = [&](const std::vector<int32_t>& values) {
+        auto array = Napi::Int32Array::New(env, values.size());
+        std::copy(values.begin(), values.end(), array.Data());
+        return array;
+    };
+    obj.Set("strips", packed(strips));
+    obj.Set("faders", packed(faders));
+    obj.Set("meters", packed(meters));
+    obj.Set("selected", selected);
+    return obj;
+}
+
+Napi::Object FooterPanels::toJSObject(Napi::Env env) {
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("open", open == -1 ? env.Null() : Napi::String::New(env, footerPanelName(open)));
+    Napi::Object rects = Napi::Object::New(env);
+    for (int i = 0; i < FOOTER_PANEL_COUNT; i++) {
+        rects.Set(footerPanelName(i), icons[i].w > 0 ? icons[i].toJSObject(env) : env.Null());
+    }
+    obj.Set("icons", rects);
+    return obj;
+}
 
 /**
  * BitwigWindow
  */
 Napi::FunctionReference BitwigWindow::constructor;
+std::set<BitwigWindow*> BitwigWindow::instances;
 MWColor BitwigWindow::colorAt(XYPoint point) {
     // TODO scaling logic here doesn't really work
+    auto& profile = this->getProfile();
     auto scaledPoint = XYPoint{
-        (int)round((float)point.x * uiScale),
-        (int)round((float)point.y * uiScale)
+        profile.scale(point.x),
+        profile.scale(point.y)
     };
     if (this->latestImageDeets == nullptr) {
         this->updateScreenshot();
@@ -326,12 +239,12 @@ Napi::Value BitwigWindow::GetTrackInsetAtPoint(const Napi::CallbackInfo &info) {
     
     auto screenshot = that->latestImageDeets;
     auto frame = that->lastBWFrame.frame;
-    auto inspectorOpen = screenshot->colorAt(frame.fromBottomLeft(scale(20), scale(17))).r == panelOpenIcon.r;
-    auto arrangerStartX = inspectorOpen ? 170 : 4;
+    auto& profile = that->getProfile();
+    auto arrangerStartX = detectInspectorOpen(screenshot, profile, frame) ? profile.get(INSPECTOR_WIDTH) : 4;
 
     auto result = screenshot->seekUntilColor(
         XYPoint{
-            scale(arrangerStartX + 1), 
+            profile.scale(arrangerStartX + 1), 
             point.y
         },
         [](MWColor color) {
@@ -345,295 +258,390 @@ Napi::Value BitwigWindow::GetTrackInsetAtPoint(const Napi::CallbackInfo &info) {
 }
 
 int BitwigWindow::getMainPanelStartY() {
-    auto frame = this->lastBWFrame.frame;
-    auto headerHeight = getConstant(BITWIG_HEADER_HEIGHT);
-    if (frame.w <= 1440) {
-        // TODO check exact height of switch, but toolbar will dock down below when there's not enough room for it
-        // Could be dynamic 😬  may need to do some pixel hunting
-        auto toolbarHeight = getConstant(BITWIG_HEADER_TOOLBAR_HEIGHT);
-        return headerHeight + toolbarHeight;
-    }
-    return headerHeight;
+    return ::getMainPanelStartY(this->getProfile(), this->lastBWFrame.frame);
 }
 
 BitwigLayout BitwigWindow::getLayoutState() {
-    if (prevLayout) {
-        return *prevLayout;
+    static auto& cacheHits = metricCounter("layout.cache.hits");
+    static auto& cacheMisses = metricCounter("layout.cache.misses");
+    if (this->prevLayout) {
+        cacheHits.add();
+        return *this->prevLayout;
     }
-
-    auto layout = BitwigLayout();
+    cacheMisses.add();
     auto screenshot = this->updateScreenshot();
-    auto tracks = std::vector<ArrangerTrack>();
+    return detectLayout(screenshot, this->getProfile(), this->lastBWFrame.frame);
+}
 
-    auto frame = this->lastBWFrame.frame;
-    if (screenshot->colorAt(frame.fromBottomLeft(scale(2), scale(2))).r == modalBgColor.r) {
-        layout.modalOpen = true;
-        return layout;
-    }
-
-    auto inspectorOpen = screenshot->colorAt(frame.fromBottomLeft(scale(20), scale(17))).r == panelOpenIcon.r;
-    auto arrangerStartY = this->getMainPanelStartY();
-    if (inspectorOpen) {
-        layout.inspector = Inspector{
-            .rect = MWRect{
-                0,
-                scale(arrangerStartY),
-                getConstant(INSPECTOR_WIDTH, true),
-                frame.h - scale(arrangerStartY + getConstant(BITWIG_FOOTER_HEIGHT))
-            }
-        };
+Napi::Value BitwigWindow::GetArrangerTracks(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    static auto& totalTime = metricHistogram("getArrangerTracks.time");
+    static auto& marshalTime = metricHistogram("napi.tracks.time");
+    MetricTimer timer(totalTime);
+
+    // Layout and tracks come from the same capture. The stages take microseconds, less than
+    // handing them to other threads would, so one window's graph runs inline (see getLayoutStates)
+    auto screenshot = this->updateScreenshot();
+    if (screenshot == nullptr) {
+        return env.Null();
+    }
+    auto snapshot = detectUISnapshot(screenshot, this->getProfile(), this->lastBWFrame.frame);
+    if (!snapshot.tracksFound) {
+        return env.Null();
     }
 
-    auto arrangerStartX = inspectorOpen ? getConstant(INSPECTOR_WIDTH) : 4;
-    auto arrangerTrackStartY = 42;
-    auto minimumPossibleTrackWidth = 210;
-
-    std::string panelOpen = "";
-    if (uiScale == 1) {
-        if (screenshot->colorAt(frame.fromBottomLeft(scale(276), scale(20))).isWithinRange(panelOpenIcon)) {
-            panelOpen = "device";
-        } else if (screenshot->colorAt(frame.fromBottomLeft(scale(309), scale(20))).isWithinRange(panelOpenIcon)) {
-            panelOpen = "mixer";
-        } else if (screenshot->colorAt(frame.fromBottomLeft(scale(250), scale(17))).isWithinRange(MWColor{153, 78, 32})) { 
-            panelOpen = "automation"; // FIX ME
-        } else if (screenshot->colorAt(frame.fromBottomLeft(scale(224), scale(18))).isWithinRange(panelOpenIcon)) {
-            panelOpen = "detail";
-        }
-    } else if (uiScale == 1.25) {
-        if (screenshot->colorAt(frame.fromBottomLeft(scale(271), scale(20))).isWithinRange(panelOpenIcon)) {
-            panelOpen = "device";
-        } else if (screenshot->colorAt(frame.fromBottomLeft(scale(309), scale(20))).isWithinRange(panelOpenIcon)) {
-            panelOpen = "mixer";
-        } else if (screenshot->colorAt(frame.fromBottomLeft(scale(250), scale(17))).isWithinRange(MWColor{153, 78, 32})) { 
-            panelOpen = "automation"; // FIX ME
-        } else if (screenshot->colorAt(frame.fromBottomLeft(scale(211), scale(14))).isWithinRange(panelOpenIcon)) {
-            panelOpen = "detail";
-        }
+    MetricTimer marshalTimer(marshalTime);
+    auto array = Napi::Array::New(env, snapshot.tracks.size());
+    for(unsigned long i = 0; i < snapshot.tracks.size(); i++) {
+        array[i] = snapshot.tracks[i].toJSObject(env);
     }
+    return array;
+};
 
-    auto arrangerViewHeightPX = frame.h - scale(arrangerStartY + getConstant(BITWIG_FOOTER_HEIGHT));
-    if (panelOpen != "") {
-        // Find the horizontal split where the extra panel stops
-        auto minimumExtraPanel = 108; // Minimum possible height of any extra panel 
-        auto horizontalSplit = screenshot->seekUntilColor(
-            XYPoint{
-                scale(arrangerStartX + 1), 
-                frame.h - scale(getConstant(BITWIG_FOOTER_HEIGHT) + (int)((float)minimumExtraPanel * .8)) 
-            },
-            [](MWColor color) {
-                return color.r == panelBorder.r || color.r == panelBorderInactive.r;
-            },
-            AXIS_Y,
-            DIRECTION_UP,
-            2
-        ).value_or(XYPoint{-1, -1});
-
-        // Go up and right a bit so we can ensure we hit the flat edge of the border and not the rounded corners
-        auto arrangerYBottomBorder = screenshot->seekUntilColor(
-            XYPoint{horizontalSplit.x + scale(20), horizontalSplit.y - scale(3)},
-            [](MWColor color) {
-                return color.r == panelBorder.r || color.r == panelBorderInactive.r;
-            },
-            AXIS_Y,
-            DIRECTION_UP,
-            2
-        ).value_or(XYPoint{-1, -1});
-        arrangerViewHeightPX = arrangerYBottomBorder.y - scale(arrangerStartY);      
-
-        layout.editor = EditorPanel{
-            .type = panelOpen,
-            .rect = MWRect{
-                scale(arrangerStartX),
-                arrangerYBottomBorder.y,
-                frame.w - scale(arrangerStartX),
-                frame.h - getConstant(BITWIG_FOOTER_HEIGHT, true) - arrangerYBottomBorder.y
-            }
-        };
+/**
+ * {layout, tracks} from one capture, tracks is null when the arranger isn't visible
+ */
+Napi::Value BitwigWindow::GetUISnapshot(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    static auto& totalTime = metricHistogram("getUISnapshot.time");
+    static auto& marshalTime = metricHistogram("napi.snapshot.time");
+    MetricTimer timer(totalTime);
+
+    auto screenshot = this->updateScreenshot();
+    if (screenshot == nullptr) {
+        return env.Null();
     }
+    // { clips: true } segments clips too, they're packed into snapshot.clips (see clips.h)
+    bool withClips = info.Length() > 0 && info[0].IsObject()
+        && info[0].As<Napi::Object>().Get("clips").ToBoolean().Value();
+    auto snapshot = detectUISnapshot(screenshot, this->getProfile(), this->lastBWFrame.frame, withClips);
+    MetricTimer marshalTimer(marshalTime);
+    return snapshot.toJSObject(env);
+}
+
+Napi::Value BitwigWindow::GetLayoutState(const Napi::CallbackInfo &info) {
+    static auto& totalTime = metricHistogram("getLayoutState.time");
+    static auto& marshalTime = metricHistogram("napi.layout.time");
+    MetricTimer timer(totalTime);
+    auto layout = this->getLayoutState();
+    MetricTimer marshalTimer(marshalTime);
+    return layout.toJSObject(info.Env());
+}
 
-    layout.arranger = Arranger{
-        MWRect{
-            scale(arrangerStartX),
-            scale(arrangerStartY),
-            frame.w - scale(arrangerStartX) - scale(28),// 28 === scrollbar
-            arrangerViewHeightPX
+BitwigWindow::BitwigWindow(const Napi::CallbackInfo &info) : Napi::ObjectWrap<BitwigWindow>(info) {
+    // Napi::Env env = info.Env();
+    this->latestImageDeets = nullptr;
+    if (info.Length() > 0 && info[0].IsObject()) {
+        auto options = info[0].As<Napi::Object>();
+        if (options.Has("windowId")) {
+            this->boundWindowId = (NativeWindowId)options.Get("windowId").As<Napi::Number>().Int64Value();
         }
-    };
+        if (options.Has("layout")) {
+            this->layoutProfile = options.Get("layout").As<Napi::String>();
+        }
+    }
+    instances.insert(this);
+}
+BitwigWindow::~BitwigWindow() {
+    instances.erase(this);
+    if (latestImageDeets != nullptr) {
+        delete latestImageDeets;
+    }
+}
+Napi::Value BitwigWindow::GetFrame(const Napi::CallbackInfo &info) {
+    auto env = info.Env();
+    return this->lastBWFrame.frame.toJSObject(env);
+}
+Napi::Value BitwigWindow::GetWindowId(const Napi::CallbackInfo &info) {
+    return Napi::Number::New(info.Env(), (double)lastBWFrame.windowId);
+}
+Napi::Value BitwigWindow::SetLayoutProfile(const Napi::CallbackInfo &info) {
+    layoutProfile = info[0].IsString() ? info[0].As<Napi::String>().Utf8Value() : "";
+    prevLayout = {};
+    return info.Env().Null();
+}
+/**
+ * Ruler, see ruler.h
+ */
+const RulerState* BitwigWindow::updateRuler() {
+    auto screenshot = this->updateScreenshot();
+    if (screenshot == nullptr) {
+        return nullptr;
+    }
+    auto frame = this->lastBWFrame.frame;
+    auto& profile = this->getProfile();
+    // Not getLayoutState, a cache miss there would capture again
+    auto layout = this->prevLayout ? *this->prevLayout : detectLayout(screenshot, profile, frame);
+    if (!layout.arranger) {
+        return nullptr;
+    }
+    auto trackWidthPX = detectTrackWidth(screenshot, profile, frame, (bool)layout.inspector);
+    if (trackWidthPX == -1) {
+        return nullptr;
+    }
+    auto& state = ruler.update(screenshot, profile, layout, layout.arranger->rect.x + trackWidthPX + profile.scale(2));
+    return state.rect.w > 0 ? &state : nullptr;
+}
 
-    return layout;
+Napi::Value BitwigWindow::GetRuler(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    static auto& totalTime = metricHistogram("getRuler.time");
+    MetricTimer timer(totalTime);
+    auto state = this->updateRuler();
+    if (state == nullptr) {
+        return env.Null();
+    }
+    Napi::Object obj = Napi::Object::New(env);
+    auto rect = state->rect;
+    obj.Set("rect", rect.toJSObject(env));
+    auto ticks = Napi::Array::New(env, state->ticks.size());
+    for (uint32_t i = 0; i < state->ticks.size(); i++) {
+        ticks[i] = state->ticks[i];
+    }
+    obj.Set("ticks", ticks);
+    obj.Set("tickSpacing", state->tickSpacing);
+    obj.Set("playheadX", state->playheadX == -1 ? env.Null() : Napi::Number::New(env, state->playheadX));
+    if (state->selectionStart != -1) {
+        Napi::Object selection = Napi::Object::New(env);
+        selection.Set("start", state->selectionStart);
+        selection.Set("end", state->selectionEnd);
+        obj.Set("selection", selection);
+    } else {
+        obj.Set("selection", env.Null());
+    }
+    auto transform = ruler.getTransform();
+    if (transform) {
+        Napi::Object transformObj = Napi::Object::New(env);
+        transformObj.Set("originX", transform->originX);
+        transformObj.Set("pixelsPerBeat", transform->pixelsPerBeat);
+        obj.Set("transform", transformObj);
+    } else {
+        obj.Set("transform", env.Null());
+    }
+    obj.Set("incremental", ruler.lastUpdateIncremental);
+    return obj;
 }
 
-Napi::Value BitwigWindow::GetArrangerTracks(const Napi::CallbackInfo &info) {
+/**
+ * anchorRuler(beat, x = the playhead): tells the ruler a pixel is at a beat. false if the
+ * ruler or playhead can't be found, or the anchor doesn't fit the ticks
+ */
+Napi::Value BitwigWindow::AnchorRuler(const Napi::CallbackInfo &info) {
     Napi::Env env = info.Env();
+    auto beat = info[0].As<Napi::Number>().DoubleValue();
+    auto state = this->updateRuler();
+    if (state == nullptr) {
+        return Napi::Boolean::New(env, false);
+    }
+    auto x = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().Int32Value() : state->playheadX;
+    return Napi::Boolean::New(env, x != -1 && ruler.anchor(x, beat));
+}
 
-    auto layout = getLayoutState();
+/**
+ * Device panel contents, see devicechain.h. null unless the device panel is open. While the rows
+ * the chain comes from don't change the same object is returned again, so don't modify it
+ */
+Napi::Value BitwigWindow::GetDeviceChain(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    static auto& totalTime = metricHistogram("getDeviceChain.time");
+    MetricTimer timer(totalTime);
     auto screenshot = this->updateScreenshot();
-    auto tracks = std::vector<ArrangerTrack>();
-
-    auto frame = this->lastBWFrame.frame;
-
-    if (layout.modalOpen || !layout.arranger) {
-        std::cout << "Settings or popup open";
+    if (screenshot == nullptr) {
+        return env.Null();
+    }
+    auto& profile = this->getProfile();
+    // Not getLayoutState, a cache miss there would capture again
+    auto layout = this->prevLayout ? *this->prevLayout : detectLayout(screenshot, profile, this->lastBWFrame.frame);
+    auto chain = deviceChain.update(screenshot, profile, layout);
+    if (chain == nullptr) {
         return env.Null();
     }
+    if (!deviceChain.lastUpdateCached || deviceChainObject.IsEmpty()) {
+        deviceChainObject = Napi::Persistent(chain->toJSObject(env));
+    }
+    return deviceChainObject.Value();
+}
 
-    auto arrangerStartX = layout.inspector ? 170 : 4;
-    auto arrangerStartY = this->getMainPanelStartY();
-    auto arrangerTrackStartY = 42;
-    auto minimumPossibleTrackWidth = 210;
-    // Includes border at top, but not bottom, since first track starts with top border
+// False, with mixer cleared, unless the mixer panel is open
+bool BitwigWindow::updateMixerStrips() {
+    auto screenshot = this->updateScreenshot();
+    if (screenshot == nullptr) {
+        return false;
+    }
+    auto& profile = this->getProfile();
+    auto layout = this->prevLayout ? *this->prevLayout : detectLayout(screenshot, profile, this->lastBWFrame.frame);
+    MWRect rect;
+    if (!getMixerRect(profile, layout, rect)) {
+        mixer.clear();
+        return false;
+    }
+    detectMixerStrips(screenshot, profile, rect, mixer);
+    return true;
+}
 
-    // If we go too high here, the point will be affected by shadow from the top of arranger
-    // view which alters the colours, 6 becomes 5 etc...
-    auto startSearchPoint = XYPoint{
-        scale(arrangerStartX + minimumPossibleTrackWidth),
-        scale(arrangerStartY + arrangerTrackStartY + 15)
-    };
+/**
+ * Mixer panel channel strips, see mixerstrips.h. null unless the mixer panel is open
+ */
+Napi::Value BitwigWindow::GetMixerStrips(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    static auto& totalTime = metricHistogram("getMixerStrips.time");
+    MetricTimer timer(totalTime);
+    if (!updateMixerStrips()) {
+        return env.Null();
+    }
+    return mixer.toJSObject(env);
+}
 
-    // Search right from minimum possible track width just a few Y pixels into first track. Of course, assumes arranger is open
-    auto endOfTrackWidthPoint = screenshot->seekUntilColor(
-        startSearchPoint,
-        [](MWColor color) {
-            return color.r == trackDivider.r;
-        },
-        AXIS_X,
-        DIRECTION_RIGHT,
-        2 // skip stays the same regardless of scale, we shouldn't lose that much speed and is safer
-    ).value_or(XYPoint{-1, -1});
+/**
+ * The footer's panel toggles, see footerpanels.h: { open, icons: { device, mixer, automation,
+ * detail } } with null for a panel that isn't open or an icon that wasn't found. null if no
+ * icons were found at all
+ */
+Napi::Value BitwigWindow::GetFooterPanels(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto screenshot = this->updateScreenshot();
+    FooterPanels panels;
+    if (screenshot == nullptr || !detectFooterPanels(screenshot, this->getProfile(), this->lastBWFrame.frame, panels)) {
+        return env.Null();
+    }
+    return panels.toJSObject(env);
+}
 
-    // We gotta do 2 searches cause we could land on the horizontal line, which'll stunt our search
-    // Only run this is the first one comes back with the same x coord. Barely uses any extra processing
-    if (endOfTrackWidthPoint.x == startSearchPoint.x) {
-        auto endOfTrackWidthPoint2 = screenshot->seekUntilColor(
-            XYPoint{
-                startSearchPoint.x,
-                startSearchPoint.y + scale(5)
-            },
-            [](MWColor color) {
-                return color.r == trackDivider.r;
-            },
-            AXIS_X,
-            DIRECTION_RIGHT,
-            2 // skip stays the same regardless of scale, we shouldn't lose that much speed and is safer
-        ).value_or(XYPoint{-1, -1});
-        if (endOfTrackWidthPoint2.x > endOfTrackWidthPoint.x) {
-            endOfTrackWidthPoint = endOfTrackWidthPoint2;
-        }
+/**
+ * setActivitySampling({ rate, threshold, capacity }) samples this window's mixer meters until
+ * it's called again, or with false to stop. See activity.h. The strips are found once here, false
+ * if there are none to sample
+ */
+Napi::Value BitwigWindow::SetActivitySampling(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    if (!info[0].IsObject()) {
+        stopActivitySampling();
+        return Napi::Boolean::New(env, false);
+    }
+    auto options = info[0].As<Napi::Object>();
+    ActivityOptions activity;
+    if (options.Has("rate")) {
+        activity.rate = options.Get("rate").As<Napi::Number>().Int32Value();
+    }
+    if (options.Has("threshold")) {
+        activity.threshold = options.Get("threshold").As<Napi::Number>().FloatValue();
+    }
+    if (options.Has("capacity")) {
+        activity.capacity = std::max(1, options.Get("capacity").As<Napi::Number>().Int32Value());
     }
+    if (!updateMixerStrips() || mixer.stripCount() == 0) {
+        stopActivitySampling();
+        return Napi::Boolean::New(env, false);
+    }
+    startActivitySampling(lastBWFrame.windowId, lastBWFrame.frame, mixer.meters, activity);
+    return Napi::Boolean::New(env, true);
+}
 
-    if (endOfTrackWidthPoint.x == -1) {
-        std::cout << "Couldn't find track width";
+/**
+ * { windowId, rate, levels: [Float32Array per strip, oldest first], active: [bool] }, null when
+ * not sampling
+ */
+Napi::Value BitwigWindow::GetActivityHistory(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto history = getActivityHistory();
+    if (history.rate == 0) {
         return env.Null();
     }
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("windowId", Napi::Number::New(env, (double)history.windowId));
+    obj.Set("rate", history.rate);
+    auto levels = Napi::Array::New(env, history.levels.size());
+    auto active = Napi::Array::New(env, history.active.size());
+    for (size_t i = 0; i < history.levels.size(); i++) {
+        auto array = Napi::Float32Array::New(env, history.levels[i].size());
+        std::copy(history.levels[i].begin(), history.levels[i].end(), array.Data());
+        levels.Set(i, array);
+        active.Set(i, Napi::Boolean::New(env, history.active[i]));
+    }
+    obj.Set("levels", levels);
+    obj.Set("active", active);
+    return obj;
+}
 
-    auto trackWidthPX = endOfTrackWidthPoint.x - scale(arrangerStartX);
-    auto arrangerViewHeightPX = (*layout.arranger).rect.h;
-    auto minimumTrackHeight = isLargeTrackHeight 
-        ? getConstant(MINIMUM_DOUBLE_TRACK_HEIGHT) 
-        : getConstant(MINIMUM_TRACK_HEIGHT);
-    auto tracksStartYPX = scale(arrangerStartY + getConstant(ARRANGER_HEADER_HEIGHT));
-    auto minimumTrackHeightPX = scale(minimumTrackHeight);
-    auto xSearchPX = scale(arrangerStartX) + (trackWidthPX - scale(1));
-    int trackI = 0;
-    auto tracksEndYPX = tracksStartYPX + arrangerViewHeightPX - scale(getConstant(ARRANGER_FOOTER_HEIGHT) + getConstant(ARRANGER_HEADER_HEIGHT));
-
-    // Traverse down the arranger looking for pixels that are selection colour
-    for (int y = tracksStartYPX; y < tracksEndYPX;) {
-        auto trackBGColor = screenshot->colorAt(XYPoint{xSearchPX, y + scale(5)});
-        if (trackBGColor.r == trackDivider.r && trackI != 0) {
-            // Empty space, reached last track
-            // Can't possibly be first track because no possible scroll position would allow for this (I don't think?)
-            break;
-        }
-        ArrangerTrack track = ArrangerTrack{
-            .isLargeTrackHeight = isLargeTrackHeight
-        };
-        track.selected = trackBGColor.r == trackSelectedColorActive.r || trackBGColor.r == trackSelectedColorInactive.r;
-
-        // If we've hit automation straight away, the whole track "header" is offscreen, not much use
-        // to us. We could maybe inform the user of this, but for simplicity just leave it out for now.
-        bool skipTrack = trackBGColor.r <= trackAutomationBg.r;
-        auto trackEndXPX = scale(arrangerStartX) + trackWidthPX;
-        auto automationTarget = XYPoint{
-            trackEndXPX - scale(isLargeTrackHeight ? 21 : 36),
-            y + scale(isLargeTrackHeight ? 33 : 14)
-        };
-        auto automationColor = screenshot->colorAt(automationTarget);
-        track.automationOpen = automationColor.isWithinRange(MWColor{253, 115, 42});
-        auto end = XYPoint{xSearchPX, y + minimumTrackHeightPX};
-        if (track.automationOpen || screenshot->colorAt(end).r != trackDivider.r) {
-            // Track height has been increased or automation is open
-
-            // If this is the first track, it could have been cut off, meaning the minimum height has no real meaning.
-            // It could be 5 pixels high, only showing the bottom 5 pixels for example. Otherwise, any track after the first
-            // should be showing full height (unless it's the last??? hmmm....)
-            auto ySearchOffsetPX = trackI == 0 ? scale(2) : minimumTrackHeightPX;    
-            end = screenshot->seekUntilColor(
-                XYPoint{
-                    xSearchPX, 
-                    y + ySearchOffsetPX + (track.automationOpen ? scale(getConstant(AUTOMATION_LANE_MINIMUM_HEIGHT)) : 0)
-                },
-                [](MWColor color) {
-                    return color.r == trackDivider.r;
-                },
-                AXIS_Y,
-                DIRECTION_DOWN,
-                2
-            ).value_or(XYPoint{-1, -1});
-        }
-        if (end.y == -1) {
-            std::cout << "Fell off bottom edge of screen, stopping search";
-            break;
+/**
+ * startRecording(path, { tileSize, keyframeInterval }) records every screenshot this window
+ * takes from now on to path, replacing any recording in progress. Replay them with
+ * bes_bench --replay path. Throws if path can't be written
+ */
+Napi::Value BitwigWindow::StartRecording(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    std::string path = info[0].As<Napi::String>();
+    FrameRecorderOptions options;
+    if (info[1].IsObject()) {
+        auto obj = info[1].As<Napi::Object>();
+        if (obj.Has("tileSize")) {
+            options.tileSize = obj.Get("tileSize").As<Napi::Number>().Int32Value();
         }
-        end.y = std::min(tracksEndYPX, end.y);
-        if (!skipTrack) {
-            track.visibleRect = MWRect{
-                scale(arrangerStartX),
-                y,
-                trackWidthPX,
-                end.y - y
-            };
-            track.rect = MWRect{
-                scale(arrangerStartX),
-                y,
-                trackWidthPX,
-                (end.y - y)
-            };
-            tracks.push_back(track);
+        if (obj.Has("keyframeInterval")) {
+            options.keyframeInterval = obj.Get("keyframeInterval").As<Napi::Number>().Int32Value();
         }
-        trackI++;
-        y = end.y;
-    };
-
-    auto array = Napi::Array::New(env, tracks.size());
-    for(unsigned long i = 0; i < tracks.size(); i++) {
-        array[i] = tracks[i].toJSObject(env);
     }
-    return array;
-};
+    recorder.reset();
+    try {
+        recorder.reset(new FrameRecorder(path, options));
+    } catch (const std::runtime_error& error) {
+        throw Napi::Error::New(env, error.what());
+    }
+    recordingStarted = std::chrono::steady_clock::now();
+    return env.Null();
+}
 
-Napi::Value BitwigWindow::GetLayoutState(const Napi::CallbackInfo &info) {
-    return this->getLayoutState().toJSObject(info.Env());
+/**
+ * Finishes the recording, { frames, bytes }. null if there wasn't one. Throws if writing it
+ * failed at any point, the file then holds the frames before the failure
+ */
+Napi::Value BitwigWindow::StopRecording(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    if (!recorder) {
+        return env.Null();
+    }
+    recorder->close();
+    if (!recorder->error().empty()) {
+        auto error = recorder->error();
+        recorder.reset();
+        throw Napi::Error::New(env, error);
+    }
+    Napi::Object obj = Napi::Object::New(env);
+    obj.Set("frames", Napi::Number::New(env, (double)recorder->frameCount()));
+    obj.Set("bytes", Napi::Number::New(env, (double)recorder->bytesWritten()));
+    recorder.reset();
+    return obj;
 }
 
-BitwigWindow::BitwigWindow(const Napi::CallbackInfo &info) : Napi::ObjectWrap<BitwigWindow>(info) {
-    // Napi::Env env = info.Env();
-    this->latestImageDeets = nullptr;
+std::string BitwigWindow::getLayoutProfile() {
+    return layoutProfile.empty() ? uiLayout : layoutProfile;
 }
-Napi::Value BitwigWindow::GetFrame(const Napi::CallbackInfo &info) {
-    auto env = info.Env();
-    return this->lastBWFrame.frame.toJSObject(env);
+const LayoutProfile& BitwigWindow::getProfile() {
+    return *findLayoutProfile(uiScale, getLayoutProfile());
 }
 Napi::Object BitwigWindow::Init(Napi::Env env, Napi::Object exports) {
     Napi::Function func = DefineClass(env, "BitwigWindow", {
         InstanceAccessor<&BitwigWindow::getRect>("rect"),
         InstanceMethod<&BitwigWindow::GetArrangerTracks>("_getArrangerTracks"),
         InstanceMethod<&BitwigWindow::GetLayoutState>("getLayoutState"),
+        InstanceMethod<&BitwigWindow::GetUISnapshot>("getUISnapshot"),
         InstanceMethod<&BitwigWindow::GetTrackInsetAtPoint>("getTrackInsetAtPoint"),
         InstanceMethod<&BitwigWindow::PixelColorAt>("pixelColorAt"),
-        InstanceMethod<&BitwigWindow::GetFrame>("getFrame")
+        InstanceMethod<&BitwigWindow::GetFrame>("getFrame"),
+        InstanceMethod<&BitwigWindow::GetWindowId>("getWindowId"),
+        InstanceMethod<&BitwigWindow::SetLayoutProfile>("setLayoutProfile"),
+        InstanceMethod<&BitwigWindow::GetRuler>("getRuler"),
+        InstanceMethod<&BitwigWindow::AnchorRuler>("anchorRuler"),
+        InstanceMethod<&BitwigWindow::GetDeviceChain>("getDeviceChain"),
+        InstanceMethod<&BitwigWindow::GetMixerStrips>("getMixerStrips"),
+        InstanceMethod<&BitwigWindow::GetFooterPanels>("getFooterPanels"),
+        InstanceMethod<&BitwigWindow::SetActivitySampling>("setActivitySampling"),
+        InstanceMethod<&BitwigWindow::GetActivityHistory>("getActivityHistory"),
+        InstanceMethod<&BitwigWindow::StartRecording>("startRecording"),
+        InstanceMethod<&BitwigWindow::StopRecording>("stopRecording")
     });
     exports.Set("BitwigWindow", func);
+    registerActivityEvents();
     BitwigWindow::constructor = Napi::Persistent(func);
     BitwigWindow::constructor.SuppressDestruct();
 };
@@ -641,59 +649,59 @@ Napi::Value BitwigWindow::getRect(const Napi::CallbackInfo &info) {
     return rect.toJSObject(info.Env());
 };
 WindowInfo BitwigWindow::getFrame() {
-    // Go through all on screen windows, find BW, get its frame
-    CFArrayRef array = CGWindowListCopyWindowInfo(kCGWindowListOptionOnScreenOnly | kCGWindowListExcludeDesktopElements, kCGNullWindowID);
-    CFIndex count = CFArrayGetCount(array);
-    for (CFIndex i = 0; i < count; i++) {
-        CFDictionaryRef dict = (CFDictionaryRef)CFArrayGetValueAtIndex(array, i);
-        auto str = CFStringToString((CFStringRef)CFDictionaryGetValue(dict, kCGWindowOwnerName));
-        if (str == "Bitwig Studio") {
-            CGRect windowRect;
-            CGRectMakeWithDictionaryRepresentation((CFDictionaryRef)(CFDictionaryGetValue(dict, kCGWindowBounds)), &windowRect);
-            if (windowRect.size.height < 100) {
-                // Bitwig opens a separate window for its tooltips, ignore this window
-                // TODO Revisit better way of only getting the main window
-                continue;
-            }
-            CGWindowID windowId;
-            CFNumberGetValue((CFNumberRef)CFDictionaryGetValue(dict, kCGWindowNumber), kCGWindowIDCFNumberType, &windowId);
-            CFRelease(array);
-            return WindowInfo{
-                windowId,
-                MWRect({ 
-                    (int)windowRect.origin.x, 
-                    (int)windowRect.origin.y,
-                    (int)windowRect.size.width, 
-                    (int)windowRect.size.height
-                })
-            };
-        }
+    if (boundWindowId == 0) {
+        return findBitwigMainWindow();
+    }
+    auto windows = getWindowList();
+    auto window = windows->find(boundWindowId);
+    if (window == nullptr) {
+        return WindowInfo{
+            boundWindowId,
+            MWRect{0, 0, 0, 0}
+        };
     }
-    CFRelease(array);
     return WindowInfo{
-        1,
-        MWRect{0, 0, 0, 0}
+        window->id,
+        window->frame
     };
 };
 
 ImageDeets* BitwigWindow::updateScreenshot() {
-    auto newFrame = getFrame();
+    static auto& findTime = metricHistogram("capture.findWindow.time");
+    static auto& captureTime = metricHistogram("capture.time");
+    static auto& captureBytes = metricHistogram("capture.bytes");
+    static auto& captureFailures = metricCounter("capture.failures");
+    WindowInfo newFrame;
+    {
+        MetricTimer timer(findTime);
+        newFrame = getFrame();
+    }
     if (newFrame.frame.w == 0 && newFrame.frame.h == 0) {
         std::cout << "Couldn't find window, can't update screenshot";
+        captureFailures.add();
+        return latestImageDeets;
+    }
+    // std::cout << "updating screenshot" << std::endl;
+    ImageDeets* image;
+    {
+        MetricTimer timer(captureTime);
+        image = captureWindow(newFrame);
+    }
+    if (image == nullptr) {
+        std::cout << "Couldn't capture window, keeping previous screenshot";
+        captureFailures.add();
         return latestImageDeets;
     }
+    captureBytes.record(image->bytesPerRow * image->height);
     lastBWFrame = newFrame;
     if (latestImageDeets != nullptr) {
         delete latestImageDeets;
     }
-    // std::cout << "updating screenshot" << std::endl;
-    auto image = CGWindowListCreateImage(
-        CGRectNull, 
-        kCGWindowListOptionIncludingWindow, 
-        this->lastBWFrame.windowId, 
-        kCGWindowImageBoundsIgnoreFraming | kCGWindowImageNominalResolution
-    );
-    latestImageDeets = new ImageDeets(image, lastBWFrame);
+    latestImageDeets = image;
+    if (recorder) {
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordingStarted).count();
+        recorder->addFrame(image, ms);
+    }
     return latestImageDeets;
 };
 
@@ -707,39 +715,137 @@ Napi::Value updateUILayoutInfo(const Napi::CallbackInfo &info) {
         isLargeTrackHeight = obj.Get("isLargeTrackHeight").As<Napi::Boolean>();
     }
     if (obj.Has("layout")) {
-        // TODO
+        uiLayout = obj.Get("layout").As<Napi::String>();
+    }
+    if (obj.Has("version")) {
+        bitwigVersion = obj.Get("version").As<Napi::String>();
+    }
+    selectLayoutProfile();
+    for (auto window : BitwigWindow::instances) {
+        window->prevLayout = {};
     }
     return env.Null();
 }
 
+/**
+ * Replaces the layout profiles with the ones in the file at path (see layoutprofile.h), returns
+ * how many sections it has. Throws if it can't be read, keeping the profiles from before
+ */
+Napi::Value loadLayoutProfilesFromFile(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    std::string path = info[0].As<Napi::String>();
+    size_t sections;
+    try {
+        sections = loadLayoutProfiles(path);
+    } catch (const std::runtime_error& error) {
+        throw Napi::Error::New(env, error.what());
+    }
+    for (auto window : BitwigWindow::instances) {
+        window->prevLayout = {};
+    }
+    return Napi::Number::New(env, sections);
+}
+
 Napi::Value invalidateLayout(const Napi::CallbackInfo &info) {
-    prevLayout = {};
+    for (auto window : BitwigWindow::instances) {
+        window->prevLayout = {};
+    }
     return info.Env().Null();
 }
 
+/**
+ * Every Bitwig window big enough to be a main window, [{windowId, frame}], e.g. to create a
+ * BitwigWindow bound to each display of a dual display layout
+ */
+Napi::Value getBitwigWindows(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto windows = getWindowList();
+    auto array = Napi::Array::New(env);
+    uint32_t i = 0;
+    for (auto window : windows->ownedBy("Bitwig Studio")) {
+        if (window->frame.h < 100) {
+            // Tooltips
+            continue;
+        }
+        auto frame = window->frame;
+        auto obj = Napi::Object::New(env);
+        obj.Set("windowId", Napi::Number::New(env, (double)window->id));
+        obj.Set("frame", frame.toJSObject(env));
+        array[i++] = obj;
+    }
+    return array;
+}
+
+/**
+ * Captures and detects the layout of each given BitwigWindow (all live ones if none are given)
+ * at once on the detection pool, so two displays take about as long as one. Returns
+ * [{windowId, frame, profile, layout}] in the same order
+ */
+Napi::Value getLayoutStates(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    static auto& totalTime = metricHistogram("getLayoutStates.time");
+    MetricTimer timer(totalTime);
+
+    std::vector<BitwigWindow*> windows;
+    if (info.Length() > 0 && info[0].IsArray()) {
+        auto array = info[0].As<Napi::Array>();
+        for (uint32_t i = 0; i < array.Length(); i++) {
+            windows.push_back(BitwigWindow::Unwrap(array.Get(i).As<Napi::Object>()));
+        }
+    } else {
+        windows.assign(BitwigWindow::instances.begin(), BitwigWindow::instances.end());
+    }
+
+    // Each task only touches its own window, and the JS thread waits for them all
+    std::vector<BitwigLayout> layouts(windows.size());
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < windows.size(); i++) {
+        tasks.push_back([&, i]() {
+            layouts[i] = windows[i]->getLayoutState();
+        });
+    }
+    getDetectionPool().runAll(tasks);
+
+    auto array = Napi::Array::New(env, windows.size());
+    for (size_t i = 0; i < windows.size(); i++) {
+        auto obj = Napi::Object::New(env);
+        obj.Set("windowId", Napi::Number::New(env, (double)windows[i]->lastBWFrame.windowId));
+        obj.Set("frame", windows[i]->lastBWFrame.frame.toJSObject(env));
+        obj.Set("profile", windows[i]->getLayoutProfile());
+        obj.Set("layout", layouts[i].toJSObject(env));
+        array[(uint32_t)i] = obj;
+    }
+    return array;
+}
+
+LayoutConstant layoutConstantArgument(const Napi::CallbackInfo &info) {
+    std::string name = info[0].As<Napi::String>();
+    LayoutConstant constant;
+    if (!findLayoutConstant(name, constant)) {
+        throw Napi::Error::New(info.Env(), "Unknown layout constant: " + name);
+    }
+    return constant;
+}
+
 Napi::Value getSizeInfo(const Napi::CallbackInfo &info) {
     Napi::Env env = info.Env();
     std::string str = info[0].As<Napi::String>();
     if (str == "minimumTrackHeight") {
         if (isLargeTrackHeight) {
-            return Napi::Number::New(env, getConstant("MINIMUM_DOUBLE_TRACK_HEIGHT") * uiScale);
+            return Napi::Number::New(env, getConstant(MINIMUM_DOUBLE_TRACK_HEIGHT) * uiScale);
         } else {
-            return Napi::Number::New(env, getConstant("MINIMUM_TRACK_HEIGHT") * uiScale);
+            return Napi::Number::New(env, getConstant(MINIMUM_TRACK_HEIGHT) * uiScale);
         }
     }
-    return Napi::Number::New(env, constants[str]);
+    return Napi::Number::New(env, getConstant(layoutConstantArgument(info)));
 }
 
 Napi::Value js_getConstant(const Napi::CallbackInfo &info) {
-    Napi::Env env = info.Env();
-    std::string str = info[0].As<Napi::String>();
-    return Napi::Number::New(env, getConstant("MINIMUM_DOUBLE_TRACK_HEIGHT"));
+    return Napi::Number::New(info.Env(), getConstant(layoutConstantArgument(info)));
 }
 
 Napi::Value js_getScaledConstant(const Napi::CallbackInfo &info) {
-    Napi::Env env = info.Env();
-    std::string str = info[0].As<Napi::String>();
-    return Napi::Number::New(env, getConstant("MINIMUM_DOUBLE_TRACK_HEIGHT") * uiScale);
+    return Napi::Number::New(info.Env(), getConstant(layoutConstantArgument(info), true));
 }
 
 Napi::Value InitUI(Napi::Env env, Napi::Object exports) {
@@ -747,7 +853,10 @@ Napi::Value InitUI(Napi::Env env, Napi::Object exports) {
 
     BitwigWindow::Init(env, obj);
     obj.Set(Napi::String::New(env, "updateUILayoutInfo"), Napi::Function::New(env, updateUILayoutInfo));
+    obj.Set(Napi::String::New(env, "loadLayoutProfiles"), Napi::Function::New(env, loadLayoutProfilesFromFile));
     obj.Set(Napi::String::New(env, "invalidateLayout"), Napi::Function::New(env, invalidateLayout));
+    obj.Set(Napi::String::New(env, "getBitwigWindows"), Napi::Function::New(env, getBitwigWindows));
+    obj.Set(Napi::String::New(env, "getLayoutStates"), Napi::Function::New(env, getLayoutStates));
     obj.Set(Napi::String::New(env, "getSizeInfo"), Napi::Function::New(env, getSizeInfo));
     obj.Set(Napi::String::New(env, "getConstant"), Napi::Function::New(env, js_getConstant));
     obj.Set(Napi::String::New(env, "getScaledConstant"), Napi::Function::New(env, js_getScaledConstant));
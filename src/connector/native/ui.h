@@ -1,85 +1,34 @@
 #pragma once
 #include <napi.h>
-#include <experimental/optional>
+#include "detect.h"
 #include "keyboard.h"
+#include "ruler.h"
+#include "devicechain.h"
+#include "footerpanels.h"
+#include "mixerstrips.h"
+#include "framerecording.h"
+#include <chrono>
+#include <experimental/optional>
+#include <memory>
+#include <set>
+#ifndef __APPLE__
+struct ShmImage;
+#endif
 
-struct XYPoint {
-    int x, y;
-    Napi::Object toJSObject(Napi::Env env);
-    static XYPoint fromJSObject(Napi::Object obj, Napi::Env env);
-};
-struct UIPoint {
-    int window;
-    XYPoint point;
-};
-struct MWRect {
-    int x, y, w, h;
-    Napi::Object toJSObject(Napi::Env env);
-    static MWRect fromJSObject(Napi::Object obj, Napi::Env env);
-    XYPoint fromBottomLeft(int x, int y);
-    XYPoint fromTopLeft(int x, int y);
-    XYPoint fromTopRight(int x, int y);
-    XYPoint fromBottomRight(int x, int y);
-};
-struct WindowInfo {
-    CGWindowID windowId;
-    MWRect frame;
-};
-struct MWColor {
-    int r, g, b;
-    Napi::Object toJSObject(Napi::Env env);
-    static MWColor fromJSObject(Napi::Object obj, Napi::Env env);
-    bool isWithinRange(MWColor b, int amount = 5);
-};
-
-struct EditorPanel {
-    std::string type;
-    MWRect rect;
-    Napi::Object toJSObject(Napi::Env env);
-};
-struct Inspector {
-    MWRect rect;
-    Napi::Object toJSObject(Napi::Env env);
-};
-struct Arranger {
-    MWRect rect;
-    Napi::Object toJSObject(Napi::Env env);
-};
-struct BitwigLayout {
-    std::experimental::optional<EditorPanel> editor;
-    std::experimental::optional<Inspector> inspector;
-    std::experimental::optional<Arranger> arranger;
-    bool modalOpen;
-    Napi::Object toJSObject(Napi::Env env);
-};
-struct ArrangerTrack {
-    MWRect rect, visibleRect;
-    bool selected, automationOpen, isLargeTrackHeight;
-    Napi::Object toJSObject(Napi::Env env);
-    static ArrangerTrack fromJSObject(Napi::Object obj, Napi::Env env);
-};
-struct ImageDeets {
+/**
+ * A captured window, FrameImage plus whatever capture.cc needs to release it
+ */
+struct ImageDeets : FrameImage {
+#ifdef __APPLE__
     CFDataRef imageData;
-    size_t bytesPerRow;
-    size_t bytesPerPixel;
     CGImageRef imageRef;
     CGBitmapInfo info;
-    WindowInfo frame;
-    size_t maxInclOffset;
-    int width, height;
     ImageDeets(CGImageRef latestImage, WindowInfo frame);
+#else
+    ShmImage* shmImage;
+    ImageDeets(ShmImage* shmImage, WindowInfo frame);
+#endif
     ~ImageDeets();
-    size_t getPixelOffset(XYPoint point);
-    bool isWithinBounds(XYPoint point);
-    MWColor colorAt(XYPoint point);
-
-    std::experimental::optional<XYPoint> seekUntilColor(
-        XYPoint startPoint,
-        std::function<bool(MWColor)> tester, 
-        int changeAxis,
-        int direction, 
-        int step = 1
-    );
 };
 // class BitwigUI : public Napi::ObjectWrap<BitwigUI> {
 //     public:
@@ -101,22 +50,46 @@ struct ImageDeets {
 //     BitwigUIComponent(const Napi::CallbackInfo &info);
 //     static Napi::Object Init(Napi::Env env, Napi::Object exports);
 // };
+/**
+ * One Bitwig window. Constructed with {windowId} it stays bound to that window (e.g. the
+ * second window of a dual display layout), otherwise it follows the main window. Each has its
+ * own layout profile ({layout}, defaulting to the one from updateUILayoutInfo), screenshot
+ * and layout cache.
+ */
 class BitwigWindow: public Napi::ObjectWrap<BitwigWindow> {
     public:
     static Napi::FunctionReference constructor;
+    // Live instances, so invalidateLayout reaches all of them
+    static std::set<BitwigWindow*> instances;
     MWRect rect;
     int index = 0;
     bool arrangerDirty;
     XYPoint mouseDownAt;
     int mouseDownButton;
+    NativeWindowId boundWindowId = 0;
+    std::string layoutProfile;
     WindowInfo lastBWFrame;
+    std::experimental::optional<BitwigLayout> prevLayout;
+    RulerTracker ruler;
+    DeviceChainCache deviceChain;
+    // What getDeviceChain last returned, handed back while deviceChain is unchanged
+    Napi::ObjectReference deviceChainObject;
+    // What getMixerStrips last found
+    MixerStrips mixer;
+    // Every screenshot goes to it while recording, see framerecording.h
+    std::unique_ptr<FrameRecorder> recorder;
+    std::chrono::steady_clock::time_point recordingStarted;
     MWColor colorAt(XYPoint point);
     ImageDeets* latestImageDeets = nullptr;
     WindowInfo getFrame();
     ImageDeets* updateScreenshot();
     BitwigLayout getLayoutState();
     int getMainPanelStartY();
+    std::string getLayoutProfile();
+    // The constants for this window's layout, every detector measures with these
+    const LayoutProfile& getProfile();
     BitwigWindow(const Napi::CallbackInfo &info);
+    ~BitwigWindow();
 
     // BitwigUIComponent arranger;
     // BitwigUIComponent inspector;
@@ -128,6 +101,21 @@ class BitwigWindow: public Napi::ObjectWrap<BitwigWindow> {
     Napi::Value GetFrame(const Napi::CallbackInfo &info);
     Napi::Value GetLayoutState(const Napi::CallbackInfo &info);
     Napi::Value GetArrangerTracks(const Napi::CallbackInfo &info);
+    Napi::Value GetUISnapshot(const Napi::CallbackInfo &info);
+    Napi::Value GetWindowId(const Napi::CallbackInfo &info);
+    Napi::Value SetLayoutProfile(const Napi::CallbackInfo &info);
+    Napi::Value GetRuler(const Napi::CallbackInfo &info);
+    Napi::Value AnchorRuler(const Napi::CallbackInfo &info);
+    Napi::Value GetDeviceChain(const Napi::CallbackInfo &info);
+    Napi::Value GetMixerStrips(const Napi::CallbackInfo &info);
+    Napi::Value GetFooterPanels(const Napi::CallbackInfo &info);
+    Napi::Value SetActivitySampling(const Napi::CallbackInfo &info);
+    Napi::Value GetActivityHistory(const Napi::CallbackInfo &info);
+    Napi::Value StartRecording(const Napi::CallbackInfo &info);
+    Napi::Value StopRecording(const Napi::CallbackInfo &info);
+    private:
+    const RulerState* updateRuler();
+    bool updateMixerStrips();
 };
 
 Napi::Value InitUI(Napi::Env env, Napi::Object exports);
\ No newline at end of file
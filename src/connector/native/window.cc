@@ -1,11 +1,13 @@
 #include "point.h"
 #include "window.h"
 #include "rect.h"
+#include "windowlist.h"
 
 #include <CoreGraphics/CoreGraphics.h>
 #include <napi.h>
 #include <iostream>
 #include <string>
+#include <vector>
 #include "string.h"
 
 Napi::Value GetMainScreen(const Napi::CallbackInfo &info) {
@@ -21,21 +23,57 @@ Napi::Value GetMainScreen(const Napi::CallbackInfo &info) {
     return obj;
 }
 
-Napi::Value ClosePluginWindows(const Napi::CallbackInfo &info) {
-    Napi::Env env = info.Env();
-
-    // Go through all on screen windows, find BW, get its frame
+void enumerateWindows(WindowListSnapshot& snapshot) {
     CFArrayRef array = CGWindowListCopyWindowInfo(kCGWindowListOptionOnScreenOnly | kCGWindowListExcludeDesktopElements, kCGNullWindowID);
+    if (array == NULL) {
+        return;
+    }
+    // The same few owners own most windows, only convert each one once
+    std::vector<std::pair<CFStringRef, const std::string*>> owners;
     CFIndex count = CFArrayGetCount(array);
     for (CFIndex i = 0; i < count; i++) {
         CFDictionaryRef dict = (CFDictionaryRef)CFArrayGetValueAtIndex(array, i);
-        auto str = CFStringToString((CFStringRef)CFDictionaryGetValue(dict, kCGWindowOwnerName));
-        auto windowName = CFStringToString((CFStringRef)CFDictionaryGetValue(dict, kCGWindowName));
-        if (str == "Bitwig Studio") {
-            std::cout << "window name: " << windowName << std::endl;
+        CFStringRef ownerRef = (CFStringRef)CFDictionaryGetValue(dict, kCGWindowOwnerName);
+        if (ownerRef == NULL) {
+            continue;
+        }
+        ListedWindow window;
+        window.owner = nullptr;
+        for (auto& owner : owners) {
+            if (CFEqual(owner.first, ownerRef)) {
+                window.owner = owner.second;
+                break;
+            }
+        }
+        if (window.owner == nullptr) {
+            window.owner = internWindowOwner(CFStringToString(ownerRef));
+            owners.push_back({ownerRef, window.owner});
         }
+
+        CGWindowID windowId;
+        CFNumberGetValue((CFNumberRef)CFDictionaryGetValue(dict, kCGWindowNumber), kCGWindowIDCFNumberType, &windowId);
+        window.id = windowId;
+        CFNumberGetValue((CFNumberRef)CFDictionaryGetValue(dict, kCGWindowOwnerPID), kCFNumberSInt32Type, &window.pid);
+        CGRect windowRect;
+        CGRectMakeWithDictionaryRepresentation((CFDictionaryRef)(CFDictionaryGetValue(dict, kCGWindowBounds)), &windowRect);
+        window.frame = MWRect({
+            (int)windowRect.origin.x,
+            (int)windowRect.origin.y,
+            (int)windowRect.size.width,
+            (int)windowRect.size.height
+        });
+        window.title = CFStringToString((CFStringRef)CFDictionaryGetValue(dict, kCGWindowName));
+        snapshot.add(std::move(window));
     }
     CFRelease(array);
+}
+
+Napi::Value ClosePluginWindows(const Napi::CallbackInfo &info) {
+    Napi::Env env = info.Env();
+    auto windows = getWindowList();
+    for (auto window : windows->ownedBy("Bitwig Studio")) {
+        std::cout << "window name: " << window->title << std::endl;
+    }
     return env.Null();
 }
 
@@ -1,5 +1,4 @@
 #pragma once
 #include <napi.h>
-#include <CoreGraphics/CoreGraphics.h>
 
 Napi::Value InitWindow(Napi::Env env, Napi::Object exports);
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include "windowgeometry.h"
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+
+std::vector<std::pair<std::string, PluginWindow>> pluginWindowsById(const PluginWindowList& windows) {
+    std::vector<std::pair<std::string, PluginWindow>> out;
+    for (auto& window : windows) {
+        auto id = window.title;
+        while (std::any_of(out.begin(), out.end(), [&](const std::pair<std::string, PluginWindow>& pair) { return pair.first == id; })) {
+            id = id + " (duplicate)";
+        }
+        out.push_back({id, window});
+    }
+    return out;
+}
+
+// Sub-pixel differences come from rounding on the window server side, not real changes
+bool geometryDiffers(double a, double b) {
+    return std::abs(a - b) >= 1;
+}
+
+GeometryTransaction::GeometryTransaction(PluginWindowRegistry& registry, bool rollback, bool alwaysMove)
+    : registry(registry),
+    windows(pluginWindowsById(*registry.windows())),
+    rollback(rollback),
+    alwaysMove(alwaysMove) {}
+
+bool GeometryTransaction::anyFailed() const {
+    return std::any_of(changes.begin(), changes.end(), [](const GeometryChange& change) {
+        return !change.ok;
+    });
+}
+
+void GeometryTransaction::add(const std::string& id, const GeometryTarget* target) {
+    auto found = std::find_if(windows.begin(), windows.end(), [&](const std::pair<std::string, PluginWindow>& pair) {
+        return pair.first == id || std::to_string(pair.second.key) == id;
+    });
+    if (found == windows.end() || target == nullptr) {
+        skipped.push_back({id, "missing"});
+        return;
+    }
+    auto& from = found->second;
+    GeometryChange change;
+    change.id = id;
+    change.key = from.key;
+    change.from = from;
+    change.x = target->x ? *target->x : from.x;
+    change.y = target->y ? *target->y : from.y;
+    change.w = target->w ? *target->w : from.w;
+    change.h = target->h ? *target->h : from.h;
+    change.move = alwaysMove || geometryDiffers(change.x, from.x) || geometryDiffers(change.y, from.y);
+    change.resize = geometryDiffers(change.w, from.w) || geometryDiffers(change.h, from.h);
+    if (!change.move && !change.resize) {
+        skipped.push_back({id, "unchanged"});
+        return;
+    }
+    changes.push_back(change);
+}
+
+void GeometryTransaction::apply(size_t i) {
+    auto& change = changes[i];
+    auto source = registry.getSource();
+    // Size first, some windows clamp their position to keep the whole frame on screen
+    change.ok = (!change.resize || source->resize(change.key, change.w, change.h))
+        && (!change.move || source->move(change.key, change.x, change.y));
+}
+
+void GeometryTransaction::finish() {
+    if (!rollback || !anyFailed()) {
+        return;
+    }
+    auto source = registry.getSource();
+    for (auto& change : changes) {
+        if (!change.ok) {
+            continue;
+        }
+        if (change.resize) {
+            source->resize(change.key, change.from.w, change.from.h);
+        }
+        if (change.move) {
+            source->move(change.key, change.from.x, change.from.y);
+        }
+    }
+}
+
+std::vector<std::pair<std::string, std::string>> GeometryTransaction::results() const {
+    auto out = skipped;
+    bool failed = anyFailed();
+    for (auto& change : changes) {
+        std::string status = change.ok ? "applied" : "failed";
+        if (change.ok && failed && rollback) {
+            status = "rolledBack";
+        }
+        out.push_back({change.id, status});
+    }
+    return out;
+}
+
+ClearTransaction::ClearTransaction(PluginWindowRegistry& registry, double x, double y, double w, double h, std::chrono::milliseconds timeout)
+    : registry(registry),
+    rx(x), ry(y), rw(w), rh(h),
+    deadline(std::chrono::steady_clock::now() + timeout),
+    unconfirmed(0) {
+    registry.getSource()->awayPosition(awayX, awayY);
+    for (auto& pair : pluginWindowsById(*registry.windows())) {
+        if (pair.second.intersects(rx, ry, rw, rh)) {
+            windows.push_back(pair);
+        }
+    }
+}
+
+void ClearTransaction::clear(size_t i) {
+    auto& from = windows[i].second;
+    auto source = registry.getSource();
+    source->move(from.key, awayX, awayY);
+
+    // Moves are applied asynchronously (and may be constrained by the window manager), so
+    // confirm by geometry rather than sleeping for a worst case amount of time. What we
+    // confirmed goes straight into the registry, its own notification may not have arrived
+    while (true) {
+        PluginWindow window;
+        if (!source->fetch(from.key, window)) {
+            registry.windowDestroyed(from.key);
+            return;
+        }
+        if (!window.intersects(rx, ry, rw, rh)) {
+            registry.windowFetched(window);
+            return;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            unconfirmed++;
+            return;
+        }
+        usleep(500);
+    }
+}
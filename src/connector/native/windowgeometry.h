@@ -0,0 +1,81 @@
+#pragma once
+#include "windowregistry.h"
+#include <atomic>
+#include <chrono>
+#include <experimental/optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Windows are identified to JS by title, with duplicates made unique in the order the window
+ * server returns them
+ */
+std::vector<std::pair<std::string, PluginWindow>> pluginWindowsById(const PluginWindowList& windows);
+
+// Whatever isn't set stays as it is
+struct GeometryTarget {
+    std::experimental::optional<double> x, y, w, h;
+};
+
+struct GeometryChange {
+    std::string id;
+    uint64_t key;
+    PluginWindow from;
+    double x, y, w, h;
+    bool move, resize;
+    bool ok = false;
+};
+
+/**
+ * One setPluginWindowsPosition/restorePluginWindows call, diffed against the registry so only
+ * what differs is touched. No N-API in here, pluginwindows.cc runs apply() for each change on
+ * its worker pool and settles the Promise with results() after finish()
+ */
+class GeometryTransaction {
+    PluginWindowRegistry& registry;
+    std::vector<std::pair<std::string, PluginWindow>> windows;
+    bool rollback;
+    bool alwaysMove;
+
+    bool anyFailed() const;
+public:
+    std::vector<GeometryChange> changes;
+    // Windows needing no change, or not found. Reported but never touched
+    std::vector<std::pair<std::string, std::string>> skipped;
+
+    // With rollback, any failure puts the windows that did change back where they were. With
+    // alwaysMove the position is set even if the registry thinks it's already there, for
+    // callers that know better than a cache that may not have caught up yet
+    GeometryTransaction(PluginWindowRegistry& registry, bool rollback, bool alwaysMove = false);
+
+    // id is the JS id or windowId, no target means the caller couldn't read one
+    void add(const std::string& id, const GeometryTarget* target);
+    // Safe to call concurrently for different changes
+    void apply(size_t i);
+    // Once every change has been applied
+    void finish();
+    // [id, 'applied' | 'unchanged' | 'missing' | 'failed' | 'rolledBack']
+    std::vector<std::pair<std::string, std::string>> results() const;
+};
+
+/**
+ * One clearPluginWindowsFrom call, the plugin windows overlapping a region and moving them
+ * out of it. pluginwindows.cc runs clear() for each window on its worker pool
+ */
+class ClearTransaction {
+    PluginWindowRegistry& registry;
+    double rx, ry, rw, rh;
+    std::chrono::steady_clock::time_point deadline;
+    double awayX, awayY;
+public:
+    // Original frames, to hand back to restorePluginWindows
+    std::vector<std::pair<std::string, PluginWindow>> windows;
+    // Windows still in the region when the timeout passed
+    std::atomic<int> unconfirmed;
+
+    ClearTransaction(PluginWindowRegistry& registry, double x, double y, double w, double h, std::chrono::milliseconds timeout);
+
+    // Safe to call concurrently for different windows
+    void clear(size_t i);
+};
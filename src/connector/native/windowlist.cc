@@ -0,0 +1,104 @@
+#include "windowlist.h"
+#include "metrics.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_set>
+
+const auto WINDOW_LIST_VALIDITY = std::chrono::milliseconds(100);
+
+std::mutex windowOwnersMutex;
+// Node based, so pointers to the names stay valid as it grows
+std::unordered_set<std::string> windowOwners;
+
+const std::string* internWindowOwner(const std::string& name) {
+    std::lock_guard<std::mutex> lock(windowOwnersMutex);
+    return &*windowOwners.insert(name).first;
+}
+
+const std::string* findInternedWindowOwner(const std::string& name) {
+    std::lock_guard<std::mutex> lock(windowOwnersMutex);
+    auto it = windowOwners.find(name);
+    return it != windowOwners.end() ? &*it : nullptr;
+}
+
+/**
+ * WindowListSnapshot
+ */
+void WindowListSnapshot::add(ListedWindow window, const std::vector<const std::string*>& alsoOwnedBy) {
+    auto index = windows.size();
+    byOwner[window.owner].push_back(index);
+    for (auto owner : alsoOwnedBy) {
+        auto& indices = byOwner[owner];
+        if (owner != window.owner && (indices.empty() || indices.back() != index)) {
+            indices.push_back(index);
+        }
+    }
+    byId[window.id] = index;
+    windows.push_back(std::move(window));
+}
+
+std::vector<const ListedWindow*> WindowListSnapshot::ownedBy(const std::string& owner) const {
+    std::vector<const ListedWindow*> out;
+    auto it = byOwner.find(findInternedWindowOwner(owner));
+    if (it != byOwner.end()) {
+        for (auto index : it->second) {
+            out.push_back(&windows[index]);
+        }
+    }
+    return out;
+}
+
+const ListedWindow* WindowListSnapshot::findOwned(const std::string& owner, int minHeight) const {
+    auto it = byOwner.find(findInternedWindowOwner(owner));
+    if (it == byOwner.end()) {
+        return nullptr;
+    }
+    for (auto index : it->second) {
+        if (windows[index].frame.h >= minHeight) {
+            return &windows[index];
+        }
+    }
+    return nullptr;
+}
+
+const ListedWindow* WindowListSnapshot::find(NativeWindowId id) const {
+    auto it = byId.find(id);
+    return it != byId.end() ? &windows[it->second] : nullptr;
+}
+
+/**
+ * Shared snapshot
+ */
+std::mutex windowListMutex;
+std::shared_ptr<const WindowListSnapshot> currentWindowList;
+std::chrono::steady_clock::time_point windowListTakenAt;
+std::atomic<bool> windowListStale(true);
+
+std::shared_ptr<const WindowListSnapshot> getWindowList() {
+    static auto& hits = metricCounter("windowList.hits");
+    static auto& misses = metricCounter("windowList.misses");
+    static auto& enumerateTime = metricHistogram("windowList.enumerate.time");
+
+    // Held while enumerating, so callers arriving meanwhile share the result
+    std::lock_guard<std::mutex> lock(windowListMutex);
+    auto now = std::chrono::steady_clock::now();
+    bool stale = windowListStale.exchange(false);
+    if (!stale && currentWindowList != nullptr && now - windowListTakenAt < WINDOW_LIST_VALIDITY) {
+        hits.add();
+        return currentWindowList;
+    }
+    misses.add();
+    auto snapshot = std::make_shared<WindowListSnapshot>();
+    {
+        MetricTimer timer(enumerateTime);
+        enumerateWindows(*snapshot);
+    }
+    currentWindowList = snapshot;
+    windowListTakenAt = now;
+    return currentWindowList;
+}
+
+void invalidateWindowList() {
+    windowListStale = true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "detect.h"
+#include <sys/types.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * One enumeration of the on screen windows, shared by every lookup until it's
+ * WINDOW_LIST_VALIDITY old or an input event invalidates it (clicks and key presses are what
+ * open, close and move windows). Owner names are interned, so each distinct name is converted
+ * once and owners compare by pointer.
+ */
+struct ListedWindow {
+    NativeWindowId id;
+    const std::string* owner;
+    pid_t pid = -1;
+    MWRect frame;
+    // Only on macOS, where it comes with the list. Use getWindowTitle on Linux
+    std::string title;
+};
+
+class WindowListSnapshot {
+    std::unordered_map<const std::string*, std::vector<size_t>> byOwner;
+    std::unordered_map<NativeWindowId, size_t> byId;
+public:
+    // In the order the platform lists them (front to back on macOS)
+    std::vector<ListedWindow> windows;
+
+    // alsoOwnedBy indexes the window under other names too (WM_CLASS instance etc. on Linux)
+    void add(ListedWindow window, const std::vector<const std::string*>& alsoOwnedBy = {});
+    std::vector<const ListedWindow*> ownedBy(const std::string& owner) const;
+    // First window of owner at least minHeight tall, e.g. to skip tooltip windows
+    const ListedWindow* findOwned(const std::string& owner, int minHeight = 0) const;
+    const ListedWindow* find(NativeWindowId id) const;
+};
+
+const std::string* internWindowOwner(const std::string& name);
+std::shared_ptr<const WindowListSnapshot> getWindowList();
+void invalidateWindowList();
+
+/**
+ * Defined per platform in window.cc (CGWindowListCopyWindowInfo) and linux/x11.cc
+ */
+void enumerateWindows(WindowListSnapshot& snapshot);
@@ -0,0 +1,98 @@
+#include "windowregistry.h"
+#include <algorithm>
+
+bool PluginWindow::intersects(double rx, double ry, double rw, double rh) const {
+    return x < rx + rw && rx < x + w && y < ry + rh && ry < y + h;
+}
+
+PluginWindowRegistry::PluginWindowRegistry(PluginWindowSource* source)
+    : source(source),
+    snapshot(std::make_shared<const PluginWindowList>()),
+    generation(1),
+    snapshotGeneration(0) {}
+
+PluginWindowSource* PluginWindowRegistry::getSource() {
+    return source;
+}
+
+void PluginWindowRegistry::publish(std::shared_ptr<const PluginWindowList> list) {
+    std::atomic_store(&snapshot, list);
+}
+
+std::shared_ptr<const PluginWindowList> PluginWindowRegistry::windows() {
+    bool watching = source->watch(this);
+    if (watching && snapshotGeneration == generation) {
+        return std::atomic_load(&snapshot);
+    }
+
+    // Not being notified (or told to re-read), fall back to asking the window server
+    std::lock_guard<std::mutex> lock(writeMutex);
+    uint64_t readAt = generation;
+    auto list = std::make_shared<const PluginWindowList>(source->fetchAll());
+    publish(list);
+    if (watching) {
+        snapshotGeneration = readAt;
+    }
+    return list;
+}
+
+void PluginWindowRegistry::store(const PluginWindow& window) {
+    auto list = std::make_shared<PluginWindowList>(*std::atomic_load(&snapshot));
+    auto it = std::find_if(list->begin(), list->end(), [&](const PluginWindow& w) {
+        return w.key == window.key;
+    });
+    if (it != list->end()) {
+        *it = window;
+    } else {
+        list->push_back(window);
+    }
+    publish(list);
+}
+
+void PluginWindowRegistry::windowChanged(uint64_t key) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    PluginWindow window;
+    if (source->fetch(key, window)) {
+        store(window);
+        return;
+    }
+    auto list = std::make_shared<PluginWindowList>(*std::atomic_load(&snapshot));
+    list->erase(std::remove_if(list->begin(), list->end(), [=](const PluginWindow& w) {
+        return w.key == key;
+    }), list->end());
+    publish(list);
+}
+
+void PluginWindowRegistry::windowFetched(const PluginWindow& window) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    store(window);
+}
+
+void PluginWindowRegistry::windowDestroyed(uint64_t key) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    auto list = std::make_shared<PluginWindowList>(*std::atomic_load(&snapshot));
+    list->erase(std::remove_if(list->begin(), list->end(), [=](const PluginWindow& w) {
+        return w.key == key;
+    }), list->end());
+    publish(list);
+}
+
+void PluginWindowRegistry::focusChanged(uint64_t key) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    auto current = std::atomic_load(&snapshot);
+    bool changed = std::any_of(current->begin(), current->end(), [=](const PluginWindow& w) {
+        return w.focused != (w.key == key);
+    });
+    if (!changed) {
+        return;
+    }
+    auto list = std::make_shared<PluginWindowList>(*current);
+    for (auto& window : *list) {
+        window.focused = window.key == key;
+    }
+    publish(list);
+}
+
+void PluginWindowRegistry::invalidate() {
+    generation++;
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Cache of plugin windows kept up to date by window notifications, so queries (and mouse
+ * events checking for plugin windows) don't need to go back to the window server. No
+ * N-API or platform code in here, see PluginWindowSource.
+ */
+struct PluginWindow {
+    // Stable for as long as the window exists (X window id, CFHash of the AX element)
+    uint64_t key = 0;
+    std::string title;
+    double x = 0, y = 0, w = 0, h = 0;
+    bool focused = false;
+
+    bool intersects(double rx, double ry, double rw, double rh) const;
+};
+typedef std::vector<PluginWindow> PluginWindowList;
+
+class PluginWindowRegistry;
+
+/**
+ * Where plugin windows come from and how they're changed. One per platform (Accessibility on
+ * macOS, X11 on Linux). A source tells the registry about changes by calling its notification
+ * methods from whatever thread it receives them on.
+ */
+class PluginWindowSource {
+public:
+    virtual ~PluginWindowSource() {}
+    // Called before each read, should be cheap if already watching. Returns false if
+    // notifications can't be relied on right now (e.g. the plugin host isn't running)
+    virtual bool watch(PluginWindowRegistry* registry) = 0;
+    virtual PluginWindowList fetchAll() = 0;
+    // Fresh state for one window, false if it no longer exists
+    virtual bool fetch(uint64_t key, PluginWindow& window) = 0;
+    // Both return false if the window server refused (or the window has gone). Called from
+    // worker threads for batch updates, so must be safe to call concurrently
+    virtual bool move(uint64_t key, double x, double y) = 0;
+    virtual bool resize(uint64_t key, double w, double h) = 0;
+    virtual void focus(uint64_t key) = 0;
+    // Somewhere to park windows out of the way
+    virtual void awayPosition(double& x, double& y) = 0;
+};
+
+class PluginWindowRegistry {
+    PluginWindowSource* source;
+    std::shared_ptr<const PluginWindowList> snapshot;
+    // Bumped by invalidate(), the snapshot is only trusted if it was read at the current one
+    std::atomic<uint64_t> generation;
+    std::atomic<uint64_t> snapshotGeneration;
+    // Writers only, readers just load the snapshot
+    std::mutex writeMutex;
+
+    void publish(std::shared_ptr<const PluginWindowList> list);
+    // Under writeMutex
+    void store(const PluginWindow& window);
+public:
+    PluginWindowRegistry(PluginWindowSource* source);
+
+    std::shared_ptr<const PluginWindowList> windows();
+    PluginWindowSource* getSource();
+
+    /**
+     * Notifications, safe from any thread
+     */
+    // Created, moved, resized or retitled
+    void windowChanged(uint64_t key);
+    // As windowChanged, for a caller that has just fetched the window itself (e.g. to confirm
+    // its own move), so the cache doesn't wait on the window server's notification
+    void windowFetched(const PluginWindow& window);
+    void windowDestroyed(uint64_t key);
+    // key is now the focused window, 0 if no plugin window is. Nothing is fetched
+    void focusChanged(uint64_t key);
+    // Anything that needs a full re-read, done on the next access
+    void invalidate();
+};
+
+/**
+ * Defined per platform in bitwig.cc
+ */
+PluginWindowRegistry& getPluginWindowRegistry();
@@ -0,0 +1,52 @@
+#include "workerpool.h"
+
+WorkerPool::WorkerPool(size_t size) : size(size > 0 ? size : 1) {}
+
+void WorkerPool::run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return !queue.empty(); });
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
+
+void WorkerPool::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(task));
+        if (threads.size() < size) {
+            threads.emplace_back([this]() {
+                run();
+            });
+            threads.back().detach();
+        }
+    }
+    condition.notify_one();
+}
+
+void WorkerPool::runAll(std::vector<std::function<void()>>& tasks) {
+    if (tasks.empty()) {
+        return;
+    }
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+    size_t remaining = tasks.size() - 1;
+    for (size_t i = 1; i < tasks.size(); i++) {
+        auto& task = tasks[i];
+        post([&]() {
+            task();
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (--remaining == 0) {
+                doneCondition.notify_one();
+            }
+        });
+    }
+    tasks[0]();
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCondition.wait(lock, [&] { return remaining == 0; });
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of threads taking tasks off a shared queue, for work that spends most of its time
+ * waiting on another process (e.g. Accessibility calls) and so gains from overlapping, or CPU
+ * bound work that splits up (detection over several windows). Threads are started on first use
+ * and live for the life of the process.
+ */
+class WorkerPool {
+    size_t size;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::function<void()>> queue;
+    std::vector<std::thread> threads;
+
+    void run();
+public:
+    WorkerPool(size_t size);
+    void post(std::function<void()> task);
+    // Runs all the tasks and returns once they are done. The calling thread runs the first
+    // itself rather than sitting idle. Don't call from one of the pool's own threads
+    void runAll(std::vector<std::function<void()>>& tasks);
+};
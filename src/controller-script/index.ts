@@ -965,7 +965,9 @@ class UIController extends Controller {
         this.deps.packetManager.send({
             type: 'ui',
             data: {
-                isLargeTrackHeight: this.hasDoubleRowTrackHeight
+                isLargeTrackHeight: this.hasDoubleRowTrackHeight,
+                // Picks the native layout profile, offsets move between releases
+                version: host.getHostVersion()
             }
         })
    }
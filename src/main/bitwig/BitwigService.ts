@@ -20,7 +20,11 @@ export class BitwigService extends BESService {
 
     // Events
     events = {
-        browserOpen: makeEvent<boolean>()
+        browserOpen: makeEvent<boolean>(),
+        // Raised by the native resource sampler, see Bitwig.setResourceSampling
+        resourceThreshold: makeEvent<any>(),
+        // Raised by the native meter sampler, see UI.MainWindow.setActivitySampling
+        activity: makeEvent<any>()
     }
 
     async activate() {
@@ -30,5 +34,13 @@ export class BitwigService extends BESService {
             this.browserIsOpen = data.isOpen
             this.events.browserOpen.emit(data, previous)
         })
+        // Only forwards, the sampler thread isn't started until a mod calls setResourceSampling
+        Bitwig.on('resourceThreshold', event => {
+            this.log(`${event.app} over ${event.kind} threshold: ${event.value}`)
+            this.events.resourceThreshold.emit(event)
+        })
+        Bitwig.on('activity', event => {
+            this.events.activity.emit(event)
+        })
     }
 }
@@ -9,9 +9,9 @@ const logInOut = false
 const RECONNECT_IN = 1000 * 3;
 
 let nextId = 0
-let waiting = 0
-let partialMsg = ''
 let bitwigClient: any = null
+// Splits Bitwig's length prefixed stream into packets natively, without decoding it to a string
+const framer = new Bitwig.PacketFramer()
 
 type WebsocketData = ({ws:any,id:number} & any)
 let activeWebsockets: WebsocketData[] = [];
@@ -22,28 +22,19 @@ let waitingForResponseById: {[id: string] : Function} = {}
  * data processor could end up out of order (as we process multiple packets in one function call)
  */
 const bitwigToClientQueue = async.queue(async function ({data}, callback) {
-    let leftToParse = data.toString()
-    while (leftToParse.length > 0) {
-        if (waiting === 0) {
-            waiting = parseInt(leftToParse, 10)
-            partialMsg = ''
-            leftToParse = leftToParse.substr(String(waiting).length)
-            // logWithTime("waiting on " + waiting)
-        }
-        let thisTime = leftToParse.substr(0, waiting)
-        leftToParse = leftToParse.substr(waiting)
-        partialMsg += thisTime
-        waiting -= thisTime.length 
-        if (waiting === 0) {
-            if (logInOut) logWithTime('Bitwig sent: ' + partialMsg.substr(0, 50));
+    for (const frame of framer.push(data)) {
+        // The framer reads type/id without parsing, so only packets someone is interested in
+        // are decoded and parsed. The rest go to the browser as they came
+        let packet: string | Buffer = Buffer.from(frame.data.buffer, frame.data.byteOffset, frame.data.byteLength)
+        if (logInOut) logWithTime('Bitwig sent: ' + packet.toString('utf8', 0, 50));
+        if (frame.id in waitingForResponseById || (fromBWInterceptors[frame.type] || []).length) {
             try {
-                partialMsg = (await processInterceptors(partialMsg, fromBWInterceptors)).string
+                packet = (await processInterceptors(packet.toString('utf8'), fromBWInterceptors)).string
             } catch (e) {
                 console.error("Error intercepting packet", e)
             }
-            activeWebsockets.forEach(info => info.ws.send(partialMsg))
-            partialMsg = ''
         }
+        activeWebsockets.forEach(info => info.ws.send(packet, { binary: false }))
     }
     callback();
 }, 1);
@@ -123,7 +114,7 @@ export class SocketMiddlemanService extends BESService {
                     this.bitwigConnected = false;
                     bitwigClient = null
                     this.events.connected.emit(false)
-                    waiting = 0
+                    framer.reset()
                     setTimeout(() => {
                         connectBitwig();
                     }, RECONNECT_IN);
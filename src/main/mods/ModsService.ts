@@ -383,6 +383,8 @@ export class ModsService extends BESService {
                 ...makeEmitterEvents({
                     selectedTrackChanged: this.events.selectedTrackChanged,
                     browserOpen: this.bitwigService.events.browserOpen,
+                    resourceThreshold: this.bitwigService.events.resourceThreshold,
+                    activity: this.bitwigService.events.activity,
                     projectChanged: this.events.projectChanged,
                     activeEngineProjectChanged: this.events.activeEngineProjectChanged
                 })
@@ -6,8 +6,9 @@ import _ from 'underscore'
 import { BitwigService } from "../bitwig/BitwigService"
 import { wait } from "../../connector/shared/engine/Debounce"
 import { returnMouseAfter } from "../../connector/shared/EventUtils"
+import { getResourcePath } from "../../connector/shared/ResourcePath"
 
-const { Keyboard, Bitwig, UI, Mouse: _Mouse, MainWindow } = require('bindings')('bes')
+const { Keyboard, Bitwig, UI, Mouse: _Mouse } = require('bindings')('bes')
 
 /**
  * UI Service is basically responsible for keeping an up to date (insofar as possbile) representation of the Bitwig UI.
@@ -85,33 +86,32 @@ export class UIService extends BESService {
             off: (event, id) => {
                 this.apiEventRouter.off(event, id)
             },
+            /**
+             * Runs steps on the native input thread, resolves once they've all been posted.
+             * Pass x/y with avoidPluginWindows to move plugin windows out of the way first
+             */
+            sequence: async (steps, opts: any = {}) => {
+                const doIt = () => _Mouse.sequence(steps, opts)
+                if (opts.avoidPluginWindows) {
+                    return this.Mouse.avoidingPluginWindows(opts, doIt)
+                } else {
+                    return doIt()
+                }
+            },
             avoidingPluginWindows: async (pointOpts, cb) => {
-                if (!this.eventIntersectsPluginWindows(pointOpts)) {
-                    return Promise.resolve(cb())
+                // Only windows overlapping the point (or x/y/w/h region) get moved, and the native
+                // side confirms they have (off the JS thread) rather than us guessing how long it takes
+                const moved = await Bitwig.clearPluginWindowsFrom(pointOpts)
+                if (moved.length === 0) {
+                    return cb()
                 }
-                const pluginPositions = Bitwig.getPluginWindowsPosition()
-                const displayDimensions = MainWindow.getMainScreen()
-                let tempPositions = {}
-                for (const key in pluginPositions) {
-                    tempPositions[key] = {
-                        ...pluginPositions[key],
-                        x: displayDimensions.w - 1,
-                        y: displayDimensions.h - 1,
+                try {
+                    return await cb()
+                } finally {
+                    if (!pointOpts.noReposition) {
+                        await Bitwig.restorePluginWindows(moved)
                     }
                 }
-                Bitwig.setPluginWindowsPosition(tempPositions)
-                return new Promise<void>(res => {
-                    setTimeout(async () => {
-                        const result = cb()
-                        if (result && result.then) {
-                            await result
-                        }
-                        if (!pointOpts.noReposition) {
-                            Bitwig.setPluginWindowsPosition(pluginPositions)
-                        }
-                        res()
-                    }, 100)
-                })
             }    
         }
 
@@ -127,28 +127,122 @@ export class UIService extends BESService {
                 uiService.log(opts)
                 return uiService.Mouse.click(opts)
             },
+            headerRect() {
+                // What's on screen of the header, down to the first automation lane. null when
+                // it's scrolled away and only lanes show
+                if (this.header === 'hidden') {
+                    return null
+                }
+                const { x, y, w, h } = this.visibleRect
+                const bottom = this.automationLanes.length > 0 ? this.automationLanes[0].y : y + h
+                return { x, y, w, h: bottom - y }
+            },
+            async clickControl(name: 'mute' | 'solo' | 'arm' | 'fold', opts: any = {}) {
+                // Found when the track was, null if it's not there (or not fully visible)
+                const control = this.controls && this.controls[name]
+                if (!control) {
+                    return false
+                }
+                await uiService.Mouse.click(0, {
+                    x: control.rect.x + Math.floor(control.rect.w / 2),
+                    y: control.rect.y + Math.floor(control.rect.h / 2),
+                    avoidPluginWindows: true,
+                    returnAfter: true,
+                    ...opts
+                })
+                return true
+            },
             async toggleExpandedWithMouse() {
+                if (await this.clickControl('fold')) {
+                    return
+                }
                 const folderIconWidth = uiService.scale(18)
                 // Click a few from the left hand side in increments of the folder icon width
                 // so we only hit it once. Quicker than working out where it is
                 const startPos = _Mouse.getPosition()
-                const opts = {
-                    y: this.visibleRect.y + uiService.scale(this.isLargeTrackHeight ? 32 : 14),
-                    avoidPluginWindows: true
-                }
+                const y = this.visibleRect.y + uiService.scale(this.isLargeTrackHeight ? 32 : 14)
+                const steps: any[] = []
                 for (let i = 0; i < 5; i++) {
                     const x = this.visibleRect.x + uiService.scale(10) + i * folderIconWidth
-                    uiService.Mouse.click({
-                        ...opts,
-                        x
-                    })
+                    steps.push({ type: 'click', button: 0, x, y })
                 }
-                _Mouse.setPosition(startPos.x, startPos.y)
+                steps.push({ type: 'move', x: startPos.x, y: startPos.y })
+                return uiService.Mouse.sequence(steps, {
+                    x: steps[0].x,
+                    y,
+                    w: 5 * folderIconWidth,
+                    avoidPluginWindows: true
+                })
             }
         }
-        proto.getArrangerTracks = (...args) => {
-            const results = proto._getArrangerTracks(...args)
-            return results ? results.map(obj => Object.setPrototypeOf(obj, ArrangerTrack)) : null
+        proto.getArrangerTracks = ({ includeHiddenHeaders = false } = {}) => {
+            const results = proto._getArrangerTracks()
+            if (!results) {
+                return null
+            }
+            // Tracks scrolled so only their automation lanes show have no header to click on,
+            // most callers don't want them
+            return results
+                .filter(obj => includeHiddenHeaders || obj.header !== 'hidden')
+                .map(obj => Object.setPrototypeOf(obj, ArrangerTrack))
+        }
+        proto.pixelToBeat = (x: number) => {
+            const ruler = proto.getRuler()
+            return ruler && ruler.transform ? (x - ruler.transform.originX) / ruler.transform.pixelsPerBeat : null
+        }
+        proto.beatToPixel = (beat: number) => {
+            const ruler = proto.getRuler()
+            return ruler && ruler.transform ? ruler.transform.originX + beat * ruler.transform.pixelsPerBeat : null
+        }
+        proto.getArrangerClips = () => {
+            // Tracks and their clips from one capture. Each track's clips is a view onto the
+            // packed rects (x, y, w, h per clip), nothing is copied
+            const snapshot = proto.getUISnapshot({ clips: true })
+            if (!snapshot || !snapshot.tracks || !snapshot.clips) {
+                return null
+            }
+            const { offsets, rects } = snapshot.clips
+            return snapshot.tracks.map((obj, i) => {
+                obj.clips = rects.subarray(offsets[i] * 4, offsets[i + 1] * 4)
+                return Object.setPrototypeOf(obj, ArrangerTrack)
+            })
+        }
+        proto.getDevices = () => {
+            // The native chain is cached and comes back as the same object while nothing in the
+            // panel changes, so unpack into a fresh array rather than touching it
+            const chain = proto.getDeviceChain()
+            if (!chain) {
+                return null
+            }
+            const { slots, flags } = chain
+            const devices: any[] = []
+            for (let i = 0; i < flags.length; i++) {
+                devices.push({
+                    rect: { x: slots[i * 4], y: slots[i * 4 + 1], w: slots[i * 4 + 2], h: slots[i * 4 + 3] },
+                    collapsed: (flags[i] & 1) !== 0,
+                    selected: (flags[i] & 2) !== 0,
+                    clipped: (flags[i] & 4) !== 0
+                })
+            }
+            return { rect: chain.rect, devices, scroll: chain.scroll }
+        }
+        proto.getMixer = () => {
+            const mixer = proto.getMixerStrips()
+            if (!mixer) {
+                return null
+            }
+            const rectAt = (packed, i) => ({ x: packed[i * 4], y: packed[i * 4 + 1], w: packed[i * 4 + 2], h: packed[i * 4 + 3] })
+            const strips: any[] = []
+            for (let i = 0; i < mixer.strips.length / 4; i++) {
+                // Fader and meter are null where the strip's couldn't be told apart
+                strips.push({
+                    rect: rectAt(mixer.strips, i),
+                    fader: mixer.faders[i * 4 + 2] ? rectAt(mixer.faders, i) : null,
+                    meter: mixer.meters[i * 4 + 2] ? rectAt(mixer.meters, i) : null,
+                    selected: i === mixer.selected
+                })
+            }
+            return { rect: mixer.rect, strips }
         }
     }
 
@@ -209,6 +303,8 @@ export class UIService extends BESService {
                 },
                 lockX: Keyboard.lockX,
                 lockY: Keyboard.lockY,
+                setConstraint: Keyboard.setPointerConstraint,
+                clearConstraint: Keyboard.clearPointerConstraint,
                 returnAfter: returnMouseAfter   
             },
             UI: {
@@ -257,6 +353,14 @@ export class UIService extends BESService {
     }
 
     async activate() {
+        try {
+            const sections = UI.loadLayoutProfiles(getResourcePath('/layout-profiles.txt'))
+            this.log(`Loaded ${sections} layout profile sections`)
+        } catch (e) {
+            // Detection carries on with the built in offsets
+            this.log(`Couldn't load layout profiles: ${e}`)
+        }
+
         // Track tool changes via number keys
         Keyboard.on('keydown', event => {
             const asNumber = parseInt(event.lowerKey, 10)
@@ -287,11 +391,24 @@ export class UIService extends BESService {
             this.log(`Ui scale set to ${this.uiScale}`)
         })
 
+        this.settingsService.onSettingValueChange('uiLayout', val => {
+            UI.updateUILayoutInfo({layout: val})
+            this.log(`Ui layout set to ${val}`)
+        })
+
         interceptPacket('ui', undefined, (packet) => {
             this.log('Updating UI from packet: ', packet)
             UI.updateUILayoutInfo(packet.data)
         })
 
+        interceptPacket('transport/play-start', undefined, ({ position }) => {
+            // When stopped Bitwig moves the playhead to the new play start, which tells the ruler
+            // what beat that pixel is. Give it a moment to redraw. Anchors that don't fit the
+            // ruler's ticks (we were playing) are ignored natively. Not awaited, interceptors
+            // run one packet at a time and would hold up everything behind this one
+            setTimeout(() => this.uiMainWindow.anchorRuler(position), 100)
+        })
+
         this.addExtras()
         this.Mouse.on('mousedown', event => {
             if (event.button === 0) {
@@ -327,24 +444,10 @@ export class UIService extends BESService {
         if ('_intersectsPluginWindows' in event) {
             return event._intersectsPluginWindows
         }
-        const pluginLocations = Bitwig.getPluginWindowsPosition()
-        for (const key in pluginLocations) {
-            const {x, y, w, h, ...rest} = pluginLocations[key]
-            if (event.x >= x && event.x < x + w && event.y >= y && event.y < y + h) {
-                let out = {
-                    id: key,
-                    x,
-                    y,
-                    w,
-                    h,
-                    ...rest
-                }
-                event._intersectsPluginWindows = out
-                return out
-            }
-        }
-        event._intersectsPluginWindows = false
-        return false
+        // Answered from the native plugin window cache, no window server round trip
+        const out = Bitwig.getPluginWindowAt(event.x, event.y)
+        event._intersectsPluginWindows = out
+        return out
     }
 
     bwToScreen({ x, y, ...rest }) {
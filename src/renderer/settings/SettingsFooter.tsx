@@ -70,7 +70,10 @@ export const SettingsFooter = () => {
         })} />
         <LabelledSelect label="UI Layout" value={state.uiLayout[0]} onChange={onSettingChange('uiLayout')}options={[
             // 'Single Display (Small)', 
-            'Single Display (Large)'
+            'Single Display (Large)',
+            'Dual Display (Studio)',
+            'Dual Display (Arranger/Mixer)',
+            'Dual Display (Master/Detail)'
         ].map(size => {
             return <option key={size} value={size}>
                 {size}